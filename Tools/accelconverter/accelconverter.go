@@ -0,0 +1,183 @@
+package main
+
+import (
+	"bufio"
+	"encoding/binary"
+	"errors"
+	"flag"
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"strings"
+)
+
+// These must match src/Accelerometers/AccelerometerFile.h
+const (
+	magicValue         = 0x43415252 // "RRAC"
+	currentVersion     = 1
+	headerSize         = 28
+	flagComplete       = 0x0001
+	unknownOrientation = 0xFF
+)
+
+var errorMessages = []string{
+	"",
+	"Failed to collect data from accelerometer",
+	"Failed to start accelerometer",
+	"Received bad data",
+	"Received mismatched data",
+}
+
+type header struct {
+	Magic          uint32
+	Version        uint16
+	DataOffset     uint16
+	NumSamples     uint32
+	NumOverflows   uint32
+	SampleRate     uint16
+	Flags          uint16
+	BoardAddress   uint8
+	Axes           uint8
+	Resolution     uint8
+	BitsAfterPoint uint8
+	Orientation    uint8
+	Error          uint8
+	Reserved       [2]uint8
+}
+
+// Get the number of decimal places that the firmware uses when it writes a CSV file
+func decimalPlaces(bitsAfterPoint uint8) int {
+	if bitsAfterPoint >= 11 {
+		return 4
+	}
+	if bitsAfterPoint >= 8 {
+		return 3
+	}
+	return 2
+}
+
+// Convert a binary accelerometer file to the CSV format that M956 writes
+func convert(data []byte, w io.Writer, verbose bool) error {
+	if len(data) < headerSize {
+		return errors.New("file is too short")
+	}
+	var h header
+	if err := binary.Read(strings.NewReader(string(data[:headerSize])), binary.LittleEndian, &h); err != nil {
+		return err
+	}
+	if h.Magic != magicValue {
+		return errors.New("not a binary accelerometer file")
+	}
+	if h.Version != currentVersion {
+		return fmt.Errorf("unsupported version %d", h.Version)
+	}
+	if int(h.DataOffset) < headerSize || int(h.DataOffset) > len(data) {
+		return fmt.Errorf("bad data offset %d", h.DataOffset)
+	}
+	if h.Axes == 0 || h.Axes&^0x07 != 0 {
+		return fmt.Errorf("bad axes field 0x%02x", h.Axes)
+	}
+
+	if verbose {
+		orientation := "unknown"
+		if h.Orientation != unknownOrientation {
+			orientation = fmt.Sprint(h.Orientation)
+		}
+		fmt.Fprintf(os.Stderr, "Board %d, %d samples at %dHz, %d-bit resolution, orientation %s\n",
+			h.BoardAddress, h.NumSamples, h.SampleRate, h.Resolution, orientation)
+	}
+
+	axisLetters := ""
+	for i, letter := range []string{"X", "Y", "Z"} {
+		if h.Axes&(1<<uint(i)) != 0 {
+			axisLetters += letter
+		}
+	}
+
+	// A run that did not finish may have been cut off part way through a sample, but a complete run must have exactly the samples that the header says
+	numAxes := len(axisLetters)
+	values := data[h.DataOffset:]
+	numSamples := len(values) / (2 * numAxes)
+	if h.Flags&flagComplete != 0 && (numSamples != int(h.NumSamples) || len(values)%(2*numAxes) != 0) {
+		return fmt.Errorf("%d bytes of data don't match %d samples of %d axes", len(values), h.NumSamples, numAxes)
+	}
+
+	bw := bufio.NewWriter(w)
+	fmt.Fprint(bw, "Sample")
+	for _, letter := range axisLetters {
+		fmt.Fprintf(bw, ",%c", letter)
+	}
+	fmt.Fprint(bw, "\n")
+
+	places := decimalPlaces(h.BitsAfterPoint)
+	scale := float64(uint32(1) << h.BitsAfterPoint)
+	for sample := 0; sample < numSamples; sample++ {
+		fmt.Fprintf(bw, "%d", sample)
+		for axis := 0; axis < numAxes; axis++ {
+			offset := 2 * (sample*numAxes + axis)
+			val := int16(binary.LittleEndian.Uint16(values[offset:]))
+			fmt.Fprintf(bw, ",%.*f", places, float64(val)/scale)
+		}
+		fmt.Fprint(bw, "\n")
+	}
+
+	switch {
+	case h.Flags&flagComplete == 0:
+		fmt.Fprint(bw, "Run did not finish\n")
+	case h.Error != 0:
+		if int(h.Error) < len(errorMessages) {
+			fmt.Fprintf(bw, "%s\n", errorMessages[h.Error])
+		} else {
+			fmt.Fprintf(bw, "Error %d\n", h.Error)
+		}
+	default:
+		fmt.Fprintf(bw, "Rate %d, overflows %d\n", h.SampleRate, h.NumOverflows)
+	}
+	return bw.Flush()
+}
+
+// Convert one file, closing the output file before returning so that nothing is lost if the caller exits
+func convertFile(inFile, outName string, verbose bool) error {
+	data, err := os.ReadFile(inFile)
+	if err != nil {
+		return err
+	}
+
+	if outName == "-" {
+		return convert(data, os.Stdout, verbose)
+	}
+	f, err := os.Create(outName)
+	if err != nil {
+		return err
+	}
+	if err = convert(data, f, verbose); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
+
+func main() {
+	outFile := flag.String("o", "", "Path of the CSV file to write, default is the input path with the extension changed to .csv, or \"-\" for stdout")
+	verbose := flag.Bool("v", false, "Print a summary of the file header to stderr")
+	flag.Usage = func() {
+		fmt.Fprintf(flag.CommandLine.Output(), "Usage: %s [-o output.csv] [-v] file.bin...\n", os.Args[0])
+		flag.PrintDefaults()
+	}
+	flag.Parse()
+	if flag.NArg() == 0 || (*outFile != "" && flag.NArg() > 1) {
+		flag.Usage()
+		os.Exit(2)
+	}
+
+	for _, inFile := range flag.Args() {
+		outName := *outFile
+		if outName == "" {
+			outName = strings.TrimSuffix(inFile, ".bin") + ".csv"
+		}
+		if err := convertFile(inFile, outName, *verbose); err != nil {
+			log.Fatalf("%s: %v", inFile, err)
+		}
+	}
+}
@@ -0,0 +1,3 @@
+module github.com/Duet3D/RepRapFirmware/Tools/accelconverter
+
+go 1.16
@@ -0,0 +1,64 @@
+/*
+ * AccelerometerFile.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Layout of the binary accelerometer data files that M956 writes when the B1 parameter is given. These are much quicker to write than CSV files.
+ * All values are little-endian. The file is a sequence of AccelerometerFileBlockSize-byte blocks, except that the last one may be shorter.
+ * The first block holds the header below padded with zeros. The following blocks hold the samples as int16_t values, interleaved by axis
+ * in the order X, Y, Z (only the axes in the header's axes bitmap are present), so a sample may be split across two blocks.
+ * Each value is an acceleration in units of 1/2^bitsAfterPoint g.
+ *
+ * The header is written when the file is created and written again when the run ends, so a file whose header doesn't have the complete flag set
+ * was not finished, for example because the board was reset. Tools/accelconverter converts these files to the same CSV format that M956 writes.
+ */
+
+#ifndef SRC_ACCELEROMETERS_ACCELEROMETERFILE_H_
+#define SRC_ACCELEROMETERS_ACCELEROMETERFILE_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_ACCELEROMETERS
+
+constexpr size_t AccelerometerFileBlockSize = 512;							// the SD card sector size
+
+// Reasons why a run failed. The host converter uses these to write the same messages that we write to CSV files.
+enum class AccelerometerFileError : uint8_t
+{
+	none = 0,
+	collectFailed,			// "Failed to collect data from accelerometer"
+	startFailed,			// "Failed to start accelerometer"
+	badData,				// "Received bad data"
+	mismatchedData			// "Received mismatched data"
+};
+
+struct __attribute__((packed)) AccelerometerFileHeader
+{
+	static constexpr uint32_t MagicValue = 0x43415252;						// "RRAC" read as a little-endian 32-bit integer
+	static constexpr uint16_t CurrentVersion = 1;
+	static constexpr uint16_t FlagComplete = 0x0001;						// set when the run has ended, successfully or not
+	static constexpr uint8_t UnknownOrientation = 0xFF;
+
+	uint32_t magic;
+	uint16_t version;
+	uint16_t dataOffset;													// the offset in the file of the first sample, equal to AccelerometerFileBlockSize
+	uint32_t numSamples;
+	uint32_t numOverflows;
+	uint16_t sampleRate;													// the configured rate (0 if the default) until the run ends, then the measured rate
+	uint16_t flags;
+	uint8_t boardAddress;
+	uint8_t axes;															// bitmap of the axes present, X in bit 0
+	uint8_t resolution;														// the number of significant bits in each value
+	uint8_t bitsAfterPoint;
+	uint8_t orientation;													// the M955 I parameter, or UnknownOrientation if the accelerometer is on an expansion board
+	AccelerometerFileError error;
+	uint8_t reserved[2];
+};
+
+static_assert(sizeof(AccelerometerFileHeader) == 28);
+static_assert(sizeof(AccelerometerFileHeader) <= AccelerometerFileBlockSize);
+
+#endif
+
+#endif /* SRC_ACCELEROMETERS_ACCELEROMETERFILE_H_ */
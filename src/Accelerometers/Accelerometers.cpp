@@ -9,6 +9,8 @@
 
 #if SUPPORT_ACCELEROMETERS
 
+#include "AccelerometerFile.h"
+
 #include <Storage/MassStorage.h>
 #include <Platform/Platform.h>
 #include <Platform/RepRap.h>
@@ -29,6 +31,10 @@
 # include <Duet3Ate.h>
 #endif
 
+#if SUPPORT_RESONANCE_ANALYSIS
+# include "ResonanceAnalyser.h"
+#endif
+
 constexpr uint32_t DefaultAccelerometerSpiFrequency = 2000000;
 
 #if SUPPORT_CAN_EXPANSION
@@ -40,6 +46,22 @@ static unsigned int numRemoteOverflows;
 
 #endif
 
+#if SUPPORT_RESONANCE_ANALYSIS
+
+static ResonanceAnalyser *analyser = nullptr;				// this is allocated when the first analysis is requested
+static volatile bool analysing = false;						// true if the current run is being analysed
+
+#endif
+
+static uint8_t GetLocalBoardAddress() noexcept
+{
+#if SUPPORT_CAN_EXPANSION
+	return CanInterface::GetCanAddress();
+#else
+	return 0;
+#endif
+}
+
 // Get the number of binary digits after the decimal point
 static inline unsigned int GetBitsAfterPoint(uint8_t dataResolution) noexcept
 {
@@ -52,6 +74,88 @@ static unsigned int GetDecimalPlaces(uint8_t dataResolution) noexcept
 	return (GetBitsAfterPoint(dataResolution) >= 11) ? 4 : (GetBitsAfterPoint(dataResolution) >= 8) ? 3 : 2;
 }
 
+// Data file handling. Only one accelerometer runs at a time, so the local accelerometer and expansion boards share these.
+constexpr size_t ValuesPerFileBlock = AccelerometerFileBlockSize/sizeof(int16_t);
+
+static const char *_ecv_array const FileErrorMessages[] =
+{
+	"",
+	"Failed to collect data from accelerometer\n",
+	"Failed to start accelerometer\n",
+	"Received bad data\n",
+	"Received mismatched data\n"
+};
+
+static bool binaryFile = false;								// true if the file being written is a binary file, false if it is a CSV file
+static AccelerometerFileHeader fileHeader;
+static int16_t *_ecv_array fileBlock = nullptr;				// the block of a binary file being assembled, allocated when the first binary file is created
+static size_t fileBlockValues = 0;							// the number of values in fileBlock
+
+// Write the header block of a new binary file
+static void StartBinaryFile(FileStore *f) noexcept
+{
+	if (fileBlock == nullptr)
+	{
+		fileBlock = new int16_t[ValuesPerFileBlock];
+	}
+	memset(fileBlock, 0, AccelerometerFileBlockSize);
+	memcpy(fileBlock, &fileHeader, sizeof(fileHeader));
+	f->Write(reinterpret_cast<const char *_ecv_array>(fileBlock), AccelerometerFileBlockSize);
+	fileBlockValues = 0;
+}
+
+// Add a value to a binary file. We write whole blocks so that the writes are aligned to SD card sectors.
+static void StoreBinaryValue(FileStore *f, int16_t val) noexcept
+{
+	fileBlock[fileBlockValues++] = val;
+	if (fileBlockValues == ValuesPerFileBlock)
+	{
+		f->Write(reinterpret_cast<const char *_ecv_array>(fileBlock), AccelerometerFileBlockSize);
+		fileBlockValues = 0;
+	}
+}
+
+// Record the result of the run in the file and close it
+static void FinishFile(FileStore *f, AccelerometerFileError error, unsigned int rate, unsigned int numSamples, unsigned int numOverflows) noexcept
+{
+	if (binaryFile)
+	{
+		if (fileBlockValues != 0)
+		{
+			f->Write(reinterpret_cast<const char *_ecv_array>(fileBlock), fileBlockValues * sizeof(int16_t));
+			fileBlockValues = 0;
+		}
+		f->Truncate();								// truncate the file in case we didn't write all the preallocated space
+		if (error == AccelerometerFileError::none)
+		{
+			fileHeader.sampleRate = rate;
+		}
+		fileHeader.numSamples = numSamples;
+		fileHeader.numOverflows = numOverflows;
+		fileHeader.flags |= AccelerometerFileHeader::FlagComplete;
+		fileHeader.error = error;
+		if (f->Seek(0))
+		{
+			f->Write(reinterpret_cast<const char *_ecv_array>(&fileHeader), sizeof(fileHeader));
+		}
+	}
+	else
+	{
+		if (error == AccelerometerFileError::none)
+		{
+			String<StringLength50> temp;
+			temp.printf("Rate %u, overflows %u\n", rate, numOverflows);
+			f->Write(temp.c_str());
+		}
+		else
+		{
+			f->Write(FileErrorMessages[(size_t)error]);
+		}
+		f->Truncate();								// truncate the file in case we didn't write all the preallocated space
+	}
+	f->Close();
+}
+
 // Local accelerometer handling
 
 #include "LIS3DH.h"
@@ -129,9 +233,10 @@ static uint8_t TranslateAxes(uint8_t axes) noexcept
 					{
 						// samplesRead == 0 indicates an error, e.g. no interrupt
 						samplesWanted = 0;
-						f->Write("Failed to collect data from accelerometer\n");
-						f->Truncate();				// truncate the file in case we didn't write all the preallocated space
-						f->Close();
+#if SUPPORT_RESONANCE_ANALYSIS
+						analysing = false;
+#endif
+						FinishFile(f, AccelerometerFileError::collectFailed, dataRate, samplesWritten, numOverflows);
 						f = nullptr;
 						AddLocalAccelerometerRun(0);
 					}
@@ -156,7 +261,14 @@ static uint8_t TranslateAxes(uint8_t axes) noexcept
 						{
 							// Write a row of data
 							String<StringLength50> temp;
-							temp.printf("%u", samplesWritten);
+							if (!binaryFile)
+							{
+								temp.printf("%u", samplesWritten);
+							}
+#if SUPPORT_RESONANCE_ANALYSIS
+							float analysisValues[3];
+							size_t numAnalysisValues = 0;
+#endif
 
 							for (unsigned int axis = 0; axis < 3; ++axis)
 							{
@@ -179,14 +291,33 @@ static uint8_t TranslateAxes(uint8_t axes) noexcept
 									const float fVal = (float)(int16_t)dataVal/(float)(1u << GetBitsAfterPoint(resolution));
 
 									// Append it to the buffer
-									temp.catf(",%.*f", decimalPlaces, (double)fVal);
+									if (binaryFile)
+									{
+										StoreBinaryValue(f, (int16_t)dataVal);
+									}
+									else
+									{
+										temp.catf(",%.*f", decimalPlaces, (double)fVal);
+									}
+#if SUPPORT_RESONANCE_ANALYSIS
+									analysisValues[numAnalysisValues++] = fVal;
+#endif
 								}
 							}
+#if SUPPORT_RESONANCE_ANALYSIS
+							if (analysing)
+							{
+								analyser->AddSample(analysisValues);
+							}
+#endif
 
 							data += 3;
 
-							temp.cat('\n');
-							f->Write(temp.c_str());
+							if (!binaryFile)
+							{
+								temp.cat('\n');
+								f->Write(temp.c_str());
+							}
 
 							--samplesRead;
 							--samplesWanted;
@@ -197,9 +328,14 @@ static uint8_t TranslateAxes(uint8_t axes) noexcept
 
 				if (f != nullptr)
 				{
-					String<StringLength50> temp;
-					temp.printf("Rate %u, overflows %u\n", dataRate, numOverflows);
-					f->Write(temp.c_str());
+#if SUPPORT_RESONANCE_ANALYSIS
+					if (analysing)
+					{
+						analyser->Finish((float)dataRate);
+					}
+#endif
+					FinishFile(f, AccelerometerFileError::none, dataRate, samplesWritten, numOverflows);
+					AddLocalAccelerometerRun(samplesWritten);
 				}
 			}
 			else
@@ -207,20 +343,17 @@ static uint8_t TranslateAxes(uint8_t axes) noexcept
 				recordFailedStart = true;
 				if (f != nullptr)
 				{
-					f->Write("Failed to start accelerometer\n");
+					FinishFile(f, AccelerometerFileError::startFailed, 0, 0, 0);
+					AddLocalAccelerometerRun(0);
 				}
 			}
 
-			if (f != nullptr)
-			{
-				f->Truncate();				// truncate the file in case we didn't write all the preallocated space
-				f->Close();
-				AddLocalAccelerometerRun(samplesWritten);
-			}
-
 			accelerometer->StopCollecting();
 
 			// Wait for another command
+#if SUPPORT_RESONANCE_ANALYSIS
+			analysing = false;
+#endif
 			accelerometerFile = nullptr;
 			if (recordFailedStart)
 			{
@@ -402,6 +535,11 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 		axes = 0x07;						// default to all three axes
 	}
 
+	const bool binary = gb.Seen('B') && gb.GetUIValue() != 0;
+#if SUPPORT_RESONANCE_ANALYSIS
+	const bool analyse = gb.Seen('D') && gb.GetUIValue() != 0;
+#endif
+
 	// Check that we have an accelerometer
 	if (
 # if SUPPORT_CAN_EXPANSION
@@ -428,7 +566,9 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 
 	// Create the file for saving the data. First calculate the approximate file size so that we can preallocate storage to reduce the risk of overflow.
 	const unsigned int numAxes = (axesRequested & 1u) + ((axesRequested >> 1) & 1u) + ((axesRequested >> 2) & 1u);
-	const uint32_t preallocSize = numSamplesRequested * ((numAxes * (3 + GetDecimalPlaces(resolution))) + 4);
+	const uint32_t preallocSize = (binary)
+									? AccelerometerFileBlockSize + numSamplesRequested * numAxes * sizeof(int16_t)
+										: numSamplesRequested * ((numAxes * (3 + GetDecimalPlaces(resolution))) + 4);
 
 	String<MaxFilenameLength> accelerometerFileName;
 	if (gb.Seen('F'))
@@ -442,13 +582,14 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 		const time_t time = reprap.GetPlatform().GetDateTime();
 		tm timeInfo;
 		gmtime_r(&time, &timeInfo);
-		accelerometerFileName.printf("0:/sys/accelerometer/%u_%04u-%02u-%02u_%02u.%02u.%02u.csv",
+		accelerometerFileName.printf("0:/sys/accelerometer/%u_%04u-%02u-%02u_%02u.%02u.%02u.%s",
 # if SUPPORT_CAN_EXPANSION
 										(unsigned int)device.boardAddress,
 # else
 										0,
 # endif
-										timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
+										timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec,
+										(binary) ? "bin" : "csv");
 	}
 	FileStore * const f = MassStorage::OpenFile(accelerometerFileName.c_str(), OpenMode::write, preallocSize);
 	if (f == nullptr)
@@ -467,7 +608,44 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 		return GCodeResult::error;
 	}
 
-	// Write the header line to the file
+	// Write the header to the file
+	binaryFile = binary;
+	if (binary)
+	{
+# if SUPPORT_CAN_EXPANSION
+		const bool remote = device.IsRemote();
+# else
+		constexpr bool remote = false;
+# endif
+		fileHeader.magic = AccelerometerFileHeader::MagicValue;
+		fileHeader.version = AccelerometerFileHeader::CurrentVersion;
+		fileHeader.dataOffset = AccelerometerFileBlockSize;
+		fileHeader.numSamples = fileHeader.numOverflows = 0;
+		fileHeader.flags = 0;
+		fileHeader.axes = axes;
+		fileHeader.error = AccelerometerFileError::none;
+		fileHeader.reserved[0] = fileHeader.reserved[1] = 0;
+		if (remote)
+		{
+			// We find out the resolution when the first data arrives
+# if SUPPORT_CAN_EXPANSION
+			fileHeader.boardAddress = device.boardAddress;
+# endif
+			fileHeader.sampleRate = 0;
+			fileHeader.resolution = fileHeader.bitsAfterPoint = 0;
+			fileHeader.orientation = AccelerometerFileHeader::UnknownOrientation;
+		}
+		else
+		{
+			fileHeader.boardAddress = GetLocalBoardAddress();
+			fileHeader.sampleRate = samplingRate;
+			fileHeader.resolution = resolution;
+			fileHeader.bitsAfterPoint = GetBitsAfterPoint(resolution);
+			fileHeader.orientation = orientation;
+		}
+		StartBinaryFile(f);
+	}
+	else
 	{
 		String<StringLength50> temp;
 		temp.printf("Sample");
@@ -478,6 +656,25 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 		f->Write(temp.c_str());
 	}
 
+#if SUPPORT_RESONANCE_ANALYSIS
+	// Set up the analyser if we need it. The accelerometer isn't running, so the analyser isn't in use.
+	if (analyse)
+	{
+		if (analyser == nullptr)
+		{
+			analyser = new ResonanceAnalyser;
+		}
+		analyser->Start(
+# if SUPPORT_CAN_EXPANSION
+						(device.IsRemote()) ? device.boardAddress : GetLocalBoardAddress(),
+# else
+						GetLocalBoardAddress(),
+# endif
+						axes);
+	}
+	analysing = analyse;
+#endif
+
 # if SUPPORT_CAN_EXPANSION
 	if (device.IsRemote())
 	{
@@ -490,6 +687,9 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 		const GCodeResult rslt = CanInterface::StartAccelerometer(device, axes, numSamples, mode, gb, reply);
 		if (rslt > GCodeResult::warning)
 		{
+# if SUPPORT_RESONANCE_ANALYSIS
+			analysing = false;
+# endif
 			accelerometerFile->Close();
 			accelerometerFile = nullptr;
 			MassStorage::Delete(accelerometerFileName.c_str(), false);
@@ -520,6 +720,9 @@ GCodeResult Accelerometers::StartAccelerometer(GCodeBuffer& gb, const StringRef&
 	}
 	if (accelerometerFile != nullptr)
 	{
+#if SUPPORT_RESONANCE_ANALYSIS
+		analysing = false;
+#endif
 		accelerometerFile->Close();
 		accelerometerFile = nullptr;
 		MassStorage::Delete(accelerometerFileName.c_str(), false);
@@ -542,6 +745,26 @@ unsigned int Accelerometers::GetLocalAccelerometerRuns() noexcept
 	return numLocalRunsCompleted;
 }
 
+#if SUPPORT_RESONANCE_ANALYSIS
+
+// Return the analysis of the last run of the local accelerometer, or null if it wasn't analysed
+const ObjectModel *_ecv_null Accelerometers::GetLocalAnalysis() noexcept
+{
+	return (analyser != nullptr && analyser->HasResults(GetLocalBoardAddress())) ? analyser : nullptr;
+}
+
+# if SUPPORT_CAN_EXPANSION
+
+// Return the analysis of the last run of the accelerometer on an expansion board, or null if it wasn't analysed
+const ObjectModel *_ecv_null Accelerometers::GetRemoteAnalysis(CanAddress address) noexcept
+{
+	return (analyser != nullptr && address != GetLocalBoardAddress() && analyser->HasResults(address)) ? analyser : nullptr;
+}
+
+# endif
+
+#endif
+
 void Accelerometers::Exit() noexcept
 {
 	if (accelerometerTask != nullptr)
@@ -568,17 +791,19 @@ void Accelerometers::ProcessReceivedData(CanAddress src, const CanMessageAcceler
 	{
 		if (msgLen < msg.GetActualDataLength())
 		{
-			f->Write("Received bad data\n");
-			f->Truncate();				// truncate the file in case we didn't write all the preallocated space
-			f->Close();
+# if SUPPORT_RESONANCE_ANALYSIS
+			analysing = false;
+# endif
+			FinishFile(f, AccelerometerFileError::badData, 0, expectedRemoteSampleNumber, numRemoteOverflows);
 			accelerometerFile = nullptr;
 			reprap.GetExpansion().AddAccelerometerRun(src, 0);
 		}
 		else if (msg.axes != expectedRemoteAxes || msg.firstSampleNumber != expectedRemoteSampleNumber || src != expectedRemoteBoardAddress)
 		{
-			f->Write("Received mismatched data\n");
-			f->Truncate();				// truncate the file in case we didn't write all the preallocated space
-			f->Close();
+# if SUPPORT_RESONANCE_ANALYSIS
+			analysing = false;
+# endif
+			FinishFile(f, AccelerometerFileError::mismatchedData, 0, expectedRemoteSampleNumber, numRemoteOverflows);
 			accelerometerFile = nullptr;
 			reprap.GetExpansion().AddAccelerometerRun(src, 0);
 		}
@@ -596,12 +821,23 @@ void Accelerometers::ProcessReceivedData(CanAddress src, const CanMessageAcceler
 			{
 				++numRemoteOverflows;
 			}
+			if (binaryFile)
+			{
+				fileHeader.resolution = receivedResolution;
+				fileHeader.bitsAfterPoint = GetBitsAfterPoint(receivedResolution);
+			}
 
 			while (numSamples != 0)
 			{
 				String<StringLength50> temp;
-				temp.printf("%u", expectedRemoteSampleNumber);
+				if (!binaryFile)
+				{
+					temp.printf("%u", expectedRemoteSampleNumber);
+				}
 				++expectedRemoteSampleNumber;
+# if SUPPORT_RESONANCE_ANALYSIS
+				float analysisValues[3];
+# endif
 
 				for (unsigned int axis = 0; axis < numAxes; ++axis)
 				{
@@ -631,21 +867,43 @@ void Accelerometers::ProcessReceivedData(CanAddress src, const CanMessageAcceler
 					const float fVal = (float)(int16_t)val/(float)(1u << GetBitsAfterPoint(receivedResolution));
 
 					// Append it to the buffer
-					temp.catf(",%.*f", decimalPlaces, (double)fVal);
+					if (binaryFile)
+					{
+						StoreBinaryValue(f, (int16_t)val);
+					}
+					else
+					{
+						temp.catf(",%.*f", decimalPlaces, (double)fVal);
+					}
+# if SUPPORT_RESONANCE_ANALYSIS
+					analysisValues[axis] = fVal;
+# endif
+				}
+# if SUPPORT_RESONANCE_ANALYSIS
+				if (analysing)
+				{
+					analyser->AddSample(analysisValues);
 				}
+# endif
 
-				temp.cat('\n');
-				f->Write(temp.c_str());
+				if (!binaryFile)
+				{
+					temp.cat('\n');
+					f->Write(temp.c_str());
+				}
 				--numSamples;
 			}
 
 			if (msg.lastPacket)
 			{
-				String<StringLength50> temp;
-				temp.printf("Rate %u, overflows %u\n", (unsigned int)msg.actualSampleRate, numRemoteOverflows);
-				f->Write(temp.c_str());
-				f->Truncate();				// truncate the file in case we didn't write all the preallocated space
-				f->Close();
+# if SUPPORT_RESONANCE_ANALYSIS
+				if (analysing)
+				{
+					analyser->Finish((float)msg.actualSampleRate);
+					analysing = false;
+				}
+# endif
+				FinishFile(f, AccelerometerFileError::none, msg.actualSampleRate, expectedRemoteSampleNumber, numRemoteOverflows);
 				accelerometerFile = nullptr;
 				reprap.GetExpansion().AddAccelerometerRun(src, expectedRemoteSampleNumber);
 			}
@@ -19,6 +19,7 @@
 #endif
 
 class CanMessageAccelerometerData;
+class ObjectModel;
 
 namespace Accelerometers
 {
@@ -31,6 +32,12 @@ namespace Accelerometers
 #if SUPPORT_CAN_EXPANSION
 	void ProcessReceivedData(CanAddress src, const CanMessageAccelerometerData& msg, size_t msgLen) noexcept;
 #endif
+#if SUPPORT_RESONANCE_ANALYSIS
+	const ObjectModel *_ecv_null GetLocalAnalysis() noexcept;
+# if SUPPORT_CAN_EXPANSION
+	const ObjectModel *_ecv_null GetRemoteAnalysis(CanAddress address) noexcept;
+# endif
+#endif
 }
 
 #endif
@@ -0,0 +1,349 @@
+/*
+ * ResonanceAnalyser.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "ResonanceAnalyser.h"
+
+#if SUPPORT_RESONANCE_ANALYSIS
+
+// Object model table and functions
+// Note: if using GCC version 7.3.1 20180622 and lambda functions are used in this table, you must compile this file with option -std=gnu++17.
+// Otherwise the table will be allocated in RAM instead of flash, which wastes too much RAM.
+
+// Macro to build a standard lambda function that includes the necessary type conversions
+#define OBJECT_MODEL_FUNC(...) OBJECT_MODEL_FUNC_BODY(ResonanceAnalyser, __VA_ARGS__)
+#define OBJECT_MODEL_FUNC_IF(...) OBJECT_MODEL_FUNC_IF_BODY(ResonanceAnalyser, __VA_ARGS__)
+
+constexpr ObjectModelArrayDescriptor ResonanceAnalyser::axesArrayDescriptor =
+{
+	nullptr,					// no lock needed
+	[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return ((const ResonanceAnalyser*)self)->numAxes; },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(self, 1); }
+};
+
+constexpr ObjectModelArrayDescriptor ResonanceAnalyser::peaksArrayDescriptor =
+{
+	nullptr,					// no lock needed
+	[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return ((const ResonanceAnalyser*)self)->results[context.GetLastIndex()].numPeaks; },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(self, 2); }
+};
+
+constexpr ObjectModelTableEntry ResonanceAnalyser::objectModelTable[] =
+{
+	// Within each group, these entries must be in alphabetical order
+	// 0. ResonanceAnalyser members
+	{ "axes",					OBJECT_MODEL_FUNC_NOSELF(&axesArrayDescriptor), 									ObjectModelEntryFlags::none },
+	{ "sampleRate",				OBJECT_MODEL_FUNC(self->sampleRate, 1), 											ObjectModelEntryFlags::none },
+	{ "segments",				OBJECT_MODEL_FUNC((int32_t)self->numSegments), 										ObjectModelEntryFlags::none },
+	{ "suggestedDamping",		OBJECT_MODEL_FUNC_IF(self->suggestedFrequency > 0.0, self->suggestedDamping, 2), 	ObjectModelEntryFlags::none },
+	{ "suggestedFrequency",		OBJECT_MODEL_FUNC_IF(self->suggestedFrequency > 0.0, self->suggestedFrequency, 1), 	ObjectModelEntryFlags::none },
+
+	// 1. axes[] members
+	{ "axis",					OBJECT_MODEL_FUNC(self->results[context.GetLastIndex()].letter), 					ObjectModelEntryFlags::none },
+	{ "peaks",					OBJECT_MODEL_FUNC_NOSELF(&peaksArrayDescriptor), 									ObjectModelEntryFlags::none },
+
+	// 2. peaks[] members
+	{ "amplitude",				OBJECT_MODEL_FUNC(self->results[context.GetIndex(1)].peaks[context.GetLastIndex()].amplitude, 4), 	ObjectModelEntryFlags::none },
+	{ "damping",				OBJECT_MODEL_FUNC(self->results[context.GetIndex(1)].peaks[context.GetLastIndex()].damping, 3), 	ObjectModelEntryFlags::none },
+	{ "frequency",				OBJECT_MODEL_FUNC(self->results[context.GetIndex(1)].peaks[context.GetLastIndex()].frequency, 1), 	ObjectModelEntryFlags::none },
+};
+
+constexpr uint8_t ResonanceAnalyser::objectModelTableDescriptor[] = { 3, 5, 2, 3 };
+
+DEFINE_GET_OBJECT_MODEL_TABLE(ResonanceAnalyser)
+
+// The half-power bandwidth in bins of the peak that a pure tone produces after the Hann window is applied. We remove this from the measured bandwidths.
+constexpr float HannWindowBandwidth = 1.44;
+
+constexpr float DefaultSuggestedDamping = 0.1;			// the damping ratio we suggest if the peak is too narrow to measure it, the same as the M593 default
+
+ResonanceAnalyser::ResonanceAnalyser() noexcept
+	: sampleRate(0.0), suggestedFrequency(0.0), suggestedDamping(0.0), numSegments(0), numSamples(0), numAxes(0), boardAddress(0), resultsValid(false)
+{
+	for (size_t i = 0; i < FftSize/2; ++i)
+	{
+		const float angle = (TwoPi * i)/FftSize;
+		cosTable[i] = cosf(angle);
+		sinTable[i] = sinf(angle);
+	}
+}
+
+// Prepare to analyse a new run
+void ResonanceAnalyser::Start(uint8_t p_boardAddress, uint8_t axes) noexcept
+{
+	resultsValid = false;
+	boardAddress = p_boardAddress;
+	numAxes = 0;
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		if (axes & (1u << axis))
+		{
+			results[numAxes].letter = "XYZ"[axis];
+			results[numAxes].numPeaks = 0;
+			for (float& f : spectra[numAxes])
+			{
+				f = 0.0;
+			}
+			++numAxes;
+		}
+	}
+	numSegments = 0;
+	numSamples = 0;
+	sampleRate = suggestedFrequency = suggestedDamping = 0.0;
+}
+
+// Add one sample for each axis. When we have a whole segment, process it and keep the second half of it as the first half of the next segment.
+void ResonanceAnalyser::AddSample(const float values[]) noexcept
+{
+	for (size_t i = 0; i < numAxes; ++i)
+	{
+		samples[i][numSamples] = values[i];
+	}
+	++numSamples;
+	if (numSamples == FftSize)
+	{
+		ProcessSegment();
+		for (size_t i = 0; i < numAxes; ++i)
+		{
+			memcpy(samples[i], samples[i] + FftSize/2, (FftSize/2) * sizeof(float));
+		}
+		numSamples = FftSize/2;
+	}
+}
+
+// Copy a segment of samples to the FFT buffer, removing the mean (which is mostly gravity) and applying a Hann window
+void ResonanceAnalyser::LoadWindowedSegment(const float segment[], float dest[]) const noexcept
+{
+	float sum = 0.0;
+	for (size_t i = 0; i < FftSize; ++i)
+	{
+		sum += segment[i];
+	}
+	const float mean = sum/FftSize;
+	for (size_t i = 0; i < FftSize; ++i)
+	{
+		const float cosine = (i < FftSize/2) ? cosTable[i] : -cosTable[i - FftSize/2];
+		dest[i] = (segment[i] - mean) * 0.5 * (1.0 - cosine);
+	}
+}
+
+// Add the power spectra of the current segment to the totals. We transform two axes at a time by passing one as the real part of the input and the other as the imaginary part.
+void ResonanceAnalyser::ProcessSegment() noexcept
+{
+	for (size_t axis = 0; axis < numAxes; axis += 2)
+	{
+		const bool paired = (axis + 1 < numAxes);
+		LoadWindowedSegment(samples[axis], re);
+		if (paired)
+		{
+			LoadWindowedSegment(samples[axis + 1], im);
+		}
+		else
+		{
+			for (float& f : im)
+			{
+				f = 0.0;
+			}
+		}
+
+		Fft();
+
+		// Separate the spectra of the two inputs using the symmetry of the transform of a real sequence
+		for (size_t k = 0; k < NumBins; ++k)
+		{
+			const size_t nk = (FftSize - k) & (FftSize - 1);
+			const float xr = 0.5 * (re[k] + re[nk]);
+			const float xi = 0.5 * (im[k] - im[nk]);
+			spectra[axis][k] += fsquare(xr) + fsquare(xi);
+			if (paired)
+			{
+				const float yr = 0.5 * (im[k] + im[nk]);
+				const float yi = 0.5 * (re[nk] - re[k]);
+				spectra[axis + 1][k] += fsquare(yr) + fsquare(yi);
+			}
+		}
+	}
+	++numSegments;
+}
+
+// In-place iterative radix-2 FFT of re[] and im[]
+void ResonanceAnalyser::Fft() noexcept
+{
+	// Put the data in bit-reversed order
+	for (size_t i = 1, j = 0; i < FftSize; ++i)
+	{
+		size_t bit = FftSize >> 1;
+		while (j & bit)
+		{
+			j ^= bit;
+			bit >>= 1;
+		}
+		j ^= bit;
+		if (i < j)
+		{
+			std::swap(re[i], re[j]);
+			std::swap(im[i], im[j]);
+		}
+	}
+
+	// Do the butterflies
+	for (size_t length = 2; length <= FftSize; length <<= 1)
+	{
+		const size_t halfLength = length/2;
+		const size_t tableStep = FftSize/length;
+		for (size_t start = 0; start < FftSize; start += length)
+		{
+			for (size_t k = 0; k < halfLength; ++k)
+			{
+				const float wr = cosTable[k * tableStep];
+				const float wi = -sinTable[k * tableStep];
+				const size_t upper = start + k;
+				const size_t lower = upper + halfLength;
+				const float vr = re[lower] * wr - im[lower] * wi;
+				const float vi = re[lower] * wi + im[lower] * wr;
+				re[lower] = re[upper] - vr;
+				im[lower] = im[upper] - vi;
+				re[upper] += vr;
+				im[upper] += vi;
+			}
+		}
+	}
+}
+
+// Find the highest peaks in an average power spectrum
+void ResonanceAnalyser::FindPeaks(const float spectrum[], AxisResult& result) const noexcept
+{
+	result.numPeaks = 0;
+	const float binWidth = sampleRate/FftSize;
+	const size_t firstBin = max<size_t>((size_t)lrintf(ceilf(ResonanceAnalysisMinFrequency/binWidth)), 1);
+	const size_t lastBin = NumBins - 2;
+	if (firstBin > lastBin)
+	{
+		return;
+	}
+
+	float maxPower = 0.0, totalPower = 0.0;
+	for (size_t k = firstBin; k <= lastBin; ++k)
+	{
+		maxPower = max<float>(maxPower, spectrum[k]);
+		totalPower += spectrum[k];
+	}
+	if (maxPower <= 0.0)
+	{
+		return;
+	}
+
+	// Find the local maxima that are high enough, keeping the highest ones in descending order of power.
+	// A peak must stand out from the average power as well as being close enough to the highest one, so that we don't report noise.
+	size_t peakBins[MaxResonancePeaks];
+	size_t numPeaks = 0;
+	const float threshold = max<float>(maxPower * ResonanceAnalysisPeakThreshold, totalPower * ResonanceAnalysisMinProminence/(lastBin + 1 - firstBin));
+	for (size_t k = firstBin; k <= lastBin; ++k)
+	{
+		if (spectrum[k] >= threshold && spectrum[k] > spectrum[k - 1] && spectrum[k] >= spectrum[k + 1])
+		{
+			size_t slot = numPeaks;
+			while (slot != 0 && spectrum[peakBins[slot - 1]] < spectrum[k])
+			{
+				if (slot < MaxResonancePeaks)
+				{
+					peakBins[slot] = peakBins[slot - 1];
+				}
+				--slot;
+			}
+			if (slot < MaxResonancePeaks)
+			{
+				peakBins[slot] = k;
+				if (numPeaks < MaxResonancePeaks)
+				{
+					++numPeaks;
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < numPeaks; ++i)
+	{
+		const size_t k = peakBins[i];
+		Peak& peak = result.peaks[i];
+
+		// Refine the frequency by fitting a parabola through the peak bin and its neighbours
+		const float before = spectrum[k - 1], power = spectrum[k], after = spectrum[k + 1];
+		const float denominator = before - 2.0 * power + after;
+		const float offset = (denominator < 0.0) ? 0.5 * (before - after)/denominator : 0.0;
+		peak.frequency = (k + offset) * binWidth;
+
+		// A sine wave of amplitude A gives a peak of A * FftSize/4 in the transform after the Hann window is applied
+		peak.amplitude = 4.0 * fastSqrtf(power)/FftSize;
+
+		// Estimate the damping ratio from the half-power bandwidth, which is 2 * zeta * f for a lightly damped resonance.
+		// If the peak is too narrow to resolve then we report zero.
+		peak.damping = 0.0;
+		const float halfPower = 0.5 * power;
+		size_t left = k;
+		while (left > 0 && spectrum[left] > halfPower)
+		{
+			--left;
+		}
+		size_t right = k;
+		while (right < NumBins - 1 && spectrum[right] > halfPower)
+		{
+			++right;
+		}
+		if (spectrum[left] <= halfPower && spectrum[right] <= halfPower)
+		{
+			const float leftPos = left + (halfPower - spectrum[left])/(spectrum[left + 1] - spectrum[left]);
+			const float rightPos = right - (halfPower - spectrum[right])/(spectrum[right - 1] - spectrum[right]);
+			const float excessBandwidth = fsquare(rightPos - leftPos) - fsquare(HannWindowBandwidth);
+			if (excessBandwidth > 0.0 && peak.frequency > 0.0)
+			{
+				peak.damping = fastSqrtf(excessBandwidth) * binWidth/(2.0 * peak.frequency);
+			}
+		}
+	}
+	result.numPeaks = numPeaks;
+}
+
+// Finish the analysis at the end of a run. The sample rate is only known accurately at the end of the run.
+// We suggest input shaping for the highest peak on the X and Y axes, or on any axis if neither X nor Y was analysed.
+void ResonanceAnalyser::Finish(float p_sampleRate) noexcept
+{
+	sampleRate = p_sampleRate;
+	const Peak *_ecv_null bestPeak = nullptr;
+	bool bestIsHorizontal = false;
+	for (size_t i = 0; i < numAxes; ++i)
+	{
+		AxisResult& result = results[i];
+		if (numSegments != 0 && sampleRate > 0.0)
+		{
+			for (float& f : spectra[i])
+			{
+				f /= numSegments;
+			}
+			FindPeaks(spectra[i], result);
+		}
+
+		const bool horizontal = (result.letter != 'Z');
+		if (result.numPeaks != 0
+			&& (bestPeak == nullptr || (horizontal && !bestIsHorizontal) || (horizontal == bestIsHorizontal && result.peaks[0].amplitude > bestPeak->amplitude))
+		   )
+		{
+			bestPeak = &result.peaks[0];
+			bestIsHorizontal = horizontal;
+		}
+	}
+
+	if (bestPeak != nullptr)
+	{
+		suggestedFrequency = bestPeak->frequency;
+		suggestedDamping = (bestPeak->damping > 0.0) ? min<float>(bestPeak->damping, 0.99) : DefaultSuggestedDamping;
+	}
+	resultsValid = true;
+}
+
+#endif
+
+// End
@@ -0,0 +1,81 @@
+/*
+ * ResonanceAnalyser.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Spectral analysis of an accelerometer run, so that the user can tune input shaping without downloading and processing the data file.
+ * The samples of each axis are split into segments of ResonanceAnalysisFftSize samples that overlap by half. Each segment has its mean removed
+ * and a Hann window applied, then we take its FFT and add its power spectrum to the total for that axis. At the end of the run we look for peaks
+ * in the average power spectrum and estimate their damping ratios from the half-power bandwidths.
+ */
+
+#ifndef SRC_ACCELEROMETERS_RESONANCEANALYSER_H_
+#define SRC_ACCELEROMETERS_RESONANCEANALYSER_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_RESONANCE_ANALYSIS
+
+#include <ObjectModel/ObjectModel.h>
+
+class ResonanceAnalyser INHERIT_OBJECT_MODEL
+{
+public:
+	ResonanceAnalyser() noexcept;
+
+	void Start(uint8_t p_boardAddress, uint8_t axes) noexcept;			// 'axes' is a bitmap of the accelerometer axes, X in bit 0
+	void AddSample(const float values[]) noexcept;							// 'values' holds one value for each axis being analysed, in axis order
+	void Finish(float sampleRate) noexcept;
+	void Abandon() noexcept { resultsValid = false; }
+
+	bool HasResults(uint8_t p_boardAddress) const noexcept { return resultsValid && boardAddress == p_boardAddress; }
+
+protected:
+	DECLARE_OBJECT_MODEL
+	OBJECT_MODEL_ARRAY(axes)
+	OBJECT_MODEL_ARRAY(peaks)
+
+private:
+	static constexpr size_t FftSize = ResonanceAnalysisFftSize;
+	static constexpr size_t NumBins = FftSize/2 + 1;
+	static_assert(FftSize >= 16 && (FftSize & (FftSize - 1)) == 0);
+
+	struct Peak
+	{
+		float frequency;
+		float damping;
+		float amplitude;													// the amplitude in g of a sine wave that would give the same peak
+	};
+
+	struct AxisResult
+	{
+		char letter;
+		uint8_t numPeaks;
+		Peak peaks[MaxResonancePeaks];
+	};
+
+	void ProcessSegment() noexcept;
+	void LoadWindowedSegment(const float segment[], float dest[]) const noexcept;
+	void Fft() noexcept;
+	void FindPeaks(const float spectrum[], AxisResult& result) const noexcept;
+
+	float samples[3][FftSize];
+	float spectra[3][NumBins];
+	float re[FftSize], im[FftSize];
+	float cosTable[FftSize/2], sinTable[FftSize/2];
+
+	AxisResult results[3];
+	float sampleRate;
+	float suggestedFrequency;
+	float suggestedDamping;
+	unsigned int numSegments;
+	size_t numSamples;														// the number of samples in the current segment
+	uint8_t numAxes;
+	uint8_t boardAddress;
+	volatile bool resultsValid;
+};
+
+#endif
+
+#endif /* SRC_ACCELEROMETERS_RESONANCEANALYSER_H_ */
@@ -14,6 +14,10 @@
 #include <Platform/Platform.h>
 #include <GCodes/GCodeBuffer/GCodeBuffer.h>
 
+#if SUPPORT_RESONANCE_ANALYSIS
+# include <Accelerometers/Accelerometers.h>
+#endif
+
 #if SUPPORT_OBJECT_MODEL
 
 // Object model table and functions
@@ -59,6 +63,9 @@ constexpr ObjectModelTableEntry ExpansionManager::objectModelTable[] =
 	{ "min",				OBJECT_MODEL_FUNC(self->FindIndexedBoard(context.GetLastIndex()).v12.minimum, 1),								ObjectModelEntryFlags::none },
 
 	// 4. accelerometer members
+#if SUPPORT_RESONANCE_ANALYSIS
+	{ "analysis",			OBJECT_MODEL_FUNC(Accelerometers::GetRemoteAnalysis(self->FindIndexedBoardAddress(context.GetLastIndex()))),	ObjectModelEntryFlags::none },
+#endif
 	{ "points",				OBJECT_MODEL_FUNC((int32_t)self->FindIndexedBoard(context.GetLastIndex()).accelerometerLastRunDataPoints),		ObjectModelEntryFlags::none },
 	{ "runs",				OBJECT_MODEL_FUNC((int32_t)self->FindIndexedBoard(context.GetLastIndex()).accelerometerRuns),					ObjectModelEntryFlags::none },
 
@@ -74,7 +81,7 @@ constexpr uint8_t ExpansionManager::objectModelTableDescriptor[] =
 	3,				// section 1: mcuTemp
 	3,				// section 2: vIn
 	3,				// section 3: v12
-	2,				// section 4: accelerometer
+	2 + SUPPORT_RESONANCE_ANALYSIS,	// section 4: accelerometer
 	2				// section 5: closed loop
 };
 
@@ -69,6 +69,9 @@ protected:
 
 private:
 	const ExpansionBoardData& FindIndexedBoard(unsigned int index) const noexcept;
+#if SUPPORT_RESONANCE_ANALYSIS
+	CanAddress FindIndexedBoardAddress(unsigned int index) const noexcept { return (CanAddress)(&FindIndexedBoard(index) - boards); }
+#endif
 	void UpdateBoardState(CanAddress address, BoardState newState) noexcept;
 
 	unsigned int numExpansionBoards;
@@ -72,6 +72,44 @@ constexpr uint32_t AuxTimeout = 2000;					// timeout in ms for PanelDue replies
 // Conditional GCode support
 constexpr unsigned int MaxBlockIndent = 10;				// maximum indentation of GCode. Each level of indentation introduced a new block.
 
+// Macro expression cache, used when SUPPORT_MACRO_CACHE is set
+constexpr size_t MacroCacheMaxMemory = 8 * 1024;		// the maximum amount of RAM used to hold compiled expressions from macro files
+constexpr size_t MaxCachedMacroFiles = 16;				// the maximum number of macro files that we cache expressions from
+constexpr size_t MaxCompiledExpressionInstructions = 64;	// expressions that need more instructions than this are not cached
+constexpr size_t MaxCompiledExpressionConstants = 16;	// the maximum number of numeric and string literals in a cached expression
+constexpr size_t MaxCompiledExpressionStringLength = 256;	// the maximum total length of the identifiers in a cached expression including null terminators
+constexpr size_t MaxCompiledExpressionStackDepth = 8;	// the maximum number of intermediate values when evaluating a cached expression
+constexpr size_t MaxCompiledExpressionVariables = 8;	// the maximum number of variable references in a cached expression that remember where the variable was found
+
+// Variable sets
+constexpr size_t MaxArrayVariableLength = 1024;			// the maximum number of elements in an array held in a variable
+constexpr size_t MaxArrayVariableIndices = 4;			// the maximum number of indices when assigning to an element of a nested array
+constexpr size_t MaxUnhashedVariables = 8;				// when a set of variables grows larger than this we index it using a hash table
+constexpr size_t InitialVariableHashBuckets = 16;		// the initial size of the hash table, must be a power of 2
+constexpr size_t MaxVariableHashBuckets = 1024;			// the hash table is doubled in size when there are more than two variables per bucket, up to this size
+
+// Object model table entry cache, used when SUPPORT_OBJECT_MODEL_CACHE is set
+constexpr size_t ObjectModelCacheSize = 256;			// the number of slots in the cache, must be a power of 2
+
+// Table of object model value fingerprints, used when SUPPORT_OBJECT_MODEL_DELTAS is set
+constexpr size_t ObjectModelChangeTableSize = 1024;		// the number of values whose changes we can track, must be a power of 2. Each one uses 12 bytes of RAM.
+constexpr size_t ObjectModelChangeTableMaxProbes = 8;	// how many slots we search for a value before we replace one
+
+// Thermistor and PT1000 lookup tables, used when SUPPORT_THERMISTOR_TABLES is set
+constexpr unsigned int DefaultThermistorTableEntries = 128;	// the default number of entries in the table of each sensor, each of which uses 6 bytes of RAM
+constexpr unsigned int MinThermistorTableEntries = 16;
+constexpr unsigned int MaxThermistorTableEntries = 512;
+constexpr float ThermistorTableMinTemperature = -50.0;	// the table covers this range of temperatures. Readings outside it are converted without using the table.
+constexpr float ThermistorTableMaxTemperature = 500.0;
+
+// Model predictive heater control, used when SUPPORT_MPC_HEATER_CONTROL is set
+constexpr size_t MpcMaxPwmHistorySlots = 32;			// the number of slots used to hold the PWM applied during the dead time. Each slot covers one or more temperature samples.
+constexpr float MpcDisturbanceGain = 0.05;				// the fraction of the model prediction error that is added to the disturbance estimate on each temperature sample
+
+// Heater auto tuning
+constexpr size_t MaxHeatersTunedTogether = 8;			// the maximum number of heaters that a single M303 command can tune at the same time
+constexpr float DefaultTuningStartInterval = 30.0;		// the default time in seconds between turning on heaters that are tuned together, so that we can measure thermal coupling
+
 // Default Z probe values
 
 // The maximum number of probe points is constrained by RAM usage:
@@ -201,6 +239,11 @@ constexpr size_t RESERVED_OUTPUT_BUFFERS = 2;           // Number of reserved ou
 # error
 #endif
 
+// Object model report streaming, used when SUPPORT_OBJECT_MODEL_STREAMING is set
+constexpr size_t ObjectModelStreamChunkSize = 4 * OUTPUT_BUFFER_SIZE;			// how much of a report we generate before we hand it to the network
+constexpr size_t ObjectModelStreamMaxQueuedData = 2 * ObjectModelStreamChunkSize;	// how much generated data may wait to be sent before we stop generating more
+constexpr uint32_t ObjectModelStreamTimeout = 2000;		// how long in milliseconds we wait for the network to take the report before we give up
+
 constexpr size_t maxQueuedCodes = 16;					// How many codes can be queued?
 
 // These two definitions are only used if TRACK_OBJECT_NAMES is defined, however that definition isn't available in this file
@@ -231,11 +274,21 @@ constexpr float MinArcSegmentLength = 0.1;				// G2 and G3 arc movement commands
 constexpr float MaxArcSegmentLength = 1.0;				// G2 and G3 arc movement commands get split into segments at most this long
 constexpr float MinArcSegmentsPerSec = 200.0;
 constexpr float SegmentsPerFulArcCalculation = 8.0;		// we do the full sine/cosine calculation every this number of segments
+constexpr float MinNativeArcPieceAngle = 0.001;			// when executing native arcs, we don't create pieces smaller than this many radians
+constexpr size_t ArcAsinTableIntervals = 256;			// number of intervals in the arcsine table that the step ISR uses for native arcs
+
+constexpr float DefaultMeshChordTolerance = 0.0;		// the default permitted bed compensation error when merging mesh segments, in mm. Zero means divide moves at every grid cell.
+
+constexpr size_t MaxKinematicsLookupTableNodes = 2500;	// the maximum number of grid points in an inverse kinematics lookup table, each of which needs 8 bytes
+constexpr float MinKinematicsLookupTableSpacing = 0.5;	// the minimum grid spacing of an inverse kinematics lookup table in mm
+constexpr float DefaultKinematicsLookupTableMaxError = 0.01;	// the default maximum interpolation error in a cell of an inverse kinematics lookup table in degrees or mm, about one microstep of a typical SCARA arm
 
 constexpr uint32_t DefaultIdleTimeout = 30000;			// Milliseconds
 constexpr float DefaultIdleCurrentFactor = 0.3;			// Proportion of normal motor current that we use for idle hold
 
 constexpr uint32_t DefaultGracePeriod = 10;				// how long we wait for more moves to become available before starting movement
+constexpr size_t MaxInputShapers = 3;					// the default input shaper plus up to two that are dedicated to particular axes
+constexpr size_t LookaheadWindowSize = 40;				// the maximum number of moves whose speeds we adjust in one lookahead pass
 
 constexpr float DefaultNonlinearExtrusionLimit = 0.2;	// Maximum additional commanded extrusion to compensate for nonlinearity
 constexpr size_t NumRestorePoints = 6;					// Number of restore points, must be at least 3
@@ -277,6 +330,18 @@ constexpr size_t MAX_FILES = 10;						// Must be large enough to handle the max
 
 constexpr size_t FILE_BUFFER_SIZE = 128;
 
+// File read-ahead, used when SUPPORT_FILE_READ_AHEAD is set
+constexpr size_t FileReadAheadBlockSize = 2048;			// the size of each of the two blocks that we read ahead of the G-code parser, must be a multiple of the SD card sector size
+constexpr size_t FileReadAheadSectorSize = 512;			// we align reads to this boundary in the file so that FatFS can read whole sectors straight into our blocks
+constexpr uint32_t FileReadAheadWaitTime = 100;			// how long in milliseconds we wait for the read-ahead task each time before checking whether it has finished
+
+// Accelerometer resonance analysis, used when SUPPORT_RESONANCE_ANALYSIS is set
+constexpr size_t ResonanceAnalysisFftSize = 512;		// the number of samples in each FFT segment, must be a power of 2
+constexpr size_t MaxResonancePeaks = 3;					// the maximum number of resonance peaks we report for each axis
+constexpr float ResonanceAnalysisMinFrequency = 10.0;	// we ignore peaks below this frequency, which are caused by the motion itself rather than by ringing
+constexpr float ResonanceAnalysisPeakThreshold = 0.1;	// we ignore peaks whose power is less than this fraction of the power of the highest peak on the same axis
+constexpr float ResonanceAnalysisMinProminence = 5.0;	// we ignore peaks whose power is less than this multiple of the average power on the same axis
+
 constexpr size_t MaxThumbnails = 4;						// Maximum number of thumbnail images read from the job file that we store and report
 
 // Webserver stuff
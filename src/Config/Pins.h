@@ -218,6 +218,62 @@
 # define SUPPORT_ACCELEROMETERS	0
 #endif
 
+#ifndef SUPPORT_STEP_BUFFERING
+# define SUPPORT_STEP_BUFFERING	0					// set nonzero to calculate step times in advance in the Move task, so that the step ISR has less to do
+#endif
+
+#ifndef SUPPORT_NATIVE_ARCS
+# define SUPPORT_NATIVE_ARCS	0					// set nonzero to execute G2/G3 arcs as true arc moves on Cartesian machines. Requires a processor with a hardware FPU.
+#endif
+
+#ifndef SUPPORT_MACRO_CACHE
+# define SUPPORT_MACRO_CACHE		0				// set nonzero to cache compiled versions of the meta command expressions in macro files. Requires mass storage.
+#endif
+
+#ifndef SUPPORT_OBJECT_MODEL_CACHE
+# define SUPPORT_OBJECT_MODEL_CACHE	0				// set nonzero to cache the object model table entries found when resolving paths
+#endif
+
+#ifndef SUPPORT_OBJECT_MODEL_CBOR
+# define SUPPORT_OBJECT_MODEL_CBOR	0				// set nonzero to support object model reports in CBOR format as well as JSON
+#endif
+
+#ifndef SUPPORT_OBJECT_MODEL_DELTAS
+# define SUPPORT_OBJECT_MODEL_DELTAS	0			// set nonzero to support object model queries that return only the values changed since a previous query
+#endif
+
+#ifndef SUPPORT_OBJECT_MODEL_STREAMING
+# define SUPPORT_OBJECT_MODEL_STREAMING	0		// set nonzero to send object model reports to HTTP clients while they are being generated
+#endif
+
+#ifndef SUPPORT_FILE_READ_AHEAD
+# define SUPPORT_FILE_READ_AHEAD	0				// set nonzero to read G-code files from SD card in a separate task ahead of the G-code parser
+#endif
+
+#ifndef SUPPORT_FAST_MOVE_PARSER
+# define SUPPORT_FAST_MOVE_PARSER	0				// set nonzero to decode plain G0/G1/G2/G3 commands in a single pass
+#endif
+
+#ifndef SUPPORT_BINARY_GCODE
+# define SUPPORT_BINARY_GCODE		0				// set nonzero to support printing binary G-code files
+#endif
+
+#ifndef SUPPORT_RESONANCE_ANALYSIS
+# define SUPPORT_RESONANCE_ANALYSIS	0			// set nonzero to support spectral analysis of accelerometer runs on the board. Requires SUPPORT_ACCELEROMETERS.
+#endif
+
+#ifndef SUPPORT_THERMISTOR_TABLES
+# define SUPPORT_THERMISTOR_TABLES	0				// set nonzero to convert thermistor and PT1000 readings to temperatures using lookup tables built when the sensor is configured
+#endif
+
+#ifndef SUPPORT_MPC_HEATER_CONTROL
+# define SUPPORT_MPC_HEATER_CONTROL	0			// set nonzero to support model predictive control of local heaters (M307 B2)
+#endif
+
+#ifndef SUPPORT_KINEMATICS_LOOKUP_TABLES
+# define SUPPORT_KINEMATICS_LOOKUP_TABLES	0		// set nonzero to allow SCARA, five-bar SCARA and polar kinematics to use an interpolated inverse kinematics table
+#endif
+
 // Optional kinematics support, to allow us to reduce flash memory usage
 #ifndef SUPPORT_LINEAR_DELTA
 # define SUPPORT_LINEAR_DELTA	1
@@ -45,6 +45,19 @@ constexpr uint32_t IAP_IMAGE_START = 0x20458000;		// last 32kb of RAM
 #define SUPPORT_FTP				1
 #define SUPPORT_TELNET			1
 #define SUPPORT_ASYNC_MOVES		1
+#define SUPPORT_NATIVE_ARCS		1					// execute G2/G3 arcs as a few true arc moves instead of many short straight segments
+#define SUPPORT_KINEMATICS_LOOKUP_TABLES	1		// allow M669 to build an interpolated inverse kinematics table for SCARA and polar machines
+#define SUPPORT_MACRO_CACHE		1					// cache compiled versions of the meta command expressions in macro files
+#define SUPPORT_OBJECT_MODEL_CACHE	1					// cache the object model table entries found when resolving paths
+#define SUPPORT_OBJECT_MODEL_DELTAS	1					// support object model queries that return only the values changed since a previous query
+#define SUPPORT_OBJECT_MODEL_CBOR	1					// support object model reports in CBOR format as well as JSON
+#define SUPPORT_OBJECT_MODEL_STREAMING	1				// send object model reports to HTTP clients while they are being generated
+#define SUPPORT_FILE_READ_AHEAD	1					// read G-code files from SD card in a separate task ahead of the G-code parser
+#define SUPPORT_FAST_MOVE_PARSER	1					// decode plain G0/G1/G2/G3 commands in a single pass
+#define SUPPORT_BINARY_GCODE		1					// support printing binary G-code files
+#define SUPPORT_RESONANCE_ANALYSIS	1				// support spectral analysis of accelerometer runs on the board
+#define SUPPORT_THERMISTOR_TABLES	1				// convert thermistor and PT1000 readings to temperatures using lookup tables
+#define SUPPORT_MPC_HEATER_CONTROL	1				// support model predictive control of local heaters
 #define ALLOCATE_DEFAULT_PORTS	0
 #define TRACK_OBJECT_NAMES		1
 
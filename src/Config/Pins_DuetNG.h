@@ -92,6 +92,7 @@ constexpr uint32_t IAP_IMAGE_START = 0x20018000;	// IAP is loaded into the last
 #endif
 
 #define SUPPORT_ASYNC_MOVES		1
+#define SUPPORT_NATIVE_ARCS		1					// execute G2/G3 arcs as a few true arc moves instead of many short straight segments
 #define ALLOCATE_DEFAULT_PORTS	0
 #define TRACK_OBJECT_NAMES		1
 
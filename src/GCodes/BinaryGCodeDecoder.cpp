@@ -0,0 +1,326 @@
+/*
+ * BinaryGCodeDecoder.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "BinaryGCodeDecoder.h"
+
+#if SUPPORT_BINARY_GCODE
+
+#include <Storage/CRC32.h>
+#include <General/Portability.h>
+
+// Values of the compression field in a block header
+constexpr uint8_t CompressionNone = 0;
+constexpr uint8_t CompressionLz4 = 1;
+
+// Record types
+constexpr uint8_t RecordText = 0x00;
+constexpr uint8_t RecordG0 = 0x01;
+constexpr uint8_t RecordG3 = 0x04;
+
+constexpr char MoveParameterLetters[] = "XYZEFIJ";
+constexpr unsigned int MoveParameterEIndex = 3;
+
+/*static*/ bool BinaryGCodeDecoder::IsFileHeader(const char *_ecv_array data, size_t length, size_t& metadataLength) noexcept
+{
+	if (length < BinaryGCodeFileHeaderSize || LoadLE32(data) != BinaryGCodeMagic || LoadLE16(data + 4) != BinaryGCodeVersion)
+	{
+		return false;
+	}
+	metadataLength = LoadLE32(data + 8);
+	return metadataLength <= BinaryGCodeMaxMetadataLength;
+}
+
+/*static*/ FilePosition BinaryGCodeDecoder::GetDataStart(size_t metadataLength) noexcept
+{
+	return (BinaryGCodeFileHeaderSize + metadataLength + BinaryGCodeBlockSize - 1) & ~(BinaryGCodeBlockSize - 1);
+}
+
+void BinaryGCodeDecoder::Clear() noexcept
+{
+	blockPosition = 0;
+	decodedLength = readPointer = 0;
+	numRecords = recordNumber = 0;
+}
+
+// Decode the block that has been read into the block buffer from the specified position in the file.
+// Return nullptr if successful, else an error message.
+const char *_ecv_null BinaryGCodeDecoder::LoadBlock(size_t length, FilePosition position) noexcept
+{
+	Clear();
+	if (length < BinaryGCodeBlockHeaderSize)
+	{
+		return "incomplete block header";
+	}
+
+	const size_t payloadLength = LoadLE16(rawBlock);
+	const size_t newDecodedLength = LoadLE16(rawBlock + 2);
+	const unsigned int newNumRecords = LoadLE16(rawBlock + 4);
+	const uint8_t compression = (uint8_t)rawBlock[6];
+	if (payloadLength > length - BinaryGCodeBlockHeaderSize)
+	{
+		return "incomplete block";
+	}
+	if (newDecodedLength > BinaryGCodeMaxDecodedLength || newNumRecords == 0 || newNumRecords > payloadLength)
+	{
+		return "bad block header";
+	}
+
+	const char *_ecv_array const payload = rawBlock + BinaryGCodeBlockHeaderSize;
+	switch (compression)
+	{
+	case CompressionNone:
+		if (payloadLength != newDecodedLength)
+		{
+			return "bad block header";
+		}
+		memcpy(decoded, payload, payloadLength);
+		break;
+
+	case CompressionLz4:
+		decodedLength = newDecodedLength;
+		if (!Decompress(payload, payloadLength))
+		{
+			decodedLength = 0;
+			return "bad compressed data";
+		}
+		break;
+
+	default:
+		return "unsupported compression";
+	}
+
+	CRC32 crc;
+	crc.Update(decoded, newDecodedLength);
+	if (crc.Get() != LoadLE32(rawBlock + 8))
+	{
+		return "CRC error";
+	}
+
+	blockPosition = position;
+	decodedLength = newDecodedLength;
+	numRecords = newNumRecords;
+	for (int64_t& val : moveParameterValues)
+	{
+		val = 0;
+	}
+	return nullptr;
+}
+
+// Decompress data in LZ4 block format into the decoded data buffer. On entry, decodedLength is the expected length of the decompressed data.
+// Each sequence is a token byte holding the number of literals and the match length, the literals, then a 2-byte offset back into the data already decoded.
+// The last sequence has literals only.
+bool BinaryGCodeDecoder::Decompress(const char *_ecv_array payload, size_t payloadLength) noexcept
+{
+	const uint8_t *_ecv_array in = reinterpret_cast<const uint8_t *_ecv_array>(payload);
+	const uint8_t *_ecv_array const inEnd = in + payloadLength;
+	size_t out = 0;
+	while (in < inEnd)
+	{
+		const uint8_t token = *in++;
+
+		// Copy the literals
+		size_t literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (in == inEnd)
+				{
+					return false;
+				}
+				b = *in++;
+				literalLength += b;
+			} while (b == 255);
+		}
+		if (literalLength > (size_t)(inEnd - in) || literalLength > decodedLength - out)
+		{
+			return false;
+		}
+		memcpy(decoded + out, in, literalLength);
+		in += literalLength;
+		out += literalLength;
+
+		if (in == inEnd)
+		{
+			break;											// this was the last sequence
+		}
+
+		// Copy the match
+		if (inEnd - in < 2)
+		{
+			return false;
+		}
+		const size_t offset = in[0] | ((size_t)in[1] << 8);
+		in += 2;
+		size_t matchLength = (token & 0x0F) + 4;
+		if ((token & 0x0F) == 15)
+		{
+			uint8_t b;
+			do
+			{
+				if (in == inEnd)
+				{
+					return false;
+				}
+				b = *in++;
+				matchLength += b;
+			} while (b == 255);
+		}
+		if (offset == 0 || offset > out || matchLength > decodedLength - out)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < matchLength; ++i)			// the match may overlap the data being written, so copy one byte at a time
+		{
+			decoded[out] = decoded[out - offset];
+			++out;
+		}
+	}
+	return out == decodedLength;
+}
+
+bool BinaryGCodeDecoder::ReadVarint(uint64_t& val) noexcept
+{
+	val = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7)
+	{
+		if (readPointer == decodedLength)
+		{
+			return false;
+		}
+		const uint8_t b = (uint8_t)decoded[readPointer++];
+		val |= (uint64_t)(b & 0x7F) << shift;
+		if ((b & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Append a value held in units of 10^-decimals to a line of G-code, without trailing zeros after the decimal point
+static char *_ecv_array AppendScaledValue(char *_ecv_array p, int64_t val, unsigned int decimals) noexcept
+{
+	uint64_t magnitude;
+	if (val < 0)
+	{
+		*p++ = '-';
+		magnitude = -(uint64_t)val;
+	}
+	else
+	{
+		magnitude = (uint64_t)val;
+	}
+
+	uint32_t scale = 1;
+	for (unsigned int i = 0; i < decimals; ++i)
+	{
+		scale *= 10;
+	}
+	uint64_t integerPart = magnitude / scale;
+	uint32_t fractionalPart = (uint32_t)(magnitude % scale);
+
+	char digits[20];
+	size_t numDigits = 0;
+	do
+	{
+		digits[numDigits++] = (char)('0' + (unsigned int)(integerPart % 10));
+		integerPart /= 10;
+	} while (integerPart != 0);
+	while (numDigits != 0)
+	{
+		*p++ = digits[--numDigits];
+	}
+
+	if (fractionalPart != 0)
+	{
+		*p++ = '.';
+		do
+		{
+			scale /= 10;
+			*p++ = (char)('0' + fractionalPart/scale);
+			fractionalPart %= scale;
+		} while (fractionalPart != 0);
+	}
+	return p;
+}
+
+// Decode the next record in the block. Return a pointer to the resulting line of G-code and set 'length' to its length, or return nullptr if the record is bad.
+// The line is not terminated by a newline or null character.
+const char *_ecv_array _ecv_null BinaryGCodeDecoder::DecodeRecord(size_t& length) noexcept
+{
+	if (!HaveRecord() || readPointer == decodedLength)
+	{
+		return nullptr;
+	}
+
+	++recordNumber;
+	const uint8_t recordType = (uint8_t)decoded[readPointer++];
+	if (recordType == RecordText)
+	{
+		uint64_t textLength;
+		if (!ReadVarint(textLength) || textLength > decodedLength - readPointer)
+		{
+			return nullptr;
+		}
+		const char *_ecv_array const text = decoded + readPointer;
+		length = (size_t)textLength;
+		if (memchr(text, '\n', length) != nullptr || memchr(text, '\r', length) != nullptr || memchr(text, 0, length) != nullptr)
+		{
+			return nullptr;											// the line ending is added by the caller, so the text must not contain one
+		}
+		readPointer += length;
+		return text;
+	}
+
+	if (recordType > RecordG3 || readPointer == decodedLength)
+	{
+		return nullptr;
+	}
+
+	const uint8_t parametersPresent = (uint8_t)decoded[readPointer++];
+	char *_ecv_array p = moveLine;
+	*p++ = 'G';
+	*p++ = (char)('0' + (recordType - RecordG0));
+	for (unsigned int i = 0; i < NumMoveParameters; ++i)
+	{
+		if (parametersPresent & (1u << i))
+		{
+			uint64_t zigzag;
+			if (!ReadVarint(zigzag))
+			{
+				return nullptr;
+			}
+			moveParameterValues[i] += (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+			*p++ = ' ';
+			*p++ = MoveParameterLetters[i];
+			p = AppendScaledValue(p, moveParameterValues[i], (i == MoveParameterEIndex) ? 5 : 3);
+		}
+	}
+	length = p - moveLine;
+	return moveLine;
+}
+
+// Skip some records, for example because we are resuming a print part way through this block. Stop at the end of the block.
+bool BinaryGCodeDecoder::SkipRecords(unsigned int count) noexcept
+{
+	while (count != 0 && HaveRecord())
+	{
+		size_t length;
+		if (DecodeRecord(length) == nullptr)
+		{
+			return false;
+		}
+		--count;
+	}
+	return true;
+}
+
+#endif
+
+// End
@@ -0,0 +1,83 @@
+/*
+ * BinaryGCodeDecoder.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Decoder for binary G-code files. A binary G-code file is a compact alternative to a sliced G-code file. It is decoded one block at a time
+ * into lines of G-code that are passed to the normal parser. All values are little-endian. The layout is:
+ *
+ *  File header (16 bytes): magic "RRBG", uint16 version (1), uint16 reserved (0), uint32 metadata length, uint32 reserved (0)
+ *  Metadata: lines of the form "key=value\n", at most BinaryGCodeMaxMetadataLength bytes. The keys that FileInfoParser understands are
+ *    generatedBy, layerHeight, objectHeight, numLayers, printTime, simulatedTime and filament (comma-separated lengths in mm).
+ *  Data blocks: the first one starts at the first multiple of BinaryGCodeBlockSize after the metadata, and each one occupies BinaryGCodeBlockSize bytes
+ *    of the file except that the last one may be shorter. Each block is a 12-byte header followed by the payload and padding. The header is:
+ *      uint16 payload length, uint16 decoded length (at most BinaryGCodeMaxDecodedLength), uint16 number of records (at least 1 and at most the payload length),
+ *      uint8 compression (0 = none, 1 = LZ4 block format), uint8 reserved (0), uint32 CRC32 of the decoded payload.
+ *
+ * The decoded payload is a sequence of records:
+ *  0x00, varint length, characters: a line of G-code without the line ending
+ *  0x01 to 0x04: a G0, G1, G2 or G3 command. This is followed by a byte holding a bitmap of the parameters present (X Y Z E F I J in bits 0 to 6),
+ *    then for each parameter present the change in its value since the last time it was present in this block (or from zero) as a zigzag-encoded varint.
+ *    E is stored in units of 0.00001 and the other parameters in units of 0.001.
+ *
+ * Each block can be decoded without reference to any other, so that printing can be resumed part way through a file. The file position that we report
+ * for a command is the position of its block's payload plus the index of its record in the block. This always lies within the block, so given the position
+ * we can find the block and the number of records to skip.
+ */
+
+#ifndef SRC_GCODES_BINARYGCODEDECODER_H_
+#define SRC_GCODES_BINARYGCODEDECODER_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_BINARY_GCODE
+
+constexpr uint32_t BinaryGCodeMagic = 0x47425252;							// "RRBG" read as a little-endian 32-bit integer
+constexpr uint16_t BinaryGCodeVersion = 1;
+constexpr size_t BinaryGCodeFileHeaderSize = 16;
+constexpr size_t BinaryGCodeMaxMetadataLength = 1024 - BinaryGCodeFileHeaderSize;
+constexpr size_t BinaryGCodeBlockSize = 512;								// must be a power of 2
+constexpr size_t BinaryGCodeBlockHeaderSize = 12;
+constexpr size_t BinaryGCodeMaxDecodedLength = 4096;
+
+class BinaryGCodeDecoder
+{
+public:
+	BinaryGCodeDecoder() noexcept { Clear(); }
+
+	// Check whether some data read from the start of a file is the header of a binary G-code file. If it is, return the metadata length.
+	static bool IsFileHeader(const char *_ecv_array data, size_t length, size_t& metadataLength) noexcept;
+
+	// Return the position of the first data block in a binary G-code file
+	static FilePosition GetDataStart(size_t metadataLength) noexcept;
+
+	void Clear() noexcept;
+	char *_ecv_array GetBlockBuffer() noexcept { return rawBlock; }
+	const char *_ecv_null LoadBlock(size_t length, FilePosition position) noexcept;	// decode the block that has been read into the block buffer
+	bool HaveRecord() const noexcept { return recordNumber < numRecords; }
+	FilePosition GetRecordPosition() const noexcept { return blockPosition + BinaryGCodeBlockHeaderSize + recordNumber; }
+	const char *_ecv_array _ecv_null DecodeRecord(size_t& length) noexcept;			// decode the next record into a line of G-code
+	bool SkipRecords(unsigned int count) noexcept;
+
+private:
+	static constexpr size_t NumMoveParameters = 7;
+	static constexpr size_t MaxMoveLineLength = 2 + NumMoveParameters * 30;			// "G1" plus the parameters, each at most space, letter, sign, 20 digits, point and 5 decimals
+
+	bool ReadVarint(uint64_t& val) noexcept;
+	bool Decompress(const char *_ecv_array payload, size_t payloadLength) noexcept;
+
+	FilePosition blockPosition;
+	size_t decodedLength;
+	size_t readPointer;
+	unsigned int numRecords;
+	unsigned int recordNumber;
+	int64_t moveParameterValues[NumMoveParameters];
+	char moveLine[MaxMoveLineLength];
+	alignas(4) char rawBlock[BinaryGCodeBlockSize];
+	char decoded[BinaryGCodeMaxDecodedLength];
+};
+
+#endif
+
+#endif /* SRC_GCODES_BINARYGCODEDECODER_H_ */
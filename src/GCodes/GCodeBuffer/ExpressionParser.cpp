@@ -13,6 +13,9 @@
 #include <General/NamedEnum.h>
 #include <General/NumericConverter.h>
 #include <Hardware/ExceptionHandlers.h>
+#if SUPPORT_MACRO_CACHE
+# include <GCodes/GCodes.h>
+#endif
 
 #include <limits>
 
@@ -33,12 +36,15 @@ namespace StackUsage
 
 // These can't be declared locally inside ParseIdentifierExpression because NamedEnum includes static data
 NamedEnum(NamedConstant, unsigned int, _false, iterations, line, _null, pi, _result, _true);
-NamedEnum(Function, unsigned int, abs, acos, asin, atan, atan2, cos, datetime, degrees, exists, floor, isnan, max, min, mod, radians, random, sin, sqrt, tan);
+NamedEnum(Function, unsigned int, abs, acos, asin, atan, atan2, cos, datetime, degrees, exists, floor, interpolate, isnan, max, min, mod, radians, random, sin, sqrt, sum, tan, vector);
 
 const char * const InvalidExistsMessage = "invalid 'exists' expression";
 
 ExpressionParser::ExpressionParser(const GCodeBuffer& p_gb, const char *text, const char *textLimit, int p_column) noexcept
 	: currentp(text), startp(text), endp(textLimit), gb(p_gb), column(p_column)
+#if SUPPORT_MACRO_CACHE
+	  , compiler(nullptr), macroCacheFileId(0), macroCacheFilePos(0)
+#endif
 {
 }
 
@@ -59,7 +65,16 @@ ExpressionValue ExpressionParser::Parse(bool evaluate) THROWS(GCodeException)
 {
 	obsoleteField.Clear();
 	ExpressionValue result;
-	ParseInternal(result, evaluate, 0);
+#if SUPPORT_MACRO_CACHE
+	if (macroCacheFileId != 0 && evaluate)
+	{
+		ParseUsingMacroCache(result);
+	}
+	else
+#endif
+	{
+		ParseInternal(result, evaluate, 0);
+	}
 	if (!obsoleteField.IsEmpty())
 	{
 		reprap.GetPlatform().MessageF(WarningMessage, "obsolete object model field %s queried\n", obsoleteField.c_str());
@@ -67,6 +82,148 @@ ExpressionValue ExpressionParser::Parse(bool evaluate) THROWS(GCodeException)
 	return result;
 }
 
+#if SUPPORT_MACRO_CACHE
+
+// Evaluate an expression in a macro file. If we have already compiled it then execute the compiled version, otherwise compile it while we parse it.
+void ExpressionParser::ParseUsingMacroCache(ExpressionValue& rslt) THROWS(GCodeException)
+{
+	MacroCache& cache = reprap.GetGCodes().GetMacroCache();
+	const CompiledExpression *const expr = cache.Find(macroCacheFileId, macroCacheFilePos, startp, endp);
+	if (expr != nullptr)
+	{
+		Execute(*expr, rslt);
+	}
+	else
+	{
+		compiler = cache.StartCompiling();
+		ParseInternal(rslt, true, 0);
+		compiler = nullptr;
+		cache.FinishCompiling(macroCacheFileId, macroCacheFilePos, startp, endp, currentp - startp);
+	}
+}
+
+// Execute a compiled expression. This must behave in the same way as the text parser did when it compiled the expression.
+// Before executing each instruction we set 'currentp' to where the text parser was when it performed that operation, so that any errors are reported at the same column.
+void ExpressionParser::Execute(const CompiledExpression& expr, ExpressionValue& rslt) THROWS(GCodeException)
+{
+	ExpressionValue stack[MaxCompiledExpressionStackDepth];
+	size_t sp = 0;
+	size_t pc = 0;
+	while (pc < expr.GetNumInstructions())
+	{
+		const ExpressionInstruction& instr = expr.GetInstruction(pc);
+		++pc;
+		currentp = startp + instr.offset;
+		switch (instr.opcode)
+		{
+		case ExpressionOpcode::pushConstant:
+			stack[sp] = expr.GetConstant(instr.operand);
+			++sp;
+			break;
+
+		case ExpressionOpcode::pushNamedConstant:
+			GetNamedConstantValue(stack[sp], instr.arg);
+			++sp;
+			break;
+
+		case ExpressionOpcode::pushIdentifier:
+			{
+				const size_t numIndices = instr.arg & CompiledIdentifierIndicesMask;
+				ObjectExplorationContext context(&gb, (instr.arg & CompiledIdentifierLengthFlag) != 0, (instr.arg & CompiledIdentifierExistsFlag) != 0,
+													gb.GetLineNumber(), (column < 0) ? column : column + instr.identifierOffset);
+				sp -= numIndices;
+				for (size_t i = 0; i < numIndices; ++i)
+				{
+					context.ProvideIndex(stack[sp + i].iVal);
+				}
+				GetIdentifierValue(stack[sp], expr.GetString(instr.operand), context, expr.GetVariableHandle(instr));
+				++sp;
+			}
+			break;
+
+		case ExpressionOpcode::checkIndex:
+			if (stack[sp - 1].GetType() != TypeCode::Int32)
+			{
+				ThrowParseException("expected integer expression");
+			}
+			break;
+
+		case ExpressionOpcode::unaryOperator:
+			ApplyUnaryOperator(instr.arg, stack[sp - 1], true);
+			break;
+
+		case ExpressionOpcode::binaryOperator:
+			--sp;
+			ApplyBinaryOperator(instr.arg, instr.operand != 0, stack[sp - 1], stack[sp], true);
+			break;
+
+		case ExpressionOpcode::callFunction:
+			if (instr.operand != 0)
+			{
+				--sp;
+				ApplyFunction(instr.arg, stack[sp - 1], &stack[sp], true);
+			}
+			else
+			{
+				ApplyFunction(instr.arg, stack[sp - 1], nullptr, true);
+			}
+			break;
+
+		case ExpressionOpcode::convertToBool:
+			ConvertToBool(stack[sp - 1], true);
+			break;
+
+		case ExpressionOpcode::makeArray:
+			MakeArray(stack[sp - 1]);
+			break;
+
+		case ExpressionOpcode::appendToArray:
+			--sp;
+			AppendToArray(stack[sp - 1], stack[sp]);
+			break;
+
+		case ExpressionOpcode::jumpIfFalse:
+			if (stack[sp - 1].bVal)
+			{
+				--sp;
+			}
+			else
+			{
+				pc = instr.operand;
+			}
+			break;
+
+		case ExpressionOpcode::jumpIfTrue:
+			if (stack[sp - 1].bVal)
+			{
+				pc = instr.operand;
+			}
+			else
+			{
+				--sp;
+			}
+			break;
+
+		case ExpressionOpcode::popJumpIfFalse:
+			--sp;
+			if (!stack[sp].bVal)
+			{
+				pc = instr.operand;
+			}
+			break;
+
+		case ExpressionOpcode::jump:
+			pc = instr.operand;
+			break;
+		}
+	}
+
+	rslt = stack[0];
+	currentp = startp + expr.GetSourceLength();
+}
+
+#endif
+
 // Evaluate an expression internally, stopping before any binary operators with priority 'priority' or lower
 // This is recursive, so avoid allocating large amounts of data on the stack
 void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_t priority) THROWS(GCodeException)
@@ -84,51 +241,17 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 	{
 	case '"':
 		ParseQuotedString(val);
+		EmitConstant(val);
 		break;
 
 	case '-':
-		AdvancePointer();
-		CheckStack(StackUsage::ParseInternal);
-		ParseInternal(val, evaluate, UnaryPriority);
-		switch (val.GetType())
-		{
-		case TypeCode::Int32:
-			val.iVal = -val.iVal;		//TODO overflow check
-			break;
-
-		case TypeCode::Float:
-			val.fVal = -val.fVal;
-			break;
-
-		default:
-			ThrowParseException("expected numeric value after '-'");
-		}
-		break;
-
 	case '+':
+	case '!':
 		AdvancePointer();
 		CheckStack(StackUsage::ParseInternal);
 		ParseInternal(val, evaluate, UnaryPriority);
-		switch (val.GetType())
-		{
-		case TypeCode::Uint32:
-			// Convert enumeration to integer
-			val.iVal = (int32_t)val.uVal;
-			val.SetType(TypeCode::Int32);
-			break;
-
-		case TypeCode::Int32:
-		case TypeCode::Float:
-			break;
-
-		case TypeCode::DateTime_tc:					// unary + converts a DateTime to a seconds count
-			val.iVal = (uint32_t)val.Get56BitValue();
-			val.SetType(TypeCode::Int32);
-			break;
-
-		default:
-			ThrowParseException("expected numeric or enumeration value after '+'");
-		}
+		Emit(ExpressionOpcode::unaryOperator, c);
+		ApplyUnaryOperator(c, val, evaluate);
 		break;
 
 	case '#':
@@ -144,24 +267,25 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 		{
 			CheckStack(StackUsage::ParseInternal);
 			ParseInternal(val, evaluate, UnaryPriority);
-			if (val.GetType() == TypeCode::CString)
-			{
-				val.Set((int32_t)strlen(val.sVal));
-			}
-			else if (val.GetType() == TypeCode::HeapString)
-			{
-				val.Set((int32_t)val.shVal.GetLength());
-			}
-			else
-			{
-				ThrowParseException("expected object model value or string after '#");
-			}
+			Emit(ExpressionOpcode::unaryOperator, c);
+			ApplyUnaryOperator(c, val, evaluate);
 		}
 		break;
 
 	case '{':
 		AdvancePointer();
-		ParseExpectKet(val, evaluate, '}');
+		CheckStack(StackUsage::ParseInternal);
+		ParseInternal(val, evaluate, 0);
+		SkipWhiteSpace();
+		if (CurrentCharacter() == EXPRESSION_LIST_SEPARATOR)
+		{
+			ParseArrayLiteral(val, evaluate);
+		}
+		if (CurrentCharacter() != '}')
+		{
+			ThrowParseException("expected '}'");
+		}
+		AdvancePointer();
 		break;
 
 	case '(':
@@ -169,18 +293,11 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 		ParseExpectKet(val, evaluate, ')');
 		break;
 
-	case '!':
-		AdvancePointer();
-		CheckStack(StackUsage::ParseInternal);
-		ParseInternal(val, evaluate, UnaryPriority);
-		ConvertToBool(val, evaluate);
-		val.bVal = !val.bVal;
-		break;
-
 	default:
 		if (isdigit(c))						// looks like a number
 		{
 			ParseNumber(val);
+			EmitConstant(val);
 		}
 		else if (isalpha(c))				// looks like a variable name
 		{
@@ -247,11 +364,15 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 		switch (opChar)
 		{
 		case '&':
+			Emit(ExpressionOpcode::convertToBool);
 			ConvertToBool(val, evaluate);
 			{
+				const size_t jumpInstruction = Emit(ExpressionOpcode::jumpIfFalse);
 				ExpressionValue val2;
 				CheckStack(StackUsage::ParseInternal);
 				ParseInternal(val2, evaluate && val.bVal, opPrio);		// get the next operand
+				Emit(ExpressionOpcode::convertToBool);
+				PatchJump(jumpInstruction);
 				if (val.bVal)
 				{
 					ConvertToBool(val2, evaluate);
@@ -261,11 +382,15 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 			break;
 
 		case '|':
+			Emit(ExpressionOpcode::convertToBool);
 			ConvertToBool(val, evaluate);
 			{
+				const size_t jumpInstruction = Emit(ExpressionOpcode::jumpIfTrue);
 				ExpressionValue val2;
 				CheckStack(StackUsage::ParseInternal);
 				ParseInternal(val2, evaluate && !val.bVal, opPrio);		// get the next operand
+				Emit(ExpressionOpcode::convertToBool);
+				PatchJump(jumpInstruction);
 				if (!val.bVal)
 				{
 					ConvertToBool(val2, evaluate);
@@ -275,9 +400,11 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 			break;
 
 		case '?':
+			Emit(ExpressionOpcode::convertToBool);
 			ConvertToBool(val, evaluate);
 			{
 				const bool b = val.bVal;
+				const size_t elseJumpInstruction = Emit(ExpressionOpcode::popJumpIfFalse);
 				ExpressionValue val2;
 				CheckStack(StackUsage::ParseInternal);
 				ParseInternal(((b) ? val : val2), evaluate && b, opPrio);		// get the second operand
@@ -286,8 +413,11 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 					ThrowParseException("expected ':'");
 				}
 				AdvancePointer();
+				const size_t endJumpInstruction = Emit(ExpressionOpcode::jump);
+				PatchJump(elseJumpInstruction, -1);								// the second operand isn't on the stack when we get here by the jump
 				// We recently checked the stack for a call to ParseInternal, no need to do it again
 				ParseInternal(((b) ? val2 : val), evaluate && !b, opPrio - 1);	// get the third operand, which may be a further conditional expression
+				PatchJump(endJumpInstruction);
 				return;
 			}
 
@@ -297,235 +427,318 @@ void ExpressionParser::ParseInternal(ExpressionValue& val, bool evaluate, uint8_
 				ExpressionValue val2;
 				CheckStack(StackUsage::ParseInternal);
 				ParseInternal(val2, evaluate, opPrio);	// get the next operand
-				switch(opChar)
-				{
-				case '+':
-					if (val.GetType() == TypeCode::DateTime_tc)
-					{
-						if (val2.GetType() == TypeCode::Uint32)
-						{
-							val.Set56BitValue(val.Get56BitValue() + val2.uVal);
-						}
-						else if (val2.GetType() == TypeCode::Int32)
-						{
-							val.Set56BitValue((int64_t)val.Get56BitValue() + val2.iVal);
-						}
-						else if (evaluate)
-						{
-							ThrowParseException("invalid operand types");
-						}
-					}
-					else
-					{
-						BalanceNumericTypes(val, val2, evaluate);
-						if (val.GetType() == TypeCode::Float)
-						{
-							val.fVal += val2.fVal;
-							val.param = max(val.param, val2.param);
-						}
-						else
-						{
-							val.iVal += val2.iVal;
-						}
-					}
-					break;
-
-				case '-':
-					if (val.GetType() == TypeCode::DateTime_tc)
-					{
-						if (val2.GetType() == TypeCode::DateTime_tc)
-						{
-							// Difference of two data/times
-							val.SetType(TypeCode::Int32);
-							val.iVal = (int32_t)(val.Get56BitValue() - val2.Get56BitValue());
-						}
-						else if (val2.GetType() == TypeCode::Uint32)
-						{
-							val.Set56BitValue(val.Get56BitValue() - val2.uVal);
-						}
-						else if (val2.GetType() == TypeCode::Int32)
-						{
-							val.Set56BitValue((int64_t)val.Get56BitValue() - val2.iVal);
-						}
-						else if (evaluate)
-						{
-							ThrowParseException("invalid operand types");
-						}
-					}
-					else
-					{
-						BalanceNumericTypes(val, val2, evaluate);
-						if (val.GetType() == TypeCode::Float)
-						{
-							val.fVal -= val2.fVal;
-							val.param = max(val.param, val2.param);
-						}
-						else
-						{
-							val.iVal -= val2.iVal;
-						}
-					}
-					break;
+				Emit(ExpressionOpcode::binaryOperator, opChar, invert);
+				ApplyBinaryOperator(opChar, invert, val, val2, evaluate);
+			}
+		}
+	} while (true);
+}
 
-				case '*':
-					BalanceNumericTypes(val, val2, evaluate);
-					if (val.GetType() == TypeCode::Float)
-					{
-						val.fVal *= val2.fVal;
-						val.param = max(val.param, val2.param);
-					}
-					else
-					{
-						val.iVal *= val2.iVal;
-					}
-					break;
-
-				case '/':
-					ConvertToFloat(val, evaluate);
-					ConvertToFloat(val2, evaluate);
-					val.fVal /= val2.fVal;
-					val.param = MaxFloatDigitsDisplayedAfterPoint;
-					break;
-
-				case '>':
-					BalanceTypes(val, val2, evaluate);
-					switch (val.GetType())
-					{
-					case TypeCode::Int32:
-						val.bVal = (val.iVal > val2.iVal);
-						break;
+// Apply a unary operator to a value
+void ExpressionParser::ApplyUnaryOperator(char op, ExpressionValue& val, bool evaluate) THROWS(GCodeException)
+{
+	switch (op)
+	{
+	case '-':
+		switch (val.GetType())
+		{
+		case TypeCode::Int32:
+			val.iVal = -val.iVal;		//TODO overflow check
+			break;
 
-					case TypeCode::Float:
-						val.bVal = (val.fVal > val2.fVal);
-						break;
+		case TypeCode::Float:
+			val.fVal = -val.fVal;
+			break;
 
-					case TypeCode::DateTime_tc:
-						val.bVal = val.Get56BitValue() > val2.Get56BitValue();
-						break;
+		default:
+			ThrowParseException("expected numeric value after '-'");
+		}
+		break;
 
-					case TypeCode::Bool:
-						val.bVal = (val.bVal && !val2.bVal);
-						break;
+	case '+':
+		switch (val.GetType())
+		{
+		case TypeCode::Uint32:
+			// Convert enumeration to integer
+			val.iVal = (int32_t)val.uVal;
+			val.SetType(TypeCode::Int32);
+			break;
 
-					default:
-						if (evaluate)
-						{
-							ThrowParseException("expected numeric or Boolean operands to comparison operator");
-						}
-						val.bVal = false;
-						break;
-					}
-					val.SetType(TypeCode::Bool);
-					if (invert)
-					{
-						val.bVal = !val.bVal;
-					}
-					break;
+		case TypeCode::Int32:
+		case TypeCode::Float:
+			break;
 
-				case '<':
-					BalanceTypes(val, val2, evaluate);
-					switch (val.GetType())
-					{
-					case TypeCode::Int32:
-						val.bVal = (val.iVal < val2.iVal);
-						break;
+		case TypeCode::DateTime_tc:					// unary + converts a DateTime to a seconds count
+			val.iVal = (uint32_t)val.Get56BitValue();
+			val.SetType(TypeCode::Int32);
+			break;
 
-					case TypeCode::Float:
-						val.bVal = (val.fVal < val2.fVal);
-						break;
+		default:
+			ThrowParseException("expected numeric or enumeration value after '+'");
+		}
+		break;
 
-					case TypeCode::DateTime_tc:
-						val.bVal = val.Get56BitValue() < val2.Get56BitValue();
-						break;
+	case '#':
+		if (val.GetType() == TypeCode::CString)
+		{
+			val.Set((int32_t)strlen(val.sVal));
+		}
+		else if (val.GetType() == TypeCode::HeapString)
+		{
+			val.Set((int32_t)val.shVal.GetLength());
+		}
+		else if (val.GetType() == TypeCode::HeapArray)
+		{
+			val.Set((int32_t)val.ahVal.GetNumElements());
+		}
+		else
+		{
+			ThrowParseException("expected object model value, array or string after '#");
+		}
+		break;
 
-					case TypeCode::Bool:
-						val.bVal = (!val.bVal && val2.bVal);
-						break;
+	case '!':
+		ConvertToBool(val, evaluate);
+		val.bVal = !val.bVal;
+		break;
 
-					default:
-						if (evaluate)
-						{
-							ThrowParseException("expected numeric or Boolean operands to comparison operator");
-						}
-						val.bVal = false;
-						break;
-					}
-					val.SetType(TypeCode::Bool);
-					if (invert)
-					{
-						val.bVal = !val.bVal;
-					}
-					break;
+	default:
+		THROW_INTERNAL_ERROR;
+	}
+}
 
-				case '=':
-					// Before balancing, handle comparisons with null
-					if (val.GetType() == TypeCode::None)
-					{
-						val.bVal = (val2.GetType() == TypeCode::None);
-					}
-					else if (val2.GetType() == TypeCode::None)
-					{
-						val.bVal = false;
-					}
-					else
-					{
-						BalanceTypes(val, val2, evaluate);
-						switch (val.GetType())
-						{
-						case TypeCode::ObjectModel_tc:
-							ThrowParseException("cannot compare objects");
+// Apply a binary operator that always evaluates both operands, leaving the result in 'val'
+void ExpressionParser::ApplyBinaryOperator(char opChar, bool invert, ExpressionValue& val, ExpressionValue& val2, bool evaluate) THROWS(GCodeException)
+{
+	switch (opChar)
+	{
+	case '+':
+		if (val.GetType() == TypeCode::DateTime_tc)
+		{
+			if (val2.GetType() == TypeCode::Uint32)
+			{
+				val.Set56BitValue(val.Get56BitValue() + val2.uVal);
+			}
+			else if (val2.GetType() == TypeCode::Int32)
+			{
+				val.Set56BitValue((int64_t)val.Get56BitValue() + val2.iVal);
+			}
+			else if (evaluate)
+			{
+				ThrowParseException("invalid operand types");
+			}
+		}
+		else
+		{
+			BalanceNumericTypes(val, val2, evaluate);
+			if (val.GetType() == TypeCode::Float)
+			{
+				val.fVal += val2.fVal;
+				val.param = max(val.param, val2.param);
+			}
+			else
+			{
+				val.iVal += val2.iVal;
+			}
+		}
+		break;
 
-						case TypeCode::Int32:
-							val.bVal = (val.iVal == val2.iVal);
-							break;
+	case '-':
+		if (val.GetType() == TypeCode::DateTime_tc)
+		{
+			if (val2.GetType() == TypeCode::DateTime_tc)
+			{
+				// Difference of two data/times
+				val.SetType(TypeCode::Int32);
+				val.iVal = (int32_t)(val.Get56BitValue() - val2.Get56BitValue());
+			}
+			else if (val2.GetType() == TypeCode::Uint32)
+			{
+				val.Set56BitValue(val.Get56BitValue() - val2.uVal);
+			}
+			else if (val2.GetType() == TypeCode::Int32)
+			{
+				val.Set56BitValue((int64_t)val.Get56BitValue() - val2.iVal);
+			}
+			else if (evaluate)
+			{
+				ThrowParseException("invalid operand types");
+			}
+		}
+		else
+		{
+			BalanceNumericTypes(val, val2, evaluate);
+			if (val.GetType() == TypeCode::Float)
+			{
+				val.fVal -= val2.fVal;
+				val.param = max(val.param, val2.param);
+			}
+			else
+			{
+				val.iVal -= val2.iVal;
+			}
+		}
+		break;
 
-						case TypeCode::Uint32:
-							val.bVal = (val.uVal == val2.uVal);
-							break;
+	case '*':
+		BalanceNumericTypes(val, val2, evaluate);
+		if (val.GetType() == TypeCode::Float)
+		{
+			val.fVal *= val2.fVal;
+			val.param = max(val.param, val2.param);
+		}
+		else
+		{
+			val.iVal *= val2.iVal;
+		}
+		break;
 
-						case TypeCode::Float:
-							val.bVal = (val.fVal == val2.fVal);
-							break;
+	case '/':
+		ConvertToFloat(val, evaluate);
+		ConvertToFloat(val2, evaluate);
+		val.fVal /= val2.fVal;
+		val.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
 
-						case TypeCode::DateTime_tc:
-							val.bVal = val.Get56BitValue() == val2.Get56BitValue();
-							break;
+	case '>':
+		BalanceTypes(val, val2, evaluate);
+		switch (val.GetType())
+		{
+		case TypeCode::Int32:
+			val.bVal = (val.iVal > val2.iVal);
+			break;
 
-						case TypeCode::Bool:
-							val.bVal = (val.bVal == val2.bVal);
-							break;
+		case TypeCode::Float:
+			val.bVal = (val.fVal > val2.fVal);
+			break;
 
-						case TypeCode::CString:
-							val.bVal = (strcmp(val.sVal, (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
-							break;
+		case TypeCode::DateTime_tc:
+			val.bVal = val.Get56BitValue() > val2.Get56BitValue();
+			break;
 
-						case TypeCode::HeapString:
-							val.bVal = (strcmp(val.shVal.Get().Ptr(), (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
-							break;
+		case TypeCode::Bool:
+			val.bVal = (val.bVal && !val2.bVal);
+			break;
 
-						default:
-							if (evaluate)
-							{
-								ThrowParseException("unexpected operand type to equality operator");
-							}
-							val.bVal = false;
-							break;
-						}
-					}
-					val.SetType(TypeCode::Bool);
-					if (invert)
-					{
-						val.bVal = !val.bVal;
-					}
-					break;
+		default:
+			if (evaluate)
+			{
+				ThrowParseException("expected numeric or Boolean operands to comparison operator");
+			}
+			val.bVal = false;
+			break;
+		}
+		val.SetType(TypeCode::Bool);
+		if (invert)
+		{
+			val.bVal = !val.bVal;
+		}
+		break;
+
+	case '<':
+		BalanceTypes(val, val2, evaluate);
+		switch (val.GetType())
+		{
+		case TypeCode::Int32:
+			val.bVal = (val.iVal < val2.iVal);
+			break;
+
+		case TypeCode::Float:
+			val.bVal = (val.fVal < val2.fVal);
+			break;
+
+		case TypeCode::DateTime_tc:
+			val.bVal = val.Get56BitValue() < val2.Get56BitValue();
+			break;
+
+		case TypeCode::Bool:
+			val.bVal = (!val.bVal && val2.bVal);
+			break;
+
+		default:
+			if (evaluate)
+			{
+				ThrowParseException("expected numeric or Boolean operands to comparison operator");
+			}
+			val.bVal = false;
+			break;
+		}
+		val.SetType(TypeCode::Bool);
+		if (invert)
+		{
+			val.bVal = !val.bVal;
+		}
+		break;
+
+	case '=':
+		// Before balancing, handle comparisons with null
+		if (val.GetType() == TypeCode::None)
+		{
+			val.bVal = (val2.GetType() == TypeCode::None);
+		}
+		else if (val2.GetType() == TypeCode::None)
+		{
+			val.Set(false);									// this releases any string or array
+		}
+		else
+		{
+			BalanceTypes(val, val2, evaluate);
+			switch (val.GetType())
+			{
+			case TypeCode::ObjectModel_tc:
+				ThrowParseException("cannot compare objects");
+
+			case TypeCode::Int32:
+				val.bVal = (val.iVal == val2.iVal);
+				break;
+
+			case TypeCode::Uint32:
+				val.bVal = (val.uVal == val2.uVal);
+				break;
+
+			case TypeCode::Float:
+				val.bVal = (val.fVal == val2.fVal);
+				break;
+
+			case TypeCode::DateTime_tc:
+				val.bVal = val.Get56BitValue() == val2.Get56BitValue();
+				break;
+
+			case TypeCode::Bool:
+				val.bVal = (val.bVal == val2.bVal);
+				break;
+
+			case TypeCode::CString:
+				val.bVal = (strcmp(val.sVal, (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
+				break;
+
+			case TypeCode::HeapString:
+				val.bVal = (strcmp(val.shVal.Get().Ptr(), (val2.GetType() == TypeCode::HeapString) ? val2.shVal.Get().Ptr() : val2.sVal) == 0);
+				break;
 
-				case '^':
-					StringConcat(val, val2);
-					break;
+			default:
+				if (evaluate)
+				{
+					ThrowParseException("unexpected operand type to equality operator");
 				}
+				val.Set(false);
+				break;
 			}
 		}
-	} while (true);
+		val.SetType(TypeCode::Bool);
+		if (invert)
+		{
+			val.bVal = !val.bVal;
+		}
+		break;
+
+	case '^':
+		StringConcat(val, val2);
+		break;
+
+	default:
+		THROW_INTERNAL_ERROR;
+	}
 }
 
 // Concatenate val1 and val2 and assign the result to val1
@@ -555,7 +768,11 @@ float ExpressionParser::ParseFloat() THROWS(GCodeException)
 
 int32_t ExpressionParser::ParseInteger() THROWS(GCodeException)
 {
-	ExpressionValue val = Parse();
+	return GetIntegerValue(Parse());
+}
+
+int32_t ExpressionParser::GetIntegerValue(const ExpressionValue& val) const THROWS(GCodeException)
+{
 	switch (val.GetType())
 	{
 	case TypeCode::Int32:
@@ -575,7 +792,11 @@ int32_t ExpressionParser::ParseInteger() THROWS(GCodeException)
 
 uint32_t ExpressionParser::ParseUnsigned() THROWS(GCodeException)
 {
-	ExpressionValue val = Parse();
+	return GetUnsignedValue(Parse());
+}
+
+uint32_t ExpressionParser::GetUnsignedValue(const ExpressionValue& val) const THROWS(GCodeException)
+{
 	switch (val.GetType())
 	{
 	case TypeCode::Uint32:
@@ -600,21 +821,39 @@ DriverId ExpressionParser::ParseDriverId() THROWS(GCodeException)
 	return val.GetDriverIdValue();
 }
 
-void ExpressionParser::ParseArray(size_t& length, function_ref<void(size_t index) THROWS(GCodeException)> processElement) THROWS(GCodeException)
+// An element that is an array variable supplies all of its elements
+void ExpressionParser::ParseArray(size_t& length, function_ref<void(size_t index, ExpressionValue& val) THROWS(GCodeException)> processElement) THROWS(GCodeException)
 {
 	size_t numElements = 0;
 	AdvancePointer();					// skip the '{'
-	while (numElements < length)
+	for (;;)
 	{
-		processElement(numElements);
-		++numElements;
-		if (CurrentCharacter() != EXPRESSION_LIST_SEPARATOR)
+		ExpressionValue val = Parse();
+		if (val.GetType() == TypeCode::HeapArray)
 		{
-			break;
+			if (numElements + val.ahVal.GetNumElements() > length)
+			{
+				ThrowParseException("Array too long");
+			}
+			for (size_t i = 0; i < val.ahVal.GetNumElements(); ++i)
+			{
+				ExpressionValue element = val.ahVal.GetElement(i);
+				processElement(numElements, element);
+				++numElements;
+			}
+		}
+		else
+		{
+			if (numElements == length)
+			{
+				ThrowParseException("Array too long");
+			}
+			processElement(numElements, val);
+			++numElements;
 		}
-		if (numElements == length)
+		if (CurrentCharacter() != EXPRESSION_LIST_SEPARATOR)
 		{
-			ThrowParseException("Array too long");
+			break;
 		}
 		AdvancePointer();				// skip the ','
 	}
@@ -629,22 +868,22 @@ void ExpressionParser::ParseArray(size_t& length, function_ref<void(size_t index
 // This is called when we expect a non-empty float array parameter and we have encountered (but not skipped) '{'
 void ExpressionParser::ParseFloatArray(float arr[], size_t& length) THROWS(GCodeException)
 {
-	ParseArray(length, [this, &arr](size_t index) { arr[index] = ParseFloat(); });
+	ParseArray(length, [this, &arr](size_t index, ExpressionValue& val) { ConvertToFloat(val, true); arr[index] = val.fVal; });
 }
 
 void ExpressionParser::ParseIntArray(int32_t arr[], size_t& length) THROWS(GCodeException)
 {
-	ParseArray(length, [this, &arr](size_t index) { arr[index] = ParseInteger(); });
+	ParseArray(length, [this, &arr](size_t index, ExpressionValue& val) { arr[index] = GetIntegerValue(val); });
 }
 
 void ExpressionParser::ParseUnsignedArray(uint32_t arr[], size_t& length) THROWS(GCodeException)
 {
-	ParseArray(length, [this, &arr](size_t index) { arr[index] = ParseUnsigned(); });
+	ParseArray(length, [this, &arr](size_t index, ExpressionValue& val) { arr[index] = GetUnsignedValue(val); });
 }
 
 void ExpressionParser::ParseDriverIdArray(DriverId arr[], size_t& length) THROWS(GCodeException)
 {
-	ParseArray(length, [this, &arr](size_t index) { arr[index] = ParseDriverId(); });
+	ParseArray(length, [this, &arr](size_t index, ExpressionValue& val) { ConvertToDriverId(val, true); arr[index] = val.GetDriverIdValue(); });
 }
 
 void ExpressionParser::BalanceNumericTypes(ExpressionValue& val1, ExpressionValue& val2, bool evaluate) const THROWS(GCodeException)
@@ -894,7 +1133,9 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 	}
 
 	String<MaxVariableNameLength> id;
+	const size_t identifierOffset = currentp - startp;
 	ObjectExplorationContext context(&gb, applyLengthOperator, applyExists, gb.GetLineNumber(), GetColumn());
+	unsigned int numIndices = 0;
 
 	// Loop parsing identifiers and index expressions
 	// When we come across an index expression, evaluate it, add it to the context, and place a marker in the identifier string.
@@ -911,6 +1152,7 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 			{
 				ThrowParseException("expected ']'");
 			}
+			Emit(ExpressionOpcode::checkIndex);
 			if (index.GetType() != TypeCode::Int32)
 			{
 				if (evaluate)
@@ -921,6 +1163,7 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 			}
 			AdvancePointer();										// skip the ']'
 			context.ProvideIndex(index.iVal);
+			++numIndices;
 			c = '^';												// add the marker
 		}
 		if (id.cat(c))
@@ -937,65 +1180,14 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 		{
 			ThrowParseException(InvalidExistsMessage);
 		}
-
-		switch (whichConstant.RawValue())
+		if (numIndices != 0)
 		{
-		case NamedConstant::_true:
-			rslt.Set(true);
-			return;
-
-		case NamedConstant::_false:
-			rslt.Set(false);
-			return;
-
-		case NamedConstant::_null:
-			rslt.Set(nullptr);
-			return;
-
-		case NamedConstant::pi:
-			rslt.Set(Pi);
-			return;
-
-		case NamedConstant::iterations:
-			{
-				const int32_t v = gb.CurrentFileMachineState().GetIterations();
-				if (v < 0)
-				{
-					ThrowParseException("'iterations' used when not inside a loop");
-				}
-				rslt.Set(v);
-			}
-			return;
-
-		case NamedConstant::_result:
-			{
-				int32_t res;
-				switch (gb.GetLastResult())
-				{
-				case GCodeResult::ok:
-					res = 0;
-					break;
-
-				case GCodeResult::warning:
-				case GCodeResult::warningNotSupported:
-					res = 1;
-					break;
-
-				default:
-					res = 2;
-					break;
-				}
-				rslt.Set(res);
-			}
-			return;
-
-		case NamedConstant::line:
-			rslt.Set((int32_t)gb.GetLineNumber());
-			return;
-
-		default:
-			THROW_INTERNAL_ERROR;
+			AbandonCompilation();									// the index values would be left on the stack
 		}
+
+		Emit(ExpressionOpcode::pushNamedConstant, whichConstant.RawValue());
+		GetNamedConstantValue(rslt, whichConstant.RawValue());
+		return;
 	}
 
 	// Check whether it is a function call
@@ -1007,6 +1199,10 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 		{
 			ThrowParseException(InvalidExistsMessage);
 		}
+		if (numIndices != 0)
+		{
+			AbandonCompilation();
+		}
 
 		const Function func(id.c_str());
 		if (!func.IsValid())
@@ -1025,311 +1221,573 @@ void ExpressionParser::ParseIdentifierExpression(ExpressionValue& rslt, bool eva
 			CheckStack(StackUsage::ParseInternal);
 			ParseInternal(rslt, evaluate, 0);					// evaluate the first operand
 
-			switch (func.RawValue())
+			const bool anyNumberOfOperands = (func == Function::max || func == Function::min);
+			if (anyNumberOfOperands || func == Function::atan2 || func == Function::mod || func == Function::interpolate || func == Function::vector)
 			{
-			case Function::abs:
-				switch (rslt.GetType())
-				{
-				case TypeCode::Int32:
-					rslt.iVal = labs(rslt.iVal);
-					break;
-
-				case TypeCode::Float:
-					rslt.fVal = fabsf(rslt.fVal);
-					break;
-
-				default:
-					if (evaluate)
-					{
-						ThrowParseException("expected numeric operand");
-					}
-					rslt.Set((int32_t)0);
-				}
-				break;
-
-			case Function::sin:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = sinf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
-
-			case Function::cos:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = cosf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
-
-			case Function::tan:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = tanf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
-
-			case Function::asin:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = asinf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
-
-			case Function::acos:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = acosf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
-
-			case Function::atan:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = atanf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
-
-			case Function::atan2:
+				// Combine the first operand with each additional one
+				bool seenMoreOperands = false;
+				for (;;)
 				{
-					ConvertToFloat(rslt, evaluate);
 					SkipWhiteSpace();
 					if (CurrentCharacter() != ',')
 					{
+						if (anyNumberOfOperands)
+						{
+							if (!seenMoreOperands)
+							{
+								// A single operand may be an array, in which case the function is applied to its elements
+								Emit(ExpressionOpcode::callFunction, func.RawValue(), 0);
+								ApplyFunction(func.RawValue(), rslt, nullptr, evaluate);
+							}
+							break;
+						}
 						ThrowParseException("expected ','");
 					}
+					seenMoreOperands = true;
 					AdvancePointer();
 					SkipWhiteSpace();
 					ExpressionValue nextOperand;
 					// We recently checked the stack for a call to ParseInternal, no need to do it again
 					ParseInternal(nextOperand, evaluate, 0);
-					ConvertToFloat(nextOperand, evaluate);
-					rslt.fVal = atan2f(rslt.fVal, nextOperand.fVal);
-					rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+					Emit(ExpressionOpcode::callFunction, func.RawValue(), 1);
+					ApplyFunction(func.RawValue(), rslt, &nextOperand, evaluate);
+					if (!anyNumberOfOperands)
+					{
+						break;
+					}
 				}
-				break;
+			}
+			else
+			{
+				Emit(ExpressionOpcode::callFunction, func.RawValue(), 0);
+				ApplyFunction(func.RawValue(), rslt, nullptr, evaluate);
+			}
+		}
 
-			case Function::degrees:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = rslt.fVal * RadiansToDegrees;
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
+		SkipWhiteSpace();
+		if (CurrentCharacter() != ')')
+		{
+			ThrowParseException("expected ')'");
+		}
+		AdvancePointer();
+		return;
+	}
 
-			case Function::radians:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = rslt.fVal * DegreesToRadians;
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
+	if (numIndices > CompiledIdentifierIndicesMask)
+	{
+		AbandonCompilation();
+	}
+	EmitIdentifier(id.c_str(), numIndices | ((applyLengthOperator) ? CompiledIdentifierLengthFlag : 0) | ((applyExists) ? CompiledIdentifierExistsFlag : 0), identifierOffset);
 
-			case Function::sqrt:
-				ConvertToFloat(rslt, evaluate);
-				rslt.fVal = fastSqrtf(rslt.fVal);
-				rslt.param = MaxFloatDigitsDisplayedAfterPoint;
-				break;
+	// If we are not evaluating then the object expression doesn't have to exist, so don't retrieve it because that might throw an error
+	if (evaluate)
+	{
+		GetIdentifierValue(rslt, id.c_str(), context);
+	}
+	else
+	{
+		rslt.Set(nullptr);
+	}
+}
 
-			case Function::isnan:
-				ConvertToFloat(rslt, evaluate);
-				rslt.SetType(TypeCode::Bool);
-				rslt.bVal = (std::isnan(rslt.fVal) != 0);
-				break;
+// Parse the remaining elements of an array literal, given that 'val' holds the first element and the current character is the list separator.
+// A separator is allowed after the last element, so that {x,} is an array with one element whereas {x} is just the value x.
+void ExpressionParser::ParseArrayLiteral(ExpressionValue& val, bool evaluate) THROWS(GCodeException)
+{
+	Emit(ExpressionOpcode::makeArray);
+	MakeArray(val);
+	do
+	{
+		AdvancePointer();										// skip the separator
+		SkipWhiteSpace();
+		if (CurrentCharacter() == '}')
+		{
+			break;
+		}
+		ExpressionValue element;
+		CheckStack(StackUsage::ParseInternal);
+		ParseInternal(element, evaluate, 0);
+		Emit(ExpressionOpcode::appendToArray);
+		AppendToArray(val, element);
+		SkipWhiteSpace();
+	} while (CurrentCharacter() == EXPRESSION_LIST_SEPARATOR);
+}
 
-			case Function::floor:
-				{
-					ConvertToFloat(rslt, evaluate);
-					const float f = floorf(rslt.fVal);
-					if (f <= (float)std::numeric_limits<int32_t>::max() && f >= (float)std::numeric_limits<int32_t>::min())
-					{
-						rslt.SetType(TypeCode::Int32);
-						rslt.iVal = (int32_t)f;
-					}
-					else
-					{
-						rslt.fVal = f;
-					}
-				}
-				break;
+// Replace a value by an array containing just that value
+/*static*/ void ExpressionParser::MakeArray(ExpressionValue& val) noexcept
+{
+	ArrayHandle ah;
+	ah.Append(val);
+	val.Set(ah);
+}
 
-			case Function::mod:
-				{
-					SkipWhiteSpace();
-					if (CurrentCharacter() != ',')
-					{
-						ThrowParseException("expected ','");
-					}
-					AdvancePointer();
-					SkipWhiteSpace();
-					ExpressionValue nextOperand;
-					// We recently checked the stack for a call to ParseInternal, no need to do it again
-					ParseInternal(nextOperand, evaluate, 0);
-					BalanceNumericTypes(rslt, nextOperand, evaluate);
-					if (rslt.GetType() == TypeCode::Float)
-					{
-						rslt.fVal = fmod(rslt.fVal, nextOperand.fVal);
-					}
-					else if (nextOperand.iVal == 0)
-					{
-						rslt.iVal = 0;
-					}
-					else
-					{
-						rslt.iVal %= nextOperand.iVal;
-					}
-				}
-				break;
+// Append a value to an array that we are building
+void ExpressionParser::AppendToArray(ExpressionValue& arr, const ExpressionValue& element) const THROWS(GCodeException)
+{
+	if (arr.ahVal.GetNumElements() == MaxArrayVariableLength)
+	{
+		ThrowParseException("array too long");
+	}
+	arr.ahVal.Append(element);
+}
 
-			case Function::max:
-				for (;;)
-				{
-					SkipWhiteSpace();
-					if (CurrentCharacter() != ',')
-					{
-						break;
-					}
-					AdvancePointer();
-					SkipWhiteSpace();
-					ExpressionValue nextOperand;
-					// We recently checked the stack for a call to ParseInternal, no need to do it again
-					ParseInternal(nextOperand, evaluate, 0);
-					BalanceNumericTypes(rslt, nextOperand, evaluate);
-					if (rslt.GetType() == TypeCode::Float)
-					{
-						rslt.fVal = max<float>(rslt.fVal, nextOperand.fVal);
-						rslt.param = max(rslt.param, nextOperand.param);
-					}
-					else
-					{
-						rslt.iVal = max<int32_t>(rslt.iVal, nextOperand.iVal);
-					}
-				}
+// Apply min or max to the elements of an array. If the operand is not an array then it is the result.
+void ExpressionParser::ApplyFunctionToArrayElements(unsigned int func, ExpressionValue& rslt, bool evaluate) THROWS(GCodeException)
+{
+	if (rslt.GetType() == TypeCode::HeapArray)
+	{
+		const ExpressionValue arr = rslt;
+		if (arr.ahVal.GetNumElements() == 0)
+		{
+			if (evaluate)
+			{
+				ThrowParseException("array is empty");
+			}
+			rslt.Set((int32_t)0);
+			return;
+		}
+		rslt = arr.ahVal.GetElement(0);
+		for (size_t i = 1; i < arr.ahVal.GetNumElements(); ++i)
+		{
+			ExpressionValue element = arr.ahVal.GetElement(i);
+			ApplyFunction(func, rslt, &element, evaluate);
+		}
+	}
+}
+
+// Get the X and Y coordinates of a point in an interpolation table
+void ExpressionParser::GetTablePoint(const ExpressionValue& table, size_t index, float& x, float& y) const THROWS(GCodeException)
+{
+	ExpressionValue point = table.ahVal.GetElement(index);
+	if (point.GetType() != TypeCode::HeapArray || point.ahVal.GetNumElements() != 2)
+	{
+		ThrowParseException("expected array of {x,y} pairs");
+	}
+	ExpressionValue coord = point.ahVal.GetElement(0);
+	ConvertToFloat(coord, true);
+	x = coord.fVal;
+	coord = point.ahVal.GetElement(1);
+	ConvertToFloat(coord, true);
+	y = coord.fVal;
+}
+
+// Interpolate linearly in a table of {x,y} pairs sorted by increasing x, replacing the table by the result.
+// Values of x outside the range of the table give the Y value at the nearest end of the table.
+void ExpressionParser::InterpolateTable(ExpressionValue& table, float x, bool evaluate) THROWS(GCodeException)
+{
+	if (table.GetType() != TypeCode::HeapArray || table.ahVal.GetNumElements() == 0)
+	{
+		if (evaluate)
+		{
+			ThrowParseException("expected non-empty array of {x,y} pairs");
+		}
+		table.Set(0.0f);
+		return;
+	}
+
+	float xLow, yLow, xHigh, yHigh;
+	size_t low = 0, high = table.ahVal.GetNumElements() - 1;
+	GetTablePoint(table, low, xLow, yLow);
+	GetTablePoint(table, high, xHigh, yHigh);
+	float result;
+	if (x <= xLow || high == 0)
+	{
+		result = yLow;
+	}
+	else if (x >= xHigh)
+	{
+		result = yHigh;
+	}
+	else
+	{
+		// Binary search for the pair of points that x lies between
+		while (high - low > 1)
+		{
+			const size_t mid = (low + high)/2;
+			float xMid, yMid;
+			GetTablePoint(table, mid, xMid, yMid);
+			if (xMid <= x)
+			{
+				low = mid;
+				xLow = xMid;
+				yLow = yMid;
+			}
+			else
+			{
+				high = mid;
+				xHigh = xMid;
+				yHigh = yMid;
+			}
+		}
+		result = (xHigh > xLow) ? yLow + (yHigh - yLow) * (x - xLow)/(xHigh - xLow) : yLow;
+	}
+	table.Set(result);
+}
+
+// Get the value of a named constant
+void ExpressionParser::GetNamedConstantValue(ExpressionValue& rslt, unsigned int whichConstant) const THROWS(GCodeException)
+{
+	switch (whichConstant)
+	{
+	case NamedConstant::_true:
+		rslt.Set(true);
+		break;
+
+	case NamedConstant::_false:
+		rslt.Set(false);
+		break;
+
+	case NamedConstant::_null:
+		rslt.Set(nullptr);
+		break;
+
+	case NamedConstant::pi:
+		rslt.Set(Pi);
+		break;
+
+	case NamedConstant::iterations:
+		{
+			const int32_t v = gb.CurrentFileMachineState().GetIterations();
+			if (v < 0)
+			{
+				ThrowParseException("'iterations' used when not inside a loop");
+			}
+			rslt.Set(v);
+		}
+		break;
+
+	case NamedConstant::_result:
+		{
+			int32_t res;
+			switch (gb.GetLastResult())
+			{
+			case GCodeResult::ok:
+				res = 0;
 				break;
 
-			case Function::min:
-				for (;;)
-				{
-					SkipWhiteSpace();
-					if (CurrentCharacter() != ',')
-					{
-						break;
-					}
-					AdvancePointer();
-					SkipWhiteSpace();
-					ExpressionValue nextOperand;
-					// We recently checked the stack for a call to ParseInternal, no need to do it again
-					ParseInternal(nextOperand, evaluate, 0);
-					BalanceNumericTypes(rslt, nextOperand, evaluate);
-					if (rslt.GetType() == TypeCode::Float)
-					{
-						rslt.fVal = min<float>(rslt.fVal, nextOperand.fVal);
-						rslt.param = max(rslt.param, nextOperand.param);
-					}
-					else
-					{
-						rslt.iVal = min<int32_t>(rslt.iVal, nextOperand.iVal);
-					}
-				}
+			case GCodeResult::warning:
+			case GCodeResult::warningNotSupported:
+				res = 1;
 				break;
 
-			case Function::random:
-				{
-					uint32_t limit;
-					if (rslt.GetType() == TypeCode::Uint32)
-					{
-						limit = rslt.uVal;
-					}
-					else if (rslt.GetType() == TypeCode::Int32 && rslt.iVal > 0)
-					{
-						limit = rslt.iVal;
-					}
-					else
-					{
-						ThrowParseException("expected positive integer");
-					}
-					rslt.Set((int32_t)random(limit));
-				}
+			default:
+				res = 2;
 				break;
+			}
+			rslt.Set(res);
+		}
+		break;
 
-			case Function::datetime:
-				{
-					uint64_t val;
-					switch (rslt.GetType())
-					{
-					case TypeCode::Int32:
-						val = (uint64_t)max<uint32_t>(rslt.iVal, 0);
-						break;
+	case NamedConstant::line:
+		rslt.Set((int32_t)gb.GetLineNumber());
+		break;
 
-					case TypeCode::Uint32:
-						val = (uint64_t)rslt.uVal;
-						break;
+	default:
+		THROW_INTERNAL_ERROR;
+	}
+}
 
-					case TypeCode::Uint64:
-					case TypeCode::DateTime_tc:
-						val = rslt.Get56BitValue();
-						break;
+// Apply a function to its first operand, or if 'nextOperand' is not null then combine it with the first operand
+// 'nextOperand' is null if and only if the function takes just one operand
+void ExpressionParser::ApplyFunction(unsigned int func, ExpressionValue& rslt, ExpressionValue *_ecv_null nextOperand, bool evaluate) THROWS(GCodeException)
+{
+	switch (func)
+	{
+	case Function::abs:
+		switch (rslt.GetType())
+		{
+		case TypeCode::Int32:
+			rslt.iVal = labs(rslt.iVal);
+			break;
 
-					case TypeCode::CString:
-						val = ParseDateTime(rslt.sVal);
-						break;
+		case TypeCode::Float:
+			rslt.fVal = fabsf(rslt.fVal);
+			break;
 
-					case TypeCode::HeapString:
-						val = ParseDateTime(rslt.shVal.Get().Ptr());
-						break;
+		default:
+			if (evaluate)
+			{
+				ThrowParseException("expected numeric operand");
+			}
+			rslt.Set((int32_t)0);
+		}
+		break;
 
-					default:
-						ThrowParseException("can't convert value to DateTime");
-					}
-					rslt.SetType(TypeCode::DateTime_tc);
-					rslt.Set56BitValue(val);
-				}
-				break;
+	case Function::sin:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = sinf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
 
-			default:
-				THROW_INTERNAL_ERROR;
+	case Function::cos:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = cosf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::tan:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = tanf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::asin:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = asinf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::acos:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = acosf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::atan:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = atanf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::atan2:
+		ConvertToFloat(rslt, evaluate);
+		ConvertToFloat(*nextOperand, evaluate);
+		rslt.fVal = atan2f(rslt.fVal, nextOperand->fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::degrees:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = rslt.fVal * RadiansToDegrees;
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::radians:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = rslt.fVal * DegreesToRadians;
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::sqrt:
+		ConvertToFloat(rslt, evaluate);
+		rslt.fVal = fastSqrtf(rslt.fVal);
+		rslt.param = MaxFloatDigitsDisplayedAfterPoint;
+		break;
+
+	case Function::isnan:
+		ConvertToFloat(rslt, evaluate);
+		rslt.SetType(TypeCode::Bool);
+		rslt.bVal = (std::isnan(rslt.fVal) != 0);
+		break;
+
+	case Function::floor:
+		{
+			ConvertToFloat(rslt, evaluate);
+			const float f = floorf(rslt.fVal);
+			if (f <= (float)std::numeric_limits<int32_t>::max() && f >= (float)std::numeric_limits<int32_t>::min())
+			{
+				rslt.SetType(TypeCode::Int32);
+				rslt.iVal = (int32_t)f;
+			}
+			else
+			{
+				rslt.fVal = f;
 			}
 		}
+		break;
 
-		SkipWhiteSpace();
-		if (CurrentCharacter() != ')')
+	case Function::mod:
+		BalanceNumericTypes(rslt, *nextOperand, evaluate);
+		if (rslt.GetType() == TypeCode::Float)
 		{
-			ThrowParseException("expected ')'");
+			rslt.fVal = fmod(rslt.fVal, nextOperand->fVal);
 		}
-		AdvancePointer();
-		return;
-	}
+		else if (nextOperand->iVal == 0)
+		{
+			rslt.iVal = 0;
+		}
+		else
+		{
+			rslt.iVal %= nextOperand->iVal;
+		}
+		break;
 
-	// If we are not evaluating then the object expression doesn't have to exist, so don't retrieve it because that might throw an error
-	if (evaluate)
-	{
-		// Check for a parameter, local or global variable
-		if (StringStartsWith(id.c_str(), "param."))
+	case Function::max:
+		if (nextOperand == nullptr)
 		{
-			GetVariableValue(rslt, &gb.GetVariables(), id.c_str() + strlen("param."), true, applyExists);
-			return;
+			ApplyFunctionToArrayElements(func, rslt, evaluate);
+			break;
 		}
+		BalanceNumericTypes(rslt, *nextOperand, evaluate);
+		if (rslt.GetType() == TypeCode::Float)
+		{
+			rslt.fVal = max<float>(rslt.fVal, nextOperand->fVal);
+			rslt.param = max(rslt.param, nextOperand->param);
+		}
+		else
+		{
+			rslt.iVal = max<int32_t>(rslt.iVal, nextOperand->iVal);
+		}
+		break;
 
-		if (StringStartsWith(id.c_str(), "global."))
+	case Function::min:
+		if (nextOperand == nullptr)
 		{
-			auto vars = reprap.GetGlobalVariablesForReading();
-			GetVariableValue(rslt, vars.Ptr(), id.c_str() + strlen("global."), false, applyExists);
-			return;
+			ApplyFunctionToArrayElements(func, rslt, evaluate);
+			break;
+		}
+		BalanceNumericTypes(rslt, *nextOperand, evaluate);
+		if (rslt.GetType() == TypeCode::Float)
+		{
+			rslt.fVal = min<float>(rslt.fVal, nextOperand->fVal);
+			rslt.param = max(rslt.param, nextOperand->param);
+		}
+		else
+		{
+			rslt.iVal = min<int32_t>(rslt.iVal, nextOperand->iVal);
 		}
+		break;
 
-		if (StringStartsWith(id.c_str(), "var."))
+	case Function::sum:
+		if (rslt.GetType() != TypeCode::HeapArray)
 		{
-			GetVariableValue(rslt, &gb.GetVariables(), id.c_str() + strlen("var."), false, applyExists);
-			return;
+			if (evaluate)
+			{
+				ThrowParseException("expected array operand");
+			}
+			rslt.Set((int32_t)0);
 		}
+		else
+		{
+			ExpressionValue total((int32_t)0);
+			for (size_t i = 0; i < rslt.ahVal.GetNumElements(); ++i)
+			{
+				ExpressionValue element = rslt.ahVal.GetElement(i);
+				ApplyBinaryOperator('+', false, total, element, evaluate);
+			}
+			rslt = total;
+		}
+		break;
 
-		// "exists(var)", "exists(param)" and "exists(global)" should return true.
-		// "exists(global)" will anyway because "global" is a root key in the object model. Handle the other two here.
-		if (applyExists && (strcmp(id.c_str(), "param") == 0 || strcmp(id.c_str(), "var") == 0))
+	case Function::vector:
+		if (rslt.GetType() != TypeCode::Int32 || rslt.iVal < 0 || rslt.iVal > (int32_t)MaxArrayVariableLength)
 		{
-			rslt.Set(true);
-			return;
+			if (evaluate)
+			{
+				ThrowParseException("expected array length in range 0 to %u", (uint32_t)MaxArrayVariableLength);
+			}
+			rslt.Set(nullptr);
 		}
+		else
+		{
+			ArrayHandle ah;
+			ah.Allocate(rslt.iVal, *nextOperand);
+			rslt.Set(ah);
+		}
+		break;
 
-		// Else assume an object model value
-		CheckStack(StackUsage::GetObjectValueUsingTableNumber);
-		rslt = reprap.GetObjectValueUsingTableNumber(context, nullptr, id.c_str(), 0);
-		if (context.ObsoleteFieldQueried() && obsoleteField.IsEmpty())
+	case Function::interpolate:
+		ConvertToFloat(*nextOperand, evaluate);
+		InterpolateTable(rslt, nextOperand->fVal, evaluate);
+		break;
+
+	case Function::random:
 		{
-			obsoleteField.copy(id.c_str());
+			uint32_t limit;
+			if (rslt.GetType() == TypeCode::Uint32)
+			{
+				limit = rslt.uVal;
+			}
+			else if (rslt.GetType() == TypeCode::Int32 && rslt.iVal > 0)
+			{
+				limit = rslt.iVal;
+			}
+			else
+			{
+				ThrowParseException("expected positive integer");
+			}
+			rslt.Set((int32_t)random(limit));
 		}
+		break;
+
+	case Function::datetime:
+		{
+			uint64_t val;
+			switch (rslt.GetType())
+			{
+			case TypeCode::Int32:
+				val = (uint64_t)max<uint32_t>(rslt.iVal, 0);
+				break;
+
+			case TypeCode::Uint32:
+				val = (uint64_t)rslt.uVal;
+				break;
+
+			case TypeCode::Uint64:
+			case TypeCode::DateTime_tc:
+				val = rslt.Get56BitValue();
+				break;
+
+			case TypeCode::CString:
+				val = ParseDateTime(rslt.sVal);
+				break;
+
+			case TypeCode::HeapString:
+				val = ParseDateTime(rslt.shVal.Get().Ptr());
+				break;
+
+			default:
+				ThrowParseException("can't convert value to DateTime");
+			}
+			rslt.SetType(TypeCode::DateTime_tc);
+			rslt.Set56BitValue(val);
+		}
+		break;
+
+	default:
+		THROW_INTERNAL_ERROR;
+	}
+}
+
+// Get the value of a parameter, variable or object model path. The caller has already provided any index values to the context.
+// If 'handle' is not null then it is used to remember where a variable or parameter was found, to save looking it up by name next time.
+void ExpressionParser::GetIdentifierValue(ExpressionValue& rslt, const char *id, ObjectExplorationContext& context, VariableHandle *handle) THROWS(GCodeException)
+{
+	// Check for a parameter, local or global variable
+	if (StringStartsWith(id, "param."))
+	{
+		GetVariableValue(rslt, &gb.GetVariables(), id + strlen("param."), true, context, handle);
 		return;
 	}
-	rslt.Set(nullptr);
+
+	if (StringStartsWith(id, "global."))
+	{
+		auto vars = reprap.GetGlobalVariablesForReading();
+		GetVariableValue(rslt, vars.Ptr(), id + strlen("global."), false, context, handle);
+		return;
+	}
+
+	if (StringStartsWith(id, "var."))
+	{
+		GetVariableValue(rslt, &gb.GetVariables(), id + strlen("var."), false, context, handle);
+		return;
+	}
+
+	// "exists(var)", "exists(param)" and "exists(global)" should return true.
+	// "exists(global)" will anyway because "global" is a root key in the object model. Handle the other two here.
+	if (context.WantExists() && (strcmp(id, "param") == 0 || strcmp(id, "var") == 0))
+	{
+		rslt.Set(true);
+		return;
+	}
+
+	// Else assume an object model value
+	CheckStack(StackUsage::GetObjectValueUsingTableNumber);
+	rslt = reprap.GetObjectValueUsingTableNumber(context, nullptr, id, 0);
+	if (context.ObsoleteFieldQueried() && obsoleteField.IsEmpty())
+	{
+		obsoleteField.copy(id);
+	}
 }
 
 // Parse a string to a DateTime
@@ -1343,23 +1801,64 @@ time_t ExpressionParser::ParseDateTime(const char *s) const THROWS(GCodeExceptio
 	return mktime(&timeInfo);
 }
 
-// Get the value of a variable
-void ExpressionParser::GetVariableValue(ExpressionValue& rslt, const VariableSet *vars, const char *name, bool parameter, bool wantExists) THROWS(GCodeException)
+// Get the value of a variable, or of an element of an array variable if the name is followed by index markers
+void ExpressionParser::GetVariableValue(ExpressionValue& rslt, const VariableSet *vars, const char *name, bool parameter, ObjectExplorationContext& context, VariableHandle *handle) THROWS(GCodeException)
 {
-	const Variable* var = vars->Lookup(name);
-	if (wantExists)
+	const char *selector = ObjectModel::GetNextElement(name);
+	String<MaxVariableNameLength> shortName;
+	if (*selector != 0)
 	{
-		rslt.Set(var != nullptr);
-		return;
+		shortName.copy(name);
+		shortName.Truncate(selector - name);
+		name = shortName.c_str();
 	}
 
-	if (var != nullptr && (!parameter || var->GetScope() < 0))
+	const Variable* var = (handle != nullptr) ? vars->Lookup(name, *handle) : vars->Lookup(name);
+	if (var == nullptr || (parameter && var->GetScope() >= 0))
 	{
-		rslt = var->GetValue();
-		return;
+		if (context.WantExists())
+		{
+			rslt.Set(var != nullptr);
+			return;
+		}
+		ThrowParseException((parameter) ? "unknown parameter '%s'" : "unknown variable '%s'", name);
 	}
 
-	ThrowParseException((parameter) ? "unknown parameter '%s'" : "unknown variable '%s'", name);
+	rslt = var->GetValue();
+	while (*selector == '^')
+	{
+		if (rslt.GetType() != TypeCode::HeapArray)
+		{
+			ThrowParseException("'%s' is not an array", name);
+		}
+		context.AddIndex();
+		const int32_t index = context.GetLastIndex();
+		if (index < 0 || (size_t)index >= rslt.ahVal.GetNumElements())
+		{
+			if (context.WantExists())
+			{
+				rslt.Set(false);
+				return;
+			}
+			ThrowParseException("array index out of bounds");
+		}
+		rslt = rslt.ahVal.GetElement(index);
+		++selector;
+	}
+
+	if (*selector != 0)
+	{
+		ThrowParseException("syntax error in variable reference");
+	}
+
+	if (context.WantExists())
+	{
+		rslt.Set(true);
+	}
+	else if (context.WantArrayLength())
+	{
+		ApplyUnaryOperator('#', rslt, true);
+	}
 }
 
 // Parse a quoted string, given that the current character is double-quote
@@ -11,8 +11,10 @@
 #include <RepRapFirmware.h>
 #include <ObjectModel/ObjectModel.h>
 #include <GCodes/GCodeException.h>
+#include "MacroCache.h"
 
 class VariableSet;
+class VariableHandle;
 
 class ExpressionParser
 {
@@ -36,6 +38,10 @@ public:
 	void CheckForExtraCharacters() THROWS(GCodeException);
 	const char *GetEndptr() const noexcept { return currentp; }
 
+#if SUPPORT_MACRO_CACHE
+	void UseMacroCache(uint32_t fileId, FilePosition pos) noexcept { macroCacheFileId = fileId; macroCacheFilePos = pos; }
+#endif
+
 private:
 	[[noreturn]] void __attribute__((noinline)) ThrowParseException(const char *str) const THROWS(GCodeException);
 	[[noreturn]] void __attribute__((noinline)) ThrowParseException(const char *str, const char *param) const THROWS(GCodeException);
@@ -49,15 +55,49 @@ private:
 		pre(readPointer >= 0; isalpha(gb.buffer[readPointer]));
 	void __attribute__((noinline)) ParseQuotedString(ExpressionValue& rslt) THROWS(GCodeException);
 
-	void ParseArray(size_t& length, function_ref<void(size_t index) THROWS(GCodeException)> processElement) THROWS(GCodeException);
+	void ParseArray(size_t& length, function_ref<void(size_t index, ExpressionValue& val) THROWS(GCodeException)> processElement) THROWS(GCodeException);
+	void __attribute__((noinline)) ParseArrayLiteral(ExpressionValue& val, bool evaluate) THROWS(GCodeException);
 	time_t ParseDateTime(const char *s) const THROWS(GCodeException);
 
-	void GetVariableValue(ExpressionValue& rslt, const VariableSet *vars, const char *name, bool parameter, bool wantExists) THROWS(GCodeException);
+	void GetVariableValue(ExpressionValue& rslt, const VariableSet *vars, const char *name, bool parameter, ObjectExplorationContext& context, VariableHandle *_ecv_null handle) THROWS(GCodeException);
+	void GetNamedConstantValue(ExpressionValue& rslt, unsigned int whichConstant) const THROWS(GCodeException);
+	void __attribute__((noinline)) GetIdentifierValue(ExpressionValue& rslt, const char *id, ObjectExplorationContext& context, VariableHandle *_ecv_null handle = nullptr) THROWS(GCodeException);
+
+	// The following are used by both the text parser and the compiled expression interpreter, so that they give the same results
+	void ApplyUnaryOperator(char op, ExpressionValue& val, bool evaluate) THROWS(GCodeException);
+	void ApplyBinaryOperator(char opChar, bool invert, ExpressionValue& val, ExpressionValue& val2, bool evaluate) THROWS(GCodeException);
+	void __attribute__((noinline)) ApplyFunction(unsigned int func, ExpressionValue& rslt, ExpressionValue *_ecv_null nextOperand, bool evaluate) THROWS(GCodeException);
+	void ApplyFunctionToArrayElements(unsigned int func, ExpressionValue& rslt, bool evaluate) THROWS(GCodeException);
+	static void MakeArray(ExpressionValue& val) noexcept;
+	void AppendToArray(ExpressionValue& arr, const ExpressionValue& element) const THROWS(GCodeException);
+	void GetTablePoint(const ExpressionValue& table, size_t index, float& x, float& y) const THROWS(GCodeException);
+	void InterpolateTable(ExpressionValue& table, float x, bool evaluate) THROWS(GCodeException);
+
+#if SUPPORT_MACRO_CACHE
+	void ParseUsingMacroCache(ExpressionValue& rslt) THROWS(GCodeException);
+	void Execute(const CompiledExpression& expr, ExpressionValue& rslt) THROWS(GCodeException);
+
+	size_t Emit(ExpressionOpcode opcode, uint8_t arg = 0, uint16_t operand = 0) noexcept
+		{ return (compiler != nullptr) ? compiler->Emit(opcode, arg, operand, currentp - startp) : 0; }
+	void EmitConstant(const ExpressionValue& val) noexcept { if (compiler != nullptr) { compiler->EmitConstant(val, currentp - startp); } }
+	void EmitIdentifier(const char *id, uint8_t arg, size_t identifierOffset) noexcept
+		{ if (compiler != nullptr) { compiler->EmitIdentifier(id, arg, currentp - startp, identifierOffset); } }
+	void PatchJump(size_t jumpInstruction, int stackAdjustment = 0) noexcept { if (compiler != nullptr) { compiler->PatchJump(jumpInstruction, stackAdjustment); } }
+	void AbandonCompilation() noexcept { if (compiler != nullptr) { compiler->Fail(); } }
+#else
+	size_t Emit(ExpressionOpcode, uint8_t = 0, uint16_t = 0) noexcept { return 0; }
+	void EmitConstant(const ExpressionValue&) noexcept { }
+	void EmitIdentifier(const char *, uint8_t, size_t) noexcept { }
+	void PatchJump(size_t, int = 0) noexcept { }
+	void AbandonCompilation() noexcept { }
+#endif
 
 	void ConvertToFloat(ExpressionValue& val, bool evaluate) const THROWS(GCodeException);
 	void ConvertToBool(ExpressionValue& val, bool evaluate) const THROWS(GCodeException);
 	void ConvertToString(ExpressionValue& val, bool evaluate) noexcept;
 	void ConvertToDriverId(ExpressionValue& val, bool evaluate) const THROWS(GCodeException);
+	int32_t GetIntegerValue(const ExpressionValue& val) const THROWS(GCodeException);
+	uint32_t GetUnsignedValue(const ExpressionValue& val) const THROWS(GCodeException);
 
 	void CheckStack(uint32_t calledFunctionStackUsage) const THROWS(GCodeException);
 
@@ -78,6 +118,11 @@ private:
 	const GCodeBuffer& gb;
 	int column;
 	String<MaxVariableNameLength> obsoleteField;
+#if SUPPORT_MACRO_CACHE
+	ExpressionCompiler *_ecv_null compiler;				// if not null, we are compiling the expression as we parse it
+	uint32_t macroCacheFileId;							// if nonzero, the expression is in a macro file that we may cache expressions from
+	FilePosition macroCacheFilePos;						// the position of the expression in that file
+#endif
 };
 
 #endif /* SRC_GCODES_GCODEBUFFER_EXPRESSIONPARSER_H_ */
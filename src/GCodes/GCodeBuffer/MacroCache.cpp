@@ -0,0 +1,422 @@
+/*
+ * MacroCache.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "MacroCache.h"
+
+#if SUPPORT_MACRO_CACHE
+
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+#include <Storage/MassStorage.h>
+#include <Storage/CRC32.h>
+
+#include <limits>
+
+// CompiledExpression members
+
+CompiledExpression::CompiledExpression(FilePosition pos, size_t p_sourceLength, uint32_t p_sourceCrc) noexcept
+	: next(nullptr), filePosition(pos), sourceCrc(p_sourceCrc), sourceLength(p_sourceLength), numInstructions(0), numConstants(0), numVariableHandles(0),
+	  memoryUsed(sizeof(CompiledExpression)), constants(nullptr), variableHandles(nullptr), instructions(nullptr), strings(nullptr)
+{
+}
+
+CompiledExpression::~CompiledExpression()
+{
+	delete[] constants;
+	delete[] variableHandles;
+	delete[] reinterpret_cast<uint16_t*>(instructions);
+}
+
+// Calculate the CRC of the source text of an expression. We include the character that ended the expression, because that is what made the text parser stop.
+/*static*/ uint32_t CompiledExpression::SourceCrc(const char *text, const char *textLimit, size_t length) noexcept
+{
+	CRC32 crc;
+	crc.Update(text, min<size_t>(length + 1, textLimit - text));
+	return crc.Get();
+}
+
+// ExpressionCompiler members
+
+void ExpressionCompiler::Reset() noexcept
+{
+	for (size_t i = 0; i < numConstants; ++i)
+	{
+		constants[i].Set(nullptr);						// release any strings
+	}
+	numInstructions = numConstants = numVariableHandles = stringLength = 0;
+	stackDepth = maxStackDepth = 0;
+	failed = false;
+}
+
+// Append an instruction, returning its index
+size_t ExpressionCompiler::Emit(ExpressionOpcode opcode, uint8_t arg, uint16_t operand, size_t offset, size_t identifierOffset, uint8_t variableHandle) noexcept
+{
+	if (failed || numInstructions == MaxCompiledExpressionInstructions || offset > std::numeric_limits<uint16_t>::max())
+	{
+		failed = true;
+		return 0;
+	}
+
+	switch (opcode)
+	{
+	case ExpressionOpcode::pushConstant:
+	case ExpressionOpcode::pushNamedConstant:
+		++stackDepth;
+		break;
+
+	case ExpressionOpcode::pushIdentifier:
+		stackDepth += 1 - (int)(arg & CompiledIdentifierIndicesMask);
+		break;
+
+	case ExpressionOpcode::binaryOperator:
+	case ExpressionOpcode::appendToArray:
+	case ExpressionOpcode::jumpIfFalse:						// if the jump is not taken then the value is popped and the following code pushes a replacement
+	case ExpressionOpcode::jumpIfTrue:
+	case ExpressionOpcode::popJumpIfFalse:
+		--stackDepth;
+		break;
+
+	case ExpressionOpcode::callFunction:
+		if (operand != 0)
+		{
+			--stackDepth;
+		}
+		break;
+
+	default:
+		break;
+	}
+	maxStackDepth = max<int>(maxStackDepth, stackDepth);
+
+	ExpressionInstruction& instr = instructions[numInstructions];
+	instr.opcode = opcode;
+	instr.arg = arg;
+	instr.operand = operand;
+	instr.offset = offset;
+	instr.identifierOffset = identifierOffset;
+	instr.variableHandle = variableHandle;
+	return numInstructions++;
+}
+
+void ExpressionCompiler::EmitConstant(const ExpressionValue& val, size_t offset) noexcept
+{
+	if (numConstants == MaxCompiledExpressionConstants)
+	{
+		failed = true;
+		return;
+	}
+	constants[numConstants] = val;
+	Emit(ExpressionOpcode::pushConstant, 0, numConstants, offset);
+	++numConstants;
+}
+
+void ExpressionCompiler::EmitIdentifier(const char *id, uint8_t arg, size_t offset, size_t identifierOffset) noexcept
+{
+	const size_t len = strlen(id) + 1;
+	if (stringLength + len > MaxCompiledExpressionStringLength)
+	{
+		failed = true;
+		return;
+	}
+	memcpy(strings + stringLength, id, len);
+
+	// Give each variable and parameter reference its own handle so that when the expression is executed again we can usually avoid looking it up by name
+	uint8_t variableHandle = NoVariableHandle;
+	if (numVariableHandles < MaxCompiledExpressionVariables && (StringStartsWith(id, "var.") || StringStartsWith(id, "global.") || StringStartsWith(id, "param.")))
+	{
+		variableHandle = numVariableHandles++;
+	}
+	Emit(ExpressionOpcode::pushIdentifier, arg, stringLength, offset, identifierOffset, variableHandle);
+	stringLength += len;
+}
+
+// Make a jump instruction jump to the next instruction to be emitted. 'stackAdjustment' corrects the stack depth when that instruction can also be reached from somewhere else.
+void ExpressionCompiler::PatchJump(size_t jumpInstruction, int stackAdjustment) noexcept
+{
+	if (!failed)
+	{
+		instructions[jumpInstruction].operand = numInstructions;
+		stackDepth += stackAdjustment;
+	}
+}
+
+// Finish compiling an expression. Return the compiled expression, or nullptr if it could not be compiled.
+CompiledExpression *ExpressionCompiler::Finish(FilePosition pos, const char *text, const char *textLimit, size_t length) noexcept
+{
+	if (failed || stackDepth != 1 || maxStackDepth > (int)MaxCompiledExpressionStackDepth || length > std::numeric_limits<uint16_t>::max())
+	{
+		return nullptr;
+	}
+
+	CompiledExpression * const expr = new CompiledExpression(pos, length, CompiledExpression::SourceCrc(text, textLimit, length));
+	if (numConstants != 0)
+	{
+		expr->constants = new ExpressionValue[numConstants];
+		for (size_t i = 0; i < numConstants; ++i)
+		{
+			expr->constants[i] = constants[i];
+		}
+		expr->numConstants = numConstants;
+		expr->memoryUsed += numConstants * sizeof(ExpressionValue);
+	}
+	if (numVariableHandles != 0)
+	{
+		expr->variableHandles = new VariableHandle[numVariableHandles];
+		expr->numVariableHandles = numVariableHandles;
+		expr->memoryUsed += numVariableHandles * sizeof(VariableHandle);
+	}
+
+	// Allocate a single block to hold the instructions followed by the identifier strings
+	const size_t instructionsSize = numInstructions * sizeof(ExpressionInstruction);
+	uint16_t * const block = new uint16_t[(instructionsSize + stringLength + 1)/sizeof(uint16_t)];
+	expr->instructions = reinterpret_cast<ExpressionInstruction*>(block);
+	memcpy(expr->instructions, instructions, instructionsSize);
+	expr->numInstructions = numInstructions;
+	expr->strings = reinterpret_cast<char*>(block) + instructionsSize;
+	memcpy(expr->strings, strings, stringLength);
+	expr->memoryUsed += instructionsSize + stringLength;
+	return expr;
+}
+
+// MacroCache members
+
+void MacroCache::CachedFile::Flush() noexcept
+{
+	for (CompiledExpression*& bucket : buckets)
+	{
+		while (bucket != nullptr)
+		{
+			CompiledExpression * const e = bucket;
+			bucket = e->next;
+			delete e;
+		}
+	}
+	memoryUsed = 0;
+}
+
+MacroCache::MacroCache() noexcept
+	: files(nullptr), compiler(nullptr), memoryUsed(0), nextFileId(1), useCounter(0), numFiles(0),
+	  hits(0), compilations(0), compilationFailures(0), evictions(0)
+{
+}
+
+// Return the ID of the cache entry for a macro file that has just been opened, creating one if necessary. Return 0 if the file can't be cached.
+// If the file has been modified since we cached expressions from it, discard them.
+uint32_t MacroCache::GetFileId(const char *fileName, FilePosition fileLength) noexcept
+{
+	String<MaxFilenameLength> path;
+	if (!reprap.GetPlatform().MakeSysFileName(path.GetRef(), fileName))
+	{
+		return 0;
+	}
+	const time_t lastModified = MassStorage::GetLastModifiedTime(path.c_str());
+	if (lastModified == 0)
+	{
+		return 0;
+	}
+
+	CRC32 crc;
+	crc.Update(path.c_str(), path.strlen());
+	const uint32_t pathCrc = crc.Get();
+	++useCounter;
+
+	for (CachedFile *f = files; f != nullptr; f = f->next)
+	{
+		if (f->pathCrc == pathCrc)
+		{
+			if (f->lastModified != lastModified || f->length != fileLength)
+			{
+				memoryUsed -= f->memoryUsed;
+				f->Flush();
+				f->lastModified = lastModified;
+				f->length = fileLength;
+			}
+			f->lastUsed = useCounter;
+			return f->id;
+		}
+	}
+
+	// Make a new entry, discarding the least recently used file if necessary
+	if ((numFiles == MaxCachedMacroFiles && !DiscardLeastRecentlyUsed(nullptr)) || !MakeRoom(sizeof(CachedFile), nullptr))
+	{
+		return 0;
+	}
+
+	CachedFile * const f = new CachedFile;
+	f->id = nextFileId++;
+	if (nextFileId == 0)
+	{
+		nextFileId = 1;									// zero means "not cached"
+	}
+	f->pathCrc = pathCrc;
+	f->lastModified = lastModified;
+	f->length = fileLength;
+	f->lastUsed = useCounter;
+	f->memoryUsed = 0;
+	for (CompiledExpression*& bucket : f->buckets)
+	{
+		bucket = nullptr;
+	}
+	f->next = files;
+	files = f;
+	++numFiles;
+	memoryUsed += sizeof(CachedFile);
+	return f->id;
+}
+
+// Find the compiled version of the expression at the specified position in a file, checking that the source text hasn't changed
+const CompiledExpression *MacroCache::Find(uint32_t fileId, FilePosition pos, const char *text, const char *textLimit) noexcept
+{
+	CachedFile * const f = FindFile(fileId);
+	if (f != nullptr)
+	{
+		for (const CompiledExpression *e = f->buckets[GetBucket(pos)]; e != nullptr; e = e->next)
+		{
+			if (e->filePosition == pos)
+			{
+				if (text + e->sourceLength <= textLimit && e->sourceCrc == CompiledExpression::SourceCrc(text, textLimit, e->sourceLength))
+				{
+					f->lastUsed = ++useCounter;
+					++hits;
+					return e;
+				}
+				break;
+			}
+		}
+	}
+	return nullptr;
+}
+
+// Get a compiler ready to compile an expression, or return nullptr if we can't
+ExpressionCompiler *MacroCache::StartCompiling() noexcept
+{
+	if (compiler == nullptr)
+	{
+		compiler = new ExpressionCompiler;
+	}
+	else
+	{
+		compiler->Reset();
+	}
+	return compiler;
+}
+
+// Store the expression that has just been compiled, replacing any previous one at the same position
+void MacroCache::FinishCompiling(uint32_t fileId, FilePosition pos, const char *text, const char *textLimit, size_t length) noexcept
+{
+	CachedFile * const f = FindFile(fileId);
+	if (f == nullptr)
+	{
+		return;
+	}
+
+	CompiledExpression * const expr = compiler->Finish(pos, text, textLimit, length);
+	compiler->Reset();
+	if (expr == nullptr)
+	{
+		++compilationFailures;
+		return;
+	}
+
+	CompiledExpression*& bucket = f->buckets[GetBucket(pos)];
+	for (CompiledExpression **pp = &bucket; *pp != nullptr; pp = &(*pp)->next)
+	{
+		CompiledExpression * const e = *pp;
+		if (e->filePosition == pos)
+		{
+			*pp = e->next;
+			f->memoryUsed -= e->GetMemoryUsed();
+			memoryUsed -= e->GetMemoryUsed();
+			delete e;
+			break;
+		}
+	}
+
+	if (!MakeRoom(expr->GetMemoryUsed(), f))
+	{
+		delete expr;
+		return;
+	}
+
+	expr->next = bucket;
+	bucket = expr;
+	f->memoryUsed += expr->GetMemoryUsed();
+	memoryUsed += expr->GetMemoryUsed();
+	++compilations;
+}
+
+MacroCache::CachedFile *MacroCache::FindFile(uint32_t fileId) const noexcept
+{
+	for (CachedFile *f = files; f != nullptr; f = f->next)
+	{
+		if (f->id == fileId)
+		{
+			return f;
+		}
+	}
+	return nullptr;
+}
+
+void MacroCache::DeleteFile(CachedFile *f) noexcept
+{
+	for (CachedFile **pp = &files; *pp != nullptr; pp = &(*pp)->next)
+	{
+		if (*pp == f)
+		{
+			*pp = f->next;
+			memoryUsed -= f->memoryUsed + sizeof(CachedFile);
+			f->Flush();
+			delete f;
+			--numFiles;
+			++evictions;
+			return;
+		}
+	}
+}
+
+// Discard the least recently used file other than 'keep', returning false if there was no such file
+bool MacroCache::DiscardLeastRecentlyUsed(const CachedFile *keep) noexcept
+{
+	CachedFile *lru = nullptr;
+	for (CachedFile *f = files; f != nullptr; f = f->next)
+	{
+		if (f != keep && (lru == nullptr || (int32_t)(f->lastUsed - lru->lastUsed) < 0))
+		{
+			lru = f;
+		}
+	}
+	if (lru == nullptr)
+	{
+		return false;
+	}
+	DeleteFile(lru);
+	return true;
+}
+
+// Discard least recently used files until we have room for the specified number of additional bytes, but never discard file 'keep'
+bool MacroCache::MakeRoom(size_t bytesNeeded, const CachedFile *keep) noexcept
+{
+	while (memoryUsed + bytesNeeded > MacroCacheMaxMemory)
+	{
+		if (!DiscardLeastRecentlyUsed(keep))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void MacroCache::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Macro cache: %u files, %u bytes, hits %" PRIu32 ", compiled %" PRIu32 ", not compiled %" PRIu32 ", evicted %" PRIu32 "\n",
+									numFiles, memoryUsed, hits, compilations, compilationFailures, evictions);
+	hits = compilations = compilationFailures = evictions = 0;
+}
+
+#endif	// SUPPORT_MACRO_CACHE
+
+// End
@@ -0,0 +1,174 @@
+/*
+ * MacroCache.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * A cache of compiled expressions from the meta commands (if, elif, while, var, global, set and echo) in macro files.
+ * The first time an expression in a macro file is evaluated, ExpressionParser records it as a short postfix program as it parses it.
+ * The program is stored here, keyed by the file and the position of the expression in the file. Later evaluations of the same expression,
+ * for example in the next iteration of a loop or the next time the macro is run, execute the program instead of parsing the text again.
+ * Each program records the length and CRC of its source text, which are checked before the program is used, so an edited file never causes
+ * a stale program to be executed. The programs belonging to a file are discarded when its size or last modified time changes.
+ */
+
+#ifndef SRC_GCODES_GCODEBUFFER_MACROCACHE_H_
+#define SRC_GCODES_GCODEBUFFER_MACROCACHE_H_
+
+#include <RepRapFirmware.h>
+
+// Operations of a compiled expression. The operands and results are held on a small stack of values.
+enum class ExpressionOpcode : uint8_t
+{
+	pushConstant,			// push constant number 'operand'
+	pushNamedConstant,		// push the value of named constant 'arg'
+	pushIdentifier,			// pop the number of indices given by 'arg', then push the value of the variable or object model path at string offset 'operand'
+	checkIndex,				// check that the value on top of the stack is a valid array index
+	unaryOperator,			// apply unary operator 'arg' to the value on top of the stack
+	binaryOperator,			// apply binary operator 'arg' to the top two values, inverting the result of a comparison if 'operand' is nonzero
+	callFunction,			// apply function 'arg' to the value on top of the stack, or if 'operand' is nonzero combine the top two values using it
+	convertToBool,			// check that the value on top of the stack is Boolean
+	makeArray,				// replace the value on top of the stack by an array containing just that value
+	appendToArray,			// pop the value on top of the stack and append it to the array below it
+	jumpIfFalse,			// jump to instruction 'operand' if the value on top of the stack is false, else pop it
+	jumpIfTrue,				// jump to instruction 'operand' if the value on top of the stack is true, else pop it
+	popJumpIfFalse,			// pop the value on top of the stack and jump to instruction 'operand' if it is false
+	jump,					// jump to instruction 'operand'
+};
+
+// Flags and index count in the 'arg' field of a pushIdentifier instruction
+constexpr uint8_t CompiledIdentifierIndicesMask = 0x0F;
+constexpr uint8_t CompiledIdentifierLengthFlag = 0x40;
+constexpr uint8_t CompiledIdentifierExistsFlag = 0x80;
+
+#if SUPPORT_MACRO_CACHE
+
+#include <ObjectModel/ObjectModel.h>
+#include <ObjectModel/Variable.h>
+
+// Value of ExpressionInstruction::variableHandle when the instruction has no variable handle
+constexpr uint8_t NoVariableHandle = 0xFF;
+
+struct ExpressionInstruction
+{
+	ExpressionOpcode opcode;
+	uint8_t arg;
+	uint16_t operand;
+	uint16_t offset;							// the offset in the source text of the parse position when the text parser performed this operation
+	uint16_t identifierOffset;					// for pushIdentifier, the offset in the source text of the start of the identifier
+	uint8_t variableHandle;						// for pushIdentifier of a variable or parameter, the number of the handle that remembers where we last found it
+};
+
+class CompiledExpression
+{
+public:
+	friend class ExpressionCompiler;
+	friend class MacroCache;
+
+	~CompiledExpression();
+
+	size_t GetNumInstructions() const noexcept { return numInstructions; }
+	const ExpressionInstruction& GetInstruction(size_t n) const noexcept pre(n < numInstructions) { return instructions[n]; }
+	const ExpressionValue& GetConstant(size_t n) const noexcept pre(n < numConstants) { return constants[n]; }
+	const char *GetString(size_t offset) const noexcept { return strings + offset; }
+	VariableHandle *_ecv_null GetVariableHandle(const ExpressionInstruction& instr) const noexcept
+		{ return (instr.variableHandle < numVariableHandles) ? &variableHandles[instr.variableHandle] : nullptr; }
+	size_t GetSourceLength() const noexcept { return sourceLength; }
+	size_t GetMemoryUsed() const noexcept { return memoryUsed; }
+
+	static uint32_t SourceCrc(const char *text, const char *textLimit, size_t length) noexcept;
+
+private:
+	CompiledExpression(FilePosition pos, size_t p_sourceLength, uint32_t p_sourceCrc) noexcept;
+
+	CompiledExpression *next;
+	FilePosition filePosition;					// the position in the file of the start of the expression
+	uint32_t sourceCrc;							// the CRC of the source text including the character that ended it
+	uint16_t sourceLength;						// the number of characters that the text parser consumed
+	uint8_t numInstructions;
+	uint8_t numConstants;
+	uint8_t numVariableHandles;
+	size_t memoryUsed;
+	ExpressionValue *constants;
+	VariableHandle *variableHandles;			// these are updated when the expression is executed, so that variables need not be looked up by name every time
+	ExpressionInstruction *instructions;
+	char *strings;								// this follows the instructions in the same block of memory
+};
+
+// Class to build a compiled expression while ExpressionParser parses the text. Any instruction that does not fit or that would make the stack too deep
+// marks the compilation as failed, in which case the expression is not cached and is parsed from text every time.
+class ExpressionCompiler
+{
+public:
+	ExpressionCompiler() noexcept : numConstants(0) { Reset(); }
+
+	void Reset() noexcept;
+	void Fail() noexcept { failed = true; }
+	size_t Emit(ExpressionOpcode opcode, uint8_t arg, uint16_t operand, size_t offset, size_t identifierOffset = 0, uint8_t variableHandle = NoVariableHandle) noexcept;
+	void EmitConstant(const ExpressionValue& val, size_t offset) noexcept;
+	void EmitIdentifier(const char *id, uint8_t arg, size_t offset, size_t identifierOffset) noexcept;
+	void PatchJump(size_t jumpInstruction, int stackAdjustment) noexcept;
+	CompiledExpression *Finish(FilePosition pos, const char *text, const char *textLimit, size_t length) noexcept;
+
+private:
+	ExpressionInstruction instructions[MaxCompiledExpressionInstructions];
+	ExpressionValue constants[MaxCompiledExpressionConstants];
+	char strings[MaxCompiledExpressionStringLength];
+	size_t numInstructions;
+	size_t numConstants;
+	size_t numVariableHandles;
+	size_t stringLength;
+	int stackDepth;
+	int maxStackDepth;
+	bool failed;
+};
+
+class MacroCache
+{
+public:
+	MacroCache() noexcept;
+
+	uint32_t GetFileId(const char *fileName, FilePosition fileLength) noexcept;
+	const CompiledExpression *Find(uint32_t fileId, FilePosition pos, const char *text, const char *textLimit) noexcept;
+	ExpressionCompiler *StartCompiling() noexcept;
+	void FinishCompiling(uint32_t fileId, FilePosition pos, const char *text, const char *textLimit, size_t length) noexcept;
+	void Diagnostics(MessageType mtype) noexcept;
+
+private:
+	static constexpr size_t NumHashBuckets = 8;
+
+	struct CachedFile
+	{
+		CachedFile *next;
+		uint32_t id;
+		uint32_t pathCrc;
+		time_t lastModified;
+		FilePosition length;
+		uint32_t lastUsed;
+		size_t memoryUsed;
+		CompiledExpression *buckets[NumHashBuckets];
+
+		void Flush() noexcept;
+	};
+
+	CachedFile *FindFile(uint32_t fileId) const noexcept;
+	void DeleteFile(CachedFile *f) noexcept;
+	bool DiscardLeastRecentlyUsed(const CachedFile *keep) noexcept;
+	bool MakeRoom(size_t bytesNeeded, const CachedFile *keep) noexcept;
+
+	static size_t GetBucket(FilePosition pos) noexcept { return pos % NumHashBuckets; }
+
+	CachedFile *files;
+	ExpressionCompiler *compiler;				// allocated when we first compile an expression
+	size_t memoryUsed;
+	uint32_t nextFileId;
+	uint32_t useCounter;
+	unsigned int numFiles;
+
+	// Statistics
+	uint32_t hits, compilations, compilationFailures, evictions;
+};
+
+#endif	// SUPPORT_MACRO_CACHE
+
+#endif /* SRC_GCODES_GCODEBUFFER_MACROCACHE_H_ */
@@ -39,6 +39,10 @@ void StringParser::Init() noexcept
 	readPointer = -1;
 	hadLineNumber = hadChecksum = overflowed = seenExpression = false;
 	computedChecksum = 0;
+#if SUPPORT_FAST_MOVE_PARSER
+	moveParametersDecoded = false;
+	currentMoveParameter = -1;
+#endif
 	gb.bufferState = GCodeBufferState::parseNotStarted;
 	commandIndent = 0;
 	if (!seenMetaCommand)
@@ -696,6 +700,7 @@ void StringParser::ProcessVarOrGlobalCommand(bool isGlobal) THROWS(GCodeExceptio
 
 	SkipWhiteSpace();
 	ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
+	UseMacroCache(parser);
 	ExpressionValue ev = parser.Parse();
 	vset->InsertNew(varName.c_str(), ev, (isGlobal) ? 0 : gb.CurrentFileMachineState().GetBlockNesting());
 	if (isGlobal)
@@ -730,6 +735,26 @@ void StringParser::ProcessSetCommand() THROWS(GCodeException)
 		c = gb.buffer[readPointer];
 	} while (isalpha(c) || isdigit(c) || c == '_' );
 
+	// Get any array indices
+	int32_t indices[MaxArrayVariableIndices];
+	size_t numIndices = 0;
+	while (gb.buffer[readPointer] == '[')
+	{
+		if (numIndices == MaxArrayVariableIndices)
+		{
+			throw ConstructParseException("too many array indices");
+		}
+		++readPointer;
+		ExpressionParser indexParser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
+		indices[numIndices++] = indexParser.ParseInteger();
+		readPointer = indexParser.GetEndptr() - gb.buffer;
+		if (gb.buffer[readPointer] != ']')
+		{
+			throw ConstructParseException("expected ']'");
+		}
+		++readPointer;
+	}
+
 	// Expect '='
 	SkipWhiteSpace();
 	if (gb.buffer[readPointer] != '=')
@@ -747,8 +772,20 @@ void StringParser::ProcessSetCommand() THROWS(GCodeException)
 
 	SkipWhiteSpace();
 	ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
+	UseMacroCache(parser);
 	ExpressionValue ev = parser.Parse();
-	var->Assign(ev);
+	if (numIndices == 0)
+	{
+		var->Assign(ev);
+	}
+	else
+	{
+		const char *_ecv_null const err = var->AssignElement(indices, numIndices, ev);
+		if (err != nullptr)
+		{
+			throw ConstructParseException(err);
+		}
+	}
 	if (isGlobal)
 	{
 		reprap.GlobalUpdated();
@@ -826,6 +863,7 @@ void StringParser::ProcessEchoCommand(const StringRef& reply) THROWS(GCodeExcept
 			break;
 		}
 		ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
+		UseMacroCache(parser);
 		const ExpressionValue val = parser.Parse();
 		readPointer = parser.GetEndptr() - gb.buffer;
 		if (!reply.IsEmpty())
@@ -863,11 +901,30 @@ void StringParser::ProcessEchoCommand(const StringRef& reply) THROWS(GCodeExcept
 bool StringParser::EvaluateCondition() THROWS(GCodeException)
 {
 	ExpressionParser parser(gb, gb.buffer + readPointer, gb.buffer + ARRAY_SIZE(gb.buffer), commandIndent + readPointer);
+	UseMacroCache(parser);
 	const bool b = parser.ParseBoolean();
 	parser.CheckForExtraCharacters();
 	return b;
 }
 
+#if SUPPORT_MACRO_CACHE
+
+// If we are executing a macro file that we can cache expressions from, tell the expression parser where the expression is in that file
+void StringParser::UseMacroCache(ExpressionParser& parser) const noexcept
+{
+	const uint32_t fileId = gb.LatestMachineState().macroCacheFileId;
+	if (fileId != 0)
+	{
+		const FilePosition pos = GetFilePosition();
+		if (pos != noFilePosition)
+		{
+			parser.UseMacroCache(fileId, pos + readPointer);
+		}
+	}
+}
+
+#endif
+
 // Decode this command and find the start of the next one on the same line.
 // On entry, 'commandStart' has already been set to the address the start of where the command should be
 // and 'commandIndent' is the number of leading whitespace characters at the start of the current line.
@@ -886,6 +943,10 @@ void StringParser::DecodeCommand() noexcept
 		cl = toupper(cl);
 	}
 	commandFraction = -1;
+#if SUPPORT_FAST_MOVE_PARSER
+	moveParametersDecoded = false;
+	currentMoveParameter = -1;
+#endif
 	if (cl == 'G' || cl == 'M' || cl == 'T')
 	{
 		commandLetter = cl;
@@ -939,7 +1000,19 @@ void StringParser::DecodeCommand() noexcept
 			++parameterStart;
 		}
 
-		FindParameters();
+#if SUPPORT_FAST_MOVE_PARSER
+		// Most commands in a print file are G0/G1/G2/G3 commands with simple numeric parameters, so try to decode them in one pass
+		if (   cl == 'G' && hasCommandNumber && commandNumber >= 0 && commandNumber <= 3 && commandFraction < 0 && !seenExpression
+			&& DecodeMoveParameters()
+		   )
+		{
+			moveParametersDecoded = true;
+		}
+		else
+#endif
+		{
+			FindParameters();
+		}
 	}
 	else if (cl == ';')
 	{
@@ -1022,6 +1095,71 @@ void StringParser::FindParameters() noexcept
 	}
 }
 
+#if SUPPORT_FAST_MOVE_PARSER
+
+// Try to decode the parameters of a G0/G1/G2/G3 command in a single pass, recording the value of each one so that Seen and GetFValue don't need to search the command again.
+// This handles the commands that slicers generate, in which each parameter is an uppercase letter followed by a plain decimal number.
+// Return false if the command needs the full parser, e.g. because it has a quoted string, an escaped or lowercase letter, a list or exponent, or there is another command on the same line.
+// In that case the parameter state is left for FindParameters to set up.
+bool StringParser::DecodeMoveParameters() noexcept
+{
+	Bitmap<uint32_t> params;
+	size_t numParams = 0;
+	unsigned int pos = parameterStart;
+	while (pos < gcodeLineEnd)
+	{
+		const char c = gb.buffer[pos];
+		if (c == ' ' || c == '\t')
+		{
+			++pos;
+			continue;
+		}
+
+		if (c < 'A' || c > 'Z' || c == 'G' || c == 'M' || numParams == MaxMoveParameters)
+		{
+			return false;
+		}
+		++pos;
+
+		// Find the end of the number and make sure that SafeStrtof will stop in the same place, so that we get the same value as ReadFloatValue would
+		unsigned int numEnd = pos;
+		if (gb.buffer[numEnd] == '-' || gb.buffer[numEnd] == '+')
+		{
+			++numEnd;
+		}
+		while (isDigit(gb.buffer[numEnd]) || gb.buffer[numEnd] == '.')
+		{
+			++numEnd;
+		}
+		const char *endptr;
+		const float val = SafeStrtof(gb.buffer + pos, &endptr);
+		if (numEnd == pos || endptr != gb.buffer + numEnd)
+		{
+			return false;
+		}
+
+		const char next = gb.buffer[numEnd];
+		if (next != ' ' && next != '\t' && next != 0 && (next < 'A' || next > 'Z' || next == 'E'))
+		{
+			return false;												// FindParameters doesn't treat E immediately after a digit as a parameter
+		}
+
+		moveParameterLetters[numParams] = c;
+		moveParameterPositions[numParams] = pos;
+		moveParameterValues[numParams] = val;
+		++numParams;
+		params.SetBit(c - 'A');
+		pos = numEnd;
+	}
+
+	parametersPresent = params;
+	numMoveParameters = numParams;
+	commandEnd = gcodeLineEnd;
+	return true;
+}
+
+#endif
+
 // Add an entire string, overwriting any existing content and adding '\n' at the end if necessary to make it a complete line
 void StringParser::PutAndDecode(const char *str, size_t len) noexcept
 {
@@ -1080,7 +1218,7 @@ FilePosition StringParser::GetFilePosition() const noexcept
 # endif
 	   )
 	{
-		return gb.LatestMachineState().fileState.GetPosition() - gb.fileInput->BytesCached() - commandLength + commandStart;
+		return gb.fileInput->GetCommandPosition(gb.LatestMachineState().fileState, commandLength, commandStart);
 	}
 #endif
 	return noFilePosition;
@@ -1116,6 +1254,27 @@ bool StringParser::Seen(char c) noexcept
 		return false;
 	}
 
+#if SUPPORT_FAST_MOVE_PARSER
+	if (moveParametersDecoded)
+	{
+		// The command has no escaped letters, so we only need to look for uppercase ones
+		if (!wantLowerCase)
+		{
+			for (size_t i = 0; i < numMoveParameters; ++i)
+			{
+				if (moveParameterLetters[i] == c)
+				{
+					currentMoveParameter = (int8_t)i;
+					readPointer = moveParameterPositions[i];
+					return true;
+				}
+			}
+		}
+		readPointer = -1;
+		return false;
+	}
+#endif
+
 	bool inQuotes = false;
 	bool escaped = false;
 	unsigned int inBrackets = 0;
@@ -1173,6 +1332,15 @@ float StringParser::GetFValue() THROWS(GCodeException)
 		THROW_INTERNAL_ERROR;
 	}
 
+#if SUPPORT_FAST_MOVE_PARSER
+	// If the parameter was decoded already then we can use its value, unless another function has read some of it since Seen was called
+	if (moveParametersDecoded && currentMoveParameter >= 0 && moveParameterPositions[currentMoveParameter] == (unsigned int)readPointer)
+	{
+		readPointer = -1;
+		return moveParameterValues[currentMoveParameter];
+	}
+#endif
+
 	const float result = ReadFloatValue();
 	readPointer = -1;
 	return result;
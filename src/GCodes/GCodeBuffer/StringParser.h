@@ -16,6 +16,8 @@
 #include <Networking/NetworkDefs.h>
 #include <Storage/CRC16.h>
 
+class ExpressionParser;
+
 class GCodeBuffer;
 class IPAddress;
 class MacAddress;
@@ -121,9 +123,17 @@ private:
 	void ProcessEchoCommand(const StringRef& reply) THROWS(GCodeException);
 
 	bool EvaluateCondition() THROWS(GCodeException);
+#if SUPPORT_MACRO_CACHE
+	void UseMacroCache(ExpressionParser& parser) const noexcept;
+#else
+	void UseMacroCache(ExpressionParser&) const noexcept { }
+#endif
 
 	void SkipWhiteSpace() noexcept;
 	void FindParameters() noexcept;
+#if SUPPORT_FAST_MOVE_PARSER
+	bool DecodeMoveParameters() noexcept SPEED_CRITICAL;
+#endif
 
 	unsigned int commandStart;							// Index in the buffer of the command letter of this command
 	unsigned int parameterStart;
@@ -134,6 +144,17 @@ private:
 	Bitmap<uint32_t> parametersPresent;					// which parameters are present in this command
 	int readPointer;									// Where in the buffer to read next, or -1
 
+#if SUPPORT_FAST_MOVE_PARSER
+	// Parameters of a plain G0/G1/G2/G3 command decoded by DecodeMoveParameters
+	static constexpr size_t MaxMoveParameters = 12;
+	float moveParameterValues[MaxMoveParameters];
+	uint16_t moveParameterPositions[MaxMoveParameters];	// index in the buffer of the character after each parameter letter
+	char moveParameterLetters[MaxMoveParameters];
+	uint8_t numMoveParameters;
+	int8_t currentMoveParameter;						// the parameter found by the last call to Seen, or -1
+	bool moveParametersDecoded;							// true if the current command was decoded by DecodeMoveParameters
+#endif
+
 	FileStore *fileBeingWritten;						// If we are copying GCodes to a file, which file it is
 	FilePosition writingFileSize;						// Size of the file being written, or zero if not known
 
@@ -250,9 +250,64 @@ bool NetworkGCodeInput::FillBuffer(GCodeBuffer *gb) noexcept /*override*/
 
 // File-based G-code input source
 
+#if SUPPORT_FILE_READ_AHEAD
+
+#include <Platform/TaskPriorities.h>
+
+constexpr size_t FileReadAheadTaskStackWords = 500;					// enough for FatFS and for reporting a read error
+static Task<FileReadAheadTaskStackWords> *readAheadTask = nullptr;
+static FileGCodeInput *volatile readAheadOwner = nullptr;			// the input that the read-ahead task reads for. In practice there is only one FileGCodeInput.
+
+extern "C" [[noreturn]] void FileReadAheadTask(void *pvParameters) noexcept
+{
+	for (;;)
+	{
+		TaskBase::Take(TaskBase::TimeoutUnlimited);
+		FileGCodeInput * const input = readAheadOwner;
+		if (input != nullptr)
+		{
+			input->DoReadAhead();
+		}
+	}
+}
+
+#endif
+
+#if SUPPORT_BINARY_GCODE
+# include "BinaryGCodeDecoder.h"
+# include <Platform/Platform.h>
+#endif
+
+#if SUPPORT_FILE_READ_AHEAD || SUPPORT_BINARY_GCODE
+
+FileGCodeInput::FileGCodeInput() noexcept
+	: RegularGCodeInput()
+# if SUPPORT_FILE_READ_AHEAD
+	  , nextReadPosition(0), readRequestSize(0), readResult(0), readInProgress(false),
+	  fillBlock(0), consumeBlock(0), readPending(false), endOfFile(false), readError(false)
+# endif
+# if SUPPORT_BINARY_GCODE
+	  , binaryDecoder(nullptr), lastLinePosition(0), recordsToSkip(0), binaryFile(false), binaryError(false)
+# endif
+{
+# if SUPPORT_FILE_READ_AHEAD
+	blocks[0].length = blocks[0].readPointer = 0;
+	blocks[1].length = blocks[1].readPointer = 0;
+# endif
+}
+
+#endif
+
 // Reset this input. Should be called when the associated file is being closed
 void FileGCodeInput::Reset() noexcept
 {
+#if SUPPORT_FILE_READ_AHEAD
+	DiscardReadAhead();
+#endif
+#if SUPPORT_BINARY_GCODE
+	binaryFile = binaryError = false;
+	recordsToSkip = 0;
+#endif
 	lastFileRead.Close();
 	RegularGCodeInput::Reset();
 }
@@ -266,24 +321,263 @@ void FileGCodeInput::Reset(const FileData &file) noexcept
 	}
 }
 
+// Get the position in the file of the next character that FillBuffer will return
+FilePosition FileGCodeInput::GetPosition(const FileData &file) const noexcept
+{
+#if SUPPORT_BINARY_GCODE
+	if (binaryFile && lastFileRead == file)
+	{
+		return (binaryDecoder->HaveRecord()) ? binaryDecoder->GetRecordPosition() : GetRawPosition();
+	}
+#endif
+#if SUPPORT_FILE_READ_AHEAD
+	if (lastFileRead == file)
+	{
+		// We keep track of the file position ourselves because the read-ahead task may be changing it
+		return nextReadPosition - BytesReadAhead() - BytesCached();
+	}
+#endif
+	return file.GetPosition() - BytesCached();
+}
+
+// Get the position in the file of a command that starts 'offset' characters into the line that FillBuffer returned last, given that the line was 'lineLength' characters long
+FilePosition FileGCodeInput::GetCommandPosition(const FileData &file, size_t lineLength, size_t offset) const noexcept
+{
+#if SUPPORT_BINARY_GCODE
+	if (binaryFile && lastFileRead == file)
+	{
+		return lastLinePosition;							// each line of a binary file comes from a single record, which is identified by its position
+	}
+#endif
+	return GetPosition(file) - lineLength + offset;
+}
+
+#if SUPPORT_FILE_READ_AHEAD
+
 // Read another chunk of G-codes from the file and return true if more data is available
 GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 {
-	const size_t bytesCached = BytesCached();
-
 	// Keep track of the last file we read from
-	if (lastFileRead.IsLive() && lastFileRead != file)
+	if (lastFileRead != file)
 	{
-		if (bytesCached > 0)
+		if (lastFileRead.IsLive())
 		{
 			// Rewind back to the right position so we can resume at the right position later.
 			// This may be necessary when nested macros are executed.
-			lastFileRead.Seek(lastFileRead.GetPosition() - bytesCached);
+			WaitForReadAhead();
+			const FilePosition pos = GetPosition(lastFileRead);
+			if (pos != nextReadPosition)
+			{
+				lastFileRead.Seek(pos);
+			}
 		}
 
+		DiscardReadAhead();
 		RegularGCodeInput::Reset();
+		lastFileRead.CopyFrom(file);
+#if SUPPORT_BINARY_GCODE
+		CheckFileFormat(lastFileRead);
+#endif
+		nextReadPosition = file.GetPosition();
+	}
+
+#if SUPPORT_BINARY_GCODE
+	if (binaryFile)
+	{
+		return ReadFromBinaryFile();
+	}
+#endif
+
+	for (;;)
+	{
+		CheckReadAheadFinished();
+		if (readError)
+		{
+			return GCodeInputReadResult::error;
+		}
+
+		if (BytesCached() < GCodeInputFileReadThreshold)
+		{
+			TransferReadAheadData();
+		}
+		StartReadAhead();								// keep the read-ahead task busy
+
+		if (BytesCached() != 0)
+		{
+			return GCodeInputReadResult::haveData;
+		}
+		if (!readPending)
+		{
+			return GCodeInputReadResult::noData;		// we have reached the end of the file
+		}
+		WaitForReadAhead();								// the SD card hasn't kept up with us
+	}
+}
+
+// Return the number of bytes that have been read from the file but not yet passed to the ring buffer
+size_t FileGCodeInput::BytesReadAhead() const noexcept
+{
+	return (blocks[0].length - blocks[0].readPointer) + (blocks[1].length - blocks[1].readPointer);
+}
+
+// If the next block is empty and we haven't reached the end of the file, ask the read-ahead task to read it
+void FileGCodeInput::StartReadAhead() noexcept
+{
+	if (!readPending && !endOfFile && !readError && blocks[fillBlock].IsEmpty())
+	{
+		blocks[fillBlock].length = blocks[fillBlock].readPointer = 0;
+
+		// Read up to the end of a sector, so that after the first read of a file all reads start on a sector boundary
+		readRequestSize = FileReadAheadBlockSize - (size_t)(nextReadPosition % FileReadAheadSectorSize);
+		readPending = true;
+		readInProgress.store(true);
+
+		if (readAheadOwner == nullptr)
+		{
+			readAheadOwner = this;
+		}
+
+		if (readAheadOwner == this)
+		{
+			if (readAheadTask == nullptr)
+			{
+				readAheadTask = new Task<FileReadAheadTaskStackWords>;
+				readAheadTask->Create(FileReadAheadTask, "FILEREAD", nullptr, TaskPriority::SpinPriority);
+			}
+			readAheadTask->Give();
+		}
+		else
+		{
+			DoReadAhead();								// another input is using the read-ahead task, so read the block ourselves
+		}
 	}
-	lastFileRead.CopyFrom(file);
+}
+
+// Read the block that has been asked for. This is normally called by the read-ahead task.
+void FileGCodeInput::DoReadAhead() noexcept
+{
+	if (readInProgress.load(std::memory_order_acquire))
+	{
+		readResult = lastFileRead.Read(blocks[fillBlock].data, readRequestSize);
+		readInProgress.store(false, std::memory_order_release);
+		readDone.Give();
+	}
+}
+
+// If the read-ahead task has finished reading a block, account for it
+void FileGCodeInput::CheckReadAheadFinished() noexcept
+{
+	if (readPending && !readInProgress.load(std::memory_order_acquire))
+	{
+		readPending = false;
+		const int result = readResult;
+		if (result < 0)
+		{
+			readError = true;
+		}
+		else if (result == 0)
+		{
+			endOfFile = true;
+		}
+		else
+		{
+			blocks[fillBlock].length = (size_t)result;
+			nextReadPosition += (FilePosition)result;
+			fillBlock ^= 1;
+		}
+	}
+}
+
+// Wait until the read-ahead task isn't reading for us, so that we can use the file
+void FileGCodeInput::WaitForReadAhead() noexcept
+{
+	while (readInProgress.load(std::memory_order_acquire))
+	{
+		(void)readDone.Take(FileReadAheadWaitTime);
+	}
+	CheckReadAheadFinished();
+}
+
+// Discard any data that we have read ahead
+void FileGCodeInput::DiscardReadAhead() noexcept
+{
+	WaitForReadAhead();
+	blocks[0].length = blocks[0].readPointer = 0;
+	blocks[1].length = blocks[1].readPointer = 0;
+	fillBlock = consumeBlock = 0;
+	endOfFile = readError = false;
+}
+
+// Copy as much data as we can from the blocks that have been read into the ring buffer
+void FileGCodeInput::TransferReadAheadData() noexcept
+{
+	// Reset the read+write pointers for better performance if possible
+	if (readingPointer == writingPointer)
+	{
+		readingPointer = writingPointer = 0;
+	}
+
+	for (;;)
+	{
+		ReadAheadBlock& blk = blocks[consumeBlock];
+		if (blk.IsEmpty())
+		{
+			// Move on to the other block unless it is still being read or it has no data
+			const unsigned int otherBlock = consumeBlock ^ 1;
+			if ((readPending && fillBlock == otherBlock) || blocks[otherBlock].IsEmpty())
+			{
+				break;
+			}
+			consumeBlock = otherBlock;
+			continue;
+		}
+
+		const size_t spaceLeft = min<size_t>(BufferSpaceLeft(), GCodeInputBufferSize - writingPointer);
+		if (spaceLeft == 0)
+		{
+			break;
+		}
+		const size_t bytesToCopy = min<size_t>(spaceLeft, blk.length - blk.readPointer);
+		memcpy(buffer + writingPointer, blk.data + blk.readPointer, bytesToCopy);
+		blk.readPointer += bytesToCopy;
+		writingPointer = (writingPointer + bytesToCopy) % GCodeInputBufferSize;
+	}
+}
+
+#else
+
+// Read another chunk of G-codes from the file and return true if more data is available
+GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
+{
+	// Keep track of the last file we read from
+	if (lastFileRead != file)
+	{
+		if (lastFileRead.IsLive())
+		{
+			// Rewind back to the right position so we can resume at the right position later.
+			// This may be necessary when nested macros are executed.
+			const FilePosition pos = GetPosition(lastFileRead);
+			if (pos != lastFileRead.GetPosition())
+			{
+				lastFileRead.Seek(pos);
+			}
+
+			RegularGCodeInput::Reset();
+		}
+		lastFileRead.CopyFrom(file);
+#if SUPPORT_BINARY_GCODE
+		CheckFileFormat(lastFileRead);
+#endif
+	}
+
+#if SUPPORT_BINARY_GCODE
+	if (binaryFile)
+	{
+		return ReadFromBinaryFile();
+	}
+#endif
+
+	const size_t bytesCached = BytesCached();
 
 	// Read more from the file
 	if (bytesCached < GCodeInputFileReadThreshold)
@@ -314,4 +608,201 @@ GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 
 #endif
 
+#if SUPPORT_BINARY_GCODE
+
+// Check whether the file we are about to read from is a binary G-code file. If it is, make sure that we start reading it at the start of a block,
+// and work out how many records in that block were executed before we stopped reading it.
+void FileGCodeInput::CheckFileFormat(FileData &file) noexcept
+{
+	binaryFile = binaryError = false;
+	recordsToSkip = 0;
+	const FilePosition pos = file.GetPosition();
+	GCodeFileFormat format = file.GetGCodeFormat();
+	FilePosition dataStart = 0;
+
+	// We only need to read the header if we haven't seen this file before, or if we are positioned before the start of the data blocks
+	if (format == GCodeFileFormat::unknown || (format == GCodeFileFormat::binary && pos < BinaryGCodeFileHeaderSize + BinaryGCodeMaxMetadataLength))
+	{
+		alignas(4) char header[BinaryGCodeFileHeaderSize];
+		size_t metadataLength;
+		if (   file.Seek(0)
+			&& file.Read(header, sizeof(header)) == (int)sizeof(header)
+			&& BinaryGCodeDecoder::IsFileHeader(header, sizeof(header), metadataLength)
+		   )
+		{
+			format = GCodeFileFormat::binary;
+			dataStart = BinaryGCodeDecoder::GetDataStart(metadataLength);
+		}
+		else
+		{
+			format = GCodeFileFormat::text;
+			file.Seek(pos);
+		}
+		file.SetGCodeFormat(format);
+	}
+
+	if (format == GCodeFileFormat::binary)
+	{
+		if (binaryDecoder == nullptr)
+		{
+			binaryDecoder = new BinaryGCodeDecoder;
+		}
+		binaryDecoder->Clear();
+		binaryFile = true;
+
+		// The positions that we report lie within the block that holds the record, so the block starts at the previous block boundary
+		FilePosition blockPosition = pos & ~(FilePosition)(BinaryGCodeBlockSize - 1);
+		if (blockPosition < dataStart)
+		{
+			blockPosition = dataStart;
+		}
+		else if (pos > blockPosition + BinaryGCodeBlockHeaderSize)
+		{
+			recordsToSkip = pos - (blockPosition + BinaryGCodeBlockHeaderSize);
+		}
+
+		if (file.GetPosition() != blockPosition)
+		{
+			file.Seek(blockPosition);
+		}
+	}
+}
+
+// Make sure that there is a record available to decode from the binary file we are reading
+GCodeInputReadResult FileGCodeInput::ReadFromBinaryFile() noexcept
+{
+	while (!binaryError && !binaryDecoder->HaveRecord())
+	{
+		const FilePosition blockPosition = GetRawPosition();
+		const int bytesRead = ReadRawData(binaryDecoder->GetBlockBuffer(), BinaryGCodeBlockSize);
+		if (bytesRead < 0)
+		{
+			return GCodeInputReadResult::error;
+		}
+		if (bytesRead == 0)
+		{
+			return GCodeInputReadResult::noData;
+		}
+
+		const char *_ecv_null const errorMessage = binaryDecoder->LoadBlock((size_t)bytesRead, blockPosition);
+		if (errorMessage != nullptr)
+		{
+			ReportBinaryFileError(errorMessage, blockPosition);
+		}
+		else if (recordsToSkip != 0)
+		{
+			if (!binaryDecoder->SkipRecords(recordsToSkip))
+			{
+				ReportBinaryFileError("bad record", binaryDecoder->GetRecordPosition());
+			}
+			recordsToSkip = 0;
+		}
+	}
+	return (binaryError) ? GCodeInputReadResult::error : GCodeInputReadResult::haveData;
+}
+
+// Fill a GCodeBuffer with the next line of G-code. We decode binary files one record at a time so that we know which record each command came from.
+bool FileGCodeInput::FillBuffer(GCodeBuffer *gb) noexcept
+{
+	if (!binaryFile)
+	{
+		return StandardGCodeInput::FillBuffer(gb);
+	}
+
+	while (!binaryError && binaryDecoder->HaveRecord())
+	{
+		lastLinePosition = binaryDecoder->GetRecordPosition();
+		size_t length;
+		const char *_ecv_array _ecv_null const line = binaryDecoder->DecodeRecord(length);
+		if (line == nullptr)
+		{
+			ReportBinaryFileError("bad record", lastLinePosition);
+			break;
+		}
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			(void)gb->Put(line[i]);
+		}
+		if (gb->Put('\n'))								// process the end of the line, returns true if a line of GCode is complete
+		{
+#if HAS_MASS_STORAGE
+			if (gb->IsWritingFile())
+			{
+				gb->WriteToFile();
+			}
+			else
+#endif
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Read data from the binary file, returning the number of bytes read or -1 if there was an error. Only a short read at the end of the file returns fewer bytes than requested.
+int FileGCodeInput::ReadRawData(char *_ecv_array dst, size_t length) noexcept
+{
+#if SUPPORT_FILE_READ_AHEAD
+	size_t bytesRead = 0;
+	while (bytesRead < length)
+	{
+		CheckReadAheadFinished();
+		if (readError)
+		{
+			return -1;
+		}
+
+		ReadAheadBlock& blk = blocks[consumeBlock];
+		if (blk.IsEmpty())
+		{
+			// Move on to the other block if it has data, else wait for more data to be read
+			const unsigned int otherBlock = consumeBlock ^ 1;
+			if (!(readPending && fillBlock == otherBlock) && !blocks[otherBlock].IsEmpty())
+			{
+				consumeBlock = otherBlock;
+				continue;
+			}
+			StartReadAhead();
+			if (!readPending)
+			{
+				break;									// we have reached the end of the file
+			}
+			WaitForReadAhead();
+			continue;
+		}
+
+		const size_t bytesToCopy = min<size_t>(length - bytesRead, blk.length - blk.readPointer);
+		memcpy(dst + bytesRead, blk.data + blk.readPointer, bytesToCopy);
+		blk.readPointer += bytesToCopy;
+		bytesRead += bytesToCopy;
+	}
+	StartReadAhead();									// keep the read-ahead task busy
+	return (int)bytesRead;
+#else
+	return lastFileRead.Read(dst, length);
+#endif
+}
+
+// Get the position in the binary file of the next byte that ReadRawData will return
+FilePosition FileGCodeInput::GetRawPosition() const noexcept
+{
+#if SUPPORT_FILE_READ_AHEAD
+	return nextReadPosition - BytesReadAhead();
+#else
+	return lastFileRead.GetPosition();
+#endif
+}
+
+void FileGCodeInput::ReportBinaryFileError(const char *_ecv_array msg, FilePosition pos) noexcept
+{
+	reprap.GetPlatform().MessageF(ErrorMessage, "binary G-code file has %s at offset %" PRIu32 "\n", msg, pos);
+	binaryError = true;
+}
+
+#endif
+
+#endif
+
 // End
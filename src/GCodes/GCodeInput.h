@@ -14,6 +14,14 @@
 
 #include <Stream.h>
 
+#if SUPPORT_FILE_READ_AHEAD
+# include <atomic>
+#endif
+
+#if SUPPORT_BINARY_GCODE
+class BinaryGCodeDecoder;
+#endif
+
 const size_t GCodeInputBufferSize = 256;						// How many bytes can we cache per input source? Make this a power of 2 for efficiency
 
 // This base class provides incoming G-codes for the GCodeBuffer class
@@ -105,18 +113,81 @@ enum class GCodeInputReadResult : uint8_t { haveData, noData, error };
 
 // This class is an expansion of the RegularGCodeInput class to buffer G-codes and to rewind file positions when
 // nested G-code files are started. However buffered codes are not explicitly checked for M112.
+// When SUPPORT_FILE_READ_AHEAD is set, the file is read in large blocks by a separate task while the G-code parser works through the previous block,
+// so that the GCodes task rarely has to wait for the SD card.
+// All the input channels share one FileGCodeInput, so when a different channel reads a file we rewind the previous file and discard up to two blocks
+// that were read ahead. We accept re-reading those blocks on each switch because another 4KB of read-ahead buffer per channel would cost too much RAM.
+// When SUPPORT_BINARY_GCODE is set, binary G-code files are decoded one record at a time into lines of G-code instead of passing through the ring buffer.
 class FileGCodeInput : public RegularGCodeInput
 {
 public:
 
+#if SUPPORT_FILE_READ_AHEAD || SUPPORT_BINARY_GCODE
+	FileGCodeInput() noexcept;
+#else
 	FileGCodeInput() noexcept : RegularGCodeInput() { }
+#endif
 
 	void Reset() noexcept override;								// Clears the buffer. Should be called when the associated file is being closed
 	void Reset(const FileData &file) noexcept;					// Clears the buffer of a specific file. Should be called when it is closed or re-opened outside the reading context
+#if SUPPORT_BINARY_GCODE
+	bool FillBuffer(GCodeBuffer *gb) noexcept override;			// Fill a GCodeBuffer with the last available G-code
+#endif
 
 	GCodeInputReadResult ReadFromFile(FileData &file) noexcept;	// Read another chunk of G-codes from the file and return true if more data is available
+	FilePosition GetPosition(const FileData &file) const noexcept;	// Get the position in the file of the next character that FillBuffer will return
+	FilePosition GetCommandPosition(const FileData &file, size_t lineLength, size_t offset) const noexcept;
+																// Get the position in the file of a command in the line that FillBuffer returned last
+
+#if SUPPORT_FILE_READ_AHEAD
+	void DoReadAhead() noexcept;								// Called by the read-ahead task to read the next block
+#endif
 
 private:
+#if SUPPORT_FILE_READ_AHEAD
+	struct ReadAheadBlock
+	{
+		size_t length;											// how many bytes were read into this block
+		size_t readPointer;										// how many of them we have passed to the ring buffer
+		alignas(4) char data[FileReadAheadBlockSize];			// aligned so that the SD card driver can use DMA to read straight into it
+
+		bool IsEmpty() const noexcept { return readPointer == length; }
+	};
+
+	size_t BytesReadAhead() const noexcept;
+	void StartReadAhead() noexcept;
+	void CheckReadAheadFinished() noexcept;
+	void WaitForReadAhead() noexcept;
+	void DiscardReadAhead() noexcept;
+	void TransferReadAheadData() noexcept;
+
+	ReadAheadBlock blocks[2];
+	FilePosition nextReadPosition;								// the position in the file at which the next block read will start
+	size_t readRequestSize;										// the number of bytes that the read-ahead task has been asked to read
+	volatile int readResult;									// the number of bytes that the read-ahead task read, or -1 if there was an error
+	std::atomic<bool> readInProgress;							// set by this task when it asks for a block to be read, cleared by the read-ahead task when it has read it
+	BinarySemaphore readDone;									// given by the read-ahead task when it has read a block
+	unsigned int fillBlock;										// the block that is being read or will be read next
+	unsigned int consumeBlock;									// the block that we are taking data from
+	bool readPending;											// true if we have asked for a block and haven't processed the result yet
+	bool endOfFile;
+	bool readError;
+#endif
+
+#if SUPPORT_BINARY_GCODE
+	void CheckFileFormat(FileData &file) noexcept;
+	GCodeInputReadResult ReadFromBinaryFile() noexcept;
+	int ReadRawData(char *_ecv_array dst, size_t length) noexcept;
+	FilePosition GetRawPosition() const noexcept;
+	void ReportBinaryFileError(const char *_ecv_array msg, FilePosition pos) noexcept;
+
+	BinaryGCodeDecoder *_ecv_null binaryDecoder;				// allocated when we first read a binary file
+	FilePosition lastLinePosition;								// the position in the file of the record that the last line we returned came from
+	unsigned int recordsToSkip;									// the number of records in the first block we read that have been executed already
+	bool binaryFile;											// true if the file we are reading is a binary G-code file
+	bool binaryError;											// true if we found bad data in the binary G-code file
+#endif
+
 	FileData lastFileRead;
 };
 
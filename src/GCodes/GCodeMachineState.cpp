@@ -15,6 +15,9 @@ GCodeMachineState::GCodeMachineState() noexcept
 	: feedRate(ConvertSpeedFromMmPerMin(DefaultFeedRate)),
 #if HAS_SBC_INTERFACE
 	  fileId(NoFileId),
+#endif
+#if SUPPORT_MACRO_CACHE
+	  macroCacheFileId(0),
 #endif
 	  lineNumber(0),
 	  selectedPlane(0), drivesRelative(false), axesRelative(false),
@@ -39,6 +42,9 @@ GCodeMachineState::GCodeMachineState(GCodeMachineState& prev, bool withinSameFil
 #endif
 #if HAS_SBC_INTERFACE
 	  fileId(prev.fileId),
+#endif
+#if SUPPORT_MACRO_CACHE
+	  macroCacheFileId((withinSameFile) ? prev.macroCacheFileId : 0),
 #endif
 	  lockedResources(prev.lockedResources),
 	  lineNumber(0),
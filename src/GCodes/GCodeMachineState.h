@@ -205,6 +205,9 @@ public:
 #endif
 #if HAS_SBC_INTERFACE
 	FileId fileId;													// virtual ID to distinguish files in different stack levels (only unique per GB)
+#endif
+#if SUPPORT_MACRO_CACHE
+	uint32_t macroCacheFileId;										// the ID of the macro cache entry for the file we are executing, or zero if none
 #endif
 	// Note, having a bit set in lockedResources doesn't necessarily mean that we own the lock!
 	// It means we acquired the lock at this stack level, and haven't released it at this level. It may have been released at a more nested level, or stolen from us (see GrabResource).
@@ -80,7 +80,7 @@ GCodes::GCodes(Platform& p) noexcept :
 {
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 	fileBeingHashed = nullptr;
-	FileGCodeInput * const fileInput = new FileGCodeInput();
+	FileGCodeInput * const fileInput = new FileGCodeInput();		// shared by all channels, see the comments about read-ahead in GCodeInput.h
 #else
 	FileGCodeInput * const fileInput = nullptr;
 #endif
@@ -1404,6 +1404,9 @@ void GCodes::Diagnostics(MessageType mtype) noexcept
 	}
 
 	codeQueue->Diagnostics(mtype);
+#if SUPPORT_MACRO_CACHE
+	macroCache.Diagnostics(mtype);
+#endif
 }
 
 // Lock movement and wait for pending moves to finish.
@@ -1999,11 +2002,16 @@ bool GCodes::DoStraightMove(GCodeBuffer& gb, bool isCoordinated, const char *& e
 		{
 			const HeightMap& heightMap = reprap.GetMove().AccessHeightMap();
 			const GridDefinition& grid = heightMap.GetGrid();
-			const unsigned int minMeshSegments = max<unsigned int>(
-					1,
-					heightMap.GetMinimumSegments(
-						moveState.currentUserPosition[grid.GetAxisNumber(0)] - initialUserPosition[grid.GetAxisNumber(0)],
-						moveState.currentUserPosition[grid.GetAxisNumber(1)] - initialUserPosition[grid.GetAxisNumber(1)]
+			const unsigned int minMeshSegments = reprap.GetMove().GetMeshSegments(
+					moveState.initialCoords,
+					moveState.coords,
+					moveState.tool,
+					max<unsigned int>(
+						1,
+						heightMap.GetMinimumSegments(
+							moveState.currentUserPosition[grid.GetAxisNumber(0)] - initialUserPosition[grid.GetAxisNumber(0)],
+							moveState.currentUserPosition[grid.GetAxisNumber(1)] - initialUserPosition[grid.GetAxisNumber(1)]
+						)
 					)
 			);
 			if (minMeshSegments > moveState.totalSegments)
@@ -2347,24 +2355,46 @@ bool GCodes::DoArcMove(GCodeBuffer& gb, bool clockwise, const char *& err)
 		}
 	}
 
-	// Compute how many segments to use
-	// For the arc to deviate up to MaxArcDeviation from the ideal, the segment length should be sqrtf(8 * arcRadius * MaxArcDeviation + fsquare(MaxArcDeviation))
-	// We leave out the square term because it is very small
-	// In CNC applications even very small deviations can be visible, so we use a smaller segment length at low speeds
-	const float arcSegmentLength = constrain<float>
-									(	min<float>(fastSqrtf(8 * moveState.arcRadius * MaxArcDeviation), moveState.feedRate * StepClockRate * (1.0/MinArcSegmentsPerSec)),
-										MinArcSegmentLength,
-										MaxArcSegmentLength
-									);
-	moveState.totalSegments = max<unsigned int>((unsigned int)((moveState.arcRadius * totalArc)/arcSegmentLength + 0.8), 1u);
-	moveState.arcAngleIncrement = totalArc/moveState.totalSegments;
-	if (clockwise)
+#if SUPPORT_NATIVE_ARCS
+	// If Move can execute true arcs in the machine coordinates of the arc axes, pass it the arc in a few pieces instead of many short straight segments.
+	// Each piece lies within one quadrant so that each arc axis moves in one direction only, which also means that checking the end of each piece against the machine limits is sufficient.
+	moveState.useNativeArcs = axis0Mapping.CountSetBits() == 1 && axis1Mapping.CountSetBits() == 1
+							&& axisScaleFactors[axis0Mapping.LowestSetBit()] > 0.0
+							&& axisScaleFactors[axis0Mapping.LowestSetBit()] == axisScaleFactors[axis1Mapping.LowestSetBit()]
+							&& reprap.GetMove().CanUseNativeArcs(axis0Mapping.LowestSetBit(), axis1Mapping.LowestSetBit());
+	if (moveState.useNativeArcs)
 	{
-		moveState.arcAngleIncrement = -moveState.arcAngleIncrement;
+		moveState.arcTotalAngle = (clockwise) ? -totalArc : totalArc;
+		moveState.arcFinalAngle = moveState.arcCurrentAngle + moveState.arcTotalAngle;
+		unsigned int numPieces = 0;
+		for (float angle = moveState.arcCurrentAngle; angle != moveState.arcFinalAngle; angle = GetNextNativeArcAngle(angle))
+		{
+			++numPieces;
+		}
+		moveState.totalSegments = numPieces;
+	}
+	else
+#endif
+	{
+		// Compute how many segments to use
+		// For the arc to deviate up to MaxArcDeviation from the ideal, the segment length should be sqrtf(8 * arcRadius * MaxArcDeviation + fsquare(MaxArcDeviation))
+		// We leave out the square term because it is very small
+		// In CNC applications even very small deviations can be visible, so we use a smaller segment length at low speeds
+		const float arcSegmentLength = constrain<float>
+										(	min<float>(fastSqrtf(8 * moveState.arcRadius * MaxArcDeviation), moveState.feedRate * StepClockRate * (1.0/MinArcSegmentsPerSec)),
+											MinArcSegmentLength,
+											MaxArcSegmentLength
+										);
+		moveState.totalSegments = max<unsigned int>((unsigned int)((moveState.arcRadius * totalArc)/arcSegmentLength + 0.8), 1u);
+		moveState.arcAngleIncrement = totalArc/moveState.totalSegments;
+		if (clockwise)
+		{
+			moveState.arcAngleIncrement = -moveState.arcAngleIncrement;
+		}
+		moveState.angleIncrementSine = sinf(moveState.arcAngleIncrement);
+		moveState.angleIncrementCosine = cosf(moveState.arcAngleIncrement);
+		moveState.segmentsTillNextFullCalc = 0;
 	}
-	moveState.angleIncrementSine = sinf(moveState.arcAngleIncrement);
-	moveState.angleIncrementCosine = cosf(moveState.arcAngleIncrement);
-	moveState.segmentsTillNextFullCalc = 0;
 
 	moveState.arcAxis0 = axis0;
 	moveState.arcAxis1 = axis1;
@@ -2473,6 +2503,12 @@ bool GCodes::ReadMove(RawMove& m) noexcept
 			if (moveState.doingArcMove)
 			{
 				m.canPauseAfter = true;					// we can pause after the final segment of an arc move
+#if SUPPORT_NATIVE_ARCS
+				if (moveState.useNativeArcs)
+				{
+					SetNativeArcPiece(m, moveState.arcCurrentAngle, moveState.arcFinalAngle);
+				}
+#endif
 			}
 			ClearMove();
 		}
@@ -2481,24 +2517,41 @@ bool GCodes::ReadMove(RawMove& m) noexcept
 			// This move needs to be divided into 2 or more segments
 			// Do the axes
 			AxesBitmap axisMap0, axisMap1;
+			float segmentFraction = 1.0/moveState.segmentsLeft;		// the fraction of the remaining movement of the non-arc axes to do in this segment
+#if SUPPORT_NATIVE_ARCS
+			const float pieceStartAngle = moveState.arcCurrentAngle;
+#endif
 			if (moveState.doingArcMove)
 			{
-				moveState.arcCurrentAngle += moveState.arcAngleIncrement;
-				if (moveState.segmentsTillNextFullCalc == 0)
+#if SUPPORT_NATIVE_ARCS
+				if (moveState.useNativeArcs)
 				{
-					// Do the full calculation
-					moveState.segmentsTillNextFullCalc = SegmentsPerFulArcCalculation;
+					// The pieces of a native arc move are of different lengths, so share the movement of the other axes in proportion to the angle
+					moveState.arcCurrentAngle = GetNextNativeArcAngle(pieceStartAngle);
+					segmentFraction = (moveState.arcCurrentAngle - pieceStartAngle)/(moveState.arcFinalAngle - pieceStartAngle);
 					moveState.currentAngleCosine = cosf(moveState.arcCurrentAngle);
 					moveState.currentAngleSine = sinf(moveState.arcCurrentAngle);
 				}
 				else
+#endif
 				{
-					// Speed up the computation by doing two multiplications and an addition or subtraction instead of a sine or cosine
-					--moveState.segmentsTillNextFullCalc;
-					const float newCosine = moveState.currentAngleCosine * moveState.angleIncrementCosine - moveState.currentAngleSine   * moveState.angleIncrementSine;
-					const float newSine   = moveState.currentAngleSine   * moveState.angleIncrementCosine + moveState.currentAngleCosine * moveState.angleIncrementSine;
-					moveState.currentAngleCosine = newCosine;
-					moveState.currentAngleSine = newSine;
+					moveState.arcCurrentAngle += moveState.arcAngleIncrement;
+					if (moveState.segmentsTillNextFullCalc == 0)
+					{
+						// Do the full calculation
+						moveState.segmentsTillNextFullCalc = SegmentsPerFulArcCalculation;
+						moveState.currentAngleCosine = cosf(moveState.arcCurrentAngle);
+						moveState.currentAngleSine = sinf(moveState.arcCurrentAngle);
+					}
+					else
+					{
+						// Speed up the computation by doing two multiplications and an addition or subtraction instead of a sine or cosine
+						--moveState.segmentsTillNextFullCalc;
+						const float newCosine = moveState.currentAngleCosine * moveState.angleIncrementCosine - moveState.currentAngleSine   * moveState.angleIncrementSine;
+						const float newSine   = moveState.currentAngleSine   * moveState.angleIncrementCosine + moveState.currentAngleCosine * moveState.angleIncrementSine;
+						moveState.currentAngleCosine = newCosine;
+						moveState.currentAngleSine = newSine;
+					}
 				}
 				axisMap0 = Tool::GetAxisMapping(moveState.tool, moveState.arcAxis0);
 				axisMap1 = Tool::GetAxisMapping(moveState.tool, moveState.arcAxis1);
@@ -2520,7 +2573,7 @@ bool GCodes::ReadMove(RawMove& m) noexcept
 				else
 				{
 					// This axis is not moving in an arc
-					const float movementToDo = (moveState.coords[drive] - moveState.initialCoords[drive])/moveState.segmentsLeft;
+					const float movementToDo = (moveState.coords[drive] - moveState.initialCoords[drive]) * segmentFraction;
 					moveState.initialCoords[drive] += movementToDo;
 				}
 				m.coords[drive] = moveState.initialCoords[drive];
@@ -2542,6 +2595,13 @@ bool GCodes::ReadMove(RawMove& m) noexcept
 				return false;
 			}
 
+#if SUPPORT_NATIVE_ARCS
+			if (moveState.doingArcMove && moveState.useNativeArcs)
+			{
+				SetNativeArcPiece(m, pieceStartAngle, moveState.arcCurrentAngle);
+			}
+#endif
+
 			if (segmentsLeftToStartAt == moveState.segmentsLeft && firstSegmentFractionToSkip != 0.0)	// if this is the segment we are starting at and we need to skip some of it
 			{
 				// Reduce the extrusion by the amount to be skipped
@@ -2559,6 +2619,56 @@ bool GCodes::ReadMove(RawMove& m) noexcept
 	}
 }
 
+#if SUPPORT_NATIVE_ARCS
+
+// Return the angle at which the next piece of a native arc move that starts at the specified angle ends.
+// Each piece ends at a multiple of 90 degrees or at the end of the arc. We avoid generating tiny pieces.
+float GCodes::GetNextNativeArcAngle(float angle) const noexcept
+{
+	constexpr float HalfPi = Pi/2;
+	float boundary;
+	if (moveState.arcTotalAngle >= 0.0)
+	{
+		boundary = (floorf(angle * (1.0/HalfPi)) + 1.0) * HalfPi;
+		if (boundary - angle < MinNativeArcPieceAngle)
+		{
+			boundary += HalfPi;
+		}
+		return (boundary >= moveState.arcFinalAngle - MinNativeArcPieceAngle) ? moveState.arcFinalAngle : boundary;
+	}
+
+	boundary = (ceilf(angle * (1.0/HalfPi)) - 1.0) * HalfPi;
+	if (angle - boundary < MinNativeArcPieceAngle)
+	{
+		boundary -= HalfPi;
+	}
+	return (boundary <= moveState.arcFinalAngle + MinNativeArcPieceAngle) ? moveState.arcFinalAngle : boundary;
+}
+
+// Set up the arc parameters of a move that executes one piece of a native arc move. The end coordinates of the move have already been set up.
+void GCodes::SetNativeArcPiece(RawMove& m, float startAngle, float endAngle) const noexcept
+{
+	const size_t axis0 = Tool::GetAxisMapping(moveState.tool, moveState.arcAxis0).LowestSetBit();
+	const size_t axis1 = Tool::GetAxisMapping(moveState.tool, moveState.arcAxis1).LowestSetBit();
+	m.nativeArc.axis[0] = axis0;
+	m.nativeArc.axis[1] = axis1;
+	m.nativeArc.centre[0] = moveState.arcCentre[axis0];
+	m.nativeArc.centre[1] = moveState.arcCentre[axis1];
+	m.nativeArc.radius = moveState.arcRadius * axisScaleFactors[axis0];
+	m.nativeArc.startAngle = startAngle;
+	m.nativeArc.angle = endAngle - startAngle;
+	m.nativeArc.isArc = true;
+
+	// FinaliseMove shared the extrusion equally between the pieces, but the pieces are not all the same length
+	const float extrusionFactor = (m.nativeArc.angle * moveState.totalSegments)/moveState.arcTotalAngle;
+	for (size_t extruder = 0; extruder < numExtruders; ++extruder)
+	{
+		m.coords[ExtruderToLogicalDrive(extruder)] *= extrusionFactor;
+	}
+}
+
+#endif
+
 void GCodes::ClearMove() noexcept
 {
 	TaskCriticalSectionLocker lock;				// make sure that other tasks sees a consistent memory state
@@ -2696,6 +2806,9 @@ bool GCodes::DoFileMacro(GCodeBuffer& gb, const char* fileName, bool reportMissi
 		}
 		gb.GetVariables().AssignFrom(initialVariables);
 		gb.LatestMachineState().fileState.Set(f);
+#if SUPPORT_MACRO_CACHE
+		gb.LatestMachineState().macroCacheFileId = macroCache.GetFileId(fileName, f->Length());
+#endif
 		gb.StartNewFile();
 		gb.GetFileInput()->Reset(gb.LatestMachineState().fileState);
 #else
@@ -4046,6 +4159,12 @@ void GCodes::StopPrint(StopPrintReason reason) noexcept
 			lastDuration = simSeconds;
 			platform.MessageF(LoggedGenericMessage, "File %s will print in %" PRIu32 "h %" PRIu32 "m plus heating time\n",
 									printingFilename, simMinutes/60u, simMinutes % 60u);
+			if (reprap.GetMove().HaveStepTimingStats())
+			{
+				String<StringLength256> timingReport;
+				reprap.GetMove().ReportStepTimingStats(timingReport.GetRef());
+				platform.MessageF(GenericMessage, "%s\n", timingReport.c_str());
+			}
 		}
 		else
 		{
@@ -38,6 +38,7 @@ Licence: GPL
 #include "RestorePoint.h"
 #include "StraightProbeSettings.h"
 #include <Movement/BedProbing/Grid.h>
+#include "GCodeBuffer/MacroCache.h"
 
 const char feedrateLetter = 'F';						// GCode feedrate
 const char extrudeLetter = 'E'; 						// GCode extrude
@@ -276,6 +277,10 @@ public:
 	void SetAux0CommsProperties(uint32_t mode) const noexcept;
 #endif
 
+#if SUPPORT_MACRO_CACHE
+	MacroCache& GetMacroCache() noexcept { return macroCache; }
+#endif
+
 #if SUPPORT_REMOTE_COMMANDS
 	void SwitchToExpansionMode() noexcept;
 	void SetRemotePrinting(bool isPrinting) noexcept { isRemotePrinting = isPrinting; }
@@ -369,6 +374,10 @@ private:
 	bool DoArcMove(GCodeBuffer& gb, bool clockwise, const char *& err) THROWS(GCodeException)				// Execute an arc move
 		pre(segmentsLeft == 0; resourceOwners[MoveResource] == &gb);
 	void FinaliseMove(GCodeBuffer& gb) noexcept;									// Adjust the move parameters to account for segmentation and/or part of the move having been done already
+#if SUPPORT_NATIVE_ARCS
+	float GetNextNativeArcAngle(float angle) const noexcept;						// Get the angle at which the next piece of a native arc move ends
+	void SetNativeArcPiece(RawMove& m, float startAngle, float endAngle) const noexcept;	// Set up a move to execute a piece of a native arc move
+#endif
 	bool CheckEnoughAxesHomed(AxesBitmap axesMoved) noexcept;						// Check that enough axes have been homed
 	bool TravelToStartPoint(GCodeBuffer& gb) noexcept;								// Set up a move to travel to the resume point
 
@@ -478,7 +487,7 @@ private:
 #endif
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE || HAS_EMBEDDED_FILES
-	GCodeResult SimulateFile(GCodeBuffer& gb, const StringRef &reply, const StringRef& file, bool updateFile) THROWS(GCodeException);	// Handle M37 to simulate a whole file
+	GCodeResult SimulateFile(GCodeBuffer& gb, const StringRef &reply, const StringRef& file, bool updateFile, SimulationMode simMode) THROWS(GCodeException);	// Handle M37 to simulate a whole file
 	GCodeResult ChangeSimulationMode(GCodeBuffer& gb, const StringRef &reply, SimulationMode newSimMode) THROWS(GCodeException);		// Handle M37 to change the simulation mode
 #endif
 
@@ -677,6 +686,10 @@ private:
 	// Code queue
 	GCodeQueue *codeQueue;						// Stores certain codes for deferred execution
 
+#if SUPPORT_MACRO_CACHE
+	MacroCache macroCache;						// compiled expressions from macro files
+#endif
+
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 	// SHA1 hashing
 	FileStore *fileBeingHashed;
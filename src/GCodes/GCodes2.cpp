@@ -1179,7 +1179,18 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 					if (seen)
 					{
 						const bool updateFile = !gb.Seen('F') || gb.GetUIValue() == 1;
-						result = SimulateFile(gb, reply, simFileName.GetRef(), updateFile);
+						uint32_t fileSimulationMode = (uint32_t)SimulationMode::normal;
+						bool dummy;
+						gb.TryGetLimitedUIValue('S', fileSimulationMode, dummy, (uint32_t)SimulationMode::normal + 1);
+						if (fileSimulationMode == (uint32_t)SimulationMode::off)
+						{
+							reply.copy("S parameter must be 1 (generate steps) or 2 (timing only) when simulating a file");
+							result = GCodeResult::badOrMissingParameter;
+						}
+						else
+						{
+							result = SimulateFile(gb, reply, simFileName.GetRef(), updateFile, (SimulationMode)fileSimulationMode);
+						}
 					}
 					else
 					{
@@ -1193,6 +1204,11 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 						{
 							reply.printf("Simulation mode: %s, move time: %.1f sec, other time: %.1f sec",
 									(IsSimulating()) ? "on" : "off", (double)reprap.GetMove().GetSimulationTime(), (double)simulationTime);
+							if (reprap.GetMove().HaveStepTimingStats())
+							{
+								reply.cat('\n');
+								reprap.GetMove().ReportStepTimingStats(reply);
+							}
 						}
 					}
 				}
@@ -2788,20 +2804,34 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 				break;
 #endif
 
-			case 376: // Set taper height
+			case 376: // Set taper height and mesh segment tolerance
 				{
 					Move& move = reprap.GetMove();
+					bool seen = false;
 					if (gb.Seen('H'))
 					{
+						seen = true;
 						move.SetTaperHeight(gb.GetFValue());
 					}
-					else if (move.GetTaperHeight() > 0.0)
+					if (gb.Seen('D'))
 					{
-						reply.printf("Bed compensation taper height is %.1fmm", (double)move.GetTaperHeight());
+						seen = true;
+						move.SetMeshChordTolerance(gb.GetFValue());
 					}
-					else
+					if (!seen)
 					{
-						reply.copy("Bed compensation is not tapered");
+						if (move.GetTaperHeight() > 0.0)
+						{
+							reply.printf("Bed compensation taper height is %.1fmm", (double)move.GetTaperHeight());
+						}
+						else
+						{
+							reply.copy("Bed compensation is not tapered");
+						}
+						if (move.GetMeshChordTolerance() > 0.0)
+						{
+							reply.catf(", mesh segments merged within %.3fmm", (double)move.GetMeshChordTolerance());
+						}
 					}
 				}
 				break;
@@ -2883,6 +2913,13 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeEx
 					bool dummy;
 					gb.TryGetQuotedString('K', key.GetRef(), dummy, true);
 					gb.TryGetQuotedString('F', flags.GetRef(), dummy, true);
+					if (ObjectExplorationContext::WantBinaryReport(flags.c_str()))
+					{
+						// G-code replies are text, so they can't carry a CBOR report
+						reply.copy("binary reports are only available from rr_model and the SBC interface");
+						result = GCodeResult::error;
+						break;
+					}
 					if (&gb == auxGCode)
 					{
 						lastAuxStatusReportType = ObjectModelAuxStatusReportType;
@@ -415,7 +415,7 @@ GCodeResult GCodes::DefineGrid(GCodeBuffer& gb, const StringRef &reply) THROWS(G
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE || HAS_EMBEDDED_FILES
 
 // Handle M37 to simulate a whole file
-GCodeResult GCodes::SimulateFile(GCodeBuffer& gb, const StringRef &reply, const StringRef& file, bool updateFile)
+GCodeResult GCodes::SimulateFile(GCodeBuffer& gb, const StringRef &reply, const StringRef& file, bool updateFile, SimulationMode simMode)
 {
 	if (reprap.GetPrintMonitor().IsPrinting())
 	{
@@ -444,7 +444,7 @@ GCodeResult GCodes::SimulateFile(GCodeBuffer& gb, const StringRef &reply, const
 # else
 		updateFileWhenSimulationComplete = updateFile;
 # endif
-		simulationMode = SimulationMode::normal;
+		simulationMode = simMode;							// normally SimulationMode::normal, or SimulationMode::debug to generate and time the steps too
 		reprap.GetMove().Simulate(simulationMode);
 		reprap.GetPrintMonitor().StartingPrint(file.c_str());
 		StartPrinting(true);
@@ -43,7 +43,7 @@ public:
 	FopDt() noexcept;
 
 	void Reset() noexcept;
-	bool SetParameters(float phr, float pbcr, float pfcr, float pcrExponent, float pdt, float pMaxPwm, float temperatureLimit, float pVoltage, bool pUsePid, bool pInverted) noexcept;
+	bool SetParameters(float phr, float pbcr, float pfcr, float pcrExponent, float pdt, float pMaxPwm, float temperatureLimit, float pVoltage, bool pUsePid, bool pUseMpc, bool pInverted) noexcept;
 	void SetDefaultToolParameters() noexcept;
 	void SetDefaultBedOrChamberParameters() noexcept;
 #if SUPPORT_REMOTE_COMMANDS
@@ -59,6 +59,7 @@ public:
 	float GetMaxPwm() const noexcept { return maxPwm; }
 	float GetVoltage() const noexcept { return standardVoltage; }
 	bool UsePid() const noexcept { return usePid; }
+	bool UseMpc() const noexcept { return useMpc; }						// if this is true then UsePid() is also true, so that expansion boards that don't support MPC use PID
 	bool IsInverted() const noexcept { return inverted; }
 	bool IsEnabled() const noexcept { return enabled; }
 
@@ -66,6 +67,7 @@ public:
 	float EstimateMaxTemperatureRise() const noexcept;
 
 	float GetNetHeatingRate(float temperatureRise, float fanPwm, float heaterPwm) const noexcept;
+	float GetCoolingRate(float temperatureRise, float fanPwm) const noexcept;
 	float CorrectPwmForVoltage(float requiredPwm, float actualVoltage) const noexcept;
 	float GetPwmCorrectionForFan(float temperatureRise, float fanPwmChange) const noexcept;
 	void CalcPidConstants(float targetTemperature) noexcept;
@@ -96,7 +98,6 @@ protected:
 	DECLARE_OBJECT_MODEL
 
 private:
-	float GetCoolingRate(float temperatureRise, float fanPwm) const noexcept;
 	void SetRawPidParameters(float p_kP, float p_recipTi, float p_tD) noexcept;
 	static float EstimateMaxTemperatureRise(float hr, float cr, float cre) noexcept;
 
@@ -109,6 +110,7 @@ private:
 	float standardVoltage;					// power voltage reading at which tuning was done, or 0 if unknown
 	bool enabled;
 	bool usePid;
+	bool useMpc;
 	bool inverted;
 	bool pidParametersOverridden;
 
@@ -90,8 +90,16 @@ constexpr ObjectModelArrayDescriptor Heat::heatersArrayDescriptor =
 	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(((const Heat*)self)->heaters[context.GetLastIndex()]); }
 };
 
+constexpr ObjectModelArrayDescriptor Heat::tuningHeatersArrayDescriptor =
+{
+	&heatersLock,
+	[] (const ObjectModel *self, const ObjectExplorationContext&) noexcept -> size_t { return ((const Heat*)self)->heatersBeingTuned.CountSetBits(); },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(self, 2); }
+};
+
 // Macro to build a standard lambda function that includes the necessary type conversions
 #define OBJECT_MODEL_FUNC(...) OBJECT_MODEL_FUNC_BODY(Heat, __VA_ARGS__)
+#define OBJECT_MODEL_FUNC_IF(...) OBJECT_MODEL_FUNC_IF_BODY(Heat, __VA_ARGS__)
 
 constexpr ObjectModelTableEntry Heat::objectModelTable[] =
 {
@@ -102,9 +110,26 @@ constexpr ObjectModelTableEntry Heat::objectModelTable[] =
 	{ "coldExtrudeTemperature",	OBJECT_MODEL_FUNC((self->coldExtrude) ? 0.0f : self->extrusionMinTemp, 1),		ObjectModelEntryFlags::none },
 	{ "coldRetractTemperature", OBJECT_MODEL_FUNC((self->coldExtrude) ? 0.0f : self->retractionMinTemp, 1),		ObjectModelEntryFlags::none },
 	{ "heaters",				OBJECT_MODEL_FUNC_NOSELF(&heatersArrayDescriptor),								ObjectModelEntryFlags::live },
+	{ "tuning",					OBJECT_MODEL_FUNC(self, 1),														ObjectModelEntryFlags::live },
+
+	// 1. Heat.tuning members
+	{ "heaters",				OBJECT_MODEL_FUNC_NOSELF(&tuningHeatersArrayDescriptor),						ObjectModelEntryFlags::live },
+	{ "lastHeater",				OBJECT_MODEL_FUNC_IF(self->lastHeaterTuned >= 0, (int32_t)self->lastHeaterTuned),	ObjectModelEntryFlags::live },
+
+	// 2. Heat.tuning.heaters[] members
+	{ "coupledTo",				OBJECT_MODEL_FUNC_IF(self->GetNthHeaterBeingTuned(context.GetLastIndex()) != nullptr,
+												self->GetNthHeaterBeingTuned(context.GetLastIndex())->GetTuningCoupledHeaters()),		ObjectModelEntryFlags::live },
+	{ "heater",					OBJECT_MODEL_FUNC_IF(self->GetNthHeaterBeingTuned(context.GetLastIndex()) != nullptr,
+												(int32_t)self->GetNthHeaterBeingTuned(context.GetLastIndex())->GetHeaterNumber()),		ObjectModelEntryFlags::none },
+	{ "phase",					OBJECT_MODEL_FUNC_IF(self->GetNthHeaterBeingTuned(context.GetLastIndex()) != nullptr,
+												(int32_t)self->GetNthHeaterBeingTuned(context.GetLastIndex())->GetTuningPhase() + 1),	ObjectModelEntryFlags::live },
+	{ "phases",					OBJECT_MODEL_FUNC_IF(self->GetNthHeaterBeingTuned(context.GetLastIndex()) != nullptr,
+												(int32_t)self->GetNthHeaterBeingTuned(context.GetLastIndex())->GetNumTuningPhases()),	ObjectModelEntryFlags::none },
+	{ "status",					OBJECT_MODEL_FUNC_IF(self->GetNthHeaterBeingTuned(context.GetLastIndex()) != nullptr,
+												self->GetNthHeaterBeingTuned(context.GetLastIndex())->GetTuningPhaseText()),			ObjectModelEntryFlags::live },
 };
 
-constexpr uint8_t Heat::objectModelTableDescriptor[] = { 1, 5 };
+constexpr uint8_t Heat::objectModelTableDescriptor[] = { 3, 6, 2, 5 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(Heat)
 
@@ -114,7 +139,7 @@ ReadWriteLock Heat::heatersLock;
 ReadWriteLock Heat::sensorsLock;
 
 Heat::Heat() noexcept
-	: sensorCount(0), sensorsRoot(nullptr), sensorOrderingErrors(0), coldExtrude(false), heaterBeingTuned(-1), lastHeaterTuned(-1)
+	: sensorCount(0), sensorsRoot(nullptr), sensorOrderingErrors(0), coldExtrude(false), lastHeaterTuned(-1)
 #if SUPPORT_REMOTE_COMMANDS
 	, newHeaterFaultState(0), newDriverFaultState(0)
 #endif
@@ -147,6 +172,22 @@ ReadLockedPointer<Heater> Heat::FindHeater(int heater) const noexcept
 	return ReadLockedPointer<Heater>(locker, (heater < 0 || heater >= (int)MaxHeaters) ? nullptr : heaters[heater]);
 }
 
+// Return the nth heater that is being tuned, or nullptr if there are fewer than n+1 of them. The caller must hold a read lock on the heaters.
+const Heater *_ecv_null Heat::GetNthHeaterBeingTuned(size_t n) const noexcept
+{
+	const Heater *_ecv_null rslt = nullptr;
+	heatersBeingTuned.IterateWhile([this, n, &rslt](unsigned int heater, unsigned int count) noexcept -> bool
+									{
+										if (count == n)
+										{
+											rslt = heaters[heater];
+											return false;
+										}
+										return true;
+									});
+	return rslt;
+}
+
 // Process M307
 GCodeResult Heat::SetOrReportHeaterModel(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException)
 {
@@ -425,22 +466,32 @@ void Heat::SendHeatersStatus(CanMessageBuffer& buf) noexcept
 				}
 			}
 
-			// See if we have finished tuning a heater
-			if (heaterBeingTuned != -1)
+			// Allow for thermal coupling between heaters being tuned together, and see if we have finished tuning any heaters
+			if (!heatersBeingTuned.IsEmpty())
 			{
-				const auto h = FindHeater(heaterBeingTuned);
-				if (h.IsNull() || h->GetStatus() != HeaterStatus::tuning)
+				UpdateTuningCoupling();
+
+				HeatersBitmap finishedHeaters;
+				heatersBeingTuned.Iterate([this, &finishedHeaters](unsigned int heater, unsigned int) noexcept
+											{
+												const auto h = FindHeater(heater);
+												if (h.IsNull() || h->GetStatus() != HeaterStatus::tuning)
+												{
+													finishedHeaters.SetBit(heater);
+												}
+											});
+				if (!finishedHeaters.IsEmpty())
 				{
-					lastHeaterTuned = heaterBeingTuned;
-					heaterBeingTuned = -1;
+					lastHeaterTuned = (int8_t)finishedHeaters.LowestSetBit();
+					heatersBeingTuned &= ~finishedHeaters;				// this task has higher priority than the tasks that set bits in it, so this is safe
 				}
 #if SUPPORT_REMOTE_COMMANDS
-				else if (CanInterface::InExpansionMode())
+				else if (CanInterface::InExpansionMode())				// in expansion mode we only tune one heater at a time
 				{
 					auto msg = buf.SetupStatusMessage<CanMessageHeaterTuningReport>(CanInterface::GetCanAddress(), CanInterface::GetCurrentMasterAddress());
 					if (LocalHeater::GetTuningCycleData(*msg))
 					{
-						msg->SetStandardFields(heaterBeingTuned);
+						msg->SetStandardFields(heatersBeingTuned.LowestSetBit());
 						CanInterface::SendMessageNoReplyNoFree(&buf);
 					}
 				}
@@ -945,72 +996,171 @@ GCodeResult Heat::ConfigureHeaterMonitoring(size_t heater, GCodeBuffer& gb, cons
 // Process M303
 GCodeResult Heat::TuneHeater(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException)
 {
-	// To tune a heater, a heater number and/or a tool number musty be given
-	FansBitmap fans;
-	int heaterNumber;
+	// To tune heaters, heater numbers and/or tool numbers must be given. If more than one is given then we tune those heaters at the same time.
+	int32_t heaterNumbers[MaxHeatersTunedTogether];
+	FansBitmap fans[MaxHeatersTunedTogether];
+	size_t numHeaters = 0;
 	const bool seenHeater = gb.Seen('H');
 	if (seenHeater)
 	{
-		heaterNumber = gb.GetIValue();
+		numHeaters = MaxHeatersTunedTogether;
+		gb.GetIntArray(heaterNumbers, numHeaters, false);
 	}
 	const bool seenTool = gb.Seen('T');
 	if (seenTool)
 	{
-		const int toolNumber = gb.GetIValue();
-		const auto tool = reprap.GetTool(toolNumber);
-		if (tool.IsNull())
+		int32_t toolNumbers[MaxHeatersTunedTogether];
+		size_t numTools = MaxHeatersTunedTogether;
+		gb.GetIntArray(toolNumbers, numTools, false);
+		if (seenHeater && numTools != numHeaters)
 		{
-			reply.printf("tool %d not found", toolNumber);
+			reply.copy("the number of H and T values must be the same");
 			return GCodeResult::error;
 		}
-		if (seenHeater)
+
+		for (size_t i = 0; i < numTools; ++i)
 		{
-			if (!tool->UsesHeater(heaterNumber))
+			const int toolNumber = toolNumbers[i];
+			const auto tool = reprap.GetTool(toolNumber);
+			if (tool.IsNull())
 			{
-				reply.printf("tool %d does not use heater %d", toolNumber, heaterNumber);
+				reply.printf("tool %d not found", toolNumber);
 				return GCodeResult::error;
 			}
+			if (seenHeater)
+			{
+				if (!tool->UsesHeater(heaterNumbers[i]))
+				{
+					reply.printf("tool %d does not use heater %d", toolNumber, (int)heaterNumbers[i]);
+					return GCodeResult::error;
+				}
+			}
+			else if (tool->HeaterCount() == 0)
+			{
+				reply.printf("tool %d has no heaters", toolNumber);
+				return GCodeResult::error;
+			}
+			else
+			{
+				heaterNumbers[i] = tool->GetHeater(0);
+			}
+			fans[i] = tool->GetFanMapping();
 		}
-		else if (tool->HeaterCount() == 0)
-		{
-			reply.printf("tool %d has no heaters", toolNumber);
-			return GCodeResult::error;
-		}
-		else
-		{
-			heaterNumber = tool->GetHeater(0);
-		}
-		fans = tool->GetFanMapping();
+		numHeaters = numTools;
 	}
 
 	if (seenHeater || seenTool)
 	{
-		if (heaterBeingTuned != -1)
+		// Check that we can tune all the heaters before we start any of them
+		HeatersBitmap batch;
+		FansBitmap fansInUse;
+		for (size_t i = 0; i < numHeaters; ++i)
 		{
-			// Trying to start a new auto tune, but we are already tuning a heater
-			reply.printf("Error: cannot start a new auto tune because heater %d is being tuned", heaterBeingTuned);
-			return GCodeResult::error;
+			const int heaterNumber = heaterNumbers[i];
+			const auto h = FindHeater(heaterNumber);
+			if (h.IsNull())
+			{
+				reply.printf("Heater %d not found", heaterNumber);
+				return GCodeResult::error;
+			}
+			if (heatersBeingTuned.IsBitSet(heaterNumber) || batch.IsBitSet(heaterNumber))
+			{
+				reply.printf("heater %d is already being tuned", heaterNumber);
+				return GCodeResult::error;
+			}
+			batch.SetBit(heaterNumber);
+			if (fans[i].Intersects(fansInUse))
+			{
+				reply.printf("cannot tune heater %d because another heater being tuned uses the same fan", heaterNumber);
+				return GCodeResult::error;
+			}
+			fansInUse |= fans[i];
 		}
 
-		const auto h = FindHeater(heaterNumber);
-		if (h.IsNull())
+		// We mustn't turn on fans that belong to heaters that are already being tuned, because that would spoil their measurements
 		{
-			reply.printf("Heater %u not found", heaterNumber);
-			return GCodeResult::error;
+			ReadLocker lock(heatersLock);
+			const bool fanClash = !heatersBeingTuned.IterateWhile([this, fansInUse](unsigned int heater, unsigned int) noexcept -> bool
+																	{
+																		return heaters[heater] == nullptr || !heaters[heater]->GetTuningFans().Intersects(fansInUse);
+																	});
+			if (fanClash)
+			{
+				reply.copy("cannot start a new auto tune because a heater that is already being tuned uses the same fan");
+				return GCodeResult::error;
+			}
 		}
 
-		const GCodeResult rslt = h->StartAutoTune(gb, reply, fans);
-		if (Succeeded(rslt))
+		// Stagger the start times so that we can measure the thermal coupling between the heaters
+		const float startInterval = (gb.Seen('W')) ? gb.GetLimitedFValue('W', 0.0, 600.0) : DefaultTuningStartInterval;
+		GCodeResult rslt = GCodeResult::ok;
+		HeatersBitmap startedHeaters, failedHeaters;
+		for (size_t i = 0; i < numHeaters; ++i)
 		{
-			heaterBeingTuned = (int8_t)heaterNumber;
+			const int heaterNumber = heaterNumbers[i];
+			const auto h = FindHeater(heaterNumber);
+			String<StringLength256> heaterReply;
+			HeatersBitmap others = batch;
+			others.ClearBit(heaterNumber);
+			const GCodeResult heaterRslt = h->StartAutoTune(gb, heaterReply.GetRef(), fans[i], others, (uint32_t)lrintf(i * startInterval * SecondsToMillis));
+			if (Succeeded(heaterRslt))
+			{
+				TaskCriticalSectionLocker lock;						// stop the heater task changing heatersBeingTuned while we update it
+				heatersBeingTuned.SetBit(heaterNumber);
+				startedHeaters.SetBit(heaterNumber);
+			}
+			else
+			{
+				failedHeaters.SetBit(heaterNumber);
+			}
+			rslt = max(rslt, heaterRslt);
+			if (!heaterReply.IsEmpty())
+			{
+				if (!reply.IsEmpty())
+				{
+					reply.cat('\n');
+				}
+				reply.cat(heaterReply.c_str());
+			}
+		}
+
+		// The heaters that we started must not wait for or measure their coupling to heaters that failed to start
+		if (!failedHeaters.IsEmpty())
+		{
+			startedHeaters.Iterate([this, failedHeaters](unsigned int heater, unsigned int) noexcept
+									{
+										const auto h = FindHeater(heater);
+										if (h.IsNotNull())
+										{
+											TaskCriticalSectionLocker lock;		// stop the heater task using the batch while we change it
+											h->RemoveFromTuningBatch(failedHeaters);
+										}
+									});
 		}
 		return rslt;
 	}
 
 	// If we get here then neither T nor H was given, so report the auto tune status
-	const int whichPid = (heaterBeingTuned == -1) ? lastHeaterTuned : heaterBeingTuned;
-	const auto h = FindHeater(whichPid);
+	if (!heatersBeingTuned.IsEmpty())
+	{
+		heatersBeingTuned.Iterate([this, &reply](unsigned int heater, unsigned int count) noexcept
+									{
+										const auto h = FindHeater(heater);
+										if (h.IsNotNull())
+										{
+											String<StringLength100> heaterReply;
+											h->GetAutoTuneStatus(heaterReply.GetRef());
+											if (count != 0)
+											{
+												reply.cat('\n');
+											}
+											reply.cat(heaterReply.c_str());
+										}
+									});
+		return GCodeResult::ok;
+	}
 
+	const auto h = FindHeater(lastHeaterTuned);
 	if (h.IsNotNull())
 	{
 		h->GetAutoTuneStatus(reply);
@@ -1022,6 +1172,47 @@ GCodeResult Heat::TuneHeater(GCodeBuffer& gb, const StringRef& reply) THROWS(GCo
 	return GCodeResult::ok;
 }
 
+// Allow for the thermal coupling between heaters that were started by the same M303 command. Called by the heater task after it has spun the heaters.
+void Heat::UpdateTuningCoupling() noexcept
+{
+	ReadLocker lock(heatersLock);
+	heatersBeingTuned.Iterate([this](unsigned int heater, unsigned int) noexcept
+								{
+									Heater * const h = heaters[heater];
+									if (h != nullptr && h->IsTuningInBatch())
+									{
+										const float temperature = h->GetTemperature();
+										const HeatersBitmap coupledHeaters = h->GetTuningCoupledHeaters();
+										float otherRiseIntegrals = 0.0, coupledTemperatureDifference = 0.0, reverseTemperatureDifference = 0.0, reverseCoefficient = 0.0;
+										HeatersBitmap heatingHeaters;
+										h->GetTuningBatch().Iterate([this, heater, temperature, coupledHeaters, &otherRiseIntegrals, &coupledTemperatureDifference, &reverseTemperatureDifference, &heatingHeaters, &reverseCoefficient]
+																	(unsigned int other, unsigned int) noexcept
+																	{
+																		const Heater * const oh = heaters[other];
+																		if (oh != nullptr)
+																		{
+																			otherRiseIntegrals += oh->GetTuningRiseIntegral();
+																			if (oh->HasStartedTuningCycles())		// only heaters that are heating can heat us
+																			{
+																				heatingHeaters.SetBit(other);
+																				const float difference = oh->GetTemperature() - temperature;
+																				if (coupledHeaters.IsBitSet(other))
+																				{
+																					coupledTemperatureDifference += difference;
+																				}
+																				if (oh->GetTuningCoupledHeaters().IsBitSet(heater))
+																				{
+																					reverseTemperatureDifference += difference;
+																					reverseCoefficient = max<float>(reverseCoefficient, oh->GetTuningCouplingCoefficient());
+																				}
+																			}
+																		}
+																	});
+										h->UpdateTuningCoupling(otherRiseIntegrals, heatingHeaters, coupledTemperatureDifference, reverseTemperatureDifference, reverseCoefficient);
+									}
+								});
+}
+
 // Process M308
 GCodeResult Heat::ConfigureSensor(GCodeBuffer& gb, const StringRef& reply) THROWS(GCodeException)
 {
@@ -1459,9 +1650,10 @@ GCodeResult Heat::SetHeaterMonitors(const CanMessageSetHeaterMonitors& msg, cons
 
 GCodeResult Heat::TuningCommand(const CanMessageHeaterTuningCommand& msg, const StringRef& reply) noexcept
 {
-	if (heaterBeingTuned != -1 && heaterBeingTuned != (int)msg.heaterNumber)
+	// In expansion mode we only tune one heater at a time, because the tuning report doesn't identify which cycle data belongs to which heater
+	if (!heatersBeingTuned.IsEmpty() && !heatersBeingTuned.IsBitSet(msg.heaterNumber))
 	{
-		reply.printf("Heater %d is already being tuned", heaterBeingTuned);
+		reply.printf("Heater %u is already being tuned", heatersBeingTuned.LowestSetBit());
 		return GCodeResult::error;
 	}
 	const auto h = FindHeater(msg.heaterNumber);
@@ -1469,7 +1661,10 @@ GCodeResult Heat::TuningCommand(const CanMessageHeaterTuningCommand& msg, const
 	{
 		return UnknownHeater(msg.heaterNumber, reply);
 	}
-	heaterBeingTuned = (int)msg.heaterNumber;			// setting this is OK even if we are stopping or fail to start tuning, because we check it in the heater task loop
+	{
+		TaskCriticalSectionLocker lock;						// stop the heater task changing heatersBeingTuned while we update it
+		heatersBeingTuned = HeatersBitmap::MakeFromBits(msg.heaterNumber);	// setting this is OK even if we are stopping or fail to start tuning, because we check it in the heater task loop
+	}
 	return h->TuningCommand(msg, reply);
 }
 
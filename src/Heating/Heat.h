@@ -159,9 +159,12 @@ protected:
 	OBJECT_MODEL_ARRAY(bedHeaters)
 	OBJECT_MODEL_ARRAY(chamberHeaters)
 	OBJECT_MODEL_ARRAY(heaters)
+	OBJECT_MODEL_ARRAY(tuningHeaters)
 
 private:
 	ReadLockedPointer<Heater> FindHeater(int heater) const noexcept;
+	const Heater *_ecv_null GetNthHeaterBeingTuned(size_t n) const noexcept;
+	void UpdateTuningCoupling() noexcept;
 	void DeleteSensor(unsigned int sn) noexcept;
 	void InsertSensor(TemperatureSensor *newSensor) noexcept;
 
@@ -183,7 +186,7 @@ private:
 	bool coldExtrude;											// Is cold extrusion allowed?
 	int8_t bedHeaters[MaxBedHeaters];							// Indices of the hot bed heaters to use or -1 if none is available
 	int8_t chamberHeaters[MaxChamberHeaters];					// Indices of the chamber heaters to use or -1 if none is available
-	int8_t heaterBeingTuned;									// which PID is currently being tuned
+	HeatersBitmap heatersBeingTuned;							// which heaters are currently being tuned
 	int8_t lastHeaterTuned;										// which PID we last finished tuning
 
 #if SUPPORT_REMOTE_COMMANDS
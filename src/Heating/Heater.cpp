@@ -62,38 +62,8 @@ DEFINE_GET_OBJECT_MODEL_TABLE(Heater)
 
 #endif
 
-// Static members of class Heater
-
-float Heater::tuningPwm;								// the PWM to use, 0..1
-float Heater::tuningTargetTemp;							// the target temperature
-float Heater::tuningHysteresis;
-float Heater::tuningFanPwm;
-
-DeviationAccumulator Heater::tuningStartTemp;			// the temperature when we turned on the heater
-DeviationAccumulator Heater::dHigh;
-DeviationAccumulator Heater::dLow;
-DeviationAccumulator Heater::tOn;
-DeviationAccumulator Heater::tOff;
-DeviationAccumulator Heater::heatingRate;
-DeviationAccumulator Heater::coolingRate;
-DeviationAccumulator Heater::tuningVoltage;				// sum of the voltage readings we take during the heating phase
-
-uint32_t Heater::tuningBeginTime;						// when we started the tuning process
-uint32_t Heater::lastOffTime;
-uint32_t Heater::lastOnTime;
-float Heater::peakTemp;									// max or min temperature
-uint32_t Heater::peakTime;								// the time at which we recorded peakTemp
-float Heater::afterPeakTemp;							// temperature after max from which we start timing the cooling rate
-uint32_t Heater::afterPeakTime;							// the time at which we recorded afterPeakTemp
-float Heater::lastCoolingRate;
-FansBitmap Heater::tuningFans;
-unsigned int Heater::tuningPhase;
-uint8_t Heater::idleCyclesDone;
-
-Heater::HeaterParameters Heater::fanOffParams, Heater::fanOnParams;
-
 // Clear all the counters except tuning voltage and start temperature
-/*static*/ void Heater::ClearCounters() noexcept
+void Heater::TuningData::ClearCounters() noexcept
 {
 	dHigh.Clear();
 	dLow.Clear();
@@ -103,8 +73,16 @@ Heater::HeaterParameters Heater::fanOffParams, Heater::fanOnParams;
 	coolingRate.Clear();
 }
 
+// Clear the thermal coupling measurements
+void Heater::TuningData::ClearCoupling() noexcept
+{
+	coupledHeaters.Clear();
+	riseIntegral = couplingSumXY = couplingSumXX = maxCouplingRise = couplingCoefficient = couplingRate = 0.0;
+	RestartCouplingAverage(0);
+}
+
 Heater::Heater(unsigned int num) noexcept
-	: tuned(false), heaterNumber(num), sensorNumber(-1), activeTemperature(0.0), standbyTemperature(0.0),
+	: tuned(false), tuning(nullptr), heaterNumber(num), sensorNumber(-1), activeTemperature(0.0), standbyTemperature(0.0),
 	  maxTempExcursion(DefaultMaxTempExcursion), maxHeatingFaultTime(DefaultMaxHeatingFaultTime),
 	  isBedOrChamber(false),
 	  active(false), modelSetByUser(false), monitorsSetByUser(false)
@@ -117,6 +95,7 @@ Heater::~Heater() noexcept
 	{
 		h.Disable();
 	}
+	delete tuning;
 }
 
 void Heater::SetSensorNumber(int sn) noexcept
@@ -137,7 +116,7 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 		coolingRateExponent = model.GetCoolingRateExponent(),
 		basicCoolingRate = model.GetBasicCoolingRate(),
 		fanCoolingRate = model.GetFanCoolingRate();
-	int32_t dontUsePid = model.UsePid() ? 0 : 1;
+	int32_t dontUsePid = (model.UseMpc()) ? 2 : (model.UsePid()) ? 0 : 1;
 	int32_t inversionParameter = 0;
 
 	if (gb.Seen('K'))
@@ -191,9 +170,21 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 
 	if (seen)
 	{
-		// Set the model
+		// Set the model. B0 selects PID, B2 selects model predictive control if we support it, and other values select bang-bang.
 		const bool inverseTemperatureControl = (inversionParameter == 1 || inversionParameter == 3);
-		const GCodeResult rslt = SetModel(heatingRate, basicCoolingRate, fanCoolingRate, coolingRateExponent, td, maxPwm, voltage, dontUsePid == 0, inverseTemperatureControl, reply);
+#if SUPPORT_MPC_HEATER_CONTROL
+		const bool useMpc = (dontUsePid == 2);
+# if SUPPORT_CAN_EXPANSION
+		if (useMpc && !IsLocal())
+		{
+			reply.printf("Heater %u is on an expansion board, which doesn't support model predictive control", heater);
+			return GCodeResult::error;
+		}
+# endif
+#else
+		constexpr bool useMpc = false;
+#endif
+		const GCodeResult rslt = SetModel(heatingRate, basicCoolingRate, fanCoolingRate, coolingRateExponent, td, maxPwm, voltage, dontUsePid == 0, useMpc, inverseTemperatureControl, reply);
 		if (Succeeded(rslt))
 		{
 			modelSetByUser = true;
@@ -214,10 +205,10 @@ GCodeResult Heater::SetOrReportModel(unsigned int heater, GCodeBuffer& gb, const
 }
 
 // Set the process model returning true if successful
-GCodeResult Heater::SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool inverted, const StringRef& reply) noexcept
+GCodeResult Heater::SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool useMpc, bool inverted, const StringRef& reply) noexcept
 {
 	GCodeResult rslt;
-	if (model.SetParameters(hr, bcr, fcr, coolingRateExponent, td, maxPwm, GetHighestTemperatureLimit(), voltage, usePid, inverted))
+	if (model.SetParameters(hr, bcr, fcr, coolingRateExponent, td, maxPwm, GetHighestTemperatureLimit(), voltage, usePid, useMpc, inverted))
 	{
 		if (model.IsEnabled())
 		{
@@ -250,8 +241,10 @@ GCodeResult Heater::SetModel(float hr, float bcr, float fcr, float coolingRateEx
 	return rslt;
 }
 
-// Start an auto tune cycle for this heater
-GCodeResult Heater::StartAutoTune(GCodeBuffer& gb, const StringRef& reply, FansBitmap fans) THROWS(GCodeException)
+// Start an auto tune cycle for this heater.
+// 'batch' is the set of other heaters that are being started by the same M303 command and 'startDelay' is the minimum time before we turn this heater on,
+// so that we can measure the thermal coupling from the heaters in the batch that have already started.
+GCodeResult Heater::StartAutoTune(GCodeBuffer& gb, const StringRef& reply, FansBitmap fans, HeatersBitmap batch, uint32_t startDelay) THROWS(GCodeException)
 {
 	// Get the target temperature (required)
 	gb.MustSee('S');
@@ -286,21 +279,100 @@ GCodeResult Heater::StartAutoTune(GCodeBuffer& gb, const StringRef& reply, FansB
 	}
 
 	// Get abd store the optional parameters
-	tuningTargetTemp = targetTemp;
-	tuningFans = fans;
-	tuningPwm = (gb.Seen('P')) ? gb.GetLimitedFValue('P', 0.1, 1.0) : GetModel().GetMaxPwm();
-	tuningHysteresis = (gb.Seen('Y')) ? gb.GetLimitedFValue('Y', 1.0, 20.0) : DefaultTuningHysteresis;
-	tuningFanPwm = (gb.Seen('F')) ? gb.GetLimitedFValue('F', 0.1, 1.0) : DefaultTuningFanPwm;
+	AllocateTuningData();
+	tuning->batch = batch;
+	tuning->startDelay = startDelay;
+	tuning->targetTemp = targetTemp;
+	tuning->fans = fans;
+	tuning->pwm = (gb.Seen('P')) ? gb.GetLimitedFValue('P', 0.1, 1.0) : GetModel().GetMaxPwm();
+	tuning->hysteresis = (gb.Seen('Y')) ? gb.GetLimitedFValue('Y', 1.0, 20.0) : DefaultTuningHysteresis;
+	tuning->fanPwm = (gb.Seen('F')) ? gb.GetLimitedFValue('F', 0.1, 1.0) : DefaultTuningFanPwm;
 
 	const GCodeResult rslt = StartAutoTune(reply, seenA, ambientTemp);
 	if (rslt == GCodeResult::ok)
 	{
-		reply.printf("Auto tuning heater %u using target temperature %.1f" DEGREE_SYMBOL "C and PWM %.2f - do not leave printer unattended",
-						GetHeaterNumber(), (double)targetTemp, (double)tuningPwm);
+		reply.printf("Auto tuning heater %u using target temperature %.1f" DEGREE_SYMBOL "C and PWM %.2f", GetHeaterNumber(), (double)targetTemp, (double)tuning->pwm);
+		if (startDelay != 0 && !seenA)
+		{
+			reply.catf(", heating will start after %" PRIu32 " seconds", startDelay/(uint32_t)SecondsToMillis);
+		}
+		reply.cat(" - do not leave printer unattended");
 	}
 	return rslt;
 }
 
+// Allocate the tuning variables if we haven't already, and reset the ones that are not set up by StartAutoTune
+void Heater::AllocateTuningData() noexcept
+{
+	if (tuning == nullptr)
+	{
+		tuning = new TuningData;
+	}
+	tuning->phase = 0;
+	tuning->batch.Clear();
+	tuning->startDelay = 0;
+	tuning->ClearCoupling();
+}
+
+// This is called when we first turn the heater on during tuning. Work out the thermal coupling from the measurements we made while waiting to start.
+void Heater::FinishCouplingMeasurement() noexcept
+{
+	if (tuning->maxCouplingRise >= MinTuningCouplingRise && tuning->couplingSumXY > 0.0 && tuning->couplingSumXX > 0.0)
+	{
+		tuning->couplingCoefficient = tuning->couplingSumXY/tuning->couplingSumXX;
+		String<StringLength100> str;
+		str.printf("Heater %u temperature rose by %.1f" DEGREE_SYMBOL "C while heater(s)", GetHeaterNumber(), (double)tuning->maxCouplingRise);
+		tuning->coupledHeaters.Iterate([&str](unsigned int h, unsigned int) noexcept { str.catf(" %u", h); });
+		str.cat(" were heating, so its tuning measurements will be corrected for thermal coupling\n");
+		reprap.GetPlatform().Message(GenericMessage, str.c_str());
+	}
+	else
+	{
+		tuning->coupledHeaters.Clear();
+		tuning->couplingCoefficient = 0.0;
+	}
+}
+
+// Update the thermal coupling between this heater and the other heaters in its tuning batch. Called by the heater task after it has spun the heaters.
+// 'otherRiseIntegrals' is the sum of the rise integrals of the other heaters in the batch and 'heatingHeaters' is the set of them that have started heating.
+// 'coupledTemperatureDifference' is the sum of the differences between our temperature and those of the heating heaters that we found ourselves coupled to.
+// 'reverseTemperatureDifference' is the same for the heating heaters that found themselves coupled to us, and 'reverseCoefficient' is the largest coupling coefficient they measured.
+void Heater::UpdateTuningCoupling(float otherRiseIntegrals, HeatersBitmap heatingHeaters, float coupledTemperatureDifference, float reverseTemperatureDifference, float reverseCoefficient) noexcept
+{
+	if (tuning->startTemp.GetNumSamples() < 5000/HeatSampleIntervalMillis)
+	{
+		return;															// we don't know the start temperature yet
+	}
+
+	const float rise = GetTemperature() - tuning->startTemp.GetMean();
+	if (tuning->phase == 0)
+	{
+		// We are waiting to start heating, so fit our temperature rise to the rise integrals of the heaters that have started
+		if (!heatingHeaters.IsEmpty())
+		{
+			tuning->couplingSumXY += rise * otherRiseIntegrals;
+			tuning->couplingSumXX += fsquare(otherRiseIntegrals);
+			tuning->maxCouplingRise = max<float>(tuning->maxCouplingRise, rise);
+			tuning->coupledHeaters |= heatingHeaters;
+		}
+	}
+	else
+	{
+		tuning->riseIntegral += rise * (HeatSampleIntervalMillis * MillisToSeconds);
+		tuning->couplingRate = (tuning->couplingSumXX > 0.0)			// use our own measurement if we made one
+								? tuning->couplingCoefficient * coupledTemperatureDifference
+									: reverseCoefficient * reverseTemperatureDifference;
+
+		// The heating and cooling rates are measured over the time since afterPeakTime, so average the coupling rate over the same time
+		if (tuning->afterPeakTime != tuning->couplingWindowStart)
+		{
+			tuning->RestartCouplingAverage(tuning->afterPeakTime);
+		}
+		tuning->couplingRateSum += tuning->couplingRate;
+		++tuning->couplingRateCount;
+	}
+}
+
 const char *const Heater::TuningPhaseText[] =
 {
 	"checking temperature is stable",
@@ -316,11 +388,10 @@ const char *const Heater::TuningPhaseText[] =
 // Get the auto tune status or last result
 void Heater::GetAutoTuneStatus(const StringRef& reply) const noexcept
 {
-	if (GetStatus() == HeaterStatus::tuning)
+	if (GetStatus() == HeaterStatus::tuning && tuning != nullptr)
 	{
 		// Phases are: 1 = stabilising, 2 = heating, 3 = settling, 4 = cycling with fan off, 5 = cycling with fan on
-		const unsigned int numPhases = (tuningFans.IsEmpty()) ? 4 : ARRAY_SIZE(TuningPhaseText);
-		reply.printf("Heater %u is being tuned, phase %u of %u, %s", GetHeaterNumber(), tuningPhase + 1, numPhases, TuningPhaseText[tuningPhase]);
+		reply.printf("Heater %u is being tuned, phase %u of %u, %s", GetHeaterNumber(), tuning->phase + 1, GetNumTuningPhases(), GetTuningPhaseText());
 	}
 	else if (tuned)
 	{
@@ -332,12 +403,35 @@ void Heater::GetAutoTuneStatus(const StringRef& reply) const noexcept
 	}
 }
 
+FansBitmap Heater::GetTuningFans() const noexcept
+{
+	return (tuning == nullptr) ? FansBitmap() : tuning->fans;
+}
+
+unsigned int Heater::GetNumTuningPhases() const noexcept
+{
+	return (tuning == nullptr || tuning->fans.IsEmpty()) ? 4 : ARRAY_SIZE(TuningPhaseText);
+}
+
+const char *_ecv_array Heater::GetTuningPhaseText() const noexcept
+{
+	if (tuning == nullptr || tuning->phase >= ARRAY_SIZE(TuningPhaseText))
+	{
+		return "";
+	}
+	if (tuning->phase == 0 && tuning->startTemp.GetNumSamples() >= 5000/HeatSampleIntervalMillis && IsWaitingForTuningStartDelay(millis()))
+	{
+		return "waiting for other heaters to start";
+	}
+	return TuningPhaseText[tuning->phase];
+}
+
 // Tell the user what's happening, called after the tuning phase has been updated
 void Heater::ReportTuningUpdate() noexcept
 {
-	if (tuningPhase < ARRAY_SIZE(TuningPhaseText))
+	if (tuning->phase < ARRAY_SIZE(TuningPhaseText))
 	{
-		reprap.GetPlatform().MessageF(GenericMessage, "Auto tune starting phase %u, %s\n", tuningPhase, TuningPhaseText[tuningPhase]);
+		reprap.GetPlatform().MessageF(GenericMessage, "Heater %u auto tune starting phase %u, %s\n", GetHeaterNumber(), tuning->phase, TuningPhaseText[tuning->phase]);
 	}
 }
 
@@ -354,44 +448,44 @@ void Heater::CalculateModel(HeaterParameters& params) noexcept
 										" V %.1f" PLUS_OR_MINUS "%.1f,"
 #endif
 										" cycles %u\n",
-										lrintf(tOn.GetMean()), lrintf(tOn.GetDeviation()),
-										lrintf(tOff.GetMean()), lrintf(tOff.GetDeviation()),
-										lrintf(dHigh.GetMean()), lrintf(dHigh.GetDeviation()),
-										lrintf(dLow.GetMean()), lrintf(dLow.GetDeviation()),
-										(double)heatingRate.GetMean(), (double)heatingRate.GetDeviation(),
-										(double)coolingRate.GetMean(), (double)coolingRate.GetDeviation(),
+										lrintf(tuning->tOn.GetMean()), lrintf(tuning->tOn.GetDeviation()),
+										lrintf(tuning->tOff.GetMean()), lrintf(tuning->tOff.GetDeviation()),
+										lrintf(tuning->dHigh.GetMean()), lrintf(tuning->dHigh.GetDeviation()),
+										lrintf(tuning->dLow.GetMean()), lrintf(tuning->dLow.GetDeviation()),
+										(double)tuning->heatingRate.GetMean(), (double)tuning->heatingRate.GetDeviation(),
+										(double)tuning->coolingRate.GetMean(), (double)tuning->coolingRate.GetDeviation(),
 #if HAS_VOLTAGE_MONITOR
-										(double)tuningVoltage.GetMean(), (double)tuningVoltage.GetDeviation(),
+										(double)tuning->voltage.GetMean(), (double)tuning->voltage.GetDeviation(),
 #endif
-										coolingRate.GetNumSamples()
+										tuning->coolingRate.GetNumSamples()
 									 );
 	}
 
-	const float cycleTime = tOn.GetMean() + tOff.GetMean();		// in milliseconds
-	const float averageTemperatureRiseHeating = tuningTargetTemp - 0.5 * (tuningHysteresis - TuningPeakTempDrop) - tuningStartTemp.GetMean();
-	const float averageTemperatureRiseCooling = tuningTargetTemp - TuningPeakTempDrop - 0.5 * tuningHysteresis - tuningStartTemp.GetMean();
-	const float averageTemperatureRise = (averageTemperatureRiseHeating * tOn.GetMean() + averageTemperatureRiseCooling * tOff.GetMean()) / cycleTime;
-	params.deadTime = (((dHigh.GetMean() * tOff.GetMean()) + (dLow.GetMean() * tOn.GetMean())) * MillisToSeconds)/cycleTime;	// in seconds
-	params.coolingRate = coolingRate.GetMean();
-	params.heatingRate = (heatingRate.GetMean() + (coolingRate.GetMean() * averageTemperatureRiseHeating/averageTemperatureRiseCooling)) / tuningPwm;
-	params.gain = (tOn.GetMean() + tOff.GetMean()) * averageTemperatureRise/tOn.GetMean();
-	params.numCycles = dHigh.GetNumSamples();
+	const float cycleTime = tuning->tOn.GetMean() + tuning->tOff.GetMean();		// in milliseconds
+	const float averageTemperatureRiseHeating = tuning->targetTemp - 0.5 * (tuning->hysteresis - TuningPeakTempDrop) - tuning->startTemp.GetMean();
+	const float averageTemperatureRiseCooling = tuning->targetTemp - TuningPeakTempDrop - 0.5 * tuning->hysteresis - tuning->startTemp.GetMean();
+	const float averageTemperatureRise = (averageTemperatureRiseHeating * tuning->tOn.GetMean() + averageTemperatureRiseCooling * tuning->tOff.GetMean()) / cycleTime;
+	params.deadTime = (((tuning->dHigh.GetMean() * tuning->tOff.GetMean()) + (tuning->dLow.GetMean() * tuning->tOn.GetMean())) * MillisToSeconds)/cycleTime;	// in seconds
+	params.coolingRate = tuning->coolingRate.GetMean();
+	params.heatingRate = (tuning->heatingRate.GetMean() + (tuning->coolingRate.GetMean() * averageTemperatureRiseHeating/averageTemperatureRiseCooling)) / tuning->pwm;
+	params.gain = (tuning->tOn.GetMean() + tuning->tOff.GetMean()) * averageTemperatureRise/tuning->tOn.GetMean();
+	params.numCycles = tuning->dHigh.GetNumSamples();
 }
 
 void Heater::SetAndReportModelAfterTuning(bool usingFans) noexcept
 {
-	const float hRate = (usingFans) ? (fanOffParams.heatingRate + fanOnParams.heatingRate) * 0.5 : fanOffParams.heatingRate;
-	const float deadTime = (usingFans) ? (fanOffParams.deadTime + fanOnParams.deadTime) * 0.5 : fanOffParams.deadTime;
+	const float hRate = (usingFans) ? (tuning->fanOffParams.heatingRate + tuning->fanOnParams.heatingRate) * 0.5 : tuning->fanOffParams.heatingRate;
+	const float deadTime = (usingFans) ? (tuning->fanOffParams.deadTime + tuning->fanOnParams.deadTime) * 0.5 : tuning->fanOffParams.deadTime;
 	const float coolingRateExponent = (reprap.GetHeat().IsBedOrChamberHeater(GetHeaterNumber())) ? DefaultBedHeaterCoolingRateExponent : DefaultToolHeaterCoolingRateExponent;
-	const float averageTemperatureRiseCooling = tuningTargetTemp - TuningPeakTempDrop - 0.5 * tuningHysteresis - tuningStartTemp.GetMean();
-	const float basicCoolingRate = fanOffParams.coolingRate/powf(averageTemperatureRiseCooling * 0.01, coolingRateExponent);
+	const float averageTemperatureRiseCooling = tuning->targetTemp - TuningPeakTempDrop - 0.5 * tuning->hysteresis - tuning->startTemp.GetMean();
+	const float basicCoolingRate = tuning->fanOffParams.coolingRate/powf(averageTemperatureRiseCooling * 0.01, coolingRateExponent);
 	float fanOnCoolingRate = 0.0;
 	if (usingFans)
 	{
 		// Sometimes the print cooling fan makes no difference to the cooling rate. The SetModel call will fail if the rate with fan on is lower than the rate with fan off.
-		if (fanOnParams.coolingRate > fanOffParams.coolingRate)
+		if (tuning->fanOnParams.coolingRate > tuning->fanOffParams.coolingRate)
 		{
-			fanOnCoolingRate = ((fanOnParams.coolingRate - fanOffParams.coolingRate) * 100.0)/(averageTemperatureRiseCooling * tuningFanPwm);
+			fanOnCoolingRate = ((tuning->fanOnParams.coolingRate - tuning->fanOffParams.coolingRate) * 100.0)/(averageTemperatureRiseCooling * tuning->fanPwm);
 		}
 		else
 		{
@@ -405,30 +499,30 @@ void Heater::SetAndReportModelAfterTuning(bool usingFans) noexcept
 										fanOnCoolingRate,
 										coolingRateExponent,
 										deadTime,
-										tuningPwm,
+										tuning->pwm,
 #if HAS_VOLTAGE_MONITOR
-										tuningVoltage.GetMean(),
+										tuning->voltage.GetMean(),
 #else
 										0.0,
 #endif
-										true, false, str.GetRef());
+										true, GetModel().UseMpc(), false, str.GetRef());
 	if (Succeeded(rslt))
 	{
 		tuned = true;
 		str.printf(	"Auto tuning heater %u completed after %u idle and %u tuning cycles in %" PRIu32 " seconds. This heater needs the following M307 command:\n ",
 					GetHeaterNumber(),
-					idleCyclesDone,
-					(usingFans) ? fanOffParams.numCycles + fanOnParams.numCycles : fanOffParams.numCycles,
-					(millis() - tuningBeginTime)/(uint32_t)SecondsToMillis
+					tuning->idleCyclesDone,
+					(usingFans) ? tuning->fanOffParams.numCycles + tuning->fanOnParams.numCycles : tuning->fanOffParams.numCycles,
+					(millis() - tuning->beginTime)/(uint32_t)SecondsToMillis
 				  );
 		GetModel().AppendM307Command(GetHeaterNumber(), str.GetRef(), !reprap.GetHeat().IsBedOrChamberHeater(GetHeaterNumber()));
 		reprap.GetPlatform().Message(LoggedGenericMessage, str.c_str());
 		if (reprap.Debug(moduleHeat))
 		{
-			str.printf("Long term gain %.1f/%.1f", (double)fanOffParams.GetNormalGain(), (double)fanOffParams.gain);
+			str.printf("Long term gain %.1f/%.1f", (double)tuning->fanOffParams.GetNormalGain(), (double)tuning->fanOffParams.gain);
 			if (usingFans)
 			{
-				str.catf(" : %.1f/.1%f", (double)fanOnParams.GetNormalGain(), (double)fanOnParams.gain);
+				str.catf(" : %.1f/.1%f", (double)tuning->fanOnParams.GetNormalGain(), (double)tuning->fanOnParams.gain);
 			}
 			str.cat('\n');
 			reprap.GetPlatform().Message(GenericMessage, str.c_str());
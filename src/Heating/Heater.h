@@ -72,9 +72,24 @@ public:
 	float GetActiveTemperature() const noexcept { return activeTemperature; }
 	float GetStandbyTemperature() const noexcept { return standbyTemperature; }
 	GCodeResult SetActiveOrStandby(bool setActive, const StringRef& reply) noexcept;	// Switch from idle to active or standby
-	GCodeResult StartAutoTune(GCodeBuffer& gb, const StringRef& reply, FansBitmap fans) THROWS(GCodeException);
+	GCodeResult StartAutoTune(GCodeBuffer& gb, const StringRef& reply, FansBitmap fans, HeatersBitmap batch, uint32_t startDelay) THROWS(GCodeException);
 																		// Start an auto tune cycle for this heater
 	void GetAutoTuneStatus(const StringRef& reply) const noexcept;		// Get the auto tune status or last result
+	FansBitmap GetTuningFans() const noexcept;							// Get the fans that we turn on during tuning
+	unsigned int GetTuningPhase() const noexcept { return (tuning == nullptr) ? 0 : tuning->phase; }
+	unsigned int GetNumTuningPhases() const noexcept;
+	const char *_ecv_array GetTuningPhaseText() const noexcept;
+	HeatersBitmap GetTuningCoupledHeaters() const noexcept { return (tuning == nullptr) ? HeatersBitmap() : tuning->coupledHeaters; }
+
+	// Functions called by the heater task to measure and compensate for the thermal coupling between heaters that are tuned together
+	bool IsTuningInBatch() const noexcept { return tuning != nullptr && !tuning->batch.IsEmpty() && GetStatus() == HeaterStatus::tuning; }
+	HeatersBitmap GetTuningBatch() const noexcept { return tuning->batch; }
+	void RemoveFromTuningBatch(HeatersBitmap heatersToRemove) noexcept
+		{ if (tuning != nullptr) { tuning->batch &= ~heatersToRemove; tuning->coupledHeaters &= ~heatersToRemove; } }
+	bool HasStartedTuningCycles() const noexcept { return tuning != nullptr && tuning->phase != 0 && GetStatus() == HeaterStatus::tuning; }
+	float GetTuningRiseIntegral() const noexcept { return (HasStartedTuningCycles()) ? tuning->riseIntegral : 0.0; }
+	float GetTuningCouplingCoefficient() const noexcept { return (tuning == nullptr) ? 0.0 : tuning->couplingCoefficient; }
+	void UpdateTuningCoupling(float otherRiseIntegrals, HeatersBitmap heatingHeaters, float coupledTemperatureDifference, float reverseTemperatureDifference, float reverseCoefficient) noexcept;
 
 	void GetFaultDetectionParameters(float& pMaxTempExcursion, float& pMaxFaultTime) const noexcept
 		{ pMaxTempExcursion = maxTempExcursion; pMaxFaultTime = maxHeatingFaultTime; }
@@ -141,7 +156,7 @@ protected:
 	float GetTargetTemperature() const noexcept { return (active) ? activeTemperature : standbyTemperature; }
 	bool IsBedOrChamber() const noexcept { return isBedOrChamber; }
 
-	GCodeResult SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool inverted, const StringRef& reply) noexcept;
+	GCodeResult SetModel(float hr, float bcr, float fcr, float coolingRateExponent, float td, float maxPwm, float voltage, bool usePid, bool useMpc, bool inverted, const StringRef& reply) noexcept;
 															// set the process model
 	void ReportTuningUpdate() noexcept;						// tell the user what's happening
 	void CalculateModel(HeaterParameters& params) noexcept;	// calculate G, td and tc from the accumulated readings
@@ -160,37 +175,68 @@ protected:
 	static constexpr float DefaultTuningFanPwm = 0.7;
 	static constexpr float TuningPeakTempDrop = 2.0;		// must be well below TuningHysteresis
 	static constexpr float HeaterSettledCoolingTimeRatio = 0.93;
+	static constexpr float MinTuningCouplingRise = 1.0;			// the temperature rise while waiting to start heating above which we compensate for thermal coupling
 
-	// Variables used during heater tuning
-	static float tuningPwm;									// the PWM to use, 0..1
-	static float tuningTargetTemp;							// the target temperature
-	static float tuningHysteresis;
-	static float tuningFanPwm;
-
-	static DeviationAccumulator tuningStartTemp;			// the temperature when we turned on the heater
-	static uint32_t tuningBeginTime;						// when we started the tuning process
-	static DeviationAccumulator dHigh;
-	static DeviationAccumulator dLow;
-	static DeviationAccumulator tOn;
-	static DeviationAccumulator tOff;
-	static DeviationAccumulator heatingRate;
-	static DeviationAccumulator coolingRate;
-	static DeviationAccumulator tuningVoltage;				// sum of the voltage readings we take during the heating phase
-
-	static uint32_t lastOffTime;
-	static uint32_t lastOnTime;
-	static float peakTemp;									// max or min temperature
-	static uint32_t peakTime;								// the time at which we recorded peakTemp
-	static float afterPeakTemp;								// temperature after max from which we start timing the cooling rate
-	static uint32_t afterPeakTime;							// the time at which we recorded afterPeakTemp
-	static float lastCoolingRate;
-	static FansBitmap tuningFans;
-	static unsigned int tuningPhase;
-	static uint8_t idleCyclesDone;
-
-	static HeaterParameters fanOffParams, fanOnParams;
-
-	static void ClearCounters() noexcept;
+	// Variables used during heater tuning. Each heater has its own set so that several heaters can be tuned at the same time.
+	// They are allocated when the heater is first tuned and kept until the heater is deleted, so that they can still be read after tuning has finished.
+	struct TuningData
+	{
+		float pwm;									// the PWM to use, 0..1
+		float targetTemp;							// the target temperature
+		float hysteresis;
+		float fanPwm;
+
+		DeviationAccumulator startTemp;				// the temperature when we turned on the heater
+		uint32_t beginTime;							// when we started the tuning process
+		DeviationAccumulator dHigh;
+		DeviationAccumulator dLow;
+		DeviationAccumulator tOn;
+		DeviationAccumulator tOff;
+		DeviationAccumulator heatingRate;
+		DeviationAccumulator coolingRate;
+		DeviationAccumulator voltage;				// sum of the voltage readings we take during the heating phase
+
+		uint32_t lastOffTime;
+		uint32_t lastOnTime;
+		float peakTemp;								// max or min temperature
+		uint32_t peakTime;							// the time at which we recorded peakTemp
+		float afterPeakTemp;						// temperature after max from which we start timing the cooling rate
+		uint32_t afterPeakTime;						// the time at which we recorded afterPeakTemp
+		float lastCoolingRate;
+		FansBitmap fans;
+		unsigned int phase;
+		uint8_t idleCyclesDone;
+
+		HeaterParameters fanOffParams, fanOnParams;
+
+		// Thermal coupling to the other heaters that were started by the same M303 command.
+		// Heaters in a batch start heating at staggered times. While a heater is waiting to start, we fit the rise in its temperature to
+		// couplingCoefficient * (sum of the rise integrals of the other heaters), then while it is cycling we subtract the heat flowing from them.
+		// Heaters that start before any others can't measure the coupling, so they use the coefficients measured by the heaters that found themselves coupled to them.
+		HeatersBitmap batch;						// the other heaters started by the same M303 command
+		HeatersBitmap coupledHeaters;				// the heaters in the batch that were heating while we measured the coupling, if we detected any
+		uint32_t startDelay;						// how long after beginTime we wait before we start heating, in milliseconds
+		float riseIntegral;							// the integral of our temperature rise since we started heating, in C.sec
+		float couplingSumXY, couplingSumXX;			// sums for the least squares fit of our temperature rise against the rise integrals of the other heaters
+		float maxCouplingRise;						// the largest temperature rise we saw while waiting to start heating
+		float couplingCoefficient;					// how fast we heat up per C of temperature difference to the other heaters, in 1/sec
+		float couplingRate;							// the current heating rate caused by the other heaters, in C/sec
+		float couplingRateSum;						// the sum of the coupling rates since the start of the current heating or cooling measurement
+		unsigned int couplingRateCount;				// how many coupling rates we have added to couplingRateSum
+		uint32_t couplingWindowStart;				// the value of afterPeakTime when we started accumulating couplingRateSum
+
+		void ClearCounters() noexcept;
+		void ClearCoupling() noexcept;
+		void RestartCouplingAverage(uint32_t windowStart) noexcept { couplingRateSum = 0.0; couplingRateCount = 0; couplingWindowStart = windowStart; }
+		float GetAverageCouplingRate() const noexcept { return (couplingRateCount == 0) ? couplingRate : couplingRateSum/couplingRateCount; }
+	};
+
+	void AllocateTuningData() noexcept;
+	void FinishCouplingMeasurement() noexcept;				// called when we turn the heater on for the first time during tuning
+	bool IsWaitingForTuningStartDelay(uint32_t now) const noexcept
+		{ return now - tuning->beginTime < tuning->startDelay; }
+
+	TuningData *tuning;										// nullptr until we first tune this heater
 
 private:
 	static const char* const TuningPhaseText[];
@@ -91,6 +91,10 @@ void LocalHeater::ResetHeater() noexcept
 	averagePWM = lastPwm = 0.0;
 	heatingFaultCount = 0;
 	temperature = BadErrorTemperature;
+#if SUPPORT_MPC_HEATER_CONTROL
+	mpcFanPwm = 0.0;
+	ResetMpc();
+#endif
 }
 
 // Configure the heater port and the sensor number
@@ -234,6 +238,10 @@ void LocalHeater::SwitchOff() noexcept
 // This is called when the heater model has been updated. Returns true if successful.
 GCodeResult LocalHeater::UpdateModel(const StringRef& reply) noexcept
 {
+#if SUPPORT_MPC_HEATER_CONTROL
+	TaskCriticalSectionLocker lock;							// the Heat task may be using the PWM history
+	ResetMpc();
+#endif
 	return GCodeResult::ok;
 }
 
@@ -247,6 +255,9 @@ void LocalHeater::Spin() noexcept
 	if (err != TemperatureError::success)
 	{
 		previousTemperaturesGood <<= 1;				// this reading isn't a good one
+#if SUPPORT_MPC_HEATER_CONTROL
+		mpcPredictionValid = false;
+#endif
 		if (mode > HeaterMode::suspended)			// don't worry about errors when reading heaters that are switched off or flagged as having faults
 		{
 			// Error may be a temporary error and may correct itself after a few additional reads
@@ -281,6 +292,9 @@ void LocalHeater::Spin() noexcept
 
 		if (GetModel().IsEnabled())
 		{
+#if SUPPORT_MPC_HEATER_CONTROL
+			UpdateMpcDisturbance();
+#endif
 			// Get the target temperature and the error
 			const float targetTemperature = GetTargetTemperature();
 			const float error = targetTemperature - temperature;
@@ -387,6 +401,20 @@ void LocalHeater::Spin() noexcept
 			else
 			{
 				// Performing normal temperature control
+#if SUPPORT_MPC_HEATER_CONTROL
+				if (GetModel().UseMpc() && !GetModel().IsInverted())
+				{
+					// Using model predictive control
+					lastPwm = CalcMpcPwm(targetTemperature);
+# if HAS_VOLTAGE_MONITOR
+					if (!reprap.GetHeat().IsBedOrChamberHeater(GetHeaterNumber()))
+					{
+						lastPwm = GetModel().CorrectPwmForVoltage(lastPwm, reprap.GetPlatform().GetCurrentPowerVoltage());
+					}
+# endif
+				}
+				else
+#endif
 				if (GetModel().UsePid())
 				{
 					// Using PID mode. Determine the PID parameters to use.
@@ -477,6 +505,10 @@ void LocalHeater::Spin() noexcept
 			lastPwm = 0.0;
 		}
 
+#if SUPPORT_MPC_HEATER_CONTROL
+		RecordMpcPwm((GetModel().IsInverted()) ? GetModel().GetMaxPwm() - lastPwm : lastPwm);
+#endif
+
 		// Set the heater power and update the average PWM
 		SetHeater(lastPwm);
 		constexpr float avgFactor = HeatSampleIntervalMillis/(HeatPwmAverageTime * SecondsToMillis);
@@ -518,7 +550,7 @@ float LocalHeater::GetExpectedHeatingRate() const noexcept
 	return GetModel().GetNetHeatingRate(temperatureRise, 1.0, pwm);
 }
 
-// Auto tune this heater. The caller has already checked that no other heater is being tuned and has set up tuningTargetTemp, tuningPwm, tuningFans, tuningHysteresis and tuningFanPwm.
+// Auto tune this heater. The caller has already checked that this heater is not being tuned and has set up the tuning target temperature, PWM, fans, hysteresis and fan PWM.
 GCodeResult LocalHeater::StartAutoTune(const StringRef& reply, bool seenA, float ambientTemp) noexcept
 {
 	if (lastPwm > 0.0 || GetAveragePWM() > 0.02)
@@ -527,25 +559,25 @@ GCodeResult LocalHeater::StartAutoTune(const StringRef& reply, bool seenA, float
 		return GCodeResult::error;
 	}
 
-	reprap.GetFansManager().SetFansValue(tuningFans, 0.0);
+	reprap.GetFansManager().SetFansValue(tuning->fans, 0.0);
 
-	tuningStartTemp.Clear();
-	tuningBeginTime = millis();
+	tuning->startTemp.Clear();
+	tuning->beginTime = millis();
 	tuned = false;					// assume failure
 
 	if (seenA)
 	{
-		tuningStartTemp.Add(ambientTemp);
-		ClearCounters();
+		tuning->startTemp.Add(ambientTemp);
+		tuning->ClearCounters();
 		timeSetHeating = millis();
-		lastPwm = tuningPwm;										// turn on heater at specified power
-		tuningPhase = 1;
+		lastPwm = tuning->pwm;										// turn on heater at specified power
+		tuning->phase = 1;
 		mode = HeaterMode::tuning1;
 		ReportTuningUpdate();
 	}
 	else
 	{
-		tuningPhase = 0;
+		tuning->phase = 0;
 		mode = HeaterMode::tuning0;
 	}
 
@@ -567,6 +599,9 @@ void LocalHeater::FeedForwardAdjustment(float fanPwmChange, float extrusionChang
 		InterruptCriticalSectionLocker lock;
 		iAccumulator += boost;
 	}
+#if SUPPORT_MPC_HEATER_CONTROL
+	mpcFanPwm = constrain<float>(mpcFanPwm + fanPwmChange, 0.0, 1.0);
+#endif
 }
 
 // Set extrusion feedforward. This is called from an ISR.
@@ -575,6 +610,107 @@ void LocalHeater::SetExtrusionFeedForward(float pwm) noexcept
 	extrusionBoost = pwm;
 }
 
+#if SUPPORT_MPC_HEATER_CONTROL
+
+/* Notes on model predictive control
+ *
+ * The heater model says that the temperature T changes at the rate R * P - C(T, F) where P is the heater PWM and C is the cooling rate,
+ * which depends on the temperature rise above ambient and the fan PWM F. A change in P only starts to affect the temperature after the dead time.
+ * So the PWM values that we applied during the last dead time have already decided the temperature one dead time from now. On each sample we
+ * predict that temperature by simulating the model forward from the current temperature using those PWM values. We then choose the PWM that
+ * moves the predicted temperature to the target over the following dead time, plus the extrusion feedforward.
+ *
+ * The model is never exact and we don't always know the fan PWM, for example if the fan was set by M106 instead of by the tool.
+ * So we compare each temperature reading with the model's prediction for it and use the errors to estimate an extra heating rate,
+ * which we include in the model. This does the job of the I term of a PID controller.
+ */
+
+// Clear the PWM history and set up the slots so that they cover the dead time. If the dead time is long, each slot covers several samples.
+void LocalHeater::ResetMpc() noexcept
+{
+	mpcSamplesInDeadTime = max<unsigned int>(lrintf(GetModel().GetDeadTime() * SecondsToMillis/(float)HeatSampleIntervalMillis), 1);
+	mpcSamplesPerSlot = (mpcSamplesInDeadTime + MpcMaxPwmHistorySlots - 1)/MpcMaxPwmHistorySlots;
+	mpcNumSlots = (mpcSamplesInDeadTime + mpcSamplesPerSlot - 1)/mpcSamplesPerSlot;
+	for (float& pwm : mpcPwmHistory)
+	{
+		pwm = 0.0;
+	}
+	mpcSlotPwmTotal = 0.0;
+	mpcSampleCount = mpcHistoryIndex = 0;
+	mpcDisturbance = 0.0;
+	mpcPredictionValid = false;
+}
+
+// Compare the latest temperature reading with the model prediction and update the disturbance estimate
+void LocalHeater::UpdateMpcDisturbance() noexcept
+{
+	if (mpcPredictionValid)
+	{
+		const float predictionError = temperature - mpcPredictedTemperature;
+		const float maxDisturbance = GetModel().GetHeatingRate();
+		mpcDisturbance = constrain<float>(mpcDisturbance + MpcDisturbanceGain * predictionError * (SecondsToMillis/(float)HeatSampleIntervalMillis), -maxDisturbance, maxDisturbance);
+	}
+}
+
+// Record the PWM that we are about to apply, and predict the next temperature reading
+void LocalHeater::RecordMpcPwm(float pwm) noexcept
+{
+	// The extrusion feedforward makes up for the heat taken by the filament, so it doesn't raise the temperature.
+	// Only subtract as much of it as we applied, because the PWM may have been limited or the heater may not have been using feedforward.
+	mpcSlotPwmTotal += pwm - min<float>(extrusionBoost, pwm);
+	++mpcSampleCount;
+	if (mpcSampleCount == mpcSamplesPerSlot)
+	{
+		mpcPwmHistory[mpcHistoryIndex] = mpcSlotPwmTotal/mpcSamplesPerSlot;
+		mpcHistoryIndex = (mpcHistoryIndex + 1) % mpcNumSlots;
+		mpcSlotPwmTotal = 0.0;
+		mpcSampleCount = 0;
+	}
+
+	// The temperature change over the next sample interval depends on the PWM that we applied one dead time ago, which is in the oldest slot
+	mpcPredictedTemperature = temperature
+								+ (GetModel().GetNetHeatingRate(temperature - NormalAmbientTemperature, mpcFanPwm, mpcPwmHistory[mpcHistoryIndex]) + mpcDisturbance)
+									* (HeatSampleIntervalMillis * MillisToSeconds);
+	mpcPredictionValid = true;
+}
+
+// Predict the temperature one dead time from now by simulating the model forward using the PWM values we applied during the last dead time
+float LocalHeater::PredictMpcTemperature() const noexcept
+{
+	const FopDt& model = GetModel();
+	const float fanPwm = mpcFanPwm;
+	constexpr float SampleInterval = HeatSampleIntervalMillis * MillisToSeconds;
+
+	// The oldest slot may start before the dead time, in which case we use only the later part of it
+	const int samplesInOldestSlot = (int)mpcSamplesInDeadTime - (int)mpcSampleCount - (int)(mpcNumSlots - 1) * (int)mpcSamplesPerSlot;
+	float t = temperature;
+	size_t index = mpcHistoryIndex;
+	for (size_t i = 0; i < mpcNumSlots; ++i)
+	{
+		const int numSamples = (i == 0) ? max<int>(samplesInOldestSlot, 0) : (int)mpcSamplesPerSlot;
+		t += (model.GetNetHeatingRate(t - NormalAmbientTemperature, fanPwm, mpcPwmHistory[index]) + mpcDisturbance) * (numSamples * SampleInterval);
+		index = (index + 1) % mpcNumSlots;
+	}
+	if (mpcSampleCount != 0)
+	{
+		t += (model.GetNetHeatingRate(t - NormalAmbientTemperature, fanPwm, mpcSlotPwmTotal/mpcSampleCount) + mpcDisturbance) * (mpcSampleCount * SampleInterval);
+	}
+	return t;
+}
+
+// Calculate the PWM that moves the temperature predicted for one dead time from now to the target over the following dead time
+float LocalHeater::CalcMpcPwm(float targetTemperature) const noexcept
+{
+	const FopDt& model = GetModel();
+	const float predictedTemperature = PredictMpcTemperature();
+	const float requiredHeatingRate = (targetTemperature - predictedTemperature)/model.GetDeadTime()
+										+ model.GetCoolingRate(predictedTemperature - NormalAmbientTemperature, mpcFanPwm)
+										- mpcDisturbance;
+	return constrain<float>(requiredHeatingRate/model.GetHeatingRate() + extrusionBoost, 0.0, model.GetMaxPwm());
+}
+
+#endif
+
 /* Notes on the auto tune algorithm
  *
  * Most 3D printer firmwares use the �str�m-H�gglund relay tuning method (sometimes called Ziegler-Nichols + relay).
@@ -618,30 +754,35 @@ void LocalHeater::DoTuningStep() noexcept
 	switch (mode)
 	{
 	case HeaterMode::tuning0:		// Waiting for initial temperature to settle after any thermostatic fans have turned on
-		if (tuningStartTemp.GetNumSamples() < 5000/HeatSampleIntervalMillis)
+		if (tuning->startTemp.GetNumSamples() < 5000/HeatSampleIntervalMillis)
 		{
-			tuningStartTemp.Add(temperature);							// take another reading until we have samples temperatures for 5 seconds
+			tuning->startTemp.Add(temperature);							// take another reading until we have samples temperatures for 5 seconds
 			return;
 		}
 
-		if (tuningStartTemp.GetDeviation() <= 2.0)
+		if (tuning->startTemp.GetDeviation() <= 2.0)
 		{
+			if (IsWaitingForTuningStartDelay(now))
+			{
+				return;													// wait for heaters tuned together with this one to start, so that we can measure the coupling
+			}
+			FinishCouplingMeasurement();
 			timeSetHeating = now;
-			lastPwm = tuningPwm;										// turn on heater at specified power
+			lastPwm = tuning->pwm;										// turn on heater at specified power
 			mode = HeaterMode::tuning1;
 
-			tuningPhase = 1;
+			tuning->phase = 1;
 			ReportTuningUpdate();
 			return;
 		}
 
-		if (now - tuningBeginTime < 20000)
+		if (now - tuning->beginTime < 20000)
 		{
 			// Allow up to 20 seconds for starting temperature to settle
 			return;
 		}
 
-		reprap.GetPlatform().Message(GenericMessage, "Auto tune cancelled because starting temperature is not stable\n");
+		reprap.GetPlatform().MessageF(GenericMessage, "Auto tune of heater %u cancelled because starting temperature is not stable\n", GetHeaterNumber());
 		break;
 
 	case HeaterMode::tuning1:		// Heating up
@@ -653,13 +794,13 @@ void LocalHeater::DoTuningStep() noexcept
 				// Move on to next phase
 				lastPwm = 0.0;
 				SetHeater(0.0);
-				peakTemp = afterPeakTemp = temperature;
-				lastOffTime = peakTime = afterPeakTime = now;
+				tuning->peakTemp = tuning->afterPeakTemp = temperature;
+				tuning->lastOffTime = tuning->peakTime = tuning->afterPeakTime = now;
 				mode = HeaterMode::tuning2;
 			}
 			else
 			{
-				lastPwm = tuningPwm;
+				lastPwm = tuning->pwm;
 			}
 			return;
 		}
@@ -668,31 +809,31 @@ void LocalHeater::DoTuningStep() noexcept
 			const bool isBedOrChamberHeater = reprap.GetHeat().IsBedOrChamberHeater(GetHeaterNumber());
 			const uint32_t heatingTime = now - timeSetHeating;
 			const float extraTimeAllowed = (isBedOrChamberHeater) ? 120.0 : 30.0;
-			if (heatingTime > (uint32_t)((GetModel().GetDeadTime() + extraTimeAllowed) * SecondsToMillis) && (temperature - tuningStartTemp.GetMean()) < 3.0)
+			if (heatingTime > (uint32_t)((GetModel().GetDeadTime() + extraTimeAllowed) * SecondsToMillis) && (temperature - tuning->startTemp.GetMean()) < 3.0)
 			{
-				reprap.GetPlatform().Message(GenericMessage, "Auto tune cancelled because temperature is not increasing\n");
+				reprap.GetPlatform().MessageF(GenericMessage, "Auto tune of heater %u cancelled because temperature is not increasing\n", GetHeaterNumber());
 				break;
 			}
 
 			const uint32_t timeoutMinutes = (isBedOrChamberHeater) ? 30 : 7;
 			if (heatingTime >= timeoutMinutes * 60 * (uint32_t)SecondsToMillis)
 			{
-				reprap.GetPlatform().Message(GenericMessage, "Auto tune cancelled because target temperature was not reached\n");
+				reprap.GetPlatform().MessageF(GenericMessage, "Auto tune of heater %u cancelled because target temperature was not reached\n", GetHeaterNumber());
 				break;
 			}
 		}
 
-		if (temperature >= tuningTargetTemp)							// if reached target
+		if (temperature >= tuning->targetTemp)							// if reached target
 		{
 			// Move on to next phase
 			lastPwm = 0.0;
 			SetHeater(0.0);
-			peakTemp = afterPeakTemp = temperature;
-			lastOffTime = peakTime = afterPeakTime = now;
-			tuningVoltage.Clear();
-			idleCyclesDone = 0;
+			tuning->peakTemp = tuning->afterPeakTemp = temperature;
+			tuning->lastOffTime = tuning->peakTime = tuning->afterPeakTime = now;
+			tuning->voltage.Clear();
+			tuning->idleCyclesDone = 0;
 			mode = HeaterMode::tuning2;
-			tuningPhase = 2;
+			tuning->phase = 2;
 			ReportTuningUpdate();
 		}
 		return;
@@ -701,10 +842,10 @@ void LocalHeater::DoTuningStep() noexcept
 #if SUPPORT_REMOTE_COMMANDS
 		if (CanInterface::InExpansionMode())
 		{
-			if (temperature >= peakTemp)
+			if (temperature >= tuning->peakTemp)
 			{
-				peakTemp = afterPeakTemp = temperature;
-				peakTime = afterPeakTime = now;
+				tuning->peakTemp = tuning->afterPeakTemp = temperature;
+				tuning->peakTime = tuning->afterPeakTime = now;
 			}
 			else if (temperature < ExpansionMode::tuningLowTemp)
 			{
@@ -713,116 +854,116 @@ void LocalHeater::DoTuningStep() noexcept
 				// If we have been collecting data, see if we have enough, and either turn the heater on to start another cycle or finish tuning.
 
 				// Save the data (don't know whether we need it yet)
-				ExpansionMode::dHigh = peakTime - lastOffTime;
-				ExpansionMode::tOff = now - lastOffTime;
-				ExpansionMode::coolingRate = (afterPeakTemp - temperature) * SecondsToMillis/(now - afterPeakTime);
-				lastOnTime = peakTime = afterPeakTime = now;
-				peakTemp = afterPeakTemp = temperature;
-				lastPwm = tuningPwm;						// turn on heater at specified power
+				ExpansionMode::dHigh = tuning->peakTime - tuning->lastOffTime;
+				ExpansionMode::tOff = now - tuning->lastOffTime;
+				ExpansionMode::coolingRate = (tuning->afterPeakTemp - temperature) * SecondsToMillis/(now - tuning->afterPeakTime);
+				tuning->lastOnTime = tuning->peakTime = tuning->afterPeakTime = now;
+				tuning->peakTemp = tuning->afterPeakTemp = temperature;
+				lastPwm = tuning->pwm;						// turn on heater at specified power
 				mode = HeaterMode::tuning3;
 			}
-			else if (afterPeakTime == peakTime && ExpansionMode::tuningHighTemp - temperature >= ExpansionMode::tuningPeakTempDrop)
+			else if (tuning->afterPeakTime == tuning->peakTime && ExpansionMode::tuningHighTemp - temperature >= ExpansionMode::tuningPeakTempDrop)
 			{
-				afterPeakTime = now;
-				afterPeakTemp = temperature;
+				tuning->afterPeakTime = now;
+				tuning->afterPeakTemp = temperature;
 			}
 			return;
 		}
 #endif
-		if (temperature >= peakTemp)
+		if (temperature >= tuning->peakTemp)
 		{
-			peakTemp = afterPeakTemp = temperature;
-			peakTime = afterPeakTime = now;
+			tuning->peakTemp = tuning->afterPeakTemp = temperature;
+			tuning->peakTime = tuning->afterPeakTime = now;
 		}
-		else if (temperature < tuningTargetTemp - tuningHysteresis)
+		else if (temperature < tuning->targetTemp - tuning->hysteresis)
 		{
 			// Temperature has dropped below the low limit.
 			// If we have been doing idle cycles, see whether we can switch to collecting data, and turn the heater on.
 			// If we have been collecting data, see if we have enough, and either turn the heater on to start another cycle or finish tuning.
 
 			// Save the data (don't know whether we need it yet)
-			dHigh.Add((float)(peakTime - lastOffTime));
-			tOff.Add((float)(now - lastOffTime));
-			const float currentCoolingRate = (afterPeakTemp - temperature) * SecondsToMillis/(now - afterPeakTime);
-			coolingRate.Add(currentCoolingRate);
+			tuning->dHigh.Add((float)(tuning->peakTime - tuning->lastOffTime));
+			tuning->tOff.Add((float)(now - tuning->lastOffTime));
+			const float currentCoolingRate = (tuning->afterPeakTemp - temperature) * SecondsToMillis/(now - tuning->afterPeakTime) + tuning->GetAverageCouplingRate();
+			tuning->coolingRate.Add(currentCoolingRate);
 
 			// Decide whether to finish this phase
-			if (tuningPhase == 2)				// if we are doing idle cycles
+			if (tuning->phase == 2)				// if we are doing idle cycles
 			{
 				// To allow for heat reservoirs, we do idle cycles until the cooling rate decreases by no more than a certain amount in a single cycle
-				if (idleCyclesDone == TuningHeaterMaxIdleCycles || (idleCyclesDone >= TuningHeaterMinIdleCycles && currentCoolingRate >= lastCoolingRate * HeaterSettledCoolingTimeRatio))
+				if (tuning->idleCyclesDone == TuningHeaterMaxIdleCycles || (tuning->idleCyclesDone >= TuningHeaterMinIdleCycles && currentCoolingRate >= tuning->lastCoolingRate * HeaterSettledCoolingTimeRatio))
 				{
-					tuningPhase = 3;
+					tuning->phase = 3;
 					ReportTuningUpdate();
 				}
 				else
 				{
-					lastCoolingRate = currentCoolingRate;
-					ClearCounters();
-					++idleCyclesDone;
+					tuning->lastCoolingRate = currentCoolingRate;
+					tuning->ClearCounters();
+					++tuning->idleCyclesDone;
 				}
 			}
-			else if (coolingRate.GetNumSamples() >= MinTuningHeaterCycles)
+			else if (tuning->coolingRate.GetNumSamples() >= MinTuningHeaterCycles)
 			{
-				const bool isConsistent = dLow.DeviationFractionWithin(0.2)
-										&& dHigh.DeviationFractionWithin(0.2)
-										&& heatingRate.DeviationFractionWithin(0.1)
-										&& coolingRate.DeviationFractionWithin(0.1);
-				if (isConsistent || coolingRate.GetNumSamples() == MaxTuningHeaterCycles)
+				const bool isConsistent = tuning->dLow.DeviationFractionWithin(0.2)
+										&& tuning->dHigh.DeviationFractionWithin(0.2)
+										&& tuning->heatingRate.DeviationFractionWithin(0.1)
+										&& tuning->coolingRate.DeviationFractionWithin(0.1);
+				if (isConsistent || tuning->coolingRate.GetNumSamples() == MaxTuningHeaterCycles)
 				{
 					if (!isConsistent)
 					{
-						reprap.GetPlatform().Message(WarningMessage, "heater behaviour was not consistent during tuning\n");
+						reprap.GetPlatform().MessageF(WarningMessage, "heater %u behaviour was not consistent during tuning\n", GetHeaterNumber());
 					}
 
-					if (tuningPhase == 3)
+					if (tuning->phase == 3)
 					{
-						CalculateModel(fanOffParams);
-						if (tuningFans.IsEmpty())
+						CalculateModel(tuning->fanOffParams);
+						if (tuning->fans.IsEmpty())
 						{
 							SetAndReportModelAfterTuning(false);
 							break;
 						}
 						else
 						{
-							tuningPhase = 4;
-							ClearCounters();
+							tuning->phase = 4;
+							tuning->ClearCounters();
 #if TUNE_WITH_HALF_FAN
-							reprap.GetFansManager().SetFansValue(tuningFans, tuningFanPwm * 0.5);	// turn fans on at half PWM
+							reprap.GetFansManager().SetFansValue(tuning->fans, tuning->fanPwm * 0.5);	// turn fans on at half PWM
 #else
-							reprap.GetFansManager().SetFansValue(tuningFans, tuningFanPwm);		// turn fans on at full PWM
+							reprap.GetFansManager().SetFansValue(tuning->fans, tuning->fanPwm);		// turn fans on at full PWM
 #endif
 							ReportTuningUpdate();
 						}
 					}
 #if TUNE_WITH_HALF_FAN
-					else if (tuningPhase == 4)
+					else if (tuning->phase == 4)
 					{
-						CalculateModel(fanOnParams);
-						tuningPhase = 5;
-						ClearCounters();
-						reprap.GetFansManager().SetFansValue(tuningFans, tuningFanPwm);			// turn fans fully on
+						CalculateModel(tuning->fanOnParams);
+						tuning->phase = 5;
+						tuning->ClearCounters();
+						reprap.GetFansManager().SetFansValue(tuning->fans, tuning->fanPwm);			// turn fans fully on
 						ReportTuningUpdate();
 					}
 #endif
 					else
 					{
-						reprap.GetFansManager().SetFansValue(tuningFans, 0.0);					// turn fans off
-						CalculateModel(fanOnParams);
+						reprap.GetFansManager().SetFansValue(tuning->fans, 0.0);					// turn fans off
+						CalculateModel(tuning->fanOnParams);
 						SetAndReportModelAfterTuning(true);
 						break;
 					}
 				}
 			}
-			lastOnTime = peakTime = afterPeakTime = now;
-			peakTemp = afterPeakTemp = temperature;
-			lastPwm = tuningPwm;						// turn on heater at specified power
+			tuning->lastOnTime = tuning->peakTime = tuning->afterPeakTime = now;
+			tuning->peakTemp = tuning->afterPeakTemp = temperature;
+			lastPwm = tuning->pwm;						// turn on heater at specified power
 			mode = HeaterMode::tuning3;
 		}
-		else if (afterPeakTime == peakTime && tuningTargetTemp - temperature >= TuningPeakTempDrop)
+		else if (tuning->afterPeakTime == tuning->peakTime && tuning->targetTemp - temperature >= TuningPeakTempDrop)
 		{
-			afterPeakTime = now;
-			afterPeakTemp = temperature;
+			tuning->afterPeakTime = now;
+			tuning->afterPeakTemp = temperature;
 		}
 		return;
 
@@ -830,10 +971,10 @@ void LocalHeater::DoTuningStep() noexcept
 #if SUPPORT_REMOTE_COMMANDS
 		if (CanInterface::InExpansionMode())
 		{
-			if (temperature <= peakTemp)
+			if (temperature <= tuning->peakTemp)
 			{
-				peakTemp = afterPeakTemp = temperature;
-				peakTime = afterPeakTime = now;
+				tuning->peakTemp = tuning->afterPeakTemp = temperature;
+				tuning->peakTime = tuning->afterPeakTime = now;
 			}
 			else if (temperature >= ExpansionMode::tuningHighTemp)
 			{
@@ -841,49 +982,49 @@ void LocalHeater::DoTuningStep() noexcept
 # if HAS_VOLTAGE_MONITOR
 				ExpansionMode::tuningVoltage = reprap.GetPlatform().GetCurrentPowerVoltage();	// save this while the heater is on
 # else
-				tuningVoltage = 0.0;
+				ExpansionMode::tuningVoltage = 0.0;
 # endif
-				ExpansionMode::dLow = peakTime - lastOnTime;
-				ExpansionMode::tOn = now - lastOnTime;
-				ExpansionMode::heatingRate = (temperature - afterPeakTemp) * SecondsToMillis/(now - afterPeakTime);
-				lastOffTime = peakTime = afterPeakTime = now;
-				peakTemp = afterPeakTemp = temperature;
+				ExpansionMode::dLow = tuning->peakTime - tuning->lastOnTime;
+				ExpansionMode::tOn = now - tuning->lastOnTime;
+				ExpansionMode::heatingRate = (temperature - tuning->afterPeakTemp) * SecondsToMillis/(now - tuning->afterPeakTime);
+				tuning->lastOffTime = tuning->peakTime = tuning->afterPeakTime = now;
+				tuning->peakTemp = tuning->afterPeakTemp = temperature;
 				lastPwm = 0.0;										// turn heater off
 				mode = HeaterMode::tuning2;
 				++ExpansionMode::cyclesDone;
 				ExpansionMode::tuningCycleComplete = true;
 			}
-			else if (afterPeakTime == peakTime && temperature - ExpansionMode::tuningLowTemp >= ExpansionMode::tuningPeakTempDrop)
+			else if (tuning->afterPeakTime == tuning->peakTime && temperature - ExpansionMode::tuningLowTemp >= ExpansionMode::tuningPeakTempDrop)
 			{
-				afterPeakTime = now;
-				afterPeakTemp = temperature;
+				tuning->afterPeakTime = now;
+				tuning->afterPeakTemp = temperature;
 			}
 			return;
 		}
 #endif
 #if HAS_VOLTAGE_MONITOR
-		tuningVoltage.Add(reprap.GetPlatform().GetCurrentPowerVoltage());
+		tuning->voltage.Add(reprap.GetPlatform().GetCurrentPowerVoltage());
 #endif
-		if (temperature <= peakTemp)
+		if (temperature <= tuning->peakTemp)
 		{
-			peakTemp = afterPeakTemp = temperature;
-			peakTime = afterPeakTime = now;
+			tuning->peakTemp = tuning->afterPeakTemp = temperature;
+			tuning->peakTime = tuning->afterPeakTime = now;
 		}
-		else if (temperature >= tuningTargetTemp)
+		else if (temperature >= tuning->targetTemp)
 		{
 			// We have reached the target temperature, so record a data point and turn the heater off
-			dLow.Add((float)(peakTime - lastOnTime));
-			tOn.Add((float)(now - lastOnTime));
-			heatingRate.Add((temperature - afterPeakTemp) * SecondsToMillis/(now - afterPeakTime));
-			lastOffTime = peakTime = afterPeakTime = now;
-			peakTemp = afterPeakTemp = temperature;
+			tuning->dLow.Add((float)(tuning->peakTime - tuning->lastOnTime));
+			tuning->tOn.Add((float)(now - tuning->lastOnTime));
+			tuning->heatingRate.Add((temperature - tuning->afterPeakTemp) * SecondsToMillis/(now - tuning->afterPeakTime) - tuning->GetAverageCouplingRate());
+			tuning->lastOffTime = tuning->peakTime = tuning->afterPeakTime = now;
+			tuning->peakTemp = tuning->afterPeakTemp = temperature;
 			lastPwm = 0.0;								// turn heater off
 			mode = HeaterMode::tuning2;
 		}
-		else if (afterPeakTime == peakTime && temperature - tuningTargetTemp >= TuningPeakTempDrop - tuningHysteresis)
+		else if (tuning->afterPeakTime == tuning->peakTime && temperature - tuning->targetTemp >= TuningPeakTempDrop - tuning->hysteresis)
 		{
-			afterPeakTime = now;
-			afterPeakTemp = temperature;
+			tuning->afterPeakTime = now;
+			tuning->afterPeakTemp = temperature;
 		}
 		return;
 
@@ -956,9 +1097,10 @@ GCodeResult LocalHeater::TuningCommand(const CanMessageHeaterTuningCommand& msg,
 		}
 
 		// We could do some more checks here but the main board should have done all the checks needed already
+		AllocateTuningData();
 		ExpansionMode::tuningHighTemp = msg.highTemp;
 		ExpansionMode::tuningLowTemp = msg.lowTemp;
-		tuningPwm = msg.pwm;
+		tuning->pwm = msg.pwm;
 		ExpansionMode::tuningPeakTempDrop = msg.peakTempDrop;
 		timeSetHeating = millis();
 		ExpansionMode::tuningCycleComplete = false;
@@ -67,6 +67,13 @@ private:
 	void DoTuningStep() noexcept;							// Called on each temperature sample when auto tuning
 	float GetExpectedHeatingRate() const noexcept;			// Get the minimum heating rate we expect
 	void RaiseHeaterFault(HeaterFaultType type, const char *_ecv_array format, ...) noexcept;
+#if SUPPORT_MPC_HEATER_CONTROL
+	void ResetMpc() noexcept;								// Clear the PWM history and set up the slots to cover the dead time
+	void UpdateMpcDisturbance() noexcept;					// Compare the temperature with the model prediction and update the disturbance estimate
+	void RecordMpcPwm(float pwm) noexcept;					// Record the PWM applied for the next sample interval
+	float PredictMpcTemperature() const noexcept;			// Predict the temperature one dead time from now
+	float CalcMpcPwm(float targetTemperature) const noexcept;	// Calculate the PWM to apply when using model predictive control
+#endif
 
 	PwmPort ports[MaxPortsPerHeater];						// The port(s) that drive the heater
 	float temperature;										// The current temperature
@@ -81,6 +88,20 @@ private:
 	uint32_t timeSetHeating;								// When we turned on the heater
 	uint32_t lastSampleTime;								// Time when the temperature was last sampled by Spin()
 
+#if SUPPORT_MPC_HEATER_CONTROL
+	float mpcPwmHistory[MpcMaxPwmHistorySlots];				// The average PWM in each complete slot of the dead time, without extrusion feedforward
+	float mpcSlotPwmTotal;									// The total PWM applied in the slot we are filling
+	float mpcPredictedTemperature;							// What the model predicts the next temperature reading will be
+	float mpcDisturbance;									// The estimated heating rate not explained by the model
+	volatile float mpcFanPwm;								// The PWM of the fans that cool this heater
+	unsigned int mpcSamplesInDeadTime;						// The number of temperature samples in the dead time
+	unsigned int mpcSamplesPerSlot;							// The number of temperature samples that each slot covers
+	unsigned int mpcSampleCount;							// The number of samples in the slot we are filling
+	uint8_t mpcNumSlots;									// The number of slots in mpcPwmHistory that we use
+	uint8_t mpcHistoryIndex;								// The index of the oldest slot
+	bool mpcPredictionValid;								// True if mpcPredictedTemperature is valid
+#endif
+
 	uint16_t heatingFaultCount;								// Count of questionable heating behaviours
 
 	uint8_t previousTemperaturesGood;						// Bitmap indicating which previous temperature were good readings
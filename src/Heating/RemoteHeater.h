@@ -71,10 +71,10 @@ private:
 	uint32_t whenLastStatusReceived;
 
 	// Variables used only during tuning
-	static uint32_t timeSetHeating;											// When we turned on the heater at the start of auto tuning
-	static float currentCoolingRate;
-	static unsigned int tuningCyclesDone;
-	static bool newTuningResult;
+	uint32_t timeSetHeating;												// When we turned on the heater at the start of auto tuning
+	float currentCoolingRate;
+	unsigned int tuningCyclesDone;
+	bool newTuningResult;
 };
 
 #endif
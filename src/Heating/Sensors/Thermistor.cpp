@@ -33,6 +33,16 @@ using
 static constexpr unsigned int AdcOversampleBits = 2;							// we use 2-bit oversampling
 static constexpr int32_t OversampledAdcRange = 1u << (AdcBits + AdcOversampleBits);	// The readings we pass in should be in range 0..(AdcRange - 1)
 
+// We convert the ADC reading to a reading scaled so that VSSA is 0 and VREF is ScaledReadingRange. This makes it independent of the ADC corrections.
+static constexpr float ScaledReadingRange = 65536.0;
+
+#ifdef DUET_NG
+// The VSSA PTC fuse on the later Duets has a resistance of a few ohms. I measured 1.0 ohms on two revision 1.04 Duet WiFi boards.
+static constexpr float VssaFuseResistance = 1.0;								// assume 1.0 ohms and only one PT1000 sensor
+#else
+static constexpr float VssaFuseResistance = 0.0;
+#endif
+
 // The Steinhart-Hart equation for thermistor resistance is:
 // 1/T = A + B ln(R) + C [ln(R)]^3
 //
@@ -46,10 +56,22 @@ Thermistor::Thermistor(unsigned int sensorNum, bool p_isPT1000) noexcept
 	: SensorWithPort(sensorNum, (p_isPT1000) ? "PT1000" : "Thermistor"),
 	  r25(DefaultThermistorR25), beta(DefaultThermistorBeta), shC(DefaultThermistorC), seriesR(DefaultThermistorSeriesR), adcFilterChannel(-1),
 	  isPT1000(p_isPT1000), adcLowOffset(0), adcHighOffset(0)
+#if SUPPORT_THERMISTOR_TABLES
+	  , lookupTableEntries(DefaultThermistorTableEntries), lookupTable(nullptr), numLookupTableReaders(0)
+#endif
 {
 	CalcDerivedParameters();
 }
 
+#if SUPPORT_THERMISTOR_TABLES
+
+Thermistor::~Thermistor() noexcept
+{
+	delete lookupTable.load();
+}
+
+#endif
+
 // Get the ADC reading
 int32_t Thermistor::GetRawReading(bool& valid) const noexcept
 {
@@ -224,10 +246,27 @@ GCodeResult Thermistor::Configure(GCodeBuffer& gb, const StringRef& reply, bool&
 		}
 		gb.TryGetFValue('C', shC, changed);
 		gb.TryGetFValue('T', r25, changed);
-		if (changed)
+	}
+
+#if SUPPORT_THERMISTOR_TABLES
+	bool seenN = false;
+	uint32_t newTableEntries = lookupTableEntries;
+	gb.TryGetLimitedUIValue('N', newTableEntries, seenN, MaxThermistorTableEntries + 1);
+	if (seenN)
+	{
+		if (newTableEntries != 0 && newTableEntries < MinThermistorTableEntries)
 		{
-			CalcDerivedParameters();
+			reply.printf("Lookup table must have 0 or at least %u entries", MinThermistorTableEntries);
+			return GCodeResult::error;
 		}
+		lookupTableEntries = newTableEntries;
+		changed = true;
+	}
+#endif
+
+	if (changed)
+	{
+		CalcDerivedParameters();			// the port (which may set the series resistor) or the conversion parameters may have changed
 	}
 
 	if (gb.Seen('L'))
@@ -263,6 +302,9 @@ GCodeResult Thermistor::Configure(GCodeBuffer& gb, const StringRef& reply, bool&
 			reply.catf(", T:%.1f B:%.1f C:%.2e R:%.1f", (double)r25, (double)beta, (double)shC, (double)seriesR);
 		}
 		reply.catf(" L:%d H:%d", adcLowOffset, adcHighOffset);
+#if SUPPORT_THERMISTOR_TABLES
+		AppendLookupTableDetails(reply);
+#endif
 
 		if (reprap.Debug(moduleHeat) && adcFilterChannel >= 0)
 		{
@@ -306,10 +348,25 @@ GCodeResult Thermistor::Configure(const CanMessageGenericParser& parser, const S
 		}
 		changed = parser.GetFloatParam('C', shC) || changed;
 		changed = parser.GetFloatParam('T', r25) || changed;
-		if (changed)
+	}
+
+#if SUPPORT_THERMISTOR_TABLES
+	uint16_t newTableEntries;
+	if (parser.GetUintParam('N', newTableEntries))
+	{
+		if (newTableEntries > MaxThermistorTableEntries || (newTableEntries != 0 && newTableEntries < MinThermistorTableEntries))
 		{
-			CalcDerivedParameters();
+			reply.printf("Lookup table must have 0 or %u to %u entries", MinThermistorTableEntries, MaxThermistorTableEntries);
+			return GCodeResult::error;
 		}
+		lookupTableEntries = newTableEntries;
+		changed = true;
+	}
+#endif
+
+	if (changed)
+	{
+		CalcDerivedParameters();			// the port (which may set the series resistor) or the conversion parameters may have changed
 	}
 
 	int16_t lVal;
@@ -345,6 +402,9 @@ GCodeResult Thermistor::Configure(const CanMessageGenericParser& parser, const S
 			reply.catf(", T:%.1f B:%.1f C:%.2e R:%.1f", (double)r25, (double)beta, (double)shC, (double)seriesR);
 		}
 		reply.catf(" L:%d H:%d", adcLowOffset, adcHighOffset);
+#if SUPPORT_THERMISTOR_TABLES
+		AppendLookupTableDetails(reply);
+#endif
 	}
 
 	return GCodeResult::ok;
@@ -400,7 +460,6 @@ void Thermistor::Poll() noexcept
 			const int32_t averagedVrefReading = OversampledAdcRange + (adcHighOffset * (1 << (AdcBits + AdcOversampleBits - 13)));
 			const int32_t averagedVssaReading = adcLowOffset * (1 << (AdcBits + AdcOversampleBits - 13));
 #endif
-			// Calculate the resistance
 			if (averagedVrefReading <= averagedTempReading)
 			{
 				SetResult((isPT1000) ? BadErrorTemperature : ABS_ZERO, TemperatureError::openCircuit);
@@ -411,37 +470,26 @@ void Thermistor::Poll() noexcept
 			}
 			else
 			{
-				float resistance = seriesR * (float)(averagedTempReading - averagedVssaReading)/(float)(averagedVrefReading - averagedTempReading);
-#ifdef DUET_NG
-				// The VSSA PTC fuse on the later Duets has a resistance of a few ohms. I measured 1.0 ohms on two revision 1.04 Duet WiFi boards.
-				resistance -= 1.0;														// assume 1.0 ohms and only one PT1000 sensor
+				const float reading = ScaledReadingRange * (float)(averagedTempReading - averagedVssaReading)/(float)(averagedVrefReading - averagedVssaReading);
+				float temp;
+				TemperatureError sts = TemperatureError::success;
+#if SUPPORT_THERMISTOR_TABLES
+				if (!LookupTemperature(reading, temp))
 #endif
-				if (isPT1000)
 				{
-					// We want 100 * the equivalent PT100 resistance, which is 10 * the actual PT1000 resistance
-					const uint16_t ohmsx100 = (uint16_t)lrintf(constrain<float>(resistance * 10, 0.0, 65535.0));
-					float t;
-					const TemperatureError sts = GetPT100Temperature(t, ohmsx100);
-					SetResult(t, sts);
+					temp = CalcTemperature(reading, sts);
+				}
+
+				// It's hard to distinguish between an open circuit and a cold high-resistance thermistor.
+				// So we treat a temperature below -5C as an open circuit, unless we are using a low-resistance thermistor. The E3D thermistor has a resistance of about 470k @ -5C.
+				if (!isPT1000 && temp < MinimumConnectedTemperature && reading > openCircuitReading)
+				{
+					// Assume thermistor is disconnected
+					SetResult(ABS_ZERO, TemperatureError::openCircuit);
 				}
 				else
 				{
-					// Else it's a thermistor
-					const float logResistance = logf(resistance);
-					const float recipT = shA + shB * logResistance + shC * logResistance * logResistance * logResistance;
-					const float temp =  (recipT > 0.0) ? (1.0/recipT) + ABS_ZERO : BadErrorTemperature;
-
-					// It's hard to distinguish between an open circuit and a cold high-resistance thermistor.
-					// So we treat a temperature below -5C as an open circuit, unless we are using a low-resistance thermistor. The E3D thermistor has a resistance of about 470k @ -5C.
-					if (temp < MinimumConnectedTemperature && resistance > seriesR * 100)
-					{
-						// Assume thermistor is disconnected
-						SetResult(ABS_ZERO, TemperatureError::openCircuit);
-					}
-					else
-					{
-						SetResult(temp, TemperatureError::success);
-					}
+					SetResult(temp, sts);
 				}
 			}
 		}
@@ -453,12 +501,205 @@ void Thermistor::Poll() noexcept
 	}
 }
 
-// Calculate shA and shB from the other parameters
+// Calculate the temperature from a reading scaled so that VSSA is 0 and VREF is ScaledReadingRange
+float Thermistor::CalcTemperature(float reading, TemperatureError& sts) const noexcept
+{
+	const float resistance = seriesR * reading/(ScaledReadingRange - reading) - VssaFuseResistance;
+	float t;
+	if (isPT1000)
+	{
+		// We want 100 * the equivalent PT100 resistance, which is 10 * the actual PT1000 resistance
+		const uint16_t ohmsx100 = (uint16_t)lrintf(constrain<float>(resistance * 10, 0.0, 65535.0));
+		sts = GetPT100Temperature(t, ohmsx100);
+	}
+	else
+	{
+		// Else it's a thermistor
+		const float logResistance = logf(resistance);
+		const float recipT = shA + shB * logResistance + shC * logResistance * logResistance * logResistance;
+		t = (recipT > 0.0) ? (1.0/recipT) + ABS_ZERO : BadErrorTemperature;
+		sts = TemperatureError::success;
+	}
+	return t;
+}
+
+// Calculate shA and shB from the other parameters, then rebuild the lookup table
 void Thermistor::CalcDerivedParameters() noexcept
 {
 	shB = 1.0/beta;
 	const float lnR25 = logf(r25);
 	shA = 1.0/(25.0 - ABS_ZERO) - shB * lnR25 - shC * lnR25 * lnR25 * lnR25;
+
+	// Find the reading at which the resistance is 100 times the series resistance
+	const float ratio = (100.0 * seriesR + VssaFuseResistance)/seriesR;
+	openCircuitReading = ScaledReadingRange * ratio/(1.0 + ratio);
+
+#if SUPPORT_THERMISTOR_TABLES
+	BuildLookupTable();
+#endif
+}
+
+#if SUPPORT_THERMISTOR_TABLES
+
+// Return true if a reading corresponds to a higher temperature than 'temperature'.
+// The temperature of a PT1000 increases with the reading and the temperature of a thermistor decreases.
+static inline bool IsAboveReading(bool isPT1000, float t, TemperatureError sts, float temperature) noexcept
+{
+	return (isPT1000) ? (sts == TemperatureError::openCircuit || (sts == TemperatureError::success && t > temperature))
+						: (sts == TemperatureError::success && t < temperature);
 }
 
+// Find the reading between readingAtMin and readingAtMax that corresponds to the specified temperature, by bisection.
+// The caller has already checked that the temperature is in range.
+float Thermistor::FindReading(float temperature, float readingAtMin, float readingAtMax) const noexcept
+{
+	for (unsigned int i = 0; i < 24; ++i)					// 24 iterations are enough to reduce the interval to less than 0.01 of a reading
+	{
+		const float mid = 0.5 * (readingAtMin + readingAtMax);
+		TemperatureError sts;
+		const float t = CalcTemperature(mid, sts);
+		if (IsAboveReading(isPT1000, t, sts, temperature))
+		{
+			readingAtMax = mid;
+		}
+		else
+		{
+			readingAtMin = mid;
+		}
+	}
+	return 0.5 * (readingAtMin + readingAtMax);
+}
+
+// Build a table of readings for temperatures spaced evenly between ThermistorTableMinTemperature and ThermistorTableMaxTemperature.
+// Each reading is rounded to an integer and the entry holds the temperature calculated at that reading, so the only error in a looked-up temperature is the interpolation error.
+// The heater task may be using the old table, so we build the new one first, then swap the pointers and wait until no lookup is using the old one before deleting it.
+void Thermistor::BuildLookupTable() noexcept
+{
+	LookupTable *newTable = nullptr;
+	if (lookupTableEntries != 0)
+	{
+		newTable = new LookupTable(lookupTableEntries);
+		constexpr float MinReading = 1.0, MaxReading = ScaledReadingRange - 1.0;
+		TemperatureError sts, stsAtMin, stsAtMax;
+		const float tAtMin = CalcTemperature(MinReading, stsAtMin);
+		const float tAtMax = CalcTemperature(MaxReading, stsAtMax);
+
+		const float temperatureInterval = (ThermistorTableMaxTemperature - ThermistorTableMinTemperature)/(float)(lookupTableEntries - 1);
+		for (size_t i = 0; i < lookupTableEntries; ++i)
+		{
+			// Readings must increase, so for a thermistor start at the highest temperature
+			const float temperature = (isPT1000) ? ThermistorTableMinTemperature + i * temperatureInterval
+									: ThermistorTableMaxTemperature - i * temperatureInterval;
+			if (IsAboveReading(isPT1000, tAtMin, stsAtMin, temperature) || !IsAboveReading(isPT1000, tAtMax, stsAtMax, temperature))
+			{
+				continue;											// this temperature is outside the range of readings
+			}
+
+			const uint16_t reading = (uint16_t)lrintf(FindReading(temperature, MinReading, MaxReading));
+			if (newTable->numEntries != 0 && reading <= newTable->readings[newTable->numEntries - 1])
+			{
+				continue;											// the table is too fine for the resolution of the readings
+			}
+			const float t = CalcTemperature((float)reading, sts);
+			if (sts != TemperatureError::success)
+			{
+				continue;
+			}
+			newTable->readings[newTable->numEntries] = reading;
+			newTable->temperatures[newTable->numEntries] = t;
+			++newTable->numEntries;
+		}
+
+		// Measure the interpolation error at the midpoint and quarter points of each interval
+		for (size_t i = 1; i < newTable->numEntries; ++i)
+		{
+			const float lowReading = newTable->readings[i - 1];
+			const float readingInterval = newTable->readings[i] - lowReading;
+			for (unsigned int j = 1; j < 4; ++j)
+			{
+				const float fraction = 0.25 * j;
+				const float t = CalcTemperature(lowReading + fraction * readingInterval, sts);
+				if (sts == TemperatureError::success)
+				{
+					const float interpolatedT = newTable->temperatures[i - 1] + fraction * (newTable->temperatures[i] - newTable->temperatures[i - 1]);
+					newTable->maxError = max<float>(newTable->maxError, fabsf(interpolatedT - t));
+				}
+			}
+		}
+
+		if (newTable->numEntries < 2)
+		{
+			delete newTable;										// the sensor parameters are such that no useful table can be built
+			newTable = nullptr;
+		}
+	}
+
+	LookupTable * const oldTable = lookupTable.exchange(newTable);
+	if (oldTable != nullptr)
+	{
+		// A lookup that started before the exchange may still be using the old table.
+		// A reader increments the count before it fetches the pointer, so any that fetches the old one is counted by now.
+		while (numLookupTableReaders != 0)
+		{
+			delay(1);
+		}
+		delete oldTable;
+	}
+}
+
+// Look up the temperature corresponding to a scaled reading. Return true if successful, false if there is no table or the reading is outside its range.
+// The table is rebuilt only when the sensor is configured, so we don't take a lock here. Instead we register as a reader so that BuildLookupTable doesn't delete the table we are using.
+bool Thermistor::LookupTemperature(float reading, float& t) const noexcept
+{
+	++numLookupTableReaders;
+	const LookupTable *const table = lookupTable;
+	const bool found = table != nullptr && LookupTemperature(*table, reading, t);
+	--numLookupTableReaders;
+	return found;
+}
+
+/*static*/ bool Thermistor::LookupTemperature(const LookupTable& table, float reading, float& t) noexcept
+{
+	if (reading < (float)table.readings[0] || reading > (float)table.readings[table.numEntries - 1])
+	{
+		return false;
+	}
+
+	// Find the first entry whose reading is not less than the one we have
+	size_t low = 1, high = table.numEntries - 1;
+	while (high > low)
+	{
+		const size_t mid = (high - low)/2u + low;
+		if (reading <= (float)table.readings[mid])
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+
+	const float lowReading = table.readings[low - 1];
+	const float fraction = (reading - lowReading)/((float)table.readings[low] - lowReading);
+	t = table.temperatures[low - 1] + fraction * (table.temperatures[low] - table.temperatures[low - 1]);
+	return true;
+}
+
+// Append the lookup table size and accuracy to a reply. Only the task that calls this replaces the table, so we don't need to register as a reader.
+void Thermistor::AppendLookupTableDetails(const StringRef& reply) const noexcept
+{
+	const LookupTable *const table = lookupTable;
+	if (table == nullptr)
+	{
+		reply.catf(" N:%u (no lookup table)", lookupTableEntries);
+	}
+	else
+	{
+		reply.catf(" N:%u (%u entries, max error %.2fC)", lookupTableEntries, (unsigned int)table->numEntries, (double)table->maxError);
+	}
+}
+
+#endif
+
 // End
@@ -10,6 +10,10 @@
 
 #include "SensorWithPort.h"
 
+#if SUPPORT_THERMISTOR_TABLES
+# include <atomic>
+#endif
+
 // The Steinhart-Hart equation for thermistor resistance is:
 // 1/T = A + B ln(R) + C [ln(R)]^3
 //
@@ -22,6 +26,9 @@ class Thermistor : public SensorWithPort
 {
 public:
 	Thermistor(unsigned int sensorNum, bool p_isPT1000) noexcept;					// create an instance with default values
+#if SUPPORT_THERMISTOR_TABLES
+	~Thermistor() noexcept override;
+#endif
 
 	GCodeResult Configure(GCodeBuffer& gb, const StringRef& reply, bool& changed) override THROWS(GCodeException); // configure the sensor from M308 parameters
 
@@ -36,7 +43,29 @@ public:
 	static constexpr const char *TypeNamePT1000 = "pt1000";
 
 private:
-	void CalcDerivedParameters() noexcept;											// calculate shA and shB
+#if SUPPORT_THERMISTOR_TABLES
+	// Table of temperatures at a set of readings. The readings are scaled so that 65536 corresponds to VREF and are in increasing order.
+	struct LookupTable
+	{
+		explicit LookupTable(size_t p_numEntries) noexcept
+			: numEntries(0), maxError(0.0), readings(new uint16_t[p_numEntries]), temperatures(new float[p_numEntries]) { }
+		~LookupTable() noexcept { delete[] readings; delete[] temperatures; }
+
+		size_t numEntries;
+		float maxError;																// the largest error we found when we compared the interpolated temperatures with calculated ones
+		uint16_t *readings;
+		float *temperatures;
+	};
+
+	void BuildLookupTable() noexcept;
+	bool LookupTemperature(float reading, float& t) const noexcept;
+	static bool LookupTemperature(const LookupTable& table, float reading, float& t) noexcept;
+	float FindReading(float temperature, float readingAtMin, float readingAtMax) const noexcept;
+	void AppendLookupTableDetails(const StringRef& reply) const noexcept;
+#endif
+
+	void CalcDerivedParameters() noexcept;											// calculate shA and shB and build the lookup table
+	float CalcTemperature(float reading, TemperatureError& sts) const noexcept;		// calculate the temperature from a reading scaled so that 65536 corresponds to VREF
 	int32_t GetRawReading(bool& valid) const noexcept;								// get the ADC reading
 	bool ConfigureHParam(int hVal, const StringRef& reply) noexcept;				// configure the H parameter returning true if successful, false if error
 	bool ConfigureLParam(int lVal, const StringRef& reply) noexcept;				// configure the L parameter returning true if successful, false if error
@@ -48,8 +77,17 @@ private:
 	bool isPT1000;																	// true if it is a PT1000 sensor, not a thermistor
 	int8_t adcLowOffset, adcHighOffset;
 
+#if SUPPORT_THERMISTOR_TABLES
+	unsigned int lookupTableEntries;												// the requested number of entries in the lookup table, or 0 to calculate every temperature
+#endif
+
 	// The following are derived from the configurable parameters
 	float shA, shB;																	// derived parameters
+	float openCircuitReading;														// readings above this correspond to more than 100 times the series resistance
+#if SUPPORT_THERMISTOR_TABLES
+	std::atomic<LookupTable *> lookupTable;											// this is replaced by the main task while the heater task may be using it
+	mutable std::atomic<unsigned int> numLookupTableReaders;						// how many calls to LookupTemperature may be using the table, so that we don't delete it under them
+#endif
 };
 
 #endif /* SRC_HEATING_THERMISTOR_H_ */
@@ -372,6 +372,90 @@ unsigned int HeightMap::GetMinimumSegments(float deltaAxis0, float deltaAxis1) c
 	return max<unsigned int>(axis0Segments, axis1Segments);
 }
 
+// Return the largest difference between the interpolated height error along a straight line and the straight line (chord) that joins the height errors at its ends.
+// This is the Z error that results if we apply bed compensation to the ends of a move but not to the points along it.
+// Along a straight line the bilinear interpolated height error is a quadratic function of distance within each grid cell, so we split the line where it crosses
+// grid lines and find the maximum deviation within each piece analytically. The grid lines at the edges are included because the height error is clamped outside them.
+float HeightMap::GetChordDeviation(float axis0Start, float axis1Start, float axis0End, float axis1End) const noexcept
+{
+	if (!useMap)
+	{
+		return 0.0;
+	}
+
+	const float starts[2] = { axis0Start, axis1Start };
+	const float deltas[2] = { axis0End - axis0Start, axis1End - axis1Start };
+	int32_t nextLine[2], lineStep[2];
+	for (size_t axis = 0; axis < 2; ++axis)
+	{
+		const float gridCoord = (starts[axis] - def.mins[axis]) * def.recipAxisSpacings[axis];
+		if (deltas[axis] > 0.0)
+		{
+			nextLine[axis] = max<int32_t>((int32_t)floorf(gridCoord) + 1, 0);
+			lineStep[axis] = 1;
+		}
+		else if (deltas[axis] < 0.0)
+		{
+			nextLine[axis] = min<int32_t>((int32_t)ceilf(gridCoord) - 1, (int32_t)def.nums[axis] - 1);
+			lineStep[axis] = -1;
+		}
+		else
+		{
+			nextLine[axis] = 0;
+			lineStep[axis] = 0;
+		}
+	}
+
+	// Return the fraction of the line at which it next crosses a grid line normal to the specified axis, or 1.0 if it doesn't
+	auto nextCrossing = [this, &starts, &deltas, &nextLine, &lineStep](size_t axis) noexcept -> float
+	{
+		if (lineStep[axis] == 0 || nextLine[axis] < 0 || nextLine[axis] >= (int32_t)def.nums[axis])
+		{
+			return 1.0;
+		}
+		return min<float>((def.mins[axis] + nextLine[axis] * def.spacings[axis] - starts[axis])/deltas[axis], 1.0);
+	};
+
+	const float zStart = GetInterpolatedHeightError(axis0Start, axis1Start);
+	const float zChange = GetInterpolatedHeightError(axis0End, axis1End) - zStart;
+	auto deviationAt = [this, &starts, &deltas, zStart, zChange](float t) noexcept -> float
+	{
+		return GetInterpolatedHeightError(starts[0] + t * deltas[0], starts[1] + t * deltas[1]) - (zStart + t * zChange);
+	};
+
+	float maxDeviation = 0.0;
+	float tPrev = 0.0;
+	float devPrev = 0.0;
+	while (tPrev < 1.0)
+	{
+		const float tAxis0 = nextCrossing(0);
+		const float tAxis1 = nextCrossing(1);
+		const float tNext = min<float>(tAxis0, tAxis1);
+		if (tAxis0 == tNext) { nextLine[0] += lineStep[0]; }
+		if (tAxis1 == tNext) { nextLine[1] += lineStep[1]; }
+		if (tNext > tPrev)
+		{
+			// Fit a quadratic u -> devPrev + b*u + a*u^2 to the deviations at the start, middle and end of this piece
+			const float devMid = deviationAt(0.5 * (tPrev + tNext));
+			const float devNext = (tNext >= 1.0) ? 0.0 : deviationAt(tNext);
+			const float a = 2.0 * (devPrev + devNext) - 4.0 * devMid;
+			const float b = 4.0 * devMid - 3.0 * devPrev - devNext;
+			maxDeviation = max<float>(maxDeviation, max<float>(fabsf(devMid), fabsf(devNext)));
+			if (a != 0.0)
+			{
+				const float u = -b/(2.0 * a);
+				if (u > 0.0 && u < 1.0)
+				{
+					maxDeviation = max<float>(maxDeviation, fabsf(devPrev + (b + a * u) * u));
+				}
+			}
+			tPrev = tNext;
+			devPrev = devNext;
+		}
+	}
+	return maxDeviation;
+}
+
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 
 // Save the grid to file returning true if an error occurred
@@ -89,6 +89,8 @@ public:
 #endif
 
 	unsigned int GetMinimumSegments(float deltaAxis0, float deltaAxis1) const noexcept;	// Return the minimum number of segments for a move by this X or Y amount
+	float GetChordDeviation(float axis0Start, float axis1Start, float axis0End, float axis1End) const noexcept;
+																	// Return the largest difference between the height error along a line and the chord joining its ends
 
 	bool UseHeightMap(bool b) noexcept;
 	bool UsingHeightMap() const noexcept { return useMap; }
@@ -10,6 +10,7 @@
 #include <Platform/Platform.h>
 #include "Move.h"
 #include "StepTimer.h"
+#include "LookaheadWindow.h"
 #include <Endstops/EndstopsManager.h>
 #include "Kinematics/LinearDeltaKinematics.h"
 #include <Tools/Tool.h>
@@ -143,7 +144,7 @@ void PrepParams::PrepParamSet::Finalise(float topSpeed) noexcept
 DDA::DDA(DDA* n) noexcept : next(n), prev(nullptr), state(empty)
 {
 	activeDMs = completedDMs = nullptr;
-	shapedSegments = unshapedSegments = nullptr;
+	ClearSegmentLists();
 	tool = nullptr;						// needed in case we pause before any moves have been done
 
 	// Set the endpoints to zero, because Move will ask for them.
@@ -179,11 +180,14 @@ void DDA::ReleaseDMs() noexcept
 	}
 	activeDMs = completedDMs = nullptr;
 
-	for (MoveSegment* seg = shapedSegments; seg != nullptr; )
+	for (MoveSegment* segs : shapedSegments)
 	{
-		MoveSegment* const nextSeg = seg->GetNext();
-		MoveSegment::Release(seg);
-		seg = nextSeg;
+		for (MoveSegment* seg = segs; seg != nullptr; )
+		{
+			MoveSegment* const nextSeg = seg->GetNext();
+			MoveSegment::Release(seg);
+			seg = nextSeg;
+		}
 	}
 	for (MoveSegment* seg = unshapedSegments; seg != nullptr; )
 	{
@@ -191,7 +195,18 @@ void DDA::ReleaseDMs() noexcept
 		MoveSegment::Release(seg);
 		seg = nextSeg;
 	}
-	shapedSegments = unshapedSegments = nullptr;
+	ClearSegmentLists();
+}
+
+// Clear the segment list pointers without releasing the segments
+void DDA::ClearSegmentLists() noexcept
+{
+	for (MoveSegment*& segs : shapedSegments)
+	{
+		segs = nullptr;
+	}
+	unshapedSegments = nullptr;
+	plannedShaper = 0;
 }
 
 // Return the number of clocks this DDA still needs to execute.
@@ -266,11 +281,14 @@ void DDA::DebugPrint(const char *tag) const noexcept
 
 	debugPrintf(" s=%.4e", (double)totalDistance);
 	DebugPrintVector(" vec", directionVector, MaxAxesPlusExtruders);
-	debugPrintf("\n" "a=%.4e d=%.4e reqv=%.4e startv=%.4e topv=%.4e endv=%.4e cks=%" PRIu32 " fp=%" PRIu32 " fl=%04x\n",
+	debugPrintf("\n" "a=%.4e d=%.4e reqv=%.4e startv=%.4e topv=%.4e endv=%.4e cks=%" PRIu32 " fp=%" PRIu32 " fl=%08" PRIx32 "\n",
 				(double)acceleration, (double)deceleration, (double)requestedSpeed, (double)startSpeed, (double)topSpeed, (double)endSpeed, clocksNeeded, (uint32_t)filePos, flags.all);
-	for (const MoveSegment *segs = shapedSegments; segs != nullptr; segs = segs->GetNext())
+	for (size_t i = 0; i < MaxInputShapers; ++i)
 	{
-		segs->DebugPrint('S');
+		for (const MoveSegment *segs = shapedSegments[i]; segs != nullptr; segs = segs->GetNext())
+		{
+			segs->DebugPrint((i == 0) ? 'S' : (char)('0' + i));
+		}
 	}
 	for (const MoveSegment *segs = unshapedSegments; segs != nullptr; segs = segs->GetNext())
 	{
@@ -438,6 +456,20 @@ bool DDA::InitStandardMove(DDARing& ring, const RawMove &nextMove, bool doMotorM
 	initialUserC0 = nextMove.initialUserC0;
 	initialUserC1 = nextMove.initialUserC1;
 
+#if SUPPORT_NATIVE_ARCS
+	if (nextMove.nativeArc.isArc && doMotorMapping)
+	{
+		flags.isArcMove = true;
+		arc.centre[0] = nextMove.nativeArc.centre[0];
+		arc.centre[1] = nextMove.nativeArc.centre[1];
+		arc.radius = nextMove.nativeArc.radius;
+		arc.startAngle = nextMove.nativeArc.startAngle;
+		arc.angle = nextMove.nativeArc.angle;
+		arc.axis[0] = nextMove.nativeArc.axis[0];
+		arc.axis[1] = nextMove.nativeArc.axis[1];
+	}
+#endif
+
 	flags.canPauseAfter = nextMove.canPauseAfter;
 	flags.usingStandardFeedrate = nextMove.usingStandardFeedrate;
 	flags.isPrintingMove = flags.xyMoving && forwardExtruding;				// require forward extrusion so that wipe-while-retracting doesn't count
@@ -470,7 +502,16 @@ bool DDA::InitStandardMove(DDARing& ring, const RawMove &nextMove, bool doMotorM
 		// This means that the user gets the feed rate that he asked for. It also makes the delta calculations simpler.
 		// First do the bed tilt compensation for deltas.
 		directionVector[Z_AXIS] += (directionVector[X_AXIS] * k.GetTiltCorrection(X_AXIS)) + (directionVector[Y_AXIS] * k.GetTiltCorrection(Y_AXIS));
-		totalDistance = NormaliseLinearMotion(reprap.GetPlatform().GetLinearAxes());
+#if SUPPORT_NATIVE_ARCS
+		if (flags.isArcMove)
+		{
+			totalDistance = NormaliseArcMotion(reprap.GetPlatform().GetLinearAxes());
+		}
+		else
+#endif
+		{
+			totalDistance = NormaliseLinearMotion(reprap.GetPlatform().GetLinearAxes());
+		}
 	}
 	else if (rotationalAxesMoving)
 	{
@@ -495,6 +536,12 @@ bool DDA::InitStandardMove(DDARing& ring, const RawMove &nextMove, bool doMotorM
 	float normalisedDirectionVector[MaxAxesPlusExtruders];			// used to hold a unit-length vector in the direction of motion
 	memcpyf(normalisedDirectionVector, directionVector, ARRAY_SIZE(normalisedDirectionVector));
 	Absolute(normalisedDirectionVector, MaxAxesPlusExtruders);
+#if SUPPORT_NATIVE_ARCS
+	if (flags.isArcMove)
+	{
+		SetArcDirections(normalisedDirectionVector);
+	}
+#endif
 	acceleration = beforePrepare.maxAcceleration = VectorBoxIntersection(normalisedDirectionVector, accelerations);
 	if (flags.xyMoving)											// apply M204 acceleration limits to XY moves
 	{
@@ -536,6 +583,14 @@ bool DDA::InitStandardMove(DDARing& ring, const RawMove &nextMove, bool doMotorM
 		k.LimitSpeedAndAcceleration(*this, normalisedDirectionVector, numVisibleAxes, flags.continuousRotationShortcut);	// give the kinematics the chance to further restrict the speed and acceleration
 	}
 
+#if SUPPORT_NATIVE_ARCS
+	if (flags.isArcMove)
+	{
+		// Limit the speed so that the centripetal acceleration doesn't exceed the acceleration that we allow along the path
+		requestedSpeed = min<float>(requestedSpeed, fastSqrtf(acceleration * arc.radius));
+	}
+#endif
+
 	// 7. Calculate the provisional accelerate and decelerate distances and the top speed
 	endSpeed = 0.0;							// until the next move asks us to adjust it
 
@@ -723,7 +778,7 @@ bool DDA::InitFromRemote(const CanMessageMovementLinear& msg) noexcept
 	params.unshaped.acceleration = acceleration;
 	params.unshaped.deceleration = deceleration;
 
-	shapedSegments = unshapedSegments = nullptr;
+	ClearSegmentLists();
 	activeDMs = completedDMs = nullptr;
 
 # if USE_REMOTE_INPUT_SHAPING
@@ -743,11 +798,11 @@ bool DDA::InitFromRemote(const CanMessageMovementLinear& msg) noexcept
 				const int32_t delta = msg.perDrive[drive].iSteps;
 				if (delta != 0)
 				{
-					if (shapedSegments == nullptr)
+					if (shapedSegments[0] == nullptr)
 					{
 						// Calculate the segments needed for axis movement
 						//TODO the message will include input shaping info
-						shapedSegments = AxisShaper::GetUnshapedSegments(*this, params);
+						shapedSegments[0] = AxisShaper::GetUnshapedSegments(*this, params);
 					}
 
 					DriveMovement* const pdm = DriveMovement::Allocate(drive, DMState::idle);
@@ -786,11 +841,11 @@ bool DDA::InitFromRemote(const CanMessageMovementLinear& msg) noexcept
 
 		case CanMessageMovementLinearShaped::shapedDelta:
 			{
-				if (shapedSegments == nullptr)
+				if (shapedSegments[0] == nullptr)
 				{
 					// Calculate the segments needed for axis movement
 					//TODO the message will include input shaping info
-					shapedSegments = AxisShaper::GetUnshapedSegments(*this, params);
+					shapedSegments[0] = AxisShaper::GetUnshapedSegments(*this, params);
 				}
 
 				//TODO
@@ -820,7 +875,7 @@ bool DDA::InitFromRemote(const CanMessageMovementLinear& msg) noexcept
 		const int32_t delta = msg.perDrive[drive].steps;
 		if (delta != 0)
 		{
-			if (shapedSegments == nullptr)
+			if (shapedSegments[0] == nullptr)
 			{
 				EnsureUnshapedSegments(params);
 			}
@@ -909,145 +964,107 @@ bool DDA::IsAccelerationMove() const noexcept
 #define LA_DEBUG	do { } while(false)
 #endif
 
+// Lookahead is only ever done by the Move task, so one window is shared by all the DDA rings
+static LookaheadWindow lookaheadWindow;
+
 // Try to increase the ending speed of this move to allow the next move to start at targetNextSpeed.
 // Only called if this move and the next one are both printing moves.
+// First we walk up the list once, gathering the moves whose speeds may change into the lookahead window along with their junction speed limits.
+// The backward pass then sets the target end speeds in the window and the forward pass calculates the new start and end speeds,
+// after which we copy them back to the moves and recalculate them.
 /*static*/ void DDA::DoLookahead(DDARing& ring, DDA *laDDA) noexcept
 pre(state == provisional)
 {
-//	if (reprap.Debug(moduleDda)) debugPrintf("Adjusting, %f\n", laDDA->targetNextSpeed);
-	unsigned int laDepth = 0;
-	bool goingUp = true;
+	lookaheadWindow.Clear();
 
-	for(;;)					// this loop is used to nest lookahead without making recursive calls
+	// Gather the moves
+	for (;;)
 	{
-		if (goingUp)
+		LookaheadWindow::MoveKind kind;
+		bool goingUp = false;
+		if (laDDA->topSpeed >= laDDA->requestedSpeed)
 		{
-			// We have been asked to adjust the end speed of this move to match the next move starting at targetNextSpeed
-			if (laDDA->beforePrepare.targetNextSpeed > laDDA->requestedSpeed)
-			{
-				laDDA->beforePrepare.targetNextSpeed = laDDA->requestedSpeed;			// don't try for an end speed higher than our requested speed
-			}
-			if (laDDA->topSpeed >= laDDA->requestedSpeed)
-			{
-				// This move already reaches its top speed, so we just need to adjust the deceleration part
-				laDDA->MatchSpeeds();													// adjust it if necessary
-				goingUp = false;
-			}
-			else if (   laDDA->IsDecelerationMove()
-					 && laDDA->prev->beforePrepare.decelDistance > 0.0					// if the previous move has no deceleration phase then no point in adjusting it
-					)
-			{
-				const DDAState st = laDDA->prev->state;
-				// This is a deceleration-only move, and the previous one has a deceleration phase. We may have to adjust the previous move as well to get optimum behaviour.
-				if (   st == provisional
-					&& (   reprap.GetMove().GetJerkPolicy() != 0
-						|| (   laDDA->prev->flags.xyMoving == laDDA->flags.xyMoving
-							&& (   laDDA->prev->flags.isPrintingMove == laDDA->flags.isPrintingMove
-								|| (laDDA->prev->flags.isPrintingMove && laDDA->prev->requestedSpeed == laDDA->requestedSpeed)	// special case to support coast-to-end
-							   )
+			// This move already reaches its top speed, so we just need to adjust the deceleration part
+			kind = LookaheadWindow::MoveKind::reachesTopSpeed;
+		}
+		else if (   laDDA->IsDecelerationMove()
+				 && laDDA->prev->beforePrepare.decelDistance > 0.0						// if the previous move has no deceleration phase then no point in adjusting it
+				)
+		{
+			const DDAState st = laDDA->prev->state;
+			// This is a deceleration-only move, and the previous one has a deceleration phase. We may have to adjust the previous move as well to get optimum behaviour.
+			if (   st == provisional
+				&& lookaheadWindow.GetNumMoves() + 1 < LookaheadWindowSize						// if the window is full then treat the previous move as fixed
+				&& (   reprap.GetMove().GetJerkPolicy() != 0
+					|| (   laDDA->prev->flags.xyMoving == laDDA->flags.xyMoving
+						&& (   laDDA->prev->flags.isPrintingMove == laDDA->flags.isPrintingMove
+							|| (laDDA->prev->flags.isPrintingMove && laDDA->prev->requestedSpeed == laDDA->requestedSpeed)	// special case to support coast-to-end
 						   )
 					   )
 				   )
-				{
-					laDDA->MatchSpeeds();
-					const float maxStartSpeed = fastSqrtf(fsquare(laDDA->beforePrepare.targetNextSpeed) + (2 * laDDA->deceleration * laDDA->totalDistance));
-					laDDA->prev->beforePrepare.targetNextSpeed = min<float>(maxStartSpeed, laDDA->requestedSpeed);
-					// leave 'goingUp' true
-				}
-				else
-				{
-					// This move is a deceleration-only move but we can't adjust the previous one
-					if (st == frozen || st == executing)
-					{
-						laDDA->flags.hadLookaheadUnderrun = true;
-					}
-					const float maxReachableSpeed = fastSqrtf(fsquare(laDDA->startSpeed) + (2 * laDDA->deceleration * laDDA->totalDistance));
-					if (laDDA->beforePrepare.targetNextSpeed > maxReachableSpeed)
-					{
-						laDDA->beforePrepare.targetNextSpeed = maxReachableSpeed;
-					}
-					laDDA->MatchSpeeds();
-					goingUp = false;
-				}
+			   )
+			{
+				kind = LookaheadWindow::MoveKind::chainedDeceleration;
+				goingUp = true;
 			}
 			else
 			{
-				// This move doesn't reach its requested speed, but it isn't a deceleration-only move
-				// Set its end speed to the minimum of the requested speed and the highest we can reach
-				const float maxReachableSpeed = fastSqrtf(fsquare(laDDA->startSpeed) + (2 * laDDA->acceleration * laDDA->totalDistance));
-				if (laDDA->beforePrepare.targetNextSpeed > maxReachableSpeed)
+				// This move is a deceleration-only move but we can't adjust the previous one
+				if (st == frozen || st == executing)
 				{
-					// Looks like this is an acceleration segment, so to ensure smooth acceleration we should reduce targetNextSpeed to endSpeed as well
-					laDDA->beforePrepare.targetNextSpeed = maxReachableSpeed;
+					laDDA->flags.hadLookaheadUnderrun = true;
 				}
-				laDDA->MatchSpeeds();
-				goingUp = false;
+				kind = LookaheadWindow::MoveKind::deceleration;
 			}
 		}
 		else
 		{
-			// Going back down the list
-			// We have adjusted the end speed of the previous move as much as is possible. Adjust this move to match it.
-			laDDA->startSpeed = laDDA->prev->endSpeed;
-			const float maxEndSpeed = fastSqrtf(fsquare(laDDA->startSpeed) + (2 * laDDA->acceleration * laDDA->totalDistance));
-			if (maxEndSpeed < laDDA->beforePrepare.targetNextSpeed)
-			{
-				laDDA->beforePrepare.targetNextSpeed = maxEndSpeed;
-			}
+			// This move doesn't reach its requested speed, but it isn't a deceleration-only move
+			kind = LookaheadWindow::MoveKind::other;
 		}
 
-		if (goingUp)
+		lookaheadWindow.AddMove(laDDA, kind, laDDA->beforePrepare.targetNextSpeed, laDDA->requestedSpeed, laDDA->GetJunctionSpeedLimit(), laDDA->startSpeed, laDDA->endSpeed,
+								2 * laDDA->acceleration * laDDA->totalDistance, 2 * laDDA->deceleration * laDDA->totalDistance);
+		if (!goingUp)
 		{
-			// Still going up
-			laDDA = laDDA->prev;
-			++laDepth;
-#if 0
-			if (reprap.Debug(moduleDda))
-			{
-				debugPrintf("Recursion start %u\n", laDepth);
-			}
-#endif
+			break;
 		}
-		else
-		{
-			// Either just stopped going up, or going down
-			if (laDDA->beforePrepare.targetNextSpeed < laDDA->endSpeed)
-			{
-				// This situation should not normally happen except by a small amount because of rounding error.
-				// Don't reduce the end speed of the current move, because that may make the move infeasible.
-				// Report a lookahead error if the change is too large to be accounted for by rounding error.
-				if (laDDA->beforePrepare.targetNextSpeed < laDDA->endSpeed * 0.99)
-				{
-					ring.RecordLookaheadError();
-					if (reprap.Debug(moduleMove))
-					{
-						debugPrintf("DDA.cpp(%d) tn=%f ", __LINE__, (double)laDDA->beforePrepare.targetNextSpeed);
-						laDDA->DebugPrint("la");
-					}
-				}
-			}
-			else
-			{
-				laDDA->endSpeed = laDDA->beforePrepare.targetNextSpeed;
-			}
-LA_DEBUG;
-			laDDA->RecalculateMove(ring);
+		laDDA = laDDA->prev;
+	}
+
+	// Backward pass
+	if (lookaheadWindow.LimitSpeeds())
+	{
+		ring.RecordLookaheadSpeedReduction();
+	}
 
-			if (laDepth == 0)
+	// Forward pass
+	lookaheadWindow.PropagateSpeeds();
+
+	// Copy the new speeds back to the moves, oldest first
+	size_t n = lookaheadWindow.GetNumMoves();
+	do
+	{
+		--n;
+		laDDA = lookaheadWindow.GetMove(n);
+		laDDA->startSpeed = lookaheadWindow.GetStartSpeed(n);
+		laDDA->beforePrepare.targetNextSpeed = lookaheadWindow.GetTargetNextSpeed(n);
+		if (laDDA->beforePrepare.targetNextSpeed < laDDA->endSpeed * 0.99)
+		{
+			// This situation should not normally happen except by a small amount because of rounding error.
+			// We haven't reduced the end speed of the move, because that may make the move infeasible.
+			// Report a lookahead error because the change is too large to be accounted for by rounding error.
+			ring.RecordLookaheadError();
+			if (reprap.Debug(moduleMove))
 			{
-#if 0
-				if (reprap.Debug(moduleDda))
-				{
-					debugPrintf("Complete, %f\n", laDDA->targetNextSpeed);
-				}
-#endif
-				return;
+				debugPrintf("DDA.cpp(%d) tn=%f ", __LINE__, (double)laDDA->beforePrepare.targetNextSpeed);
+				laDDA->DebugPrint("la");
 			}
-
-			laDDA = laDDA->next;
-			--laDepth;
 		}
-	}
+		laDDA->endSpeed = lookaheadWindow.GetEndSpeed(n);
+LA_DEBUG;
+		laDDA->RecalculateMove(ring);
+	} while (n != 0);
 }
 
 // Try to push babystepping earlier in the move queue, returning the amount we pushed
@@ -1201,24 +1218,25 @@ void DDA::RecalculateMove(DDARing& ring) noexcept
 	clocksNeeded = (uint32_t)totalTime;
 }
 
-// Decide what speed we would really like this move to end at.
-// On entry, targetNextSpeed is the speed we would like the next move after this one to start at and this one to end at
-// On return, targetNextSpeed is the actual speed we can achieve without exceeding the jerk limits.
-void DDA::MatchSpeeds() noexcept
+// Return the highest speed, up to the requested speed, at which this move can end and the next one start without exceeding the jerk limits
+float DDA::GetJunctionSpeedLimit() const noexcept
 {
+	float limit = requestedSpeed;
 	for (size_t drive = 0; drive < MaxAxesPlusExtruders; ++drive)
 	{
-		if (directionVector[drive] != 0.0 || next->directionVector[drive] != 0.0)
+		const float endDirection = GetEndDirection(drive);
+		const float nextStartDirection = next->GetStartDirection(drive);
+		if (endDirection != 0.0 || nextStartDirection != 0.0)
 		{
-			const float totalFraction = fabsf(directionVector[drive] - next->directionVector[drive]);
-			const float jerk = totalFraction * beforePrepare.targetNextSpeed;
+			const float totalFraction = fabsf(endDirection - nextStartDirection);
 			const float allowedJerk = reprap.GetPlatform().GetInstantDv(drive);
-			if (jerk > allowedJerk)
+			if (totalFraction * limit > allowedJerk)
 			{
-				beforePrepare.targetNextSpeed = allowedJerk/totalFraction;
+				limit = allowedJerk/totalFraction;
 			}
 		}
 	}
+	return limit;
 }
 
 // This is called by Move::CurrentMoveCompleted to update the live coordinates from the move that has just finished
@@ -1288,6 +1306,19 @@ void DDA::EnsureUnshapedSegments(const PrepParams& params) noexcept
 	}
 }
 
+// Return the segments that the DM for an axis or leadscrew motor should use.
+// If the shaper for that axis couldn't generate segments that match the plan then it uses those of the planned shaper, so that it stays in step with the other axes.
+// If the move isn't shaped at all then it uses the unshaped segments.
+MoveSegment *DDA::GetAxisSegments(size_t drive) const noexcept
+{
+	MoveSegment *segs = (drive < MaxAxes) ? shapedSegments[reprap.GetMove().GetAxisShaper().GetShaperNumber(drive)] : shapedSegments[0];
+	if (segs == nullptr)
+	{
+		segs = shapedSegments[plannedShaper];
+	}
+	return (segs != nullptr) ? segs : unshapedSegments;
+}
+
 // Prepare this DDA for execution.
 // This must not be called with interrupts disabled, because it calls Platform::EnableDrive.
 void DDA::Prepare(SimulationMode simMode) noexcept
@@ -1303,12 +1334,12 @@ void DDA::Prepare(SimulationMode simMode) noexcept
 #endif
 
 	// Prepare for movement
-	shapedSegments = unshapedSegments = nullptr;
+	ClearSegmentLists();
 
 	PrepParams params;										// the default constructor clears params.plan to 'no shaping'
 	if (flags.xyMoving)
 	{
-		reprap.GetMove().GetAxisShaper().PlanShaping(*this, params, flags.xyMoving);	// this will set up shapedSegments if we are doing any shaping
+		reprap.GetMove().GetAxisShaper().PlanShaping(*this, params, flags.xyMoving);	// this will set up shapedSegments[] if we are doing any shaping
 	}
 	else
 	{
@@ -1416,7 +1447,7 @@ void DDA::Prepare(SimulationMode simMode) noexcept
 			{
 				// On a delta we need to move all towers even if some of them have no net movement
 				platform.EnableDrivers(drive, false);
-				if (shapedSegments == nullptr)
+				if (shapedSegments[0] == nullptr)
 				{
 					EnsureUnshapedSegments(params);
 				}
@@ -1467,7 +1498,7 @@ void DDA::Prepare(SimulationMode simMode) noexcept
 				if (delta != 0)
 				{
 					platform.EnableDrivers(drive, false);
-					if (shapedSegments == nullptr)
+					if (GetAxisSegments(drive) == nullptr)
 					{
 						EnsureUnshapedSegments(params);
 					}
@@ -1494,7 +1525,12 @@ void DDA::Prepare(SimulationMode simMode) noexcept
 						DriveMovement* const pdm = DriveMovement::Allocate(drive, DMState::idle);
 						pdm->direction = (delta >= 0);
 						pdm->totalSteps = labs(delta);
-						if (pdm->PrepareCartesianAxis(*this, params))
+						const bool stepsToDo =
+#if SUPPORT_NATIVE_ARCS
+												(flags.isArcMove && (drive == arc.axis[0] || drive == arc.axis[1])) ? pdm->PrepareArcAxis(*this, params) :
+#endif
+													pdm->PrepareCartesianAxis(*this, params);
+						if (stepsToDo)
 						{
 							pdm->directionChanged = false;
 							// Check for sensible values, print them if they look dubious
@@ -1764,6 +1800,52 @@ float DDA::NormaliseLinearMotion(AxesBitmap linearAxes) noexcept
 	return magnitude;
 }
 
+#if SUPPORT_NATIVE_ARCS
+
+// Make the direction vector of an arc move unit-normal along the path and return the path length.
+// The arc axes move along the arc, the other linear axes move in proportion to the angle, so the path is a helix.
+float DDA::NormaliseArcMotion(AxesBitmap linearAxes) noexcept
+{
+	float magSquared = fsquare(arc.radius * arc.angle);
+	const float * const dv = directionVector;
+	const uint8_t arcAxis0 = arc.axis[0], arcAxis1 = arc.axis[1];
+	linearAxes.Iterate([&magSquared, dv, arcAxis0, arcAxis1](unsigned int axis, unsigned int count)
+						{
+							if (axis != arcAxis0 && axis != arcAxis1)
+							{
+								magSquared += fsquare(dv[axis]);
+							}
+						}
+					  );
+	const float magnitude = fastSqrtf(magSquared);
+	if (magnitude <= 0.0)
+	{
+		return 0.0;
+	}
+
+	// The arc axis components of the direction vector are the chord divided by the path length, so that the start coordinates can still be found from the end coordinates
+	Scale(directionVector, 1.0/magnitude);
+	return magnitude;
+}
+
+// Set up the directions of motion of the arc axes at the start and end of an arc move, and set the arc axis components of the normalised direction vector
+// to the greatest fraction of the speed that they need. The move lies within one quadrant, so the greatest fraction is at the start or at the end.
+void DDA::SetArcDirections(float normalisedDirectionVector[]) noexcept
+{
+	const float arcFraction = (arc.radius * arc.angle)/totalDistance;		// the signed proportion of the path length that is arc movement
+	const float endAngle = arc.startAngle + arc.angle;
+	arc.startDirection[0] = -arcFraction * sinf(arc.startAngle);
+	arc.startDirection[1] = arcFraction * cosf(arc.startAngle);
+	arc.endDirection[0] = -arcFraction * sinf(endAngle);
+	arc.endDirection[1] = arcFraction * cosf(endAngle);
+	for (size_t i = 0; i < 2; ++i)
+	{
+		normalisedDirectionVector[arc.axis[i]] = max<float>(fabsf(arc.startDirection[i]), fabsf(arc.endDirection[i]));
+	}
+}
+
+#endif
+
 // Return the magnitude of a vector over the specified orthogonal axes
 /*static*/ float DDA::Magnitude(const float v[], AxesBitmap axes) noexcept
 {
@@ -2142,43 +2224,104 @@ void DDA::SimulateSteppingDrivers(Platform& p) noexcept
 		}
 		lastStepTime = dueTime;
 		checkTiming = true;
+		RescheduleSimulatedDrives(dm);
+	}
 
-		for (DriveMovement *dm2 = activeDMs; dm2 != dm; dm2 = dm2->nextDM)
+	// If there are no more steps to do and the time for the move has nearly expired, flag the move as complete
+	if (activeDMs == nullptr)
+	{
+		checkTiming = false;		// don't check the timing of the first step in the next move
+		state = completed;
+	}
+}
+
+// Calculate the next step times of the drives from activeDMs up to but not including firstNotDue, then re-insert them so as to keep the list in step-time order.
+// This is the part of DDA::StepDrivers that is common to SimulateSteppingDrivers and BenchmarkSteppingDrivers.
+void DDA::RescheduleSimulatedDrives(DriveMovement *firstNotDue) noexcept
+{
+	for (DriveMovement *dm2 = activeDMs; dm2 != firstNotDue; dm2 = dm2->nextDM)
+	{
+		(void)dm2->CalcNextStepTime(*this);								// calculate next step times
+	}
+
+	DriveMovement *dmToInsert = activeDMs;								// head of the chain we need to re-insert
+	activeDMs = firstNotDue;											// remove the chain from the list
+	while (dmToInsert != firstNotDue)									// note that both of these may be nullptr
+	{
+		DriveMovement * const nextToInsert = dmToInsert->nextDM;
+		if (dmToInsert->state >= DMState::firstMotionState)
 		{
-			(void)dm2->CalcNextStepTime(*this);							// calculate next step times
+			InsertDM(dmToInsert);
+			dmToInsert->directionChanged = false;
+		}
+		else
+		{
+			dmToInsert->nextDM = completedDMs;
+			completedDMs = dmToInsert;
 		}
+		dmToInsert = nextToInsert;
+	}
+}
 
-		// Remove those drives from the list, update the direction pins where necessary, and re-insert them so as to keep the list in step-time order.
-		DriveMovement *dmToInsert = activeDMs;							// head of the chain we need to re-insert
-		activeDMs = dm;													// remove the chain from the list
-		while (dmToInsert != dm)										// note that both of these may be nullptr
+// Generate all the steps for this move without driving any step pins, timing each simulated step interrupt in CPU cycles.
+// This is called from the Move task when we are simulating with step generation. The list handling mirrors DDA::StepDrivers so that the timings are representative.
+void DDA::BenchmarkSteppingDrivers(StepTimingStats& stats) noexcept
+{
+	while (activeDMs != nullptr)
+	{
+#if SUPPORT_STEP_BUFFERING
+		while (TopUpStepBuffer()) { }									// do what the Move task would do, outside the timed section
+#endif
+		IrqDisable();
+		asm volatile("":::"memory");
+		const uint32_t startCycles = StepTimingStats::GetCycleCount();
+
+		DriveMovement* dm = activeDMs;
+		const uint32_t elapsedTime = dm->nextStepTime + StepTimer::MinInterruptInterval;
+		unsigned int stepsGenerated = 0;
+		while (dm != nullptr && elapsedTime >= dm->nextStepTime)		// if the next step is due
 		{
-			DriveMovement * const nextToInsert = dmToInsert->nextDM;
-			if (dmToInsert->state >= DMState::firstMotionState)
-			{
-				InsertDM(dmToInsert);
-				if (dmToInsert->directionChanged)
-				{
-					dmToInsert->directionChanged = false;
-				}
-			}
-			else
-			{
-				dmToInsert->nextDM = completedDMs;
-				completedDMs = dmToInsert;
-			}
-			dmToInsert = nextToInsert;
+			++stepsGenerated;
+			dm = dm->nextDM;
 		}
+
+		RescheduleSimulatedDrives(dm);
+
+		const uint32_t endCycles = StepTimingStats::GetCycleCount();
+		asm volatile("":::"memory");
+		IrqEnable();
+		stats.RecordStepPass(StepTimingStats::CyclesBetween(startCycles, endCycles), stepsGenerated);
 	}
 
-	// If there are no more steps to do and the time for the move has nearly expired, flag the move as complete
-	if (activeDMs == nullptr)
+	state = completed;
+}
+
+#if SUPPORT_STEP_BUFFERING
+
+// Calculate one step in advance for the active drive that has the fewest steps buffered. Return true if we calculated a step.
+// The caller must lock out the step interrupt if this move is being executed.
+bool DDA::TopUpStepBuffer() noexcept
+{
+	StepBuffer *emptiest = nullptr;
+	size_t fewestBuffered = StepBuffer::Size;
+	for (DriveMovement *dm = activeDMs; dm != nullptr; dm = dm->nextDM)
 	{
-		checkTiming = false;		// don't check the timing of the first step in the next move
-		state = completed;
+		StepBuffer * const sb = dm->stepBuffer;
+		if (sb != nullptr && !sb->IsFinished())
+		{
+			const size_t numBuffered = sb->NumBuffered();
+			if (numBuffered < fewestBuffered)
+			{
+				fewestBuffered = numBuffered;
+				emptiest = sb;
+			}
+		}
 	}
+	return emptiest != nullptr && emptiest->CalcStep(*this);
 }
 
+#endif
+
 // Stop a drive and re-calculate the corresponding endpoint.
 // For extruder drivers, we need to be able to calculate how much of the extrusion was completed after calling this.
 void DDA::StopDrive(size_t drive) noexcept
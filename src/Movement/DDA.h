@@ -13,6 +13,7 @@
 #include "StepTimer.h"
 #include "MoveSegment.h"
 #include "InputShaperPlan.h"
+#include "StepTimingStats.h"
 #include <Platform/Tasks.h>
 #include <GCodes/GCodes.h>			// for class RawMove
 
@@ -71,6 +72,7 @@ class DDA
 {
 	friend class DriveMovement;
 	friend class AxisShaper;
+	friend class InputShaper;
 	friend class ExtruderShaper;
 	friend class PrepParams;
 
@@ -101,6 +103,10 @@ public:
 	void Start(Platform& p, uint32_t tim) noexcept SPEED_CRITICAL;					// Start executing the DDA, i.e. move the move.
 	void StepDrivers(Platform& p, uint32_t now) noexcept SPEED_CRITICAL;			// Take one step of the DDA, called by timer interrupt.
 	void SimulateSteppingDrivers(Platform& p) noexcept;								// For debugging use
+	void BenchmarkSteppingDrivers(StepTimingStats& stats) noexcept;					// Generate all the steps for this move and time how long it takes
+#if SUPPORT_STEP_BUFFERING
+	bool TopUpStepBuffer() noexcept;												// Calculate one step in advance for the drive that has fewest steps buffered
+#endif
 	bool ScheduleNextStepInterrupt(StepTimer& timer) const noexcept SPEED_CRITICAL;	// Schedule the next interrupt, returning true if we can't because it is already due
 
 	void SetNext(DDA *n) noexcept { next = n; }
@@ -241,14 +247,17 @@ public:
 private:
 	DriveMovement *FindActiveDM(size_t drive) const noexcept;				// find the DM for a drive if there is one but only if it is active
 	void RecalculateMove(DDARing& ring) noexcept SPEED_CRITICAL;
-	void MatchSpeeds() noexcept SPEED_CRITICAL;
+	float GetJunctionSpeedLimit() const noexcept SPEED_CRITICAL;
 	void StopDrive(size_t drive) noexcept;									// stop movement of a drive and recalculate the endpoint
 	void InsertDM(DriveMovement *dm) noexcept SPEED_CRITICAL;
+	void RescheduleSimulatedDrives(DriveMovement *firstNotDue) noexcept;		// Used when simulating step generation
 	void DeactivateDM(size_t drive) noexcept;
 	void ReleaseDMs() noexcept;
 	bool IsDecelerationMove() const noexcept;								// return true if this move is or have been might have been intended to be a deceleration-only move
 	bool IsAccelerationMove() const noexcept;								// return true if this move is or have been might have been intended to be an acceleration-only move
 	void EnsureUnshapedSegments(const PrepParams& params) noexcept;
+	MoveSegment *GetAxisSegments(size_t drive) const noexcept;
+	void ClearSegmentLists() noexcept;
 	void DebugPrintVector(const char *name, const float *vec, size_t len) const noexcept;
 
 #if SUPPORT_CAN_EXPANSION
@@ -259,6 +268,12 @@ private:
     static float Normalise(float v[], AxesBitmap unitLengthAxes) noexcept;  // Normalise a vector to unit length over the specified axes
     static float Normalise(float v[]) noexcept; 							// Normalise a vector to unit length over all axes
 	float NormaliseLinearMotion(AxesBitmap linearAxes) noexcept;			// Make the direction vector unit-normal in XYZ
+#if SUPPORT_NATIVE_ARCS
+	float NormaliseArcMotion(AxesBitmap linearAxes) noexcept;				// Make the direction vector unit-normal along the path of an arc move
+	void SetArcDirections(float normalisedDirectionVector[]) noexcept;		// Set up the arc start and end directions and the greatest arc axis movement fractions
+#endif
+	float GetStartDirection(size_t drive) const noexcept;					// Get the component of the unit direction vector for this drive at the start of the move
+	float GetEndDirection(size_t drive) const noexcept;						// Get the component of the unit direction vector for this drive at the end of the move
     static void Absolute(float v[], size_t dimensions) noexcept;			// Put a vector in the positive hyperquadrant
 
     static float Magnitude(const float v[]) noexcept;						// Get the magnitude measured over all axes and extruders
@@ -275,7 +290,7 @@ private:
 	{
 		struct
 		{
-			uint16_t endCoordinatesValid : 1,		// True if endCoordinates can be relied
+			uint32_t endCoordinatesValid : 1,		// True if endCoordinates can be relied
 #if SUPPORT_LINEAR_DELTA
 					 isDeltaMovement : 1,			// True if this is a delta printer movement
 #endif
@@ -292,9 +307,12 @@ private:
 					 controlLaser : 1,				// True if this move controls the laser or iobits
 					 hadHiccup : 1,	 	 	 		// True if we had a hiccup while executing a move from a remote master
 					 isRemote : 1,					// True if this move was commanded from a remote
+#if SUPPORT_NATIVE_ARCS
+					 isArcMove : 1,					// True if the arc axes move in a true arc described by the arc parameters
+#endif
 					 wasAccelOnlyMove : 1;			// set by Prepare if this was an acceleration-only move, for the next move to look at
 		};
-		uint16_t all;								// so that we can print all the flags at once for debugging
+		uint32_t all;								// so that we can print all the flags at once for debugging
 	} flags;
 
 #if SUPPORT_LASER || SUPPORT_IOBITS
@@ -321,6 +339,19 @@ private:
 
 	float proportionDone;							// what proportion of the extrusion in the G1 or G0 move of which this is a part has been done after this segment is complete
 	float initialUserC0, initialUserC1;				// if this is a segment of an arc move, the user X and Y coordinates at the start
+
+#if SUPPORT_NATIVE_ARCS
+	struct ArcParameters							// Parameters of a true arc move, only valid if flags.isArcMove is set
+	{
+		float centre[2];							// the machine coordinates of the arc centre along the two arc axes
+		float radius;
+		float startAngle;							// the angle at the start of the move relative to the +axis[0] direction
+		float angle;								// the signed angle moved through, positive is anticlockwise
+		float startDirection[2];					// the arc axis components of the unit direction vector at the start of the move
+		float endDirection[2];						// the arc axis components of the unit direction vector at the end of the move
+		uint8_t axis[2];							// the machine axes that the arc is in
+	} arc;
+#endif
 	uint32_t clocksNeeded;
 
 	union
@@ -360,8 +391,9 @@ private:
 	// These three could possibly be moved into afterPrepare
 	DriveMovement* activeDMs;						// list of associated DMs that need steps, in step time order
 	DriveMovement* completedDMs;					// list of associated DMs that don't need any more steps
-	MoveSegment* shapedSegments;					// linked list of move segments used by axis DMs
+	MoveSegment* shapedSegments[MaxInputShapers];	// linked lists of move segments used by axis DMs, one for each input shaper that we use in this move
 	MoveSegment* unshapedSegments;					// linked list of move segments used by extruder DMs
+	uint8_t plannedShaper;							// the input shaper that planned this move. Axes whose own shaper can't match the plan use its segments.
 };
 
 // Find the DriveMovement record for a given drive even if it is completed, or return nullptr if there isn't one
@@ -397,6 +429,44 @@ inline DriveMovement *DDA::FindActiveDM(size_t drive) const noexcept
 	return nullptr;
 }
 
+// Get the component of the unit direction vector for a drive at the start of the move. For an arc move this is not the same as the direction vector.
+inline float DDA::GetStartDirection(size_t drive) const noexcept
+{
+#if SUPPORT_NATIVE_ARCS
+	if (flags.isArcMove)
+	{
+		if (drive == arc.axis[0])
+		{
+			return arc.startDirection[0];
+		}
+		if (drive == arc.axis[1])
+		{
+			return arc.startDirection[1];
+		}
+	}
+#endif
+	return directionVector[drive];
+}
+
+// Get the component of the unit direction vector for a drive at the end of the move. For an arc move this is not the same as the direction vector.
+inline float DDA::GetEndDirection(size_t drive) const noexcept
+{
+#if SUPPORT_NATIVE_ARCS
+	if (flags.isArcMove)
+	{
+		if (drive == arc.axis[0])
+		{
+			return arc.endDirection[0];
+		}
+		if (drive == arc.axis[1])
+		{
+			return arc.endDirection[1];
+		}
+	}
+#endif
+	return directionVector[drive];
+}
+
 // Force an end point
 inline void DDA::SetDriveCoordinate(int32_t a, size_t drive) noexcept
 {
@@ -8,6 +8,7 @@
 #include "DDARing.h"
 #include <Platform/RepRap.h>
 #include "Move.h"
+#include "MoveArena.h"
 #include <Platform/Tasks.h>
 #include <GCodes/GCodeBuffer/GCodeBuffer.h>
 #include <Tools/Tool.h>
@@ -26,15 +27,39 @@ constexpr uint32_t MoveStartPollInterval = 10;					// delay in milliseconds betw
 #define OBJECT_MODEL_FUNC(...) OBJECT_MODEL_FUNC_BODY(DDARing, __VA_ARGS__)
 #define OBJECT_MODEL_FUNC_IF(...) OBJECT_MODEL_FUNC_IF_BODY(DDARing, __VA_ARGS__)
 
+constexpr ObjectModelArrayDescriptor DDARing::preparedTimeHistogramArrayDescriptor =
+{
+	nullptr,					// no lock needed
+	[] (const ObjectModel *self, const ObjectExplorationContext&) noexcept -> size_t { return MoveQueueStats::NumPreparedTimeBins; },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue
+		{ return ExpressionValue((int32_t)((const DDARing*)self)->queueStats.GetPreparedTimeBinCount(context.GetLastIndex())); }
+};
+
+// The upper limits of the histogram bins in seconds. The last bin has no upper limit.
+constexpr ObjectModelArrayDescriptor DDARing::preparedTimeLimitsArrayDescriptor =
+{
+	nullptr,					// no lock needed
+	[] (const ObjectModel *self, const ObjectExplorationContext&) noexcept -> size_t { return MoveQueueStats::NumPreparedTimeBins - 1; },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(MoveQueueStats::GetPreparedTimeBinLimit(context.GetLastIndex()), 3); }
+};
+
 constexpr ObjectModelTableEntry DDARing::objectModelTable[] =
 {
 	// DDARing each group, these entries must be in alphabetical order
 	// 0. DDARing members
-	{ "gracePeriod",			OBJECT_MODEL_FUNC(self->gracePeriod * MillisToSeconds, 3),			ObjectModelEntryFlags::none },
-	{ "length",					OBJECT_MODEL_FUNC((int32_t)self->numDdasInRing), 					ObjectModelEntryFlags::none },
+	{ "gracePeriod",			OBJECT_MODEL_FUNC(self->gracePeriod * MillisToSeconds, 3),								ObjectModelEntryFlags::none },
+	{ "length",					OBJECT_MODEL_FUNC((int32_t)self->numDdasInRing), 										ObjectModelEntryFlags::none },
+	{ "stats",					OBJECT_MODEL_FUNC(self, 1),																ObjectModelEntryFlags::live },
+
+	// 1. DDARing.stats members
+	{ "hiccups",				OBJECT_MODEL_FUNC((int32_t)self->queueStats.GetNumHiccups()),							ObjectModelEntryFlags::live },
+	{ "lookaheadSpeedReductions", OBJECT_MODEL_FUNC((int32_t)self->queueStats.GetNumLookaheadSpeedReductions()),		ObjectModelEntryFlags::live },
+	{ "minPreparedTime",		OBJECT_MODEL_FUNC(self->queueStats.GetMinPreparedTime(), 3),							ObjectModelEntryFlags::live },
+	{ "preparedTimeHistogram",	OBJECT_MODEL_FUNC_NOSELF(&preparedTimeHistogramArrayDescriptor),						ObjectModelEntryFlags::live },
+	{ "preparedTimeLimits",		OBJECT_MODEL_FUNC_NOSELF(&preparedTimeLimitsArrayDescriptor),							ObjectModelEntryFlags::none },
 };
 
-constexpr uint8_t DDARing::objectModelTableDescriptor[] = { 1, 2 };
+constexpr uint8_t DDARing::objectModelTableDescriptor[] = { 2, 3, 5 };
 
 DEFINE_GET_OBJECT_MODEL_TABLE(DDARing)
 
@@ -43,9 +68,11 @@ DDARing::DDARing() noexcept : gracePeriod(DefaultGracePeriod), scheduledMoves(0)
 }
 
 // This can be called in the constructor for class Move
-void DDARing::Init1(unsigned int numDdas) noexcept
+void DDARing::Init1(unsigned int numDdas, unsigned int maxDdas) noexcept
 {
 	numDdasInRing = numDdas;
+	maxDdasInRing = maxDdas;
+	wantLongerRing = false;
 
 	// Build the DDA ring
 	DDA *dda = new DDA(nullptr);
@@ -119,6 +146,7 @@ GCodeResult DDARing::ConfigureMovementQueue(GCodeBuffer& gb, const StringRef& re
 	gb.TryGetUIValue('P', numDdasWanted, seen);
 	gb.TryGetUIValue('S', numDMsWanted, seen);
 	gb.TryGetUIValue('R', gracePeriod, seen);
+	gb.TryGetUIValue('Q', maxDdasInRing, seen);
 	if (seen)
 	{
 		if (!reprap.GetGCodes().LockMovementAndWaitForStandstill(gb))
@@ -164,7 +192,7 @@ GCodeResult DDARing::ConfigureMovementQueue(GCodeBuffer& gb, const StringRef& re
 	}
 	else
 	{
-		reply.printf("DDAs %u, DMs %u, GracePeriod %" PRIu32, numDdasInRing, DriveMovement::NumCreated(), gracePeriod);
+		reply.printf("DDAs %u (automatic maximum %u), DMs %u, GracePeriod %" PRIu32, numDdasInRing, maxDdasInRing, DriveMovement::NumCreated(), gracePeriod);
 	}
 	return GCodeResult::ok;
 }
@@ -192,6 +220,55 @@ void DDARing::RecycleDDAs() noexcept
 		}
 		checkPointer = checkPointer->GetNext();
 	}
+
+	// If PrepareMoves ran out of moves that it was allowed to prepare, try to make the ring longer
+	if (wantLongerRing)
+	{
+		wantLongerRing = false;
+		if (numDdasInRing < maxDdasInRing && addPointer->GetState() == DDA::empty)
+		{
+			LengthenRing();
+		}
+	}
+}
+
+// Add a DDA from the move arena to the ring, if there is room in the arena. Only the Move task may call this.
+// We insert the new DDA after addPointer, which is empty. So the moves in the ring stay contiguous and the step ISR never sees the change.
+void DDARing::LengthenRing() noexcept
+pre(addPointer->GetState() == DDA::empty)
+{
+	static_assert(sizeof(DDA) <= MoveArena::GetMaxObjectSize(), "DDA is too large to allocate from the move arena");
+	void * const mem = MoveArena::Allocate(sizeof(DDA));
+	if (mem != nullptr)
+	{
+		DDA * const nextDda = addPointer->GetNext();
+		DDA * const newDda = ::new(mem) DDA(nextDda);
+		newDda->SetPrevious(addPointer);
+		nextDda->SetPrevious(newDda);
+		addPointer->SetNext(newDda);
+		++numDdasInRing;
+	}
+}
+
+// Remove from the ring all the DDAs that we allocated from the move arena and give back the memory. Only call this when the ring is idle.
+// We must keep the DDA before addPointer, because the next move we add takes its starting position and speed from it.
+void DDARing::ReleaseArenaDdas() noexcept
+pre(IsIdle())
+{
+	DDA * const lastMove = addPointer->GetPrevious();
+	DDA *dda = addPointer->GetNext();
+	while (dda != lastMove)
+	{
+		DDA * const nextDda = dda->GetNext();
+		if (dda->GetState() == DDA::empty && dda != getPointer && dda != checkPointer && MoveArena::Owns(dda))
+		{
+			dda->GetPrevious()->SetNext(nextDda);
+			nextDda->SetPrevious(dda->GetPrevious());
+			MoveArena::Release(dda);
+			--numDdasInRing;
+		}
+		dda = nextDda;
+	}
 }
 
 bool DDARing::CanAddMove() const noexcept
@@ -265,6 +342,13 @@ bool DDARing::AddAsyncMove(const AsyncMove& nextMove) noexcept
 // Return the maximum time in milliseconds that should elapse before we prepare further unprepared moves that are already in the ring, or TaskBase::TimeoutUnlimited if there are no unprepared moves left.
 uint32_t DDARing::Spin(SimulationMode simulationMode, bool waitingForSpace, bool shouldStartMove) noexcept
 {
+#if SUPPORT_STEP_BUFFERING
+	if (simulationMode == SimulationMode::off)
+	{
+		FillStepBuffers();											// do this first, because when a step buffer runs dry the step ISR has to do the work
+	}
+#endif
+
 	DDA *cdda = currentDda;											// capture volatile variable
 
 	// If we are simulating, simulate completion of the current move.
@@ -272,12 +356,19 @@ uint32_t DDARing::Spin(SimulationMode simulationMode, bool waitingForSpace, bool
 	if (simulationMode != SimulationMode::off && cdda != nullptr)
 	{
 		simulationTime += (float)cdda->GetClocksNeeded() * (1.0/StepClockRate);
-		if (simulationMode == SimulationMode::debug && reprap.Debug(moduleDda))
+		if (simulationMode == SimulationMode::debug)
 		{
-			do
+			if (reprap.Debug(moduleDda))
+			{
+				do
+				{
+					cdda->SimulateSteppingDrivers(reprap.GetPlatform());
+				} while (cdda->GetState() != DDA::completed);
+			}
+			else
 			{
-				cdda->SimulateSteppingDrivers(reprap.GetPlatform());
-			} while (cdda->GetState() != DDA::completed);
+				cdda->BenchmarkSteppingDrivers(timingStats);
+			}
 		}
 		else
 		{
@@ -406,6 +497,9 @@ uint32_t DDARing::Spin(SimulationMode simulationMode, bool waitingForSpace, bool
 // Return the maximum time in milliseconds that should elapse before we prepare further unprepared moves that are already in the ring, or TaskBase::TimeoutUnlimited if there are no unprepared moves left.
 uint32_t DDARing::PrepareMoves(DDA *firstUnpreparedMove, int32_t moveTimeLeft, unsigned int alreadyPrepared, SimulationMode simulationMode) noexcept
 {
+	// If we are already moving then record how much prepared time is left for each move that we prepare, so that we can see how close we come to an underrun.
+	const bool recordPreparedTime = alreadyPrepared != 0 && simulationMode == SimulationMode::off;
+
 	// If the number of prepared moves will execute in less than the minimum time, prepare another move.
 	// Try to avoid preparing deceleration-only moves too early
 	while (	  firstUnpreparedMove->GetState() == DDA::provisional
@@ -417,7 +511,20 @@ uint32_t DDARing::PrepareMoves(DDA *firstUnpreparedMove, int32_t moveTimeLeft, u
 #endif
 		  )
 	{
-		firstUnpreparedMove->Prepare(simulationMode);
+		if (recordPreparedTime)
+		{
+			queueStats.RecordPreparedTime(moveTimeLeft);
+		}
+		if (simulationMode == SimulationMode::debug)
+		{
+			const uint32_t startTime = StepTimer::GetTimerTicks();
+			firstUnpreparedMove->Prepare(simulationMode);
+			timingStats.RecordPrepare(StepTimer::GetTimerTicks() - startTime);
+		}
+		else
+		{
+			firstUnpreparedMove->Prepare(simulationMode);
+		}
 		moveTimeLeft += firstUnpreparedMove->GetTimeLeft();
 		++alreadyPrepared;
 		firstUnpreparedMove = firstUnpreparedMove->GetNext();
@@ -426,6 +533,12 @@ uint32_t DDARing::PrepareMoves(DDA *firstUnpreparedMove, int32_t moveTimeLeft, u
 	// Decide how soon we want to be called again to prepare further moves
 	if (firstUnpreparedMove->GetState() == DDA::provisional)
 	{
+		// If we have prepared half the ring and it still doesn't cover the usual minimum prepared time, the moves are very short and a longer ring would help
+		if (alreadyPrepared * 2 >= numDdasInRing && moveTimeLeft < (int32_t)DDA::UsualMinimumPreparedTime && simulationMode == SimulationMode::off)
+		{
+			wantLongerRing = true;
+		}
+
 		// There are more moves waiting to be prepared, so ask to be woken up early
 		if (simulationMode != SimulationMode::off)
 		{
@@ -440,6 +553,27 @@ uint32_t DDARing::PrepareMoves(DDA *firstUnpreparedMove, int32_t moveTimeLeft, u
 	return TaskBase::TimeoutUnlimited;
 }
 
+#if SUPPORT_STEP_BUFFERING
+
+// Top up the step buffers of the move being executed.
+// We lock out the step interrupt while calculating each step, but we don't keep it locked out for longer than that.
+void DDARing::FillStepBuffers() noexcept
+{
+	for (;;)
+	{
+		const uint32_t baseprio = ChangeBasePriority(NvicPriorityStep);
+		DDA * const cdda = currentDda;								// capture volatile variable
+		const bool calculated = cdda != nullptr && cdda->TopUpStepBuffer();
+		RestoreBasePriority(baseprio);
+		if (!calculated)
+		{
+			break;
+		}
+	}
+}
+
+#endif
+
 // Return true if this DDA ring is idle
 bool DDARing::IsIdle() const noexcept
 {
@@ -494,6 +628,7 @@ void DDARing::Interrupt(Platform& p) noexcept
 			{
 				// Force a break by updating the move start time.
 				++numHiccups;
+				queueStats.RecordHiccup();
 #if SUPPORT_CAN_EXPANSION
 				uint32_t cumulativeHiccupTime = 0;
 #endif
@@ -963,6 +1098,20 @@ void DDARing::Diagnostics(MessageType mtype, const char *prefix) noexcept
 									prefix, scheduledMoves, completedMoves, numHiccups, stepErrors, numLookaheadErrors, numLookaheadUnderruns, numPrepareUnderruns, numNoMoveUnderruns,
 									(cdda == nullptr) ? -1 : (int)cdda->GetState());
 	numHiccups = stepErrors = numLookaheadUnderruns = numPrepareUnderruns = numNoMoveUnderruns = numLookaheadErrors = 0;
+
+	String<StringLength256> scratchString;
+	if (!queueStats.IsEmpty())
+	{
+		queueStats.Report(scratchString.GetRef());
+		reprap.GetPlatform().MessageF(mtype, "%s\n", scratchString.c_str());
+	}
+
+	if (!timingStats.IsEmpty())
+	{
+		scratchString.Clear();
+		timingStats.Report(scratchString.GetRef());
+		reprap.GetPlatform().MessageF(mtype, "%s\n", scratchString.c_str());
+	}
 }
 
 #if SUPPORT_LASER
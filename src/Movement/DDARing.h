@@ -11,17 +11,19 @@
 #define SRC_MOVEMENT_DDARING_H_
 
 #include "DDA.h"
+#include "MoveQueueStats.h"
 
 class DDARing INHERIT_OBJECT_MODEL
 {
 public:
 	DDARing() noexcept;
 
-	void Init1(unsigned int numDdas) noexcept;
+	void Init1(unsigned int numDdas, unsigned int maxDdas) noexcept;
 	void Init2() noexcept;
 	void Exit() noexcept;
 
 	void RecycleDDAs() noexcept;
+	void ReleaseArenaDdas() noexcept;													// Give back the DDAs that were added from the move arena
 	bool CanAddMove() const noexcept;
 	bool AddStandardMove(const RawMove &nextMove, bool doMotorMapping) noexcept SPEED_CRITICAL;	// Set up a new move, returning true if it represents real movement
 	bool AddSpecialMove(float feedRate, const float coords[MaxDriversPerAxis]) noexcept;
@@ -48,7 +50,9 @@ public:
 	void ResetMoveCounters() noexcept { scheduledMoves = completedMoves = 0; }
 
 	float GetSimulationTime() const noexcept { return simulationTime; }
-	void ResetSimulationTime() noexcept { simulationTime = 0.0; }
+	void ResetSimulationTime() noexcept { simulationTime = 0.0; timingStats.Reset(); }
+	bool HaveStepTimingStats() const noexcept { return !timingStats.IsEmpty(); }
+	void ReportStepTimingStats(const StringRef& reply) const noexcept { timingStats.Report(reply); }
 
 #if HAS_SMART_DRIVERS
 	uint32_t GetStepInterval(size_t axis, uint32_t microstepShift) const noexcept;
@@ -80,6 +84,7 @@ public:
 #endif
 
 	void RecordLookaheadError() noexcept { ++numLookaheadErrors; }						// Record a lookahead error
+	void RecordLookaheadSpeedReduction() noexcept { queueStats.RecordLookaheadSpeedReduction(); }	// Record that lookahead couldn't reach a junction speed because earlier moves were fixed
 	void Diagnostics(MessageType mtype, const char *prefix) noexcept;
 
 	bool SetWaitingToEmpty() noexcept;
@@ -96,10 +101,16 @@ public:
 
 protected:
 	DECLARE_OBJECT_MODEL
+	OBJECT_MODEL_ARRAY(preparedTimeHistogram)
+	OBJECT_MODEL_ARRAY(preparedTimeLimits)
 
 private:
 	bool StartNextMove(Platform& p, uint32_t startTime) noexcept SPEED_CRITICAL;		// Start the next move, returning true if laser or IObits need to be controlled
 	uint32_t PrepareMoves(DDA *firstUnpreparedMove, int32_t moveTimeLeft, unsigned int alreadyPrepared, SimulationMode simulationMode) noexcept;
+	void LengthenRing() noexcept;
+#if SUPPORT_STEP_BUFFERING
+	void FillStepBuffers() noexcept;
+#endif
 
 	static void TimerCallback(CallbackParameter p) noexcept;
 
@@ -114,6 +125,7 @@ private:
 	volatile int32_t liveEndPoints[MaxAxesPlusExtruders];						// The XYZ endpoints of the last completed move in motor coordinates
 
 	unsigned int numDdasInRing;
+	uint32_t maxDdasInRing;														// The length that we may extend the ring to automatically using DDAs from the move arena
 	uint32_t gracePeriod;														// The minimum idle time in milliseconds, before we should start a move. Better to have a few moves in the queue so that we can do lookahead
 
 	uint32_t scheduledMoves;													// Move counters for the code queue
@@ -127,6 +139,8 @@ private:
 	unsigned int stepErrors;													// count of step errors, for diagnostics
 
 	float simulationTime;														// Print time since we started simulating
+	StepTimingStats timingStats;												// Step generation and move preparation timings collected when simulating with step generation
+	MoveQueueStats queueStats;													// Prepared time ahead, lookahead and hiccup statistics, cumulative since startup
 	volatile int32_t movementAccumulators[MaxAxesPlusExtruders]; 				// Accumulated motor steps, used by filament monitors
 	volatile uint32_t extrudersPrintingSince;									// The milliseconds clock time when extrudersPrinting was set to true
 
@@ -134,6 +148,7 @@ private:
 	volatile bool liveCoordinatesValid;											// True if the XYZ live coordinates in liveCoordinates are reliable (the extruder ones always are)
 	volatile bool liveCoordinatesChanged;										// True if the live coordinates have changed since LiveCoordinates was last called
 	volatile bool waitingForRingToEmpty;										// True if Move has signalled that we are waiting for this ring to empty
+	bool wantLongerRing;														// True if PrepareMoves was limited by the length of the ring
 };
 
 // Start the next move. Return true if laser or IO bits need to be active
@@ -9,6 +9,7 @@
 #include "DDA.h"
 #include "Move.h"
 #include "StepTimer.h"
+#include "MoveArena.h"
 #include <Platform/RepRap.h>
 #include <Math/Isqrt.h>
 #include "Kinematics/LinearDeltaKinematics.h"
@@ -23,6 +24,48 @@ static_assert(((int64_t)-10000000001 >> 1) == (int64_t)-5000000001);
 
 #endif
 
+#if MS_USE_FPU
+
+// Version of fastSqrtf that allows for slightly negative operands caused by rounding error
+static inline float fastLimSqrtf(float f) noexcept
+{
+	return (f > 0.0) ? fastSqrtf(f) : 0.0;
+}
+
+#else
+
+static inline uint32_t LimISqrt64(int64_t num) noexcept
+{
+	return (num <= 0) ? 0 : isqrt64((uint64_t)num);
+}
+
+#endif
+
+#if SUPPORT_NATIVE_ARCS
+
+// Table of asin(u) for u from 0 to sqrt(0.5), so that the step ISR doesn't have to call asinf for every step of an arc axis.
+// Over this range asin has a bounded second derivative, so linear interpolation between 256 intervals is accurate to about 2e-6 radians.
+constexpr float ArcAsinTableMaxArg = 0.70710678;
+static float arcAsinTable[ArcAsinTableIntervals + 1];
+
+// Return asin(u) for 0 <= u <= sqrt(0.5) by interpolating in the table
+static inline float ArcAsin(float u) noexcept
+{
+	const float f = u * (ArcAsinTableIntervals/ArcAsinTableMaxArg);
+	const size_t i = min<size_t>((size_t)f, ArcAsinTableIntervals - 1);
+	return arcAsinTable[i] + (f - (float)i) * (arcAsinTable[i + 1] - arcAsinTable[i]);
+}
+
+/*static*/ void DriveMovement::InitArcTable() noexcept
+{
+	for (size_t i = 0; i <= ArcAsinTableIntervals; ++i)
+	{
+		arcAsinTable[i] = asinf((float)i * (ArcAsinTableMaxArg/ArcAsinTableIntervals));
+	}
+}
+
+#endif
+
 // Static members
 
 DriveMovement *DriveMovement::freeList = nullptr;
@@ -32,7 +75,7 @@ void DriveMovement::InitialAllocate(unsigned int num) noexcept
 {
 	while (num > numCreated)
 	{
-		freeList = new DriveMovement(freeList);
+		freeList = Create(freeList);
 		++numCreated;
 	}
 }
@@ -48,7 +91,12 @@ DriveMovement *DriveMovement::Allocate(size_t p_drive, DMState st) noexcept
 	}
 	else
 	{
-		dm = new DriveMovement(nullptr);
+		// Use the move arena if we can, so that we can give the memory back when we are idle
+		dm = CreateInArena();
+		if (dm == nullptr)
+		{
+			dm = Create(nullptr);
+		}
 		++numCreated;
 	}
 	dm->drive = (uint8_t)p_drive;
@@ -56,8 +104,79 @@ DriveMovement *DriveMovement::Allocate(size_t p_drive, DMState st) noexcept
 	return dm;
 }
 
+// Create a new DM along with its step buffer if we use one
+/*static*/ DriveMovement *DriveMovement::Create(DriveMovement *next) noexcept
+{
+	DriveMovement * const dm = new DriveMovement(next);
+#if SUPPORT_STEP_BUFFERING
+	dm->stepBuffer = new StepBuffer;
+#endif
+	return dm;
+}
+
+// Create a new DM and its step buffer in the move arena, returning nullptr if there isn't enough memory in the arena
+/*static*/ DriveMovement *DriveMovement::CreateInArena() noexcept
+{
+	void * const mem = MoveArena::Allocate(sizeof(DriveMovement));
+	if (mem == nullptr)
+	{
+		return nullptr;
+	}
+	DriveMovement * const dm = ::new(mem) DriveMovement(nullptr);
+#if SUPPORT_STEP_BUFFERING
+	void * const bufferMem = MoveArena::Allocate(sizeof(StepBuffer));
+	if (bufferMem == nullptr)
+	{
+		MoveArena::Release(dm);
+		return nullptr;
+	}
+	dm->stepBuffer = ::new(bufferMem) StepBuffer;
+#endif
+	return dm;
+}
+
+/*static*/ void DriveMovement::DestroyInArena(DriveMovement *dm) noexcept
+{
+#if SUPPORT_STEP_BUFFERING
+	MoveArena::Release(dm->stepBuffer);
+#endif
+	MoveArena::Release(dm);
+}
+
+// Give back to the move arena all free DMs that were allocated from it. Only call this when no moves are being executed.
+/*static*/ void DriveMovement::ReleaseArenaDMs() noexcept
+{
+	DriveMovement *prev = nullptr;
+	DriveMovement *dm = freeList;
+	while (dm != nullptr)
+	{
+		DriveMovement * const next = dm->nextDM;
+		if (MoveArena::Owns(dm))
+		{
+			if (prev == nullptr)
+			{
+				freeList = next;
+			}
+			else
+			{
+				prev->nextDM = next;
+			}
+			DestroyInArena(dm);
+			--numCreated;
+		}
+		else
+		{
+			prev = dm;
+		}
+		dm = next;
+	}
+}
+
 // Constructors
 DriveMovement::DriveMovement(DriveMovement *next) noexcept : nextDM(next)
+#if SUPPORT_STEP_BUFFERING
+	, stepBuffer(nullptr)
+#endif
 {
 }
 
@@ -77,6 +196,13 @@ void DriveMovement::DebugPrint() const noexcept
 			debugPrintf(" hmz0s=%.4e minusAaPlusBbTimesS=%.4e dSquaredMinusAsquaredMinusBsquared=%.4e drev=%.4e\n",
 							(double)mp.delta.fHmz0s, (double)mp.delta.fMinusAaPlusBbTimesS, (double)mp.delta.fDSquaredMinusAsquaredMinusBsquaredTimesSsquared, (double)mp.delta.reverseStartDistance);
 		}
+#if SUPPORT_NATIVE_ARCS
+		else if (isArc)
+		{
+			debugPrintf(" d0=%.4e dps=%.4e so=%.4e spha=%.4e\n",
+							(double)mp.arc.dStart, (double)mp.arc.dPerStep, (double)mp.arc.sOffset, (double)mp.arc.sPerHalfAngle);
+		}
+#endif
 		else if (isExtruder)
 		{
 			debugPrintf(" pa=%" PRIu32 " eed=%.4e ebf=%.4e\n", (uint32_t)mp.cart.pressureAdvanceK, (double)mp.cart.extraExtrusionDistance, (double)mp.cart.extrusionBroughtForwards);
@@ -86,17 +212,17 @@ void DriveMovement::DebugPrint() const noexcept
 			debugPrintf("\n");
 		}
 #else
-		debugPrintf("DM%c%s dir=%c steps=%" PRIu32 " next=%" PRIu32 " rev=%" PRIu32 " interval=%" PRIu32 " ssl=%" PRIu32 " A=%" PRIi64 " B=%" PRIi32 " C=%" PRIi32 " dsf=%" PRIu32 " tsf=%" PRIu32,
+		debugPrintf("DM%c%s dir=%c steps=%" PRIu32 " next=%" PRIu32 " rev=%" PRIu32 " interval=%" PRIu32 " ssl=%" PRIu32 " A=%" PRIi64 " B=%" PRIi32 " C=%" PRIi64 " dsf=%" PRIi32 " tsf=%" PRIu32,
 						c, (state == DMState::stepError) ? " ERR:" : ":", (direction) ? 'F' : 'B', totalSteps, nextStep, reverseStartStep, stepInterval, segmentStepLimit,
 							iA, iB, iC, iDistanceSoFar, iTimeSoFar);
 		if (isDelta)
 		{
-			debugPrintf(" hmz0sk=%" PRIi32 " minusAaPlusBbTimesS=%" PRIi32 " dSquaredMinusAsquaredMinusBsquared=%" PRIi64 " drev=%" PRIu32 "\n",
+			debugPrintf(" hmz0sk=%" PRIi32 " minusAaPlusBbTimesS=%" PRIi32 " dSquaredMinusAsquaredMinusBsquared=%" PRIi64 " drev=%" PRIi32 "\n",
 							mp.delta.hmz0sK, mp.delta.minusAaPlusBbTimesKs, mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared, mp.delta.iReverseStartDistance);
 		}
 		else if (isExtruder)
 		{
-			debugPrintf(" pa=%" PRIu32 " eed=%" PRIu32 " ebf=%.4e\n", mp.cart.iPressureAdvanceK, mp.cart.iExtraExtrusionDistance, (double)mp.cart.extrusionBroughtForwards);
+			debugPrintf(" pa=%" PRIu32 " eed=%" PRIi32 " ebf=%.4e\n", mp.cart.iPressureAdvanceK, mp.cart.iExtraExtrusionDistance, (double)mp.cart.extrusionBroughtForwards);
 		}
 		else
 		{
@@ -160,7 +286,8 @@ bool DriveMovement::NewCartesianSegment() noexcept
 		iDistanceSoFar += currentSegment->GetSegmentLength();
 		iTimeSoFar += currentSegment->GetSegmentTime();
 
-		segmentStepLimit = (currentSegment->GetNext() == nullptr) ? totalSteps + 1 : (uint32_t)(((iDistanceSoFar * (uint64_t)mp.cart.iEffectiveStepsPerMmTimesK)) >> MoveSegment::SFstepsPerMm) + 1;
+		segmentStepLimit = (currentSegment->GetNext() == nullptr) ? totalSteps + 1
+							: (uint32_t)(((int64_t)iDistanceSoFar * mp.cart.iEffectiveStepsPerMmTimesK) >> (MoveSegment::SFdistance + MoveSegment::SFstepsPerMm)) + 1;
 #endif
 
 		if (nextStep < segmentStepLimit)
@@ -184,8 +311,8 @@ bool DriveMovement::NewDeltaSegment(const DDA& dda) noexcept
 			return false;
 		}
 
-		const float stepsPerMm = reprap.GetPlatform().DriveStepsPerUnit(drive);
 #if MS_USE_FPU
+		const float stepsPerMm = reprap.GetPlatform().DriveStepsPerUnit(drive);
 		pC = currentSegment->GetC()/stepsPerMm;		//TODO store the reciprocal to avoid the division
 		if (currentSegment->IsLinear())
 		{
@@ -254,55 +381,129 @@ bool DriveMovement::NewDeltaSegment(const DDA& dda) noexcept
 			}
 		}
 #else
-		iC = currentSegment->GetC()/stepsPerMm;		//TODO store the reciprocal to avoid the division? Use a scaling factor for C
+		iC = currentSegment->CalcC(mp.delta.iMmPerStepTimesK);
 		if (currentSegment->IsLinear())
 		{
-			// Set up pB, pC such that for forward motion, time = pB + pC * (distanceMoved * steps/mm)
+			// Set up iB, iC such that for forward motion, time = iB + iC * (distanceMoved * steps/mm)/KmmPerStep
 			iB = currentSegment->CalcLinearB(iDistanceSoFar, iTimeSoFar);
 		}
 		else
 		{
-			// Set up pA, pB, pC such that for forward motion, time = pB + sqrt(pA + pC * (distanceMoved * steps/mm))
+			// Set up iA, iB, iC such that for forward motion, time = iB + sqrt(iA + iC * (distanceMoved * steps/mm))
 			iA = currentSegment->CalcNonlinearA(iDistanceSoFar);
 			iB = currentSegment->CalcNonlinearB(iTimeSoFar);
 		}
 
-		const uint32_t startDistance = iDistanceSoFar;
 		iDistanceSoFar += currentSegment->GetSegmentLength();
 		iTimeSoFar += currentSegment->GetSegmentTime();
 
-		// Work out whether we reverse in this segment and the movement limit in steps
-		const float sDx = iDistanceSoFar * dda.directionVector[0];	//TODO avoid float maths
-		const float sDy = iDistanceSoFar * dda.directionVector[1];	//TODO avoid float maths
-		const int32_t netStepsAtEnd = (int32_t)(isqrt64(mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared - fsquare(stepsPerMm) * (sDx * (sDx + mp.delta.fTwoA) + sDy * (sDy + mp.delta.fTwoB)))
-								 	 	 	 	 + (iDistanceSoFar * dda.directionVector[2] - mp.delta.h0MinusZ0) * stepsPerMm);	//TODO avoid float maths
+		// Work out whether we reverse in this segment and the movement limit in steps.
+		// First check whether the first step in this segment is the previously-calculated reverse start step, and if so then do the reversal.
+		if (nextStep == reverseStartStep)
+		{
+			direction = false;					// we must have been going up, so now we are going down
+			directionChanged = true;
+		}
 
-		if (mp.delta.iReverseStartDistance <= (int32_t)startDistance)
+		if (currentSegment->GetNext() == nullptr)
 		{
-			// This segment is purely downwards motion and we want the greater of the two quadratic solutions. There may have been upwards motion earlier in the move.
-			if (direction)
+			// This is the last segment, so the phase step limit is the number of total steps, and we can avoid some calculation
+			segmentStepLimit = totalSteps + 1;
+			state = (reverseStartStep <= totalSteps && nextStep < reverseStartStep) ? DMState::deltaForwardsReversing : DMState::deltaNormal;
+		}
+		else
+		{
+			// Work out how many whole steps we have moved up or down at the end of this segment. All the intermediate values are in steps multiplied by Kdelta.
+			constexpr unsigned int shift = MoveSegment::SFdistance + MoveSegment::SFdeltaDirection;
+			const int32_t sDxK = (int32_t)(((int64_t)iDistanceSoFar * mp.delta.dxsK) >> shift);
+			const int32_t sDyK = (int32_t)(((int64_t)iDistanceSoFar * mp.delta.dysK) >> shift);
+			const int32_t sDzK = (int32_t)(((int64_t)iDistanceSoFar * mp.delta.dzsK) >> shift);
+			const int64_t t2a = mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared
+								- (int64_t)sDxK * (sDxK + mp.delta.twoAsK) - (int64_t)sDyK * (sDyK + mp.delta.twoBsK);
+			int32_t netStepsAtEnd = ((int32_t)LimISqrt64(t2a) + sDzK - mp.delta.h0MinusZ0sK) >> MoveSegment::SFdelta;		// arithmetic shift rounds down, like floorf
+
+			// If there is a reversal then we only ever move up by (reverseStartStep - 1) steps, so netStepsAtEnd should be less than reverseStartStep.
+			// However, because of rounding error, it might possibly be equal.
+			// If there is no reversal then reverseStartStep is set to totalSteps + 1, so netStepsAtEnd must again be less than reverseStartStep.
+			if (netStepsAtEnd >= (int32_t)reverseStartStep)
 			{
-				direction = false;
-				directionChanged = true;
+				netStepsAtEnd = (int32_t)(reverseStartStep - 1);			// correct the rounding error - we know that reverseStartStep cannot be 0 so subtracting 1 is safe
+			}
+
+			if (!direction)
+			{
+				// We are going down so any reversal has already happened
+				state = DMState::deltaNormal;
+				segmentStepLimit = (nextStep >= reverseStartStep)
+									? (uint32_t)((int32_t)(2 * reverseStartStep) - netStepsAtEnd)		// we went up (reverseStartStep-1) steps, now we are going down to netStepsAtEnd
+										: (uint32_t)(-netStepsAtEnd);									// we are just going down to netStepsAtEnd
+			}
+			else if (iDistanceSoFar <= mp.delta.iReverseStartDistance)
+			{
+				// This segment is purely upwards motion of the tower
+				state = DMState::deltaNormal;
+				segmentStepLimit = (uint32_t)(netStepsAtEnd + 1);
+			}
+			else
+			{
+				// This segment ends with reverse motion
+				segmentStepLimit = (uint32_t)((int32_t)(2 * reverseStartStep) - netStepsAtEnd);
+				state = DMState::deltaForwardsReversing;
 			}
-			state = DMState::deltaReverse;
-			segmentStepLimit = (currentSegment->GetNext() == nullptr) ? totalSteps + 1
-								: (reverseStartStep <= totalSteps) ? (uint32_t)((int32_t)(2 * reverseStartStep) - netStepsAtEnd)
-									: 1 - netStepsAtEnd;
 		}
-		else if ((int32_t)iDistanceSoFar <= mp.delta.iReverseStartDistance)
+#endif
+
+		if (segmentStepLimit > nextStep)
+		{
+			return true;
+		}
+
+		currentSegment = currentSegment->GetNext();
+	}
+}
+
+#endif // SUPPORT_LINEAR_DELTA
+
+#if SUPPORT_NATIVE_ARCS
+
+// This is called when currentSegment has just been changed to a new segment. Return true if there is a new segment to execute.
+bool DriveMovement::NewArcSegment(const DDA& dda) noexcept
+{
+	while (true)
+	{
+		if (currentSegment == nullptr)
 		{
-			// This segment is purely upwards motion of the tower and we want the lower quadratic solution
-			state = DMState::deltaForwardsNoReverse;
-			segmentStepLimit = (currentSegment->GetNext() == nullptr) ? totalSteps + 1 : (uint32_t)(netStepsAtEnd + 1);
+			return false;
+		}
+
+		pC = currentSegment->GetC();
+		if (currentSegment->IsLinear())
+		{
+			// Set up pB, pC such that for forward motion, time = pB + pC * distanceMoved
+			pB = currentSegment->CalcLinearB(distanceSoFar, timeSoFar);
 		}
 		else
 		{
-			// This segment ends with reverse motion. We want the lower quadratic solution initially.
-			segmentStepLimit = (currentSegment->GetNext() == nullptr) ? totalSteps + 1 : (uint32_t)((int32_t)(2 * reverseStartStep) - netStepsAtEnd);
-			state = DMState::deltaForwardsReversing;
+			// Set up pA, pB, pC such that for forward motion, time = pB + sqrt(pA + pC * distanceMoved)
+			pA = currentSegment->CalcNonlinearA(distanceSoFar);
+			pB = currentSegment->CalcNonlinearB(timeSoFar);
+		}
+
+		distanceSoFar += currentSegment->GetSegmentLength();
+		timeSoFar += currentSegment->GetSegmentTime();
+
+		if (currentSegment->GetNext() == nullptr)
+		{
+			// This is the last segment, so the phase step limit is the number of total steps, and we can avoid some calculation
+			segmentStepLimit = totalSteps + 1;
+		}
+		else
+		{
+			// Work out how many whole steps we have moved at the end of this segment. The distance from the extreme is 2 * radius * sin^2(half the angle from the extreme).
+			const float halfAngleFromExtreme = 0.5 * (distanceSoFar - mp.arc.sOffset) * (dda.arc.angle/dda.totalDistance);
+			const float dAtEnd = fsquare(sinf(halfAngleFromExtreme))/mp.arc.recipTwoRadius;
+			segmentStepLimit = (uint32_t)max<float>((dAtEnd - mp.arc.dStart)/mp.arc.dPerStep, 0.0) + 1;
 		}
-#endif
 
 		if (segmentStepLimit > nextStep)
 		{
@@ -313,7 +514,7 @@ bool DriveMovement::NewDeltaSegment(const DDA& dda) noexcept
 	}
 }
 
-#endif // SUPPORT_LINEAR_DELTA
+#endif
 
 // This is called when currentSegment has just been changed to a new segment. Return true if there is a new segment to execute.
 bool DriveMovement::NewExtruderSegment() noexcept
@@ -360,10 +561,9 @@ bool DriveMovement::NewExtruderSegment() noexcept
 		// Work out the movement limit in steps
 		segmentStepLimit = ((currentSegment->GetNext() == nullptr) ? totalSteps : (uint32_t)(distanceSoFar * mp.cart.effectiveStepsPerMm)) + 1;
 #else
-		const uint32_t startDistance = iDistanceSoFar;
+		const int32_t startDistance = iDistanceSoFar;
 		const uint32_t startTime = iTimeSoFar;
 
-		// Work out the movement limit in steps
 		iDistanceSoFar += currentSegment->GetSegmentLength();
 		iTimeSoFar += currentSegment->GetSegmentTime();
 
@@ -388,11 +588,13 @@ bool DriveMovement::NewExtruderSegment() noexcept
 			else
 			{
 				// This is the single decelerating segment. If it includes pressure advance then it may include reversal.
-				state = DMState::cartDecelForwardsReversing;			// assume that it may reverse
+				state = (reverseStartStep <= totalSteps) ? DMState::cartDecelForwardsReversing : DMState::cartDecelNoReverse;
 			}
 		}
 
-		segmentStepLimit = ((currentSegment->GetNext() == nullptr) ? totalSteps : (uint32_t)((iDistanceSoFar * (uint64_t)mp.cart.iEffectiveStepsPerMmTimesK)) >> MoveSegment::SFstepsPerMm) + 1;
+		// Work out the movement limit in steps
+		segmentStepLimit = ((currentSegment->GetNext() == nullptr) ? totalSteps
+								: (uint32_t)(((int64_t)iDistanceSoFar * mp.cart.iEffectiveStepsPerMmTimesK) >> (MoveSegment::SFdistance + MoveSegment::SFstepsPerMm))) + 1;
 #endif
 
 		if (nextStep < segmentStepLimit)
@@ -419,13 +621,14 @@ bool DriveMovement::PrepareCartesianAxis(const DDA& dda, const PrepParams& param
 	iTimeSoFar = 0;
 	mp.cart.iPressureAdvanceK = 0;
 	// We can't use directionVector here because those values relate to Cartesian space, whereas we may be CoreXY etc.
-	const float stepsTimesK = (float)((uint64_t)totalSteps << MoveSegment::SFstepsPerMm);
-	mp.cart.iEffectiveStepsPerMmTimesK = stepsTimesK/dda.totalDistance;
-	mp.cart.iEffectiveMmPerStepTimesK = dda.totalDistance/stepsTimesK;
+	const float effStepsPerMm = (float)totalSteps/dda.totalDistance;
+	mp.cart.iEffectiveStepsPerMmTimesK = lrintf(effStepsPerMm * MoveSegment::KstepsPerMm);
+	mp.cart.iEffectiveMmPerStepTimesK = (uint64_t)llrintf((float)MoveSegment::KmmPerStep/effStepsPerMm);
 #endif
 	isDelta = false;
 	isExtruder = false;
-	currentSegment = (dda.shapedSegments != nullptr) ? dda.shapedSegments : dda.unshapedSegments;
+	isArc = false;
+	currentSegment = dda.GetAxisSegments(drive);
 	nextStep = 0;									// must do this before calling NewCartesianSegment
 
 	if (!NewCartesianSegment())
@@ -438,7 +641,7 @@ bool DriveMovement::PrepareCartesianAxis(const DDA& dda, const PrepParams& param
 	stepsTakenThisSegment = 0;						// no steps taken yet since the start of the segment
 	stepsTillRecalc = 0;							// so that we don't skip the calculation
 	reverseStartStep = totalSteps + 1;				// no reverse phase
-	return CalcNextStepTime(dda);
+	return CalcFirstStepTime(dda);
 }
 
 #if SUPPORT_LINEAR_DELTA
@@ -453,20 +656,14 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 	const float dSquaredMinusAsquaredMinusBsquared = params.dparams->GetDiagonalSquared(drive) - fsquare(A) - fsquare(B);
 	const float h0MinusZ0 = fastSqrtf(dSquaredMinusAsquaredMinusBsquared);
 
-#if MS_USE_FPU
-	mp.delta.h0MinusZ0 = h0MinusZ0;
-	mp.delta.fTwoA = 2.0 * A;
-	mp.delta.fTwoB = 2.0 * B;
-	mp.delta.fHmz0s = h0MinusZ0 * stepsPerMm;
-	mp.delta.fMinusAaPlusBbTimesS = -(aAplusbB * stepsPerMm);
-	mp.delta.fDSquaredMinusAsquaredMinusBsquaredTimesSsquared = dSquaredMinusAsquaredMinusBsquared * fsquare(stepsPerMm);
+	float reverseStartDistance;
 
 	// Calculate the distance at which we need to reverse direction.
 	if (params.a2plusb2 <= 0.0)
 	{
 		// Pure Z movement. We can't use the main calculation because it divides by params.a2plusb2.
 		direction = (dda.directionVector[Z_AXIS] >= 0.0);
-		mp.delta.reverseStartDistance = (direction) ? dda.totalDistance + 1.0 : -1.0;	// so that we never reverse and NewDeltaSegment knows which way we are going
+		reverseStartDistance = (direction) ? dda.totalDistance + 1.0 : -1.0;	// so that we never reverse and NewDeltaSegment knows which way we are going
 		reverseStartStep = totalSteps + 1;
 	}
 	else
@@ -475,7 +672,7 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 		// the other root corresponds to the carriages being above the bed.
 		const float drev = ((dda.directionVector[Z_AXIS] * fastSqrtf(params.a2plusb2 * params.dparams->GetDiagonalSquared(drive) - fsquare(A * dda.directionVector[Y_AXIS] - B * dda.directionVector[X_AXIS])))
 							- aAplusbB)/params.a2plusb2;
-		mp.delta.reverseStartDistance = drev;
+		reverseStartDistance = drev;
 		if (drev <= 0.0)
 		{
 			// No reversal, going down
@@ -492,7 +689,7 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 		{
 			// Calculate how many steps we need to move up before reversing
 			const float hrev = dda.directionVector[Z_AXIS] * drev + fastSqrtf(dSquaredMinusAsquaredMinusBsquared - 2 * drev * aAplusbB - params.a2plusb2 * fsquare(drev));
-			const int32_t numStepsUp = (int32_t)((hrev - mp.delta.h0MinusZ0) * stepsPerMm);
+			const int32_t numStepsUp = (int32_t)((hrev - h0MinusZ0) * stepsPerMm);
 
 			// We may be going down but almost at the peak height already, in which case we don't really have a reversal.
 			// However, we could be going up by a whole step due to rounding, so we need to check the direction
@@ -500,11 +697,11 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 			{
 				if (direction)
 				{
-					mp.delta.reverseStartDistance = dda.totalDistance + 1.0;	// indicate that there is no reversal
+					reverseStartDistance = dda.totalDistance + 1.0;				// indicate that there is no reversal
 				}
 				else
 				{
-					mp.delta.reverseStartDistance = -1.0;						// so that we know we have reversed already
+					reverseStartDistance = -1.0;								// so that we know we have reversed already
 					reverseStartStep = totalSteps + 1;
 				}
 			}
@@ -515,7 +712,7 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 				// This can happen if the calculated reversal is very close to the end of the move, because we round the final step positions to the nearest step, which may be up.
 				// Either way, don't do a reverse segment.
 				reverseStartStep = totalSteps + 1;
-				mp.delta.reverseStartDistance = dda.totalDistance + 1.0;
+				reverseStartDistance = dda.totalDistance + 1.0;
 			}
 			else
 			{
@@ -537,77 +734,39 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 		}
 	}
 
+#if MS_USE_FPU
+	mp.delta.h0MinusZ0 = h0MinusZ0;
+	mp.delta.fTwoA = 2.0 * A;
+	mp.delta.fTwoB = 2.0 * B;
+	mp.delta.fHmz0s = h0MinusZ0 * stepsPerMm;
+	mp.delta.fMinusAaPlusBbTimesS = -(aAplusbB * stepsPerMm);
+	mp.delta.fDSquaredMinusAsquaredMinusBsquaredTimesSsquared = dSquaredMinusAsquaredMinusBsquared * fsquare(stepsPerMm);
+	mp.delta.reverseStartDistance = reverseStartDistance;
+
 	distanceSoFar = 0.0;
 	timeSoFar = 0.0;
 #else
-	mp.delta.h0MinusZ0 = h0MinusZ0;		//TODO change to integer
-	mp.delta.fTwoA = 2.0 * A;			//TODO change to integer
-	mp.delta.fTwoB = 2.0 * B;			//TODO change to integer
-	mp.delta.hmz0sK = lrintf(h0MinusZ0 * stepsPerMm * MoveSegment::Kdelta);
-	mp.delta.minusAaPlusBbTimesKs = -lrintf(aAplusbB * stepsPerMm * MoveSegment::Kdelta);
-	mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared = llrintf(dSquaredMinusAsquaredMinusBsquared * fsquare(stepsPerMm * MoveSegment::Kdelta));
-
-	// Calculate the distance at which we need to reverse direction.
-	if (params.a2plusb2 <= 0.0)
-	{
-		// Pure Z movement. We can't use the main calculation because it divides by a2plusb2.
-		direction = (dda.directionVector[Z_AXIS] >= 0.0);
-		const float reverseStartDistance = (direction) ? dda.totalDistance + 1.0 : -1.0;	// so that we never reverse and NewDeltaSegment knows which way we are going
-		mp.delta.iReverseStartDistance = (int32_t)(reverseStartDistance * MoveSegment::Kdistance);
-		reverseStartStep = totalSteps + 1;
-	}
-	else
-	{
-		// The distance to reversal is the solution to a quadratic equation. One root corresponds to the carriages being below the bed,
-		// the other root corresponds to the carriages being above the bed.
-		const float drev = ((dda.directionVector[Z_AXIS] * fastSqrtf(params.a2plusb2 * params.dparams->GetDiagonalSquared(drive) - fsquare(A * dda.directionVector[Y_AXIS] - B * dda.directionVector[X_AXIS])))
-							- aAplusbB)/params.a2plusb2;
-		mp.delta.iReverseStartDistance = (int32_t)(drev * MoveSegment::Kdistance);
-		if (drev > 0.0 && drev < dda.totalDistance)						// if the reversal point is within range
-		{
-			// Calculate how many steps we need to move up before reversing
-			const float hrev = dda.directionVector[Z_AXIS] * drev + fastSqrtf(dSquaredMinusAsquaredMinusBsquared - 2 * drev * aAplusbB - params.a2plusb2 * fsquare(drev));
-			const int32_t numStepsUp = (int32_t)((hrev - mp.delta.h0MinusZ0) * stepsPerMm);
-
-			// We may be almost at the peak height already, in which case we don't really have a reversal.
-			if (numStepsUp < 1)
-			{
-				mp.delta.iReverseStartDistance = -1;					// so that we know we have reversed already
-				reverseStartStep = totalSteps + 1;
-				direction = false;
-			}
-			else
-			{
-				reverseStartStep = (uint32_t)numStepsUp + 1;
-
-				// Correct the initial direction and the total number of steps
-				if (direction)
-				{
-					// Net movement is up, so we will go up first and then down by a lesser amount
-					totalSteps = (2 * numStepsUp) - totalSteps;
-				}
-				else
-				{
-					// Net movement is down, so we will go up first and then down by a greater amount
-					direction = true;
-					totalSteps = (2 * numStepsUp) + totalSteps;
-				}
-			}
-		}
-		else
-		{
-			// No reversal
-			reverseStartStep = totalSteps + 1;
-			direction = (drev >= 0.0);
-		}
-	}
+	// Convert everything we need in the step ISR to fixed point
+	const float stepsPerMmTimesK = stepsPerMm * MoveSegment::Kdelta;
+	mp.delta.hmz0sK = mp.delta.h0MinusZ0sK = lrintf(h0MinusZ0 * stepsPerMmTimesK);
+	mp.delta.minusAaPlusBbTimesKs = -lrintf(aAplusbB * stepsPerMmTimesK);
+	mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared = llrintf(dSquaredMinusAsquaredMinusBsquared * fsquare(stepsPerMmTimesK));
+	mp.delta.twoAsK = lrintf(2.0 * A * stepsPerMmTimesK);
+	mp.delta.twoBsK = lrintf(2.0 * B * stepsPerMmTimesK);
+	const float directionMultiplier = stepsPerMmTimesK * MoveSegment::KdeltaDirection;
+	mp.delta.dxsK = lrintf(dda.directionVector[X_AXIS] * directionMultiplier);
+	mp.delta.dysK = lrintf(dda.directionVector[Y_AXIS] * directionMultiplier);
+	mp.delta.dzsK = lrintf(dda.directionVector[Z_AXIS] * directionMultiplier);
+	mp.delta.iMmPerStepTimesK = (uint64_t)llrintf((float)MoveSegment::KmmPerStep/stepsPerMm);
+	mp.delta.iReverseStartDistance = lrintf(reverseStartDistance * MoveSegment::Kdistance);
 
 	iDistanceSoFar = 0;
 	iTimeSoFar = 0;
 #endif
 
 	isDelta = true;
-	currentSegment = (dda.shapedSegments != nullptr) ? dda.shapedSegments : dda.unshapedSegments;
+	isArc = false;
+	currentSegment = (dda.shapedSegments[0] != nullptr) ? dda.shapedSegments[0] : dda.unshapedSegments;
 
 	nextStep = 0;									// must do this before calling NewDeltaSegment
 	if (!NewDeltaSegment(dda))
@@ -619,11 +778,60 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 	nextStepTime = 0;
 	stepsTakenThisSegment = 0;						// no steps taken yet since the start of the segment
 	stepsTillRecalc = 0;							// so that we don't skip the calculation
-	return CalcNextStepTime(dda);
+	return CalcFirstStepTime(dda);
 }
 
 #endif	// SUPPORT_LINEAR_DELTA
 
+#if SUPPORT_NATIVE_ARCS
+
+// Prepare this DM for an axis that moves in a true arc, returning true if there are steps to do.
+// The move lies within one quadrant of the circle, so the axis moves in one direction only. We track the position of the axis by its distance d
+// from the extreme position that it reaches at one end of that quadrant. If delta is the angle from that extreme then d = radius * (1 - cos(delta)),
+// so delta = 2 * asin(sqrt(d/(2 * radius))), from which we get the distance moved along the path and hence the step time.
+bool DriveMovement::PrepareArcAxis(const DDA& dda, const PrepParams& params) noexcept
+{
+	constexpr float HalfPi = Pi/2;
+	const size_t arcIndex = (drive == dda.arc.axis[0]) ? 0 : 1;				// arc axis 0 moves with the cosine of the angle, arc axis 1 with the sine
+	const float stepsPerMm = reprap.GetPlatform().DriveStepsPerUnit(drive);
+
+	// Find the quadrant that the move lies in, and whether this axis is at its extreme position at the lower or upper angle of that quadrant.
+	// Axis 0 is at an extreme at multiples of Pi, axis 1 at odd multiples of Pi/2.
+	const int32_t quadrant = (int32_t)floorf((dda.arc.startAngle + 0.5 * dda.arc.angle) * (1.0/HalfPi));
+	const bool extremeIsLower = ((quadrant & 1) == 0) == (arcIndex == 0);
+	const float extremeAngle = (float)quadrant * HalfPi + ((extremeIsLower) ? 0.0 : HalfPi);
+	const float radiansPerMm = dda.arc.angle/dda.totalDistance;
+
+	mp.arc.sOffset = (extremeAngle - dda.arc.startAngle)/radiansPerMm;
+	mp.arc.sPerHalfAngle = ((extremeIsLower) ? 2.0 : -2.0)/radiansPerMm;
+	mp.arc.recipTwoRadius = 0.5/dda.arc.radius;
+	mp.arc.dStart = dda.arc.radius - fabsf((float)dda.prev->endPoint[drive]/stepsPerMm - dda.arc.centre[arcIndex]);
+	mp.arc.dPerStep = (mp.arc.sPerHalfAngle > 0.0) ? 1.0/stepsPerMm : -1.0/stepsPerMm;	// the angle from the extreme increases along the path if sPerHalfAngle is positive
+
+	distanceSoFar = 0.0;
+	timeSoFar = 0.0;
+	isDelta = false;
+	isExtruder = false;
+	isArc = true;
+	state = DMState::arcAxis;
+	currentSegment = dda.GetAxisSegments(drive);
+	nextStep = 0;									// must do this before calling NewArcSegment
+
+	if (!NewArcSegment(dda))
+	{
+		return false;
+	}
+
+	// Prepare for the first step
+	nextStepTime = 0;
+	stepsTakenThisSegment = 0;						// no steps taken yet since the start of the segment
+	stepsTillRecalc = 0;							// so that we don't skip the calculation
+	reverseStartStep = totalSteps + 1;				// no reverse phase
+	return CalcFirstStepTime(dda);
+}
+
+#endif
+
 // Prepare this DM for an extruder move, returning true if there are steps to do
 // If there are no steps to do, set nextStep = 0 so that DDARing::CurrentMoveCompleted doesn't add any steps to the movement accumulator
 // We have already generated the extruder segments and we know that there are some
@@ -635,21 +843,15 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 
 	ExtruderShaper& shaper = reprap.GetMove().GetExtruderShaper(LogicalDriveToExtruder(drive));
 	float forwardDistance =	mp.cart.extrusionBroughtForwards = shaper.GetExtrusionPending()/dda.directionVector[drive];
-	float reverseDistance;
-
-#if MS_USE_FPU
-	mp.cart.effectiveStepsPerMm = effStepsPerMm;
-	mp.cart.effectiveMmPerStep = effMmPerStep;
-	distanceSoFar = forwardDistance;
-	timeSoFar = 0.0;
+	float reverseDistance, pressureAdvanceK, extraExtrusionDistance;
 
 	// Calculate the total forward and reverse movement distances
 	if (dda.flags.usePressureAdvance && shaper.GetKclocks() > 0.0)
 	{
 		// We are using nonzero pressure advance. Movement must be forwards.
-		mp.cart.pressureAdvanceK = shaper.GetKclocks();
-		mp.cart.extraExtrusionDistance = mp.cart.pressureAdvanceK * (dda.topSpeed - dda.startSpeed);
-		forwardDistance += mp.cart.extraExtrusionDistance;
+		pressureAdvanceK = shaper.GetKclocks();
+		extraExtrusionDistance = pressureAdvanceK * (dda.topSpeed - dda.startSpeed);
+		forwardDistance += extraExtrusionDistance;
 
 # if 0 //SHAPE_EXTRUSION
 		forwardDistance += params.shaped.decelStartDistance;
@@ -666,7 +868,7 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 		float lastDistance = forwardDistance;
 		while (decelSeg != nullptr)
 		{
-			const float initialDecelSpeed = lastUncorrectedSpeed - mp.cart.pressureAdvanceK * decelSeg->deceleration;
+			const float initialDecelSpeed = lastUncorrectedSpeed - pressureAdvanceK * decelSeg->deceleration;
 			if (initialDecelSpeed <= 0.0)
 			{
 				// This entire deceleration segment is in reverse
@@ -685,7 +887,7 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 				else
 				{
 					// No reversal
-					forwardDistance += dda.totalDistance - (mp.cart.pressureAdvanceK * params.unshaped.deceleration * params.unshaped.decelClocks);
+					forwardDistance += dda.totalDistance - (pressureAdvanceK * params.unshaped.deceleration * params.unshaped.decelClocks);
 					reverseDistance = 0.0;
 				}
 			}
@@ -707,7 +909,7 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 		}
 		else
 		{
-			const float initialDecelSpeed = dda.topSpeed - mp.cart.pressureAdvanceK * params.unshaped.deceleration;
+			const float initialDecelSpeed = dda.topSpeed - pressureAdvanceK * params.unshaped.deceleration;
 			if (initialDecelSpeed <= 0.0)
 			{
 				// The entire deceleration segment is in reverse
@@ -727,7 +929,7 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 				else
 				{
 					// No reversal
-					forwardDistance += dda.totalDistance - (mp.cart.pressureAdvanceK * params.unshaped.deceleration * params.unshaped.decelClocks);
+					forwardDistance += dda.totalDistance - (pressureAdvanceK * params.unshaped.deceleration * params.unshaped.decelClocks);
 					reverseDistance = 0.0;
 				}
 			}
@@ -737,74 +939,26 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 	else
 	{
 		// No pressure advance. Movement may be backwards but this still counts as forward distance in the calculations.
-		mp.cart.pressureAdvanceK = mp.cart.extraExtrusionDistance = 0.0;
+		pressureAdvanceK = extraExtrusionDistance = 0.0;
 		forwardDistance += dda.totalDistance;
 		reverseDistance = 0.0;
 	}
+
+#if MS_USE_FPU
+	mp.cart.effectiveStepsPerMm = effStepsPerMm;
+	mp.cart.effectiveMmPerStep = effMmPerStep;
+	mp.cart.pressureAdvanceK = pressureAdvanceK;
+	mp.cart.extraExtrusionDistance = extraExtrusionDistance;
+	distanceSoFar = mp.cart.extrusionBroughtForwards;
+	timeSoFar = 0.0;
 #else
-	mp.cart.iEffectiveStepsPerMmTimesK = lrintf(effStepsPerMm * (float)(1u << MoveSegment::SFstepsPerMm));
-	mp.cart.iEffectiveMmPerStepTimesK = lrintf(effMmPerStep * (float)(1u << MoveSegment::SFstepsPerMm));
+	// Convert everything we need in the step ISR to fixed point
+	mp.cart.iEffectiveStepsPerMmTimesK = lrintf(effStepsPerMm * MoveSegment::KstepsPerMm);
+	mp.cart.iEffectiveMmPerStepTimesK = (uint64_t)llrintf(effMmPerStep * (float)MoveSegment::KmmPerStep);
+	mp.cart.iPressureAdvanceK = lrintf(pressureAdvanceK);				// zero if this move doesn't use pressure advance
+	mp.cart.iExtraExtrusionDistance = lrintf(extraExtrusionDistance * MoveSegment::Kdistance);
+	iDistanceSoFar = lrintf(mp.cart.extrusionBroughtForwards * MoveSegment::Kdistance);
 	iTimeSoFar = 0;
-
-	// Calculate the total forward and reverse movement distances
-	//TODO distances as integer?
-
-	if (dda.flags.usePressureAdvance && shaper.GetKclocks() > 0.0)
-	{
-		// We are using nonzero pressure advance. Movement must be forwards.
-		mp.cart.iPressureAdvanceK = shaper.GetKclocks();
-		const float extraExtrusionDistance = (float)mp.cart.iPressureAdvanceK * (dda.topSpeed - dda.startSpeed);
-		mp.cart.iExtraExtrusionDistance = lrintf(extraExtrusionDistance * (float)(1u << MoveSegment::SFdistance));
-		forwardDistance += extraExtrusionDistance;
-
-		// Check if there is a reversal in the deceleration segment
-		// There is at most one deceleration segment in the unshaped segments
-		const MoveSegment *decelSeg = dda.unshapedSegments;
-		while (decelSeg != nullptr && (decelSeg->IsLinear() || decelSeg->IsAccelerating()))
-		{
-			decelSeg = decelSeg->GetNext();
-		}
-
-		if (decelSeg == nullptr)
-		{
-			forwardDistance += dda.totalDistance;			// no deceleration segment
-			reverseDistance = 0.0;
-		}
-		else
-		{
-			const float initialDecelSpeed = dda.topSpeed - (float)mp.cart.iPressureAdvanceK * params.unshaped.deceleration;
-			if (initialDecelSpeed <= 0.0)
-			{
-				// The entire deceleration segment is in reverse
-				forwardDistance += params.unshaped.decelStartDistance;
-				reverseDistance = ((0.5 * params.unshaped.deceleration * params.unshaped.decelClocks) - initialDecelSpeed) * params.unshaped.decelClocks;
-			}
-			else
-			{
-				const float timeToReverse = initialDecelSpeed * ((-0.5) * decelSeg->GetC());	// 'c' is -2/deceleration, so -0.5*c is 1/deceleration
-				if (timeToReverse < params.unshaped.decelClocks)
-				{
-					// There is a reversal, although it could be tiny
-					const float distanceToReverse = fsquare(initialDecelSpeed) * decelSeg->GetC() * (-0.25);	// because (v^2-u^2) = 2as, so if v=0 then s=-u^2/2a = u^2/2d = -0.25*u^2*c
-					forwardDistance += params.unshaped.decelStartDistance + distanceToReverse;
-					reverseDistance = 0.5 * params.unshaped.deceleration * fsquare(params.unshaped.decelClocks - timeToReverse);	// because s = 0.5*a*t^2
-				}
-				else
-				{
-					// No reversal
-					forwardDistance += dda.totalDistance - ((float)mp.cart.iPressureAdvanceK * params.unshaped.deceleration * params.unshaped.decelClocks);
-					reverseDistance = 0.0;
-				}
-			}
-		}
-	}
-	else
-	{
-		// No pressure advance. Movement may be backwards but this still counts as forward distance in the calculations.
-		mp.cart.iPressureAdvanceK = mp.cart.iExtraExtrusionDistance = 0;
-		forwardDistance += dda.totalDistance;
-		reverseDistance = 0.0;
-	}
 #endif
 
 	// Check whether there are any steps at all
@@ -865,6 +1019,7 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 	currentSegment = dda.unshapedSegments;
 	isDelta = false;
 	isExtruder = true;
+	isArc = false;
 
 	nextStep = 0;									// must do this before calling NewExtruderSegment
 	if (!NewExtruderSegment())
@@ -876,22 +1031,82 @@ bool DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params) no
 	nextStepTime = 0;
 	stepsTakenThisSegment = 0;						// no steps taken yet since the start of the segment
 	stepsTillRecalc = 0;							// so that we don't skip the calculation
-	return CalcNextStepTime(dda);
+	return CalcFirstStepTime(dda);
 }
 
-#if MS_USE_FPU
+#if SUPPORT_STEP_BUFFERING
 
-// Version of fastSqrtf that allows for slightly negative operands caused by rounding error
-static inline float fastLimSqrtf(float f) noexcept
+// Fetch the time of the next step from the step buffer, calculating it here if the Move task hasn't kept up.
+// We have already incremented nextStep and checked that it does not exceed totalSteps, so at least one more step is due.
+bool DriveMovement::TakeBufferedStep(const DDA &dda) noexcept
 {
-	return (f > 0.0) ? fastSqrtf(f) : 0.0;
+	StepBuffer& sb = *stepBuffer;
+	if (sb.NumBuffered() == 0 && !sb.CalcStep(dda))
+	{
+		// The calculation ran out of steps early or failed
+		state = DMState::stepError;
+		nextStep += 150000000;									// so we can tell what happened in the debug print
+		return false;
+	}
+
+	const uint32_t entry = sb.Take();
+	const uint32_t stepTime = entry & ~StepBuffer::DirectionChangedBit;
+	stepInterval = (stepTime > nextStepTime) ? stepTime - nextStepTime : 0;
+	nextStepTime = stepTime;
+	if ((entry & StepBuffer::DirectionChangedBit) != 0)
+	{
+		direction = !direction;
+		directionChanged = true;
+	}
+
+	// Wake up the Move task to top up the buffer when it is half empty, unless we are simulating
+	if (sb.NumBuffered() == StepBuffer::Size/2 && !sb.IsFinished() && inInterrupt())
+	{
+		Move::WakeMoveTaskFromISR();
+	}
+	return true;
 }
 
-#else
+// Set up the step buffer from a DM whose first step has just been calculated
+void StepBuffer::Init(const DriveMovement& dm) noexcept
+{
+	calc = dm;
+	calc.nextDM = nullptr;
+	calc.stepBuffer = nullptr;									// the copy must calculate its own steps
+	calc.directionChanged = false;								// the caller sets the initial direction
+	putIndex = getIndex = 0;
+	finished = false;
+}
 
-static inline uint32_t LimISqrt64(int64_t num) noexcept
+// Calculate the next step and append it to the buffer, returning false if there are no more steps or the calculation failed.
+// The caller must make sure that the buffer isn't full.
+bool StepBuffer::CalcStep(const DDA& dda) noexcept
 {
-	return (num <= 0) ? 0 : isqrt64((uint64_t)num);
+	if (finished)
+	{
+		return false;
+	}
+
+	if (!calc.CalcNextStepTime(dda))
+	{
+		finished = true;
+		return false;
+	}
+
+	uint32_t entry = calc.nextStepTime;
+	if (calc.directionChanged)
+	{
+		calc.directionChanged = false;
+		entry |= DirectionChangedBit;
+	}
+	stepTimes[(putIndex++) & (Size - 1)] = entry;
+	return true;
+}
+
+// Fill the buffer. Only call this when the step ISR can't be using the DM, e.g. when preparing the move.
+void StepBuffer::Fill(const DDA& dda) noexcept
+{
+	while (!IsFull() && CalcStep(dda)) { }
 }
 
 #endif
@@ -913,6 +1128,9 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 			const bool more =
 #if SUPPORT_LINEAR_DELTA
 								(isDelta) ? NewDeltaSegment(dda) :
+#endif
+#if SUPPORT_NATIVE_ARCS
+								(isArc) ? NewArcSegment(dda) :
 #endif
 									(isExtruder) ? NewExtruderSegment()
 										: NewCartesianSegment();
@@ -975,7 +1193,7 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 #if MS_USE_FPU
 		nextCalcStepTime = pB + (float)(nextStep + stepsTillRecalc) * pC;
 #else
-		iNextCalcStepTime = iB + (nextStep + stepsTillRecalc) * iC;	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = iB + (int32_t)((iC * (int64_t)(nextStep + stepsTillRecalc)) >> MoveSegment::SFmmPerStep);
 #endif
 		break;
 
@@ -983,7 +1201,7 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 #if MS_USE_FPU
 		nextCalcStepTime = pB + fastLimSqrtf(pA + pC * (float)(nextStep + stepsTillRecalc));
 #else
-		iNextCalcStepTime = iB + LimISqrt64(iA + iC * (nextStep + stepsTillRecalc));	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = iB + LimISqrt64(iA + iC * (int64_t)(nextStep + stepsTillRecalc));
 #endif
 		break;
 
@@ -993,7 +1211,7 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 #if MS_USE_FPU
 			nextCalcStepTime = pB - fastLimSqrtf(pA + pC * (float)(nextStep + stepsTillRecalc));
 #else
-			iNextCalcStepTime = iB - LimISqrt64(iA + iC * (nextStep + stepsTillRecalc));	//TODO ??scaling factor for iC ?
+			iNextCalcStepTime = iB - LimISqrt64(iA + iC * (int64_t)(nextStep + stepsTillRecalc));
 #endif
 			break;
 		}
@@ -1006,7 +1224,7 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 #if MS_USE_FPU
 		nextCalcStepTime = pB + fastLimSqrtf(pA + pC * (float)((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)(nextStep + stepsTillRecalc)));
 #else
-		iNextCalcStepTime = iB + LimISqrt64(iA + iC * ((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)(nextStep + stepsTillRecalc)));	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = iB + LimISqrt64(iA + iC * (int64_t)((2 * (int32_t)(reverseStartStep - 1)) - (int32_t)(nextStep + stepsTillRecalc)));
 #endif
 		break;
 
@@ -1014,7 +1232,7 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 #if MS_USE_FPU
 		nextCalcStepTime = pB - fastLimSqrtf(pA + pC * (float)(nextStep + stepsTillRecalc));
 #else
-		iNextCalcStepTime = iB - LimISqrt64(iA + iC * (nextStep + stepsTillRecalc));	//TODO ??scaling factor for iC ?
+		iNextCalcStepTime = iB - LimISqrt64(iA + iC * (int64_t)(nextStep + stepsTillRecalc));
 #endif
 		break;
 
@@ -1068,11 +1286,11 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 			}
 			mp.delta.hmz0sK += shiftedK2;							// get K2 * (new carriage height above Z in steps)
 
-			const int32_t hmz0scK = (int32_t)(((int64_t)mp.delta.hmz0sK * dda.afterPrepare.cKc) >> MoveSegment::SFdelta);
+			const int32_t hmz0scK = (int32_t)(((int64_t)mp.delta.hmz0sK * dda.afterPrepare.cKc) >> MoveSegment::SFdirectionVector);
 			const int32_t t1 = mp.delta.minusAaPlusBbTimesKs + hmz0scK;
-			const int32_t t2a = (int32_t)(mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared - (int64_t)isquare64(mp.delta.hmz0sK) + (int64_t)isquare64(t1));
+			const int64_t t2a = mp.delta.dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared - (int64_t)isquare64(mp.delta.hmz0sK) + (int64_t)isquare64(t1);
 			// Due to rounding error we can end up trying to take the square root of a negative number if we do not take precautions here
-			const uint32_t t2 = LimISqrt64(t2a);
+			const int32_t t2 = (int32_t)LimISqrt64(t2a);
 			const int32_t dsK = (direction) ? t1 - t2 : t1 + t2;
 
 			// Now feed dsK into the step algorithm for Cartesian motion
@@ -1083,15 +1301,37 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 				return false;
 			}
 
-			const int32_t iCds = ((int64_t)iC * dsK) >> (MoveSegment::SFdelta + MoveSegment::SFdistance);
-			iNextCalcStepTime = (currentSegment->IsLinear()) ? iB + iCds
-								: (currentSegment->IsAccelerating()) ? iB + LimISqrt64(iA + iCds)
-									 : iB - LimISqrt64(iA + iCds);
+			if (currentSegment->IsLinear())
+			{
+				iNextCalcStepTime = iB + (int32_t)MoveSegment::MulShift(iC, dsK, MoveSegment::SFmmPerStep + MoveSegment::SFdelta);
+			}
+			else
+			{
+				const int64_t iCds = MoveSegment::MulShift(iC, dsK, MoveSegment::SFdelta);
+				iNextCalcStepTime = (currentSegment->IsAccelerating()) ? iB + LimISqrt64(iA + iCds) : iB - LimISqrt64(iA + iCds);
+			}
 			//if (currentSegment->IsLinear()) { iA = dsK; }	//DEBUG
 #endif
 		}
 		break;
 
+#if SUPPORT_NATIVE_ARCS
+	case DMState::arcAxis:
+		// Calculate the distance along the path from the distance of the axis from its extreme position
+		{
+			const float d = mp.arc.dStart + (float)(nextStep + stepsTillRecalc) * mp.arc.dPerStep;
+			const float halfAngleFromExtreme = ArcAsin(fastSqrtf(constrain<float>(d * mp.arc.recipTwoRadius, 0.0, 0.5)));
+			const float ds = constrain<float>(mp.arc.sOffset + mp.arc.sPerHalfAngle * halfAngleFromExtreme, 0.0, dda.totalDistance);
+
+			// Now feed ds into the step algorithm for Cartesian motion
+			const float pCds = pC * ds;
+			nextCalcStepTime = (currentSegment->IsLinear()) ? pB + pCds
+								: (currentSegment->IsAccelerating()) ? pB + fastLimSqrtf(pA + pCds)
+									 : pB - fastLimSqrtf(pA + pCds);
+		}
+		break;
+#endif
+
 	default:
 		return false;
 	}
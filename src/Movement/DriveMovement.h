@@ -15,9 +15,14 @@
 class LinearDeltaKinematics;
 class PrepParams;
 class ExtruderShaper;
+class StepBuffer;
 
 #define EVEN_STEPS			(1)						// 1 to generate steps at even intervals when doing double/quad/octal stepping
 
+#if SUPPORT_NATIVE_ARCS && !MS_USE_FPU
+# error "Native arc moves need a processor with a hardware FPU"
+#endif
+
 enum class DMState : uint8_t
 {
 	idle = 0,
@@ -33,6 +38,10 @@ enum class DMState : uint8_t
 
 	deltaNormal,									// moving forwards without reversing in this segment, or in reverse
 	deltaForwardsReversing,							// moving forwards to start with, reversing before the end of this segment
+
+#if SUPPORT_NATIVE_ARCS
+	arcAxis,										// moving in a true arc, in one direction only
+#endif
 };
 
 // This class describes a single movement of one drive
@@ -40,6 +49,7 @@ class DriveMovement
 {
 public:
 	friend class DDA;
+	friend class StepBuffer;
 
 	DriveMovement(DriveMovement *next) noexcept;
 
@@ -52,6 +62,9 @@ public:
 	bool PrepareCartesianAxis(const DDA& dda, const PrepParams& params) noexcept SPEED_CRITICAL;
 #if SUPPORT_LINEAR_DELTA
 	bool PrepareDeltaAxis(const DDA& dda, const PrepParams& params) noexcept SPEED_CRITICAL;
+#endif
+#if SUPPORT_NATIVE_ARCS
+	bool PrepareArcAxis(const DDA& dda, const PrepParams& params) noexcept SPEED_CRITICAL;
 #endif
 	bool PrepareExtruder(const DDA& dda, const PrepParams& params) noexcept SPEED_CRITICAL;
 
@@ -67,14 +80,28 @@ public:
 	static unsigned int NumCreated() noexcept { return numCreated; }
 	static DriveMovement *Allocate(size_t p_drive, DMState st) noexcept;
 	static void Release(DriveMovement *item) noexcept;
+	static void ReleaseArenaDMs() noexcept;
+#if SUPPORT_NATIVE_ARCS
+	static void InitArcTable() noexcept;
+#endif
 
 private:
+	static DriveMovement *Create(DriveMovement *next) noexcept;
+	static DriveMovement *CreateInArena() noexcept;
+	static void DestroyInArena(DriveMovement *dm) noexcept;
+	bool CalcFirstStepTime(const DDA &dda) noexcept;
 	bool CalcNextStepTimeFull(const DDA &dda) noexcept SPEED_CRITICAL;
+#if SUPPORT_STEP_BUFFERING
+	bool TakeBufferedStep(const DDA &dda) noexcept SPEED_CRITICAL;
+#endif
 	bool NewCartesianSegment() noexcept SPEED_CRITICAL;
 	bool NewExtruderSegment() noexcept SPEED_CRITICAL;
 #if SUPPORT_LINEAR_DELTA
 	bool NewDeltaSegment(const DDA& dda) noexcept SPEED_CRITICAL;
 #endif
+#if SUPPORT_NATIVE_ARCS
+	bool NewArcSegment(const DDA& dda) noexcept SPEED_CRITICAL;
+#endif
 
 	static DriveMovement *freeList;
 	static unsigned int numCreated;
@@ -90,7 +117,8 @@ private:
 			directionChanged : 1,						// set by CalcNextStepTime if the direction is changed
 			isDelta : 1,								// true if this DM uses segment-free delta kinematics
 			isExtruder : 1,								// true if this DM is for an extruder (only matters if !isDelta)
-					: 2,								// padding to make the next field last
+			isArc : 1,									// true if this DM is for an axis moving in a true arc (only matters if !isDelta)
+					: 1,								// padding to make the next field last
 			stepsTakenThisSegment : 2;					// how many steps we have taken this phase, counts from 0 to 2. Last field in the byte so that we can increment it efficiently.
 	uint8_t stepsTillRecalc;							// how soon we need to recalculate
 
@@ -103,36 +131,47 @@ private:
 	uint32_t nextStepTime;								// how many clocks after the start of this move the next step is due
 	uint32_t stepInterval;								// how many clocks between steps
 
+#if SUPPORT_STEP_BUFFERING
+	StepBuffer *stepBuffer;								// precalculated step times, or nullptr if this DM calculates its own steps
+#endif
+
 #if MS_USE_FPU
 	float distanceSoFar;
 	float timeSoFar;
 	float pA, pB, pC;
 #else
-	uint32_t iDistanceSoFar;
+	int32_t iDistanceSoFar;								// multiplied by MoveSegment::Kdistance
 	uint32_t iTimeSoFar;
-	int64_t iA;
-	int32_t iB, iC;
+	int64_t iA;											// in step clocks squared
+	int32_t iB;											// in step clocks
+	int64_t iC;											// in step clocks squared per step, or step clocks per step multiplied by MoveSegment::KmmPerStep for linear segments
 #endif
 
-	// Parameters unique to a style of move (Cartesian, delta or extruder). Currently, extruders and Cartesian moves use the same parameters.
+	// Parameters unique to a style of move (Cartesian, delta, arc or extruder). Currently, extruders and Cartesian moves use the same parameters.
 	union
 	{
 		struct DeltaParameters							// Parameters for delta movement
 		{
+#if MS_USE_FPU
 			// The following don't depend on how the move is executed, so they could be set up in Init() if we use fixed acceleration/deceleration
 			float fTwoA;
 			float fTwoB;
 			float h0MinusZ0;							// the height subtended by the rod at the start of the move
-#if MS_USE_FPU
 			float fDSquaredMinusAsquaredMinusBsquaredTimesSsquared;
 			float fHmz0s;								// the starting height less the starting Z height, multiplied by the Z movement fraction (can go negative)
 			float fMinusAaPlusBbTimesS;
 			float reverseStartDistance;					// the overall move distance at which movement reversal occurs
 #else
+			// All values ending in K are in steps multiplied by MoveSegment::Kdelta
 			int64_t dSquaredMinusAsquaredMinusBsquaredTimesKsquaredSsquared;
 			int32_t hmz0sK;								// the starting step position less the starting Z height, multiplied by the Z movement fraction and K (can go negative)
+			int32_t h0MinusZ0sK;						// the height subtended by the rod at the start of the move
 			int32_t minusAaPlusBbTimesKs;
-			int32_t iReverseStartDistance;				// the overall move distance at which movement reversal occurs
+			int32_t twoAsK;
+			int32_t twoBsK;
+			int32_t dxsK, dysK, dzsK;					// the direction vector components multiplied by steps/mm, K and MoveSegment::KdeltaDirection
+			int32_t iReverseStartDistance;				// the overall move distance at which movement reversal occurs, multiplied by MoveSegment::Kdistance
+			uint64_t iMmPerStepTimesK;					// reciprocal of steps/mm, multiplied by MoveSegment::KmmPerStep
 #endif
 		} delta;
 
@@ -144,16 +183,64 @@ private:
 			float effectiveMmPerStep;					// reciprocal of [the steps/mm multiplied by the movement fraction]
 			float extraExtrusionDistance;				// the extra extrusion distance in the acceleration phase
 #else
-			uint32_t iPressureAdvanceK;					// how much pressure advance is applied to this move
-			uint32_t iEffectiveStepsPerMmTimesK;		// the steps/mm multiplied by the movement fraction
-			uint32_t iEffectiveMmPerStepTimesK;			// reciprocal of [the steps/mm multiplied by the movement fraction]
-			uint32_t iExtraExtrusionDistance;			// the extra extrusion distance in the acceleration phase
+			uint32_t iPressureAdvanceK;					// how much pressure advance is applied to this move, in step clocks
+			uint32_t iEffectiveStepsPerMmTimesK;		// the steps/mm multiplied by the movement fraction, multiplied by MoveSegment::KstepsPerMm
+			uint64_t iEffectiveMmPerStepTimesK;			// reciprocal of [the steps/mm multiplied by the movement fraction], multiplied by MoveSegment::KmmPerStep
+			int32_t iExtraExtrusionDistance;			// the extra extrusion distance in the acceleration phase, multiplied by MoveSegment::Kdistance
 #endif
 			float extrusionBroughtForwards;				// the amount of extrusion brought forwards from previous moves. Only needed for debug output.
 		} cart;
+
+#if SUPPORT_NATIVE_ARCS
+		struct ArcParameters							// Parameters for an axis moving in a true arc. Distances from the extreme are measured along this axis.
+		{
+			float dStart;								// the distance from the extreme position of the axis in this quadrant at the start of the move
+			float dPerStep;								// the change in that distance per step
+			float recipTwoRadius;						// reciprocal of twice the arc radius
+			float sOffset;								// the distance along the path at which the axis would be at its extreme position
+			float sPerHalfAngle;						// the distance along the path per radian of half the angle from the extreme position, signed
+		} arc;
+#endif
 	} mp;
 };
 
+#if SUPPORT_STEP_BUFFERING
+
+// This class holds step times for a DriveMovement that the Move task has calculated in advance, so that most of the time the step ISR only has to fetch them.
+// The calculation is done using a private copy of the DriveMovement, so that calculating ahead doesn't change the values that the ISR and the rest of the firmware use.
+// The copy is only ever used by the Move task with the step interrupt locked out, or by the step ISR itself when the Move task hasn't kept up.
+class StepBuffer
+{
+public:
+	static constexpr size_t Size = 32;											// must be a power of 2 and less than 256
+	static constexpr uint32_t DirectionChangedBit = 0x80000000;				// set in a buffered step time if the direction changes before that step
+
+	void* operator new(size_t count) { return Tasks::AllocPermanent(count); }
+	void operator delete(void* ptr) noexcept {}
+
+	StepBuffer() noexcept : calc(nullptr) { }
+
+	void Init(const DriveMovement& dm) noexcept;
+	bool CalcStep(const DDA& dda) noexcept SPEED_CRITICAL;						// calculate one step, returning false if there are no more
+	void Fill(const DDA& dda) noexcept;
+
+	size_t NumBuffered() const noexcept { return (uint8_t)(putIndex - getIndex); }
+	bool IsFull() const noexcept { return NumBuffered() == Size; }
+	bool IsFinished() const noexcept { return finished; }
+	uint32_t Take() noexcept { return stepTimes[(getIndex++) & (Size - 1)]; }
+
+private:
+	static_assert(Size < 256 && (Size & (Size - 1)) == 0);
+
+	DriveMovement calc;															// the copy of the DM that we use to calculate the steps
+	uint8_t putIndex;
+	uint8_t getIndex;
+	bool finished;																// true if the calculation has no more steps to do
+	uint32_t stepTimes[Size];
+};
+
+#endif
+
 // Calculate and store the time since the start of the move when the next step for the specified DriveMovement is due.
 // Return true if there are more steps to do. When finished, leave nextStep == totalSteps + 1.
 // This is also used for extruders on delta machines.
@@ -163,6 +250,12 @@ inline bool DriveMovement::CalcNextStepTime(const DDA &dda) noexcept
 	++nextStep;
 	if (nextStep <= totalSteps)
 	{
+#if SUPPORT_STEP_BUFFERING
+		if (stepBuffer != nullptr && nextStep > 1)
+		{
+			return TakeBufferedStep(dda);	// the first step is always calculated here, after which the buffer takes over
+		}
+#endif
 		if (stepsTillRecalc != 0)
 		{
 			--stepsTillRecalc;				// we are doing double/quad/octal stepping
@@ -194,6 +287,23 @@ inline bool DriveMovement::CalcNextStepTime(const DDA &dda) noexcept
 	return false;
 }
 
+// Calculate the time of the first step of the move. If we are buffering steps then also copy this DM to the step buffer and calculate some more steps.
+inline bool DriveMovement::CalcFirstStepTime(const DDA &dda) noexcept
+{
+	if (!CalcNextStepTime(dda))
+	{
+		return false;
+	}
+#if SUPPORT_STEP_BUFFERING
+	if (stepBuffer != nullptr)
+	{
+		stepBuffer->Init(*this);
+		stepBuffer->Fill(dda);
+	}
+#endif
+	return true;
+}
+
 // Return the number of net steps left for the move in the forwards direction.
 // We have already taken nextSteps - 1 steps, unless nextStep is zero.
 inline int32_t DriveMovement::GetNetStepsLeft() const noexcept
@@ -0,0 +1,1120 @@
+/*
+ * InputShaper.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "InputShaper.h"
+#include "InputShaperFamily.h"
+
+#include <GCodes/GCodeBuffer/GCodeBuffer.h>
+#include <Platform/RepRap.h>
+#include "StepTimer.h"
+#include "DDA.h"
+#include "MoveSegment.h"
+
+// Object model table and functions
+// Note: if using GCC version 7.3.1 20180622 and lambda functions are used in this table, you must compile this file with option -std=gnu++17.
+// Otherwise the table will be allocated in RAM instead of flash, which wastes too much RAM.
+
+// Macro to build a standard lambda function that includes the necessary type conversions
+#define OBJECT_MODEL_FUNC(...) OBJECT_MODEL_FUNC_BODY(InputShaper, __VA_ARGS__)
+#define OBJECT_MODEL_FUNC_IF(...) OBJECT_MODEL_FUNC_IF_BODY(InputShaper, __VA_ARGS__)
+
+constexpr ObjectModelArrayDescriptor InputShaper::amplitudesArrayDescriptor =
+{
+	nullptr,					// no lock needed
+	[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return ((const InputShaper*)self)->numExtraImpulses; },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept
+										-> ExpressionValue { return ExpressionValue(((const InputShaper*)self)->coefficients[context.GetIndex(0)], 3); }
+};
+
+constexpr ObjectModelArrayDescriptor InputShaper::durationsArrayDescriptor =
+{
+	nullptr,					// no lock needed
+	[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return ((const InputShaper*)self)->numExtraImpulses; },
+	[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept
+										-> ExpressionValue { return ExpressionValue(((const InputShaper*)self)->durations[context.GetIndex(0)] * (1.0/StepClockRate), 5); }
+};
+
+constexpr ObjectModelTableEntry InputShaper::objectModelTable[] =
+{
+	// Within each group, these entries must be in alphabetical order
+	// 0. InputShaper members
+	{ "amplitudes",				OBJECT_MODEL_FUNC_NOSELF(&amplitudesArrayDescriptor), 		ObjectModelEntryFlags::none },
+	{ "axes",					OBJECT_MODEL_FUNC(self->axes), 								ObjectModelEntryFlags::none },
+	{ "damping",				OBJECT_MODEL_FUNC(self->zeta, 2), 							ObjectModelEntryFlags::none },
+	{ "durations",				OBJECT_MODEL_FUNC_NOSELF(&durationsArrayDescriptor), 		ObjectModelEntryFlags::none },
+	{ "frequency",				OBJECT_MODEL_FUNC(self->frequency, 2), 						ObjectModelEntryFlags::none },
+	{ "minAcceleration",		OBJECT_MODEL_FUNC(self->minimumAcceleration, 1),			ObjectModelEntryFlags::none },
+	{ "type", 					OBJECT_MODEL_FUNC(self->type.ToString()), 					ObjectModelEntryFlags::none },
+};
+
+constexpr uint8_t InputShaper::objectModelTableDescriptor[] = { 1, 7 };
+
+DEFINE_GET_OBJECT_MODEL_TABLE(InputShaper)
+
+// Table of input shaper families, built at compile time. There must be one entry for each InputShaperType, in the same order.
+// Values for the two- and three-hump EI shapers are from http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.465.1337&rep=rep1&type=pdf. United States patent #4,916,635.
+static constexpr float Ei2Amplitudes[3][InputShaperFamily::NumTerms] =
+{
+	{ 0.16054,  0.76699,  2.26560, -1.22750 },
+	{ 0.33911,  0.45081, -2.58080,  1.73650 },
+	{ 0.34089, -0.61533, -0.68765,  0.42261 },
+};
+
+static constexpr float Ei2Times[3][InputShaperFamily::NumTerms] =
+{
+	{ 0.49890,  0.16270, -0.54262,  6.16180 },
+	{ 0.99748,  0.18382, -1.58270,  8.17120 },
+	{ 1.49920, -0.09297, -0.28338,  1.85710 },
+};
+
+static constexpr float Ei3Amplitudes[4][InputShaperFamily::NumTerms] =
+{
+	{ 0.11275,  0.76632,  3.29160, -1.44380 },
+	{ 0.23698,  0.61164, -2.57850,  4.85220 },
+	{ 0.30008, -0.19062, -2.14560,  0.13744 },
+	{ 0.23775, -0.73297,  0.46885, -2.08650 },
+};
+
+static constexpr float Ei3Times[4][InputShaperFamily::NumTerms] =
+{
+	{ 0.49974,  0.23834,  0.44559, 12.4720  },
+	{ 0.99849,  0.29808, -2.36460, 23.3990  },
+	{ 1.49870,  0.10306, -2.01390, 17.0320  },
+	{ 1.99960, -0.28231,  0.61536,  5.40450 },
+};
+
+static constexpr float EiVibrationTolerance = 0.05;		// the residual vibration that the single-hump EI shaper allows at the design frequency
+
+static constexpr InputShaperFamily InputShaperFamilies[] =
+{
+	MakeNoShaperFamily(),								// custom
+#if SUPPORT_DAA
+	MakeNoShaperFamily(),								// daa
+#endif
+	MakeEiShaperFamily(EiVibrationTolerance),			// ei
+	MakeFittedShaperFamily(Ei2Amplitudes, Ei2Times),	// ei2
+	MakeFittedShaperFamily(Ei3Amplitudes, Ei3Times),	// ei3
+	MakeMzvShaperFamily(),								// mzv
+	MakeNoShaperFamily(),								// none
+	MakeZvShaperFamily(0),								// zv
+	MakeZvShaperFamily(1),								// zvd
+	MakeZvShaperFamily(2),								// zvdd
+	MakeZvShaperFamily(3),								// zvddd
+};
+
+static_assert(ARRAY_SIZE(InputShaperFamilies) == InputShaperType::NumValues, "InputShaperFamilies table doesn't match InputShaperType");
+
+// Evaluate a polynomial in zeta
+static inline float EvaluatePolynomial(const float (&terms)[InputShaperFamily::NumTerms], float zeta) noexcept
+{
+	return ((terms[3] * zeta + terms[2]) * zeta + terms[1]) * zeta + terms[0];
+}
+
+// Evaluate a shaper family for the specified damping ratio, returning the number of extra impulses.
+// Set up the cumulative coefficients of the impulses (the last one is implicitly 1.0) and the durations between them in step clocks.
+static unsigned int EvaluateFamily(const InputShaperFamily& family, float zeta, float dampedPeriod, float coefficients[], float durations[]) noexcept
+{
+	if (family.form == InputShaperFamily::Form::none || family.numImpulses < 2)
+	{
+		return 0;
+	}
+
+	float amplitudes[InputShaperFamily::MaxImpulses];
+	float times[InputShaperFamily::MaxImpulses];
+	float sum = 0.0;
+	const float minusLogK = zeta * Pi/fastSqrtf(1.0 - fsquare(zeta));
+	for (unsigned int i = 0; i < family.numImpulses; ++i)
+	{
+		if (family.form == InputShaperFamily::Form::damped)
+		{
+			times[i] = family.times[i][0];
+			amplitudes[i] = family.amplitudes[i][0] * expf(-2.0 * minusLogK * times[i]);
+		}
+		else
+		{
+			times[i] = EvaluatePolynomial(family.times[i], zeta);
+			amplitudes[i] = EvaluatePolynomial(family.amplitudes[i], zeta);
+		}
+		sum += amplitudes[i];
+	}
+
+	float cumulativeAmplitude = 0.0;
+	for (unsigned int i = 0; i + 1 < family.numImpulses; ++i)
+	{
+		cumulativeAmplitude += amplitudes[i];
+		coefficients[i] = cumulativeAmplitude/sum;
+		durations[i] = (times[i + 1] - times[i]) * dampedPeriod;
+	}
+	return family.numImpulses - 1;
+}
+
+InputShaper::InputShaper() noexcept
+	: numExtraImpulses(0),
+	  frequency(DefaultFrequency),
+	  zeta(DefaultDamping),
+	  minimumAcceleration(ConvertAcceleration(DefaultMinimumAcceleration)),
+	  totalShapingClocks(0.0),
+	  type(InputShaperType::none)
+{
+}
+
+// Process the shaping parameters of M593, setting 'seen' if we find any
+GCodeResult InputShaper::Configure(GCodeBuffer& gb, const StringRef& reply, bool& seen) THROWS(GCodeException)
+{
+	constexpr float MinimumInputShapingFrequency = (float)StepClockRate/(2 * 65535);		// we use a 16-bit number of step clocks to represent half the input shaping period
+	constexpr float MaximumInputShapingFrequency = 1000.0;
+
+	if (gb.Seen('F'))
+	{
+		seen = true;
+		frequency = gb.GetLimitedFValue('F', MinimumInputShapingFrequency, MaximumInputShapingFrequency);
+	}
+	if (gb.Seen('L'))
+	{
+		seen = true;
+		minimumAcceleration = ConvertAcceleration(max<float>(gb.GetFValue(), 1.0));			// very low accelerations cause problems with the maths
+	}
+	if (gb.Seen('S'))
+	{
+		seen = true;
+		zeta = gb.GetLimitedFValue('S', 0.0, 0.99);
+	}
+
+	if (gb.Seen('P'))
+	{
+		String<StringLength20> shaperName;
+		gb.GetReducedString(shaperName.GetRef());
+		const InputShaperType newType(shaperName.c_str());
+		if (!newType.IsValid())
+		{
+			reply.printf("Unsupported input shaper type '%s'", shaperName.c_str());
+			return GCodeResult::error;
+		}
+		seen = true;
+		type = newType;
+	}
+	else if (seen && type == InputShaperType::none)
+	{
+#if SUPPORT_DAA
+		// For backwards compatibility, if we have set input shaping parameters but not defined shaping type, default to DAA for now. Change this when we support better types of input shaping.
+		type = InputShaperType::daa;
+#else
+		type = InputShaperType::zvd;
+#endif
+	}
+
+	if (seen)
+	{
+		const float dampedFrequency = frequency * fastSqrtf(1.0 - fsquare(zeta));
+		const float dampedPeriod = StepClockRate/dampedFrequency;
+		switch (type.RawValue())
+		{
+		case InputShaperType::custom:
+			{
+				// Get the coefficients
+				size_t numAmplitudes = MaxExtraImpulses;
+				gb.MustSee('H');
+				gb.GetFloatArray(coefficients, numAmplitudes, false);
+
+				// Get the impulse durations, if provided
+				if (gb.Seen('T'))
+				{
+					size_t numDurations = numAmplitudes;
+					gb.GetFloatArray(durations, numDurations, true);
+
+					// Check we have the same number of both
+					if (numDurations != numAmplitudes)
+					{
+						reply.copy("Too few durations given");
+						type = InputShaperType::none;
+						numExtraImpulses = 0;
+						CalculateDerivedParameters();
+						return GCodeResult::error;
+					}
+					for (unsigned int i = 0; i < numAmplitudes; ++i)
+					{
+						durations[i] *= StepClockRate;			// convert from seconds to step clocks
+					}
+				}
+				else
+				{
+					for (unsigned int i = 0; i < numAmplitudes; ++i)
+					{
+						durations[i] = 0.5 * dampedPeriod;
+					}
+				}
+				numExtraImpulses = numAmplitudes;
+			}
+			break;
+
+#if SUPPORT_DAA
+		case InputShaperType::daa:
+			durations[0] = dampedPeriod;
+			numExtraImpulses = 0;
+			break;
+#endif
+
+		default:
+			numExtraImpulses = EvaluateFamily(InputShaperFamilies[type.RawValue()], zeta, dampedPeriod, coefficients, durations);
+			break;
+		}
+
+		CalculateDerivedParameters();
+		reprap.MoveUpdated();
+	}
+	return GCodeResult::ok;
+}
+
+// Append a description of this shaper to the reply
+void InputShaper::AppendDescription(const StringRef& reply) const noexcept
+{
+	if (type == InputShaperType::none)
+	{
+		reply.cat("disabled");
+		return;
+	}
+
+	reply.catf("'%s' at %.1fHz damping factor %.2f, min. acceleration %.1f",
+					type.ToString(), (double)frequency, (double)zeta, (double)InverseConvertAcceleration(minimumAcceleration));
+	if (numExtraImpulses != 0)
+	{
+		reply.cat(", impulses");
+		for (unsigned int i = 0; i < numExtraImpulses; ++i)
+		{
+			reply.catf(" %.3f", (double)coefficients[i]);
+		}
+		reply.cat(" with durations (ms)");
+		for (unsigned int i = 0; i < numExtraImpulses; ++i)
+		{
+			reply.catf(" %.2f", (double)(durations[i] * StepClocksToMillis));
+		}
+		if (reprap.Debug(moduleMove))
+		{
+			reply.catf(" odpa=%.4e odvpa=%.4e ovc=", (double)overlappedDistancePerA, (double)overlappedDeltaVPerA);
+			for (unsigned int i = 0; i < 2 * numExtraImpulses; ++i)
+			{
+				reply.catf(" %.3f", (double)overlappedCoefficients[i]);
+			}
+		}
+	}
+}
+
+// Calculate the values used by the motion planner from the impulse coefficients and durations
+void InputShaper::CalculateDerivedParameters() noexcept
+{
+	// Calculate the total extra duration of input shaping
+	totalShapingClocks = 0.0;
+	extraClocksAtStart = 0.0;
+	extraClocksAtEnd = 0.0;
+	extraDistanceAtStart = 0.0;
+	extraDistanceAtEnd = 0.0;
+
+	{
+		float u = 0.0;
+		for (unsigned int i = 0; i < numExtraImpulses; ++i)
+		{
+			const float segTime = durations[i];
+			totalShapingClocks += segTime;
+			extraClocksAtStart += (1.0 - coefficients[i]) * segTime;
+			extraClocksAtEnd += coefficients[i] * segTime;
+			const float speedChange = coefficients[i] * segTime;
+			extraDistanceAtStart += (1.0 - coefficients[i]) * (u + 0.5 * speedChange) * segTime;
+			u += speedChange;
+		}
+	}
+
+	minimumShapingStartOriginalClocks = totalShapingClocks - extraClocksAtStart + (MinimumMiddleSegmentTime * StepClockRate);
+	minimumShapingEndOriginalClocks = totalShapingClocks - extraClocksAtEnd + (MinimumMiddleSegmentTime * StepClockRate);
+	minimumNonOverlappedOriginalClocks = (totalShapingClocks * 2) - extraClocksAtStart - extraClocksAtEnd + (MinimumMiddleSegmentTime * StepClockRate);
+
+	{
+		float v = 0.0;
+		for (int i = numExtraImpulses - 1; i >= 0; --i)
+		{
+			const float segTime = durations[i];
+			const float speedChange = (1.0 - coefficients[i]) * segTime;
+			extraDistanceAtEnd += coefficients[i] * (v - 0.5 * speedChange) * segTime;
+			v -= speedChange;
+		}
+	}
+
+	if (numExtraImpulses != 0)
+	{
+		overlappedShapingClocks = 2 * totalShapingClocks;
+		// Calculate the clocks and coefficients needed when we shape the start of acceleration/deceleration and then immediately shape the end
+		float maxVal = 0.0;
+		for (unsigned int i = 0; i < numExtraImpulses; ++i)
+		{
+			overlappedDurations[i] = overlappedDurations[i + numExtraImpulses] = durations[i];
+			float val = coefficients[i];
+			overlappedCoefficients[i] = val;
+			if (val > maxVal)
+			{
+				maxVal = val;
+			}
+			val = 1.0 - val;
+			overlappedCoefficients[i + numExtraImpulses] = val;
+			if (val > maxVal)
+			{
+				maxVal = val;
+			}
+		}
+
+		// Now scale the values by maxVal so that the highest coefficient is 1.0, and calculate the total distance per unit acceleration
+		overlappedDistancePerA = 0.0;
+		float u = 0.0;
+		for (unsigned int i = 0; i < 2 * numExtraImpulses; ++i)
+		{
+			overlappedCoefficients[i] /= maxVal;
+			const float speedChange = overlappedCoefficients[i] * overlappedDurations[i];
+			overlappedDistancePerA += (u + 0.5 * speedChange) * overlappedDurations[i];
+			u += speedChange;
+		}
+		overlappedDeltaVPerA = u;
+	}
+}
+
+// Plan input shaping, generate the MoveSegments, and set up the basic move parameters.
+// On entry, params.shapingPlan is set to 'no shaping'.
+// Return the shaped segments, or nullptr if we are not doing any shaping.
+MoveSegment *InputShaper::PlanShaping(DDA& dda, PrepParams& params, bool shapingEnabled) const noexcept
+{
+	switch ((shapingEnabled) ? type.RawValue() : InputShaperType::none)
+	{
+#if SUPPORT_DAA
+	case InputShaperType::daa:
+		do
+		{
+			// Try to reduce the acceleration/deceleration of the move to cancel ringing
+			const float idealPeriod = 1.0/frequency;					// for DAA this the full period, 1.0
+
+			float proposedAcceleration = dda.acceleration, proposedAccelDistance = dda.beforePrepare.accelDistance;
+			bool adjustAcceleration = false;
+			if (dda.topSpeed > dda.startSpeed && ((dda.GetPrevious()->state != DDA::DDAState::frozen && dda.GetPrevious()->state != DDA::DDAState::executing) || !dda.GetPrevious()->flags.wasAccelOnlyMove))
+			{
+				const float accelTime = (dda.topSpeed - dda.startSpeed)/dda.acceleration;
+				if (accelTime < idealPeriod)
+				{
+					proposedAcceleration = (dda.topSpeed - dda.startSpeed) * frequency;
+					adjustAcceleration = true;
+				}
+				else if (accelTime < idealPeriod * 2)
+				{
+					proposedAcceleration = (dda.topSpeed - dda.startSpeed) * frequency * 0.5;
+					adjustAcceleration = true;
+				}
+				if (adjustAcceleration)
+				{
+					proposedAccelDistance = (fsquare(dda.topSpeed) - fsquare(dda.startSpeed))/(2 * proposedAcceleration);
+				}
+			}
+
+			float proposedDeceleration = dda.deceleration, proposedDecelDistance = dda.beforePrepare.decelDistance;
+			bool adjustDeceleration = false;
+			if (dda.GetNext()->state != DDA::DDAState::provisional || !dda.GetNext()->IsDecelerationMove())
+			{
+				const float decelTime = (dda.topSpeed - dda.endSpeed)/dda.deceleration;
+				if (decelTime < idealPeriod)
+				{
+					proposedDeceleration = (dda.topSpeed - dda.endSpeed) * frequency;
+					adjustDeceleration = true;
+				}
+				else if (decelTime < idealPeriod * 2)
+				{
+					proposedDeceleration = (dda.topSpeed - dda.endSpeed) * frequency * 0.5;
+					adjustDeceleration = true;
+				}
+				if (adjustDeceleration)
+				{
+					proposedDecelDistance = (fsquare(dda.topSpeed) - fsquare(dda.endSpeed))/(2 * proposedDeceleration);
+				}
+			}
+
+			if (adjustAcceleration || adjustDeceleration)
+			{
+				if (proposedAccelDistance + proposedDecelDistance <= dda.totalDistance)
+				{
+					if (proposedAcceleration < minimumAcceleration || proposedDeceleration < minimumAcceleration)
+					{
+						break;
+					}
+					dda.acceleration = proposedAcceleration;
+					dda.deceleration = proposedDeceleration;
+					dda.beforePrepare.accelDistance = proposedAccelDistance;
+					dda.beforePrepare.decelDistance = proposedDecelDistance;
+				}
+				else
+				{
+					// We can't keep this as a trapezoidal move with the original top speed.
+					// Try an accelerate-decelerate move with acceleration and deceleration times equal to the ideal period.
+					const float twiceTotalDistance = 2 * dda.totalDistance;
+					float proposedTopSpeed = dda.totalDistance * frequency - (dda.startSpeed + dda.endSpeed)/2;
+					if (proposedTopSpeed > dda.startSpeed && proposedTopSpeed > dda.endSpeed)
+					{
+						proposedAcceleration = (twiceTotalDistance - ((3 * dda.startSpeed + dda.endSpeed) * idealPeriod)) * fsquare(frequency) * 0.5;
+						proposedDeceleration = (twiceTotalDistance - ((dda.startSpeed + 3 * dda.endSpeed) * idealPeriod)) * fsquare(frequency) * 0.5;
+						if (   proposedAcceleration < minimumAcceleration || proposedDeceleration < minimumAcceleration
+							|| proposedAcceleration > dda.acceleration || proposedDeceleration > dda.deceleration
+						   )
+						{
+							break;
+						}
+						dda.topSpeed = proposedTopSpeed;
+						dda.acceleration = proposedAcceleration;
+						dda.deceleration = proposedDeceleration;
+						dda.beforePrepare.accelDistance = dda.startSpeed * idealPeriod + (dda.acceleration * fsquare(idealPeriod)) * 0.5;
+						dda.beforePrepare.decelDistance = dda.endSpeed * idealPeriod + (dda.deceleration * fsquare(idealPeriod)) * 0.5;
+					}
+					else if (dda.startSpeed < dda.endSpeed)
+					{
+						// Change it into an accelerate-only move, accelerating as slowly as we can
+						proposedAcceleration = (fsquare(dda.endSpeed) - fsquare(dda.startSpeed))/twiceTotalDistance;
+						if (proposedAcceleration < minimumAcceleration)
+						{
+							break;		// avoid very small accelerations because they can be problematic
+						}
+						dda.acceleration = proposedAcceleration;
+						dda.topSpeed = dda.endSpeed;
+						dda.beforePrepare.accelDistance = dda.totalDistance;
+						dda.beforePrepare.decelDistance = 0.0;
+					}
+					else if (dda.startSpeed > dda.endSpeed)
+					{
+						// Change it into a decelerate-only move, decelerating as slowly as we can
+						proposedDeceleration = (fsquare(dda.startSpeed) - fsquare(dda.endSpeed))/twiceTotalDistance;
+						if (proposedDeceleration < minimumAcceleration)
+						{
+							break;		// avoid very small accelerations because they can be problematic
+						}
+						dda.deceleration = proposedDeceleration;
+						dda.topSpeed = dda.startSpeed;
+						dda.beforePrepare.decelDistance = dda.totalDistance;
+					}
+					else
+					{
+						// Start and end speeds are exactly the same, possibly zero, so give up trying to adjust this move
+						break;
+					}
+				}
+
+				if (reprap.Debug(moduleMove))
+				{
+					debugPrintf("DAA: new a=%.1f d=%.1f\n", (double)dda.acceleration, (double)dda.deceleration);
+				}
+			}
+		} while (false);			// this loop is solely for the purpose of catching 'break' statements
+		params.SetFromDDA(dda);
+		break;
+#endif
+
+	case InputShaperType::none:
+	default:
+		params.SetFromDDA(dda);
+		break;
+
+	// The other input shapers all have multiple impulses with varying coefficients
+	case InputShaperType::custom:
+	case InputShaperType::zv:
+	case InputShaperType::zvd:
+	case InputShaperType::mzv:
+	case InputShaperType::zvdd:
+	case InputShaperType::zvddd:
+	case InputShaperType::ei:
+	case InputShaperType::ei2:
+	case InputShaperType::ei3:
+		params.SetFromDDA(dda);															// set up the provisional parameters
+
+		if (params.unshaped.accelDistance < params.unshaped.decelStartDistance)			// we can't do any shaping unless there is a steady speed segment that can be shortened
+		{
+			params.shaped = params.unshaped;
+			//TODO if we want to shape both acceleration and deceleration but the steady distance is zero or too short, we could reduce the top speed
+			if (params.unshaped.accelDistance > 0.0)
+			{
+				if ((dda.GetPrevious()->state != DDA::DDAState::frozen && dda.GetPrevious()->state != DDA::DDAState::executing) || !dda.GetPrevious()->flags.wasAccelOnlyMove)
+				{
+					TryShapeAccelBoth(dda, params);
+				}
+				else if (params.unshaped.accelClocks >= minimumShapingEndOriginalClocks)
+				{
+					TryShapeAccelEnd(dda, params);
+				}
+			}
+			if (params.unshaped.decelStartDistance < dda.totalDistance)
+			{
+				if (dda.GetNext()->GetState() != DDA::DDAState::provisional || !dda.GetNext()->IsDecelerationMove())
+				{
+					TryShapeDecelBoth(dda, params);
+				}
+				else if (params.unshaped.decelClocks >= minimumShapingStartOriginalClocks)
+				{
+					TryShapeDecelStart(dda, params);
+				}
+			}
+		}
+		break;
+	}
+
+	// If we are doing any input shaping then generate the shaped segments, else return null
+	MoveSegment *shapedSegs = nullptr;
+	if (params.shapingPlan.IsShaped())
+	{
+		MoveSegment * const accelSegs = GetAccelerationSegments(dda, params);
+		MoveSegment * const decelSegs = GetDecelerationSegments(dda, params);
+		params.shaped.Finalise(dda.topSpeed);									// this sets up params.shaped.steadyClocks, which is needed by FinishShapedSegments
+		dda.clocksNeeded = params.shaped.TotalClocks();
+		shapedSegs = FinishShapedSegments(dda, params, accelSegs, decelSegs);
+		params.unshaped.steadyClocks = max<float>(dda.clocksNeeded - params.unshaped.accelClocks - params.unshaped.decelClocks, 0.0);
+	}
+	else
+	{
+		params.unshaped.Finalise(dda.topSpeed);									// this sets up params.steadyClocks
+		dda.clocksNeeded = params.unshaped.TotalClocks();
+	}
+
+//	debugPrintf(" final plan %03x\n", (unsigned int)params.shapingPlan.all);
+	return shapedSegs;
+}
+
+// Generate shaped segments for the axes that use this shaper, when the move has already been planned by a different shaper.
+// All axes must stay in step with each other at the start and end of the steady speed phase of the planned move, so we only shape the acceleration or deceleration
+// if we can find an acceleration that makes our shaped phase lose the same distance relative to moving at top speed as the planned phase does.
+// We use the unshaped acceleration or deceleration only for a phase that the planned shaper didn't shape either, because only then does it meet this condition.
+// Return nullptr if we can't match every phase that the planned shaper shaped, in which case the axes use the segments of the planned shaper.
+MoveSegment *InputShaper::GetMatchingSegments(const DDA& dda, const PrepParams& plannedParams) const noexcept
+{
+	if (numExtraImpulses == 0 || !plannedParams.shapingPlan.IsShaped())
+	{
+		return nullptr;
+	}
+
+	PrepParams params;
+	params.shaped = plannedParams.unshaped;
+	const bool accelShaped = TryMatchAccel(dda, plannedParams, params);
+	const bool decelShaped = TryMatchDecel(dda, plannedParams, params);
+	const InputShaperPlan& plan = plannedParams.shapingPlan;
+	if (   (!accelShaped && (plan.shapeAccelStart || plan.shapeAccelEnd || plan.shapeAccelOverlapped))
+		|| (!decelShaped && (plan.shapeDecelStart || plan.shapeDecelEnd || plan.shapeDecelOverlapped))
+	   )
+	{
+		return nullptr;
+	}
+
+	MoveSegment * const accelSegs = GetAccelerationSegments(dda, params);
+	MoveSegment * const decelSegs = GetDecelerationSegments(dda, params);
+	params.shaped.Finalise(dda.topSpeed);
+	return FinishShapedSegments(dda, params, accelSegs, decelSegs);
+}
+
+// Solve (speedChange^2/(2 * a)) + (speedChange * extraClocks) + (q * a) = lostDistance for the acceleration a.
+// This gives the acceleration that makes a shaped acceleration or deceleration phase lose the required distance compared with moving at top speed throughout.
+// Return true if there is a positive solution.
+static bool SolveForAcceleration(float speedChange, float extraClocks, float q, float lostDistance, float& acceleration) noexcept
+{
+	const float b = lostDistance - speedChange * extraClocks;
+	const float discriminant = fsquare(b) - 2 * q * fsquare(speedChange);
+	if (b <= 0.0 || discriminant < 0.0)
+	{
+		return false;
+	}
+	acceleration = fsquare(speedChange)/(b + fastSqrtf(discriminant));		// this form of the solution remains accurate when q is close to zero
+	return true;
+}
+
+// Try to shape both ends of the acceleration so that it matches the planned acceleration phase. If successful, update params and return true.
+bool InputShaper::TryMatchAccel(const DDA& dda, const PrepParams& plannedParams, PrepParams& params) const noexcept
+{
+	if (   plannedParams.unshaped.accelDistance <= 0.0
+		|| ((dda.GetPrevious()->state == DDA::DDAState::frozen || dda.GetPrevious()->state == DDA::DDAState::executing) && dda.GetPrevious()->flags.wasAccelOnlyMove)
+	   )
+	{
+		return false;
+	}
+
+	const float speedIncrease = dda.topSpeed - dda.startSpeed;
+	const float lostDistance = (dda.topSpeed * plannedParams.unshaped.accelClocks) - plannedParams.unshaped.accelDistance;
+	float acceleration;
+	if (   !SolveForAcceleration(speedIncrease, extraClocksAtStart, -(extraDistanceAtStart + extraDistanceAtEnd), lostDistance, acceleration)
+		|| acceleration > dda.acceleration
+		|| acceleration < minimumAcceleration
+		|| speedIncrease < acceleration * minimumNonOverlappedOriginalClocks
+	   )
+	{
+		return false;
+	}
+
+	const float accelDistance = ((dda.startSpeed + dda.topSpeed) * speedIncrease)/(2 * acceleration)
+								+ GetExtraAccelStartDistance(dda.startSpeed, acceleration) + GetExtraAccelEndDistance(dda.topSpeed, acceleration);
+	if (accelDistance > params.shaped.decelStartDistance)
+	{
+		return false;
+	}
+
+	params.shaped.accelDistance = accelDistance;
+	params.shaped.accelClocks = speedIncrease/acceleration + extraClocksAtStart + extraClocksAtEnd;
+	params.shaped.acceleration = acceleration;
+	params.shapingPlan.shapeAccelStart = params.shapingPlan.shapeAccelEnd = true;
+	return true;
+}
+
+// Try to shape both ends of the deceleration so that it matches the planned deceleration phase. If successful, update params and return true.
+bool InputShaper::TryMatchDecel(const DDA& dda, const PrepParams& plannedParams, PrepParams& params) const noexcept
+{
+	if (   plannedParams.unshaped.decelStartDistance >= dda.totalDistance
+		|| (dda.GetNext()->GetState() == DDA::DDAState::provisional && dda.GetNext()->IsDecelerationMove())
+	   )
+	{
+		return false;
+	}
+
+	const float speedDecrease = dda.topSpeed - dda.endSpeed;
+	const float lostDistance = (dda.topSpeed * plannedParams.unshaped.decelClocks) - (dda.totalDistance - plannedParams.unshaped.decelStartDistance);
+	float deceleration;
+	if (   !SolveForAcceleration(speedDecrease, extraClocksAtEnd, extraDistanceAtStart + extraDistanceAtEnd, lostDistance, deceleration)
+		|| deceleration > dda.deceleration
+		|| deceleration < minimumAcceleration
+		|| speedDecrease < deceleration * minimumNonOverlappedOriginalClocks
+	   )
+	{
+		return false;
+	}
+
+	const float decelDistance = ((dda.topSpeed + dda.endSpeed) * speedDecrease)/(2 * deceleration)
+								+ GetExtraDecelStartDistance(dda.topSpeed, deceleration) + GetExtraDecelEndDistance(dda.endSpeed, deceleration);
+	if (dda.totalDistance - decelDistance < params.shaped.accelDistance)
+	{
+		return false;
+	}
+
+	params.shaped.decelStartDistance = dda.totalDistance - decelDistance;
+	params.shaped.decelClocks = speedDecrease/deceleration + extraClocksAtStart + extraClocksAtEnd;
+	params.shaped.deceleration = deceleration;
+	params.shapingPlan.shapeDecelStart = params.shapingPlan.shapeDecelEnd = true;
+	return true;
+}
+
+// Try to shape the end of the acceleration. We already know that there is sufficient acceleration time to do this, but we still need to check that there is enough distance.
+void InputShaper::TryShapeAccelEnd(const DDA& dda, PrepParams& params) const noexcept
+{
+	const float extraAccelDistance = GetExtraAccelEndDistance(dda.topSpeed, params.unshaped.acceleration);
+	if (ImplementAccelShaping(dda, params, params.unshaped.accelDistance + extraAccelDistance, params.unshaped.accelClocks + extraClocksAtEnd))
+	{
+		params.shapingPlan.shapeAccelEnd = true;
+	}
+	else
+	{
+		// Not enough constant speed time to the acceleration shaping
+		if (reprap.Debug(Module::moduleDda))
+		{
+			debugPrintf("Can't shape accel end\n");
+		}
+	}
+}
+
+void InputShaper::TryShapeAccelBoth(DDA& dda, PrepParams& params) const noexcept
+{
+	const float speedIncrease = dda.topSpeed - dda.startSpeed;
+	if (speedIncrease <= overlappedDeltaVPerA * params.unshaped.acceleration)
+	{
+		// We can use overlapped shaping
+		const float newAcceleration = speedIncrease/overlappedDeltaVPerA;
+		if (newAcceleration >= minimumAcceleration)
+		{
+			const float newAccelDistance = (dda.startSpeed * overlappedShapingClocks) + (newAcceleration * overlappedDistancePerA);
+			if (ImplementAccelShaping(dda, params, newAccelDistance, overlappedShapingClocks))
+			{
+				params.shapingPlan.shapeAccelOverlapped = true;
+				params.shaped.acceleration = newAcceleration;
+			}
+		}
+	}
+	else if (params.unshaped.accelClocks < minimumNonOverlappedOriginalClocks)
+	{
+		// The speed change is too high to allow overlapping, but non-overlapped shaping will give a very short steady acceleration segment.
+		// If we have enough spare distance, reduce the acceleration slightly to lengthen that segment.
+		const float newAcceleration = speedIncrease/minimumNonOverlappedOriginalClocks;
+		const float newUnshapedAccelDistance = (dda.startSpeed + 0.5 * newAcceleration * minimumNonOverlappedOriginalClocks) * minimumNonOverlappedOriginalClocks;
+		const float extraAccelDistance = GetExtraAccelStartDistance(dda.startSpeed, newAcceleration) + GetExtraAccelEndDistance(dda.topSpeed, newAcceleration);
+		if (ImplementAccelShaping(dda, params, newUnshapedAccelDistance + extraAccelDistance, minimumNonOverlappedOriginalClocks + extraClocksAtStart + extraClocksAtEnd))
+		{
+			params.shapingPlan.shapeAccelStart = params.shapingPlan.shapeAccelEnd = true;
+			params.shaped.acceleration = newAcceleration;
+			//params.shapingPlan.debugPrint = true;
+		}
+	}
+	else
+	{
+		// We only attempt shaping if we can shape both the start and end of acceleration
+		const float extraAccelDistance = GetExtraAccelStartDistance(dda.startSpeed, params.unshaped.acceleration) + GetExtraAccelEndDistance(dda.topSpeed, params.unshaped.acceleration);
+		if (ImplementAccelShaping(dda, params, params.unshaped.accelDistance + extraAccelDistance, params.unshaped.accelClocks + extraClocksAtStart + extraClocksAtEnd))
+		{
+			params.shapingPlan.shapeAccelStart = params.shapingPlan.shapeAccelEnd = true;
+		}
+	}
+}
+
+// Check whether we can implement acceleration shaping using the proposed parameters; if so then implement it and return true; else return false with nothing changed
+bool InputShaper::ImplementAccelShaping(const DDA& dda, PrepParams& params, float newAccelDistance, float newAccelClocks) const noexcept
+{
+	if (newAccelDistance <= params.shaped.decelStartDistance)
+	{
+		const float speedIncrease = dda.topSpeed - dda.startSpeed;
+		const float unshapedAccelClocks = 2 * (dda.topSpeed * newAccelClocks - newAccelDistance)/speedIncrease;
+		const float unshapedAccelDistance = (dda.startSpeed + dda.topSpeed) * unshapedAccelClocks * 0.5;
+		if (unshapedAccelDistance <= params.unshaped.decelStartDistance)
+		{
+			params.shaped.accelDistance = newAccelDistance;
+			params.shaped.accelClocks = newAccelClocks;
+			params.unshaped.accelClocks = unshapedAccelClocks;
+			params.unshaped.accelDistance = unshapedAccelDistance;
+			params.unshaped.acceleration = speedIncrease/unshapedAccelClocks;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Try to shape the start of the deceleration. We already know that there is sufficient deceleration time to do this, but we still need to check that there is enough distance.
+void InputShaper::TryShapeDecelStart(const DDA& dda, PrepParams& params) const noexcept
+{
+	const float extraDecelDistance = GetExtraDecelStartDistance(dda.topSpeed, params.unshaped.deceleration);
+	if (ImplementDecelShaping(dda, params, params.unshaped.decelStartDistance - extraDecelDistance, params.unshaped.decelClocks + extraClocksAtStart))
+	{
+		params.shapingPlan.shapeDecelStart = true;
+	}
+	else
+	{
+		// Not enough constant speed time to do deceleration shaping
+		if (reprap.Debug(Module::moduleDda))
+		{
+			debugPrintf("Can't shape decel start\n");
+		}
+	}
+}
+
+void InputShaper::TryShapeDecelBoth(DDA& dda, PrepParams& params) const noexcept
+{
+	const float speedDecrease = dda.topSpeed - dda.endSpeed;
+	if (speedDecrease <= overlappedDeltaVPerA * params.unshaped.deceleration)
+	{
+		// We can use overlapped shaping
+		const float newDeceleration = speedDecrease/overlappedDeltaVPerA;
+		if (newDeceleration >= minimumAcceleration)
+		{
+			const float newDecelDistance = (dda.topSpeed * overlappedShapingClocks) - (newDeceleration * overlappedDistancePerA);
+			if (ImplementDecelShaping(dda, params, dda.totalDistance - newDecelDistance, overlappedShapingClocks))
+			{
+				params.shapingPlan.shapeDecelOverlapped = true;
+				params.shaped.deceleration = newDeceleration;
+			}
+		}
+	}
+	else if (params.unshaped.decelClocks < minimumNonOverlappedOriginalClocks)
+	{
+		// The speed change is too high to allow overlapping, but non-overlapped shaping will give a very short steady acceleration segment.
+		// If we have enough spare distance, reduce the acceleration slightly to lengthen that segment.
+		const float newDeceleration = speedDecrease/minimumNonOverlappedOriginalClocks;
+		const float newUnshapedDecelDistance = (dda.endSpeed + (0.5 * newDeceleration * minimumNonOverlappedOriginalClocks)) * minimumNonOverlappedOriginalClocks;
+		const float extraDecelDistance = GetExtraDecelStartDistance(dda.topSpeed, newDeceleration) + GetExtraDecelEndDistance(dda.endSpeed, newDeceleration);
+		if (ImplementDecelShaping(dda, params, dda.totalDistance - (newUnshapedDecelDistance + extraDecelDistance), minimumNonOverlappedOriginalClocks + extraClocksAtStart + extraClocksAtEnd))
+		{
+			params.shapingPlan.shapeDecelStart = params.shapingPlan.shapeDecelEnd = true;
+			params.shaped.deceleration = newDeceleration;
+			//params.shapingPlan.debugPrint = true;
+		}
+	}
+	else
+	{
+		// Only perform shaping if we can shape both the start and end of deceleration, otherwise we may not be able to generate a corresponding unshaped move because it might require negative steady distance
+		const float extraDecelDistance = GetExtraDecelStartDistance(dda.topSpeed, params.unshaped.deceleration) + GetExtraDecelEndDistance(dda.endSpeed, params.unshaped.deceleration);
+		if (ImplementDecelShaping(dda, params, params.unshaped.decelStartDistance - extraDecelDistance, params.unshaped.decelClocks + extraClocksAtStart + extraClocksAtEnd))
+		{
+			params.shapingPlan.shapeDecelStart = params.shapingPlan.shapeDecelEnd = true;
+		}
+	}
+}
+
+// Check whether we can implement acceleration shaping using the proposed parameters; if so then implement it and return true; else return false with nothing changed
+bool InputShaper::ImplementDecelShaping(const DDA& dda, PrepParams& params, float newDecelStartDistance, float newDecelClocks) const noexcept
+{
+	if (params.shaped.accelDistance <= newDecelStartDistance)
+	{
+		const float speedDecrease = dda.topSpeed - dda.endSpeed;
+		const float unshapedDecelClocks = 2 * (dda.topSpeed * newDecelClocks - (dda.totalDistance - newDecelStartDistance))/speedDecrease;
+		const float unshapedDecelDistance = (dda.topSpeed + dda.endSpeed) * unshapedDecelClocks * 0.5;
+		if (params.unshaped.accelDistance + unshapedDecelDistance <= dda.totalDistance)
+		{
+			params.shaped.decelStartDistance = newDecelStartDistance;
+			params.shaped.decelClocks = newDecelClocks;
+			params.unshaped.decelClocks = unshapedDecelClocks;
+			params.unshaped.decelStartDistance = dda.totalDistance - unshapedDecelDistance;
+			params.unshaped.deceleration = speedDecrease/unshapedDecelClocks;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// If there is an acceleration phase, generate the acceleration segments according to the plan, and set the number of acceleration segments in the plan
+MoveSegment *InputShaper::GetAccelerationSegments(const DDA& dda, PrepParams& params) const noexcept
+{
+	if (params.shaped.accelDistance > 0.0)
+	{
+		if (params.shapingPlan.shapeAccelOverlapped)
+		{
+			MoveSegment *accelSegs = nullptr;
+			float segStartSpeed = dda.topSpeed;
+			for (unsigned int i = 2 * numExtraImpulses; i != 0; )
+			{
+				--i;
+				accelSegs = MoveSegment::Allocate(accelSegs);
+				const float acceleration = params.shaped.acceleration * overlappedCoefficients[i];
+				const float segTime = overlappedDurations[i];
+				segStartSpeed -= acceleration * segTime;
+				const float b = segStartSpeed/(-acceleration);
+				const float c = 2.0/acceleration;
+				const float segLen = (segStartSpeed + (0.5 * acceleration * segTime)) * segTime;
+				accelSegs->SetNonLinear(segLen, segTime, b, c);
+			}
+			return accelSegs;
+		}
+
+		float accumulatedSegTime = 0.0;
+		float endDistance = params.shaped.accelDistance;
+		MoveSegment *endAccelSegs = nullptr;
+		if (params.shapingPlan.shapeAccelEnd)
+		{
+			// Shape the end of the acceleration
+			float segStartSpeed = dda.topSpeed;
+			for (unsigned int i = numExtraImpulses; i != 0; )
+			{
+				--i;
+				endAccelSegs = MoveSegment::Allocate(endAccelSegs);
+				const float acceleration = params.shaped.acceleration * (1.0 - coefficients[i]);
+				const float segTime = durations[i];
+				segStartSpeed -= acceleration * segTime;
+				const float b = segStartSpeed/(-acceleration);
+				const float c = 2.0/acceleration;
+				const float segLen = (segStartSpeed + (0.5 * acceleration * segTime)) * segTime;
+				endDistance -= segLen;
+				endAccelSegs->SetNonLinear(segLen, segTime, b, c);
+			}
+			accumulatedSegTime += totalShapingClocks;
+		}
+
+		float startDistance = 0.0;
+		float startSpeed = dda.startSpeed;
+		MoveSegment *startAccelSegs = nullptr;
+		if (params.shapingPlan.shapeAccelStart)
+		{
+			// Shape the start of the acceleration
+			for (unsigned int i = 0; i < numExtraImpulses; ++i)
+			{
+				MoveSegment *seg = MoveSegment::Allocate(nullptr);
+				const float acceleration = params.shaped.acceleration * coefficients[i];
+				const float segTime = durations[i];
+				const float b = startSpeed/(-acceleration);
+				const float c = 2.0/acceleration;
+				const float segLen = (startSpeed + (0.5 * acceleration * segTime)) * segTime;
+				startDistance += segLen;
+				seg->SetNonLinear(segLen, segTime, b, c);
+				if (i == 0)
+				{
+					startAccelSegs = seg;
+				}
+				else
+				{
+					startAccelSegs->AddToTail(seg);
+				}
+				startSpeed += acceleration * segTime;
+			}
+			accumulatedSegTime += totalShapingClocks;
+		}
+
+		// Do the constant acceleration part
+		if (endDistance > startDistance)
+		{
+			endAccelSegs = MoveSegment::Allocate(endAccelSegs);
+			const float b = startSpeed/(-params.shaped.acceleration);
+			const float c = 2.0/params.shaped.acceleration;
+			endAccelSegs->SetNonLinear(endDistance - startDistance, params.shaped.accelClocks - accumulatedSegTime, b, c);
+		}
+		else if (reprap.Debug(moduleMove))
+		{
+			debugPrintf("Missing steady accel segment\n");
+			params.shapingPlan.debugPrint = true;
+		}
+
+		if (startAccelSegs == nullptr)
+		{
+			return endAccelSegs;
+		}
+
+		if (endAccelSegs != nullptr)
+		{
+			startAccelSegs->AddToTail(endAccelSegs);
+		}
+		return startAccelSegs;
+	}
+
+	return nullptr;
+}
+
+// If there is a deceleration phase, generate the deceleration segments according to the plan, and set the number of deceleration segments in the plan
+MoveSegment *InputShaper::GetDecelerationSegments(const DDA& dda, PrepParams& params) const noexcept
+{
+	if (params.shaped.decelStartDistance < dda.totalDistance)
+	{
+		if (params.shapingPlan.shapeDecelOverlapped)
+		{
+			MoveSegment *decelSegs = nullptr;
+			float segStartSpeed = dda.endSpeed;
+			for (unsigned int i = 2 * numExtraImpulses; i != 0; )
+			{
+				--i;
+				decelSegs = MoveSegment::Allocate(decelSegs);
+				const float deceleration = params.shaped.deceleration * overlappedCoefficients[i];
+				const float segTime = overlappedDurations[i];
+				segStartSpeed += deceleration * segTime;
+				const float b = segStartSpeed/deceleration;
+				const float c = -2.0/deceleration;
+				const float segLen = (segStartSpeed + (-0.5 * deceleration * segTime)) * segTime;
+				decelSegs->SetNonLinear(segLen, segTime, b, c);
+			}
+			return decelSegs;
+		}
+
+		float accumulatedSegTime = 0.0;
+		float endDistance = dda.totalDistance;
+		MoveSegment *endDecelSegs = nullptr;
+		if (params.shapingPlan.shapeDecelEnd)
+		{
+			// Shape the end of the deceleration
+			float segStartSpeed = dda.endSpeed;
+			for (unsigned int i = numExtraImpulses; i != 0; )
+			{
+				--i;
+				endDecelSegs = MoveSegment::Allocate(endDecelSegs);
+				const float deceleration = params.shaped.deceleration * (1.0 - coefficients[i]);
+				const float segTime = durations[i];
+				segStartSpeed += deceleration * segTime;
+				const float b = segStartSpeed/deceleration;
+				const float c = -2.0/deceleration;
+				const float segLen = (segStartSpeed + (-0.5 * deceleration * segTime)) * segTime;
+				endDecelSegs->SetNonLinear(segLen, segTime, b, c);
+				endDistance -= segLen;
+			}
+			accumulatedSegTime += totalShapingClocks;
+		}
+
+		float startDistance = params.shaped.decelStartDistance;
+		float startSpeed = dda.topSpeed;
+		MoveSegment *startDecelSegs = nullptr;
+		if (params.shapingPlan.shapeDecelStart)
+		{
+			// Shape the start of the deceleration
+			for (unsigned int i = 0; i < numExtraImpulses; ++i)
+			{
+				MoveSegment *seg = MoveSegment::Allocate(nullptr);
+				const float deceleration = params.shaped.deceleration * coefficients[i];
+				const float segTime = durations[i];
+				const float b = startSpeed/deceleration;
+				const float c = -2.0/deceleration;
+				const float segLen = (startSpeed + (-0.5 * deceleration * segTime)) * segTime;
+				startDistance += segLen;
+				seg->SetNonLinear(segLen, segTime, b, c);
+				if (i == 0)
+				{
+					startDecelSegs = seg;
+				}
+				else
+				{
+					startDecelSegs->AddToTail(seg);
+				}
+				startSpeed -= deceleration * segTime;
+			}
+			accumulatedSegTime += totalShapingClocks;
+		}
+
+		// Do the constant deceleration part
+		if (endDistance > startDistance)
+		{
+			endDecelSegs = MoveSegment::Allocate(endDecelSegs);
+			const float b = startSpeed/params.shaped.deceleration;
+			const float c = -2.0/params.shaped.deceleration;
+			endDecelSegs->SetNonLinear(endDistance - startDistance, params.shaped.decelClocks - accumulatedSegTime, b, c);
+		}
+		else if (reprap.Debug(moduleMove))
+		{
+			debugPrintf("Missing steady decel segment\n");
+			params.shapingPlan.debugPrint = true;
+		}
+
+		if (startDecelSegs == nullptr)
+		{
+			return endDecelSegs;
+		}
+
+		if (endDecelSegs != nullptr)
+		{
+			startDecelSegs->AddToTail(endDecelSegs);
+		}
+		return startDecelSegs;
+	}
+
+	return nullptr;
+}
+
+// Generate the steady speed segment (if any), tack the segments together, and attach them to the DDA
+// Must set up params.steadyClocks before calling this
+MoveSegment *InputShaper::FinishShapedSegments(const DDA& dda, const PrepParams& params, MoveSegment *accelSegs, MoveSegment *decelSegs) const noexcept
+{
+	if (params.shaped.steadyClocks > 0.0)
+	{
+		// Insert a steady speed segment before the deceleration segments
+		decelSegs = MoveSegment::Allocate(decelSegs);
+		const float c = 1.0/dda.topSpeed;
+		decelSegs->SetLinear(params.shaped.decelStartDistance - params.shaped.accelDistance, params.shaped.steadyClocks, c);
+	}
+
+	if (accelSegs != nullptr)
+	{
+		if (decelSegs != nullptr)
+		{
+			accelSegs->AddToTail(decelSegs);
+		}
+		return accelSegs;
+	}
+
+	return decelSegs;
+}
+
+// Calculate the additional acceleration distance needed if we shape the start of acceleration
+inline float InputShaper::GetExtraAccelStartDistance(float startSpeed, float acceleration) const noexcept
+{
+	return (extraClocksAtStart * startSpeed) + (extraDistanceAtStart * acceleration);
+}
+
+// Calculate the additional acceleration distance needed if we shape the end of acceleration
+inline float InputShaper::GetExtraAccelEndDistance(float topSpeed, float acceleration) const noexcept
+{
+	return (extraClocksAtEnd * topSpeed) + (extraDistanceAtEnd * acceleration);
+}
+
+inline float InputShaper::GetExtraDecelStartDistance(float topSpeed, float deceleration) const noexcept
+{
+	return (extraClocksAtStart * topSpeed) - (extraDistanceAtStart * deceleration);
+}
+
+// Calculate the additional deceleration distance needed if we shape the end of deceleration
+inline float InputShaper::GetExtraDecelEndDistance(float endSpeed, float deceleration) const noexcept
+{
+	return (extraClocksAtEnd * endSpeed) - (extraDistanceAtEnd * deceleration);
+}
+
+// End
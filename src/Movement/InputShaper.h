@@ -0,0 +1,113 @@
+/*
+ * InputShaper.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * An input shaper of a particular type, frequency and damping ratio. The AxisShaper holds a bank of these so that different axes can be tuned to different resonances.
+ */
+
+#ifndef SRC_MOVEMENT_INPUTSHAPER_H_
+#define SRC_MOVEMENT_INPUTSHAPER_H_
+
+#define SUPPORT_DAA		(0)
+
+#include <RepRapFirmware.h>
+#include <General/NamedEnum.h>
+#include <ObjectModel/ObjectModel.h>
+#include "InputShaperPlan.h"
+
+// These names must be in alphabetical order and lowercase
+NamedEnum(InputShaperType, uint8_t,
+	custom,
+#if SUPPORT_DAA
+	daa,
+#endif
+	ei,
+	ei2,
+	ei3,
+	mzv,
+	none,
+	zv,
+	zvd,
+	zvdd,
+	zvddd,
+);
+
+class DDA;
+class PrepParams;
+class MoveSegment;
+
+class InputShaper INHERIT_OBJECT_MODEL
+{
+	friend class AxisShaper;
+
+public:
+	InputShaper() noexcept;
+
+	float GetFrequency() const noexcept { return frequency; }
+	float GetDamping() const noexcept { return zeta; }
+	InputShaperType GetType() const noexcept { return type; }
+	float GetTotalShapingClocks() const noexcept { return totalShapingClocks; }
+	AxesBitmap GetAxes() const noexcept { return axes; }
+	void SetAxes(AxesBitmap p_axes) noexcept { axes = p_axes; }
+
+	GCodeResult Configure(GCodeBuffer& gb, const StringRef& reply, bool& seen) THROWS(GCodeException);	// process the shaping parameters of M593
+	void AppendDescription(const StringRef& reply) const noexcept;
+
+	MoveSegment *PlanShaping(DDA& dda, PrepParams& params, bool shapingEnabled) const noexcept;
+	MoveSegment *GetMatchingSegments(const DDA& dda, const PrepParams& params) const noexcept;
+
+protected:
+	DECLARE_OBJECT_MODEL
+	OBJECT_MODEL_ARRAY(amplitudes)
+	OBJECT_MODEL_ARRAY(durations)
+
+private:
+	void CalculateDerivedParameters() noexcept;
+	MoveSegment *GetAccelerationSegments(const DDA& dda, PrepParams& params) const noexcept;
+	MoveSegment *GetDecelerationSegments(const DDA& dda, PrepParams& params) const noexcept;
+	MoveSegment *FinishShapedSegments(const DDA& dda, const PrepParams& params, MoveSegment *accelSegs, MoveSegment *decelSegs) const noexcept;
+	float GetExtraAccelStartDistance(float startSpeed, float acceleration) const noexcept;
+	float GetExtraAccelEndDistance(float topSpeed, float acceleration) const noexcept;
+	float GetExtraDecelStartDistance(float topSpeed, float deceleration) const noexcept;
+	float GetExtraDecelEndDistance(float endSpeed, float deceleration) const noexcept;
+	void TryShapeAccelEnd(const DDA& dda, PrepParams& params) const noexcept;
+	void TryShapeAccelBoth(DDA& dda, PrepParams& params) const noexcept;
+	void TryShapeDecelStart(const DDA& dda, PrepParams& params) const noexcept;
+	void TryShapeDecelBoth(DDA& dda, PrepParams& params) const noexcept;
+	bool ImplementAccelShaping(const DDA& dda, PrepParams& params, float newAccelDistance, float newAccelClocks) const noexcept;
+	bool ImplementDecelShaping(const DDA& dda, PrepParams& params, float newDecelStartDistance, float newDecelClocks) const noexcept;
+	bool TryMatchAccel(const DDA& dda, const PrepParams& plannedParams, PrepParams& params) const noexcept;
+	bool TryMatchDecel(const DDA& dda, const PrepParams& plannedParams, PrepParams& params) const noexcept;
+
+	static constexpr unsigned int MaxExtraImpulses = 4;
+	static constexpr float DefaultFrequency = 40.0;
+	static constexpr float DefaultDamping = 0.1;
+	static constexpr float DefaultMinimumAcceleration = 10.0;
+	static constexpr float MinimumMiddleSegmentTime = 5.0/1000.0;	// minimum length of the segment between shaped start and shaped end of an acceleration or deceleration
+
+	unsigned int numExtraImpulses;						// the number of extra impulses
+	float frequency;									// the undamped frequency in Hz
+	float zeta;											// the damping ratio, see https://en.wikipedia.org/wiki/Damping. 0 = undamped, 1 = critically damped.
+	float minimumAcceleration;							// the minimum value that we reduce average acceleration to in mm/sec^2
+	float coefficients[MaxExtraImpulses];				// the coefficients of all the impulses
+	float durations[MaxExtraImpulses];					// the duration in step clocks of each impulse
+	float totalShapingClocks;							// the total input shaping time in step clocks
+	float minimumShapingStartOriginalClocks;			// the minimum acceleration/deceleration time for which we can shape the start, without changing the acceleration/deceleration
+	float minimumShapingEndOriginalClocks;				// the minimum acceleration/deceleration time for which we can shape the start, without changing the acceleration/deceleration
+	float minimumNonOverlappedOriginalClocks;			// the minimum original acceleration or deceleration time using non-overlapped start and end shaping
+	float extraClocksAtStart;							// the extra time needed to shape the start of acceleration or deceleration
+	float extraClocksAtEnd;								// the extra time needed to shape the end of acceleration or deceleration
+	float extraDistanceAtStart;							// the extra distance per unit acceleration to shape the start of acceleration or deceleration, less the initial velocity contribution
+	float extraDistanceAtEnd;							// the extra distance per unit acceleration to shape the end of acceleration or deceleration, less the final velocity contribution
+	float overlappedDurations[2 * MaxExtraImpulses];	// the duration in step clocks of each impulse of an overlapped acceleration or deceleration
+	float overlappedCoefficients[2 * MaxExtraImpulses];	// the coefficients if we use a shaped start immediately followed by a shaped end
+	float overlappedShapingClocks;						// the acceleration or deceleration duration when we use overlapping, in step clocks
+	float overlappedDeltaVPerA;							// the effective acceleration time (velocity change per unit acceleration) when we use overlapping, in step clocks
+	float overlappedDistancePerA;						// the distance needed by an overlapped acceleration or deceleration, less the initial velocity contribution
+	AxesBitmap axes;									// the axes that this shaper is dedicated to, empty for the default shaper
+	InputShaperType type;
+};
+
+#endif /* SRC_MOVEMENT_INPUTSHAPER_H_ */
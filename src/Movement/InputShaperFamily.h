@@ -0,0 +1,111 @@
+/*
+ * InputShaperFamily.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Each standard type of input shaper is a family of impulse sequences parameterised by the damping ratio of the resonance that it cancels.
+ * The families are described by the constexpr generator functions in this file, so that the table of them is built at compile time and lives in flash memory.
+ * When the user configures a shaper we only need to evaluate the family for the requested damping ratio and scale the times by the damped period.
+ */
+
+#ifndef SRC_MOVEMENT_INPUTSHAPERFAMILY_H_
+#define SRC_MOVEMENT_INPUTSHAPERFAMILY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+struct InputShaperFamily
+{
+	static constexpr size_t MaxImpulses = 5;				// the initial impulse plus up to 4 extra ones
+	static constexpr size_t NumTerms = 4;					// we use polynomials in zeta up to zeta^3
+
+	enum class Form : uint8_t
+	{
+		none = 0,		// not a standard shaper, e.g. 'none' or 'custom'
+		damped,			// impulse i has amplitude amplitudes[i][0] * K^(2 * times[i][0]) where K = exp(-zeta * pi/sqrt(1 - zeta^2)) and occurs times[i][0] damped periods after the first
+		fitted			// impulse i has amplitude and time (in damped periods) given by polynomials in zeta with coefficients amplitudes[i][] and times[i][]
+	};
+
+	Form form;
+	uint8_t numImpulses;
+	float amplitudes[MaxImpulses][NumTerms];				// amplitudes are normalised to sum to 1 when the family is evaluated
+	float times[MaxImpulses][NumTerms];
+};
+
+// Generator for shapers that we don't evaluate from the table
+constexpr InputShaperFamily MakeNoShaperFamily() noexcept
+{
+	return InputShaperFamily{};
+}
+
+// Generator for ZV, ZVD, ZVDD etc. The amplitudes are the terms of the binomial expansion of (1 + K)^(numDerivatives + 1) and the impulses are half a damped period apart.
+// See https://www.researchgate.net/publication/316556412_INPUT_SHAPING_CONTROL_TO_REDUCE_RESIDUAL_VIBRATION_OF_A_FLEXIBLE_BEAM
+constexpr InputShaperFamily MakeZvShaperFamily(unsigned int numDerivatives) noexcept
+{
+	InputShaperFamily family{};
+	family.form = InputShaperFamily::Form::damped;
+	family.numImpulses = numDerivatives + 2;
+	float binomialCoefficient = 1.0;
+	for (unsigned int i = 0; i < family.numImpulses; ++i)
+	{
+		family.amplitudes[i][0] = binomialCoefficient;
+		family.times[i][0] = 0.5 * i;
+		binomialCoefficient = (binomialCoefficient * (float)(family.numImpulses - 1 - i))/(float)(i + 1);
+	}
+	return family;
+}
+
+// Generator for MZV. I can't find any references in the literature to this input shaper type, so the values are taken from Klipper source code.
+// Klipper gives amplitudes of [a1 = 1 - 1/sqrt(2), a2 = k * (sqrt(2) - 1), a3 = k^2 * (1 - 1/sqrt(2))] where k = K^0.75, at 3/8 damped period intervals.
+constexpr InputShaperFamily MakeMzvShaperFamily() noexcept
+{
+	constexpr float Sqrt2 = 1.41421356;
+	InputShaperFamily family{};
+	family.form = InputShaperFamily::Form::damped;
+	family.numImpulses = 3;
+	family.amplitudes[0][0] = family.amplitudes[2][0] = 1.0 - 0.5 * Sqrt2;
+	family.amplitudes[1][0] = Sqrt2 - 1.0;
+	family.times[0][0] = 0.0;
+	family.times[1][0] = 0.375;
+	family.times[2][0] = 0.75;
+	return family;
+}
+
+// Generator for the single-hump extra-insensitive shaper, which allows residual vibration up to the specified fraction over a wider range of frequencies than ZVD
+constexpr InputShaperFamily MakeEiShaperFamily(float vibrationTolerance) noexcept
+{
+	InputShaperFamily family{};
+	family.form = InputShaperFamily::Form::damped;
+	family.numImpulses = 3;
+	family.amplitudes[0][0] = family.amplitudes[2][0] = 0.25 * (1.0 + vibrationTolerance);
+	family.amplitudes[1][0] = 0.5 * (1.0 - vibrationTolerance);
+	family.times[0][0] = 0.0;
+	family.times[1][0] = 0.5;
+	family.times[2][0] = 1.0;
+	return family;
+}
+
+// Generator for shapers whose impulse amplitudes and times have been fitted to cubic polynomials in zeta.
+// We are passed the polynomials for all amplitudes except the last and for the times of all impulses except the first, which is at time zero.
+// The last amplitude is whatever is needed to make the amplitudes sum to 1.
+template<size_t N> constexpr InputShaperFamily MakeFittedShaperFamily(const float (&amplitudes)[N][InputShaperFamily::NumTerms], const float (&times)[N][InputShaperFamily::NumTerms]) noexcept
+{
+	static_assert(N < InputShaperFamily::MaxImpulses, "too many impulses");
+	InputShaperFamily family{};
+	family.form = InputShaperFamily::Form::fitted;
+	family.numImpulses = N + 1;
+	family.amplitudes[N][0] = 1.0;
+	for (size_t i = 0; i < N; ++i)
+	{
+		for (size_t j = 0; j < InputShaperFamily::NumTerms; ++j)
+		{
+			family.amplitudes[i][j] = amplitudes[i][j];
+			family.amplitudes[N][j] -= amplitudes[i][j];
+			family.times[i + 1][j] = times[i][j];
+		}
+	}
+	return family;
+}
+
+#endif /* SRC_MOVEMENT_INPUTSHAPERFAMILY_H_ */
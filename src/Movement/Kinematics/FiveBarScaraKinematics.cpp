@@ -690,7 +690,8 @@ bool FiveBarScaraKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, cons
 		// optional rectangle definition of a print area. Must match the workmode reachable area
 		//TODO is this needed? Why not use the M208 limits instead?
 		bool seenNonGeometry = TryConfigureSegmentation(gb);
-		if (gb.Seen('Z'))
+		const bool seenPrintArea = gb.Seen('Z');
+		if (seenPrintArea)
 		{
 			float coordinates[4];
 			gb.TryGetFloatArray('Z', 4, coordinates, reply, seenNonGeometry);
@@ -700,21 +701,37 @@ bool FiveBarScaraKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, cons
 			}
 			printAreaDefined = true;
 		}
-		else
-		{
-			printAreaDefined = false;
-		}
+
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		const bool seenTable = ikTable.TryConfigure(gb);
+#endif
 
 		if (seen)
 		{
 			Recalc();
 		}
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		else if (seenTable || seenPrintArea)
+		{
+			BuildLookupTable();
+		}
+#endif
 		else if (!seenNonGeometry && !gb.Seen('K'))
 		{
 			//TODO print all the parameters here
 			Kinematics::Configure(mCode, gb, reply, error);
 			reply.catf(", documented in https://duet3d.dozuki.com/Guide/Five+Bar+Parallel+SCARA/24?lang=en");
 		}
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		if (seenTable)
+		{
+			ikTable.AppendDescription(reply);
+			if (!ikTable.IsBuilt() && ikTable.IsEnabled())
+			{
+				reply.cat(" (the table needs a print area defined by the Z parameter)");
+			}
+		}
+#endif
 
 		return seen;
 	}
@@ -745,16 +762,27 @@ LimitPositionResult FiveBarScaraKinematics::LimitPosition(float coords[], const
 bool FiveBarScaraKinematics::CartesianToMotorSteps(const float machinePos[], const float stepsPerMm[],
 													size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) const noexcept
 {
-	float coords[2] = { machinePos[0], machinePos[1] };
-	getInverse(coords);
-
-	if (!constraintsOk(coords))
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	float thetas[2];
+	if (ikTable.Lookup(machinePos[0], machinePos[1], thetas))
 	{
-		return false;
+		motorPos[X_AXIS] = lrintf(thetas[0] * stepsPerMm[X_AXIS]);
+		motorPos[Y_AXIS] = lrintf(thetas[1] * stepsPerMm[Y_AXIS]);
 	}
+	else
+#endif
+	{
+		float coords[2] = { machinePos[0], machinePos[1] };
+		getInverse(coords);
 
-	motorPos[X_AXIS] = lrintf(cachedThetaL * stepsPerMm[X_AXIS]);
-	motorPos[Y_AXIS] = lrintf(cachedThetaR * stepsPerMm[Y_AXIS]);
+		if (!constraintsOk(coords))
+		{
+			return false;
+		}
+
+		motorPos[X_AXIS] = lrintf(cachedThetaL * stepsPerMm[X_AXIS]);
+		motorPos[Y_AXIS] = lrintf(cachedThetaR * stepsPerMm[Y_AXIS]);
+	}
 	motorPos[Z_AXIS] = lrintf(machinePos[Z_AXIS] * stepsPerMm[Z_AXIS]);
 
 	// Transform any additional axes linearly
@@ -946,11 +974,49 @@ AxesBitmap FiveBarScaraKinematics::GetConnectedAxes(size_t axis) const noexcept
 // Recalculate the derived parameters
 void FiveBarScaraKinematics::Recalc() noexcept
 {
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	if (ikTable.IsEnabled())
+	{
+		BuildLookupTable();
+	}
+#endif
 	cachedX0 = std::numeric_limits<float>::quiet_NaN(); // make sure that the cached values won't match any coordinates
 	cachedY0 = std::numeric_limits<float>::quiet_NaN(); // make sure that the cached values won't match any coordinates
 	cachedInvalid = true;
 }
 
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+// Build the inverse kinematics table. We only know the reachable area if the print area has been defined.
+// Cells are only used if the constraints are satisfied at all the points that we check in them.
+void FiveBarScaraKinematics::BuildLookupTable() noexcept
+{
+	if (printAreaDefined)
+	{
+		ikTable.Build(min<float>(printArea[0], printArea[2]), max<float>(printArea[0], printArea[2]),
+						min<float>(printArea[1], printArea[3]), max<float>(printArea[1], printArea[3]),
+						[this](float x, float y, float results[2]) noexcept -> bool
+						{
+							const float coords[2] = { x, y };
+							getInverse(coords);
+							if (!constraintsOk(coords))
+							{
+								return false;
+							}
+							results[0] = cachedThetaL;
+							results[1] = cachedThetaR;
+							return true;
+						}
+					 );
+	}
+	else
+	{
+		ikTable.Free();
+	}
+}
+
+#endif
+
 #endif // SUPPORT_FIVEBARSCARA
 
 // End
@@ -11,6 +11,7 @@
 #define SRC_MOVEMENT_KINEMATICS_FIVEBARSCARAKINEMATICS_H_
 
 #include "ZLeadscrewKinematics.h"
+#include "KinematicsLookupTable.h"
 
 #if SUPPORT_FIVEBARSCARA
 
@@ -64,6 +65,9 @@ private:
     float getTurn(float x1, float y1, float x2, float y2, float x3, float y3) const noexcept;
 	bool isPointInsideDefinedPrintableArea(float x0, float y0) const noexcept;
 	bool constraintsOk(const float coords[]) const noexcept;
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	void BuildLookupTable() noexcept;
+#endif
 
 	// Primary parameters
 	float xOrigL;
@@ -95,6 +99,9 @@ private:
 	float actuatorAngleRMax;
 
 	// Derived parameters
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	KinematicsLookupTable ikTable;		// actuator angles at grid points within the print area
+#endif
 
 	// State variables
 	mutable float cachedX0, cachedY0;
@@ -0,0 +1,206 @@
+/*
+ * KinematicsLookupTable.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "KinematicsLookupTable.h"
+
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+#include <GCodes/GCodeBuffer/GCodeBuffer.h>
+
+#include <limits>
+
+KinematicsLookupTable::KinematicsLookupTable() noexcept
+	: requestedSpacing(0.0), maxPermittedError(DefaultKinematicsLookupTableMaxError),
+	  xMin(0.0), yMin(0.0), spacing(0.0), recipSpacing(0.0), maxError(0.0), numX(0), numY(0), numUsableCells(0),
+	  nodeValues(nullptr), usableCells(nullptr)
+{
+}
+
+// Process the table parameters of M669, returning true if any were seen. The caller must rebuild the table if they were.
+// G is the grid spacing in mm, or 0 to disable the table. Spacings smaller than MinKinematicsLookupTableSpacing are increased to it. E is the maximum permitted interpolation error in degrees or mm.
+bool KinematicsLookupTable::TryConfigure(GCodeBuffer& gb) THROWS(GCodeException)
+{
+	bool seen = false;
+	if (gb.Seen('G'))
+	{
+		seen = true;
+		const float newSpacing = gb.GetFValue();
+		requestedSpacing = (newSpacing > 0.0) ? max<float>(newSpacing, MinKinematicsLookupTableSpacing) : 0.0;		// the reply reports the spacing actually used
+	}
+	gb.TryGetFValue('E', maxPermittedError, seen);
+	if (seen && !IsEnabled())
+	{
+		Free();
+	}
+	return seen;
+}
+
+// Release the memory used by the table
+void KinematicsLookupTable::Free() noexcept
+{
+	delete[] nodeValues;
+	nodeValues = nullptr;
+	delete[] usableCells;
+	usableCells = nullptr;
+	numX = numY = numUsableCells = 0;
+}
+
+// Build the table to cover the specified rectangle, using the supplied function to calculate the exact motor positions
+void KinematicsLookupTable::Build(float p_xMin, float p_xMax, float p_yMin, float p_yMax, CalcFunction calc) noexcept
+{
+	Free();
+	if (!IsEnabled() || !(p_xMax > p_xMin) || !(p_yMax > p_yMin))
+	{
+		return;
+	}
+
+	// If the requested spacing needs too many grid points, increase it until the table fits.
+	// Start from the spacing that would give the maximum number of grid points if there were no rounding, so that we can't overflow when calculating the table size.
+	spacing = max<float>(requestedSpacing, sqrtf((p_xMax - p_xMin) * (p_yMax - p_yMin)/MaxKinematicsLookupTableNodes));
+	for (;;)
+	{
+		numX = (size_t)ceilf((p_xMax - p_xMin)/spacing) + 1;
+		numY = (size_t)ceilf((p_yMax - p_yMin)/spacing) + 1;
+		if (numX * numY <= MaxKinematicsLookupTableNodes)
+		{
+			break;
+		}
+		spacing *= 1.05;
+	}
+	recipSpacing = 1.0/spacing;
+	xMin = p_xMin;
+	yMin = p_yMin;
+
+	const size_t numCells = (numX - 1) * (numY - 1);
+	nodeValues = new float[2 * numX * numY];
+	usableCells = new uint32_t[(numCells + 31)/32];
+	memset(usableCells, 0, ((numCells + 31)/32) * sizeof(uint32_t));
+
+	// Calculate the motor positions at the grid points, flagging unreachable ones with NaN
+	float *p = nodeValues;
+	for (size_t iy = 0; iy < numY; ++iy)
+	{
+		const float y = yMin + iy * spacing;
+		for (size_t ix = 0; ix < numX; ++ix)
+		{
+			if (!calc(xMin + ix * spacing, y, p))
+			{
+				p[0] = p[1] = std::numeric_limits<float>::quiet_NaN();
+			}
+			p += 2;
+		}
+	}
+
+	// Decide which cells we can use. We estimate the interpolation error at the middle of each cell and at the middle of each of its sides.
+	// A cell that straddles a discontinuity in the motor positions has a large error at one or more of these points, so we don't use it.
+	static constexpr float SamplePoints[5][2] = { { 0.5, 0.5 }, { 0.5, 0.0 }, { 0.0, 0.5 }, { 1.0, 0.5 }, { 0.5, 1.0 } };
+	maxError = 0.0;
+	for (size_t iy = 0; iy + 1 < numY; ++iy)
+	{
+		for (size_t ix = 0; ix + 1 < numX; ++ix)
+		{
+			const float *const corner = nodeValues + 2 * (iy * numX + ix);
+			if (std::isnan(corner[0]) || std::isnan(corner[2]) || std::isnan(corner[2 * numX]) || std::isnan(corner[2 * numX + 2]))
+			{
+				continue;
+			}
+
+			float cellError = 0.0;
+			for (const float (&sample)[2] : SamplePoints)
+			{
+				float interpolated[2];
+				Interpolate(corner, sample[0], sample[1], interpolated);
+				const float err = CheckInterpolationError(xMin + (ix + sample[0]) * spacing, yMin + (iy + sample[1]) * spacing, interpolated, calc);
+				if (!(err <= maxPermittedError))
+				{
+					cellError = std::numeric_limits<float>::infinity();
+					break;
+				}
+				cellError = max<float>(cellError, err);
+			}
+
+			if (cellError <= maxPermittedError)
+			{
+				SetCellUsable(iy * (numX - 1) + ix);
+				++numUsableCells;
+				maxError = max<float>(maxError, cellError);
+			}
+		}
+	}
+}
+
+// Return the largest difference between the interpolated and exact motor positions at a point, or NaN if the point is not reachable
+float KinematicsLookupTable::CheckInterpolationError(float x, float y, const float interpolated[2], CalcFunction calc) const noexcept
+{
+	float exact[2];
+	if (!calc(x, y, exact))
+	{
+		return std::numeric_limits<float>::quiet_NaN();
+	}
+	return max<float>(fabsf(exact[0] - interpolated[0]), fabsf(exact[1] - interpolated[1]));
+}
+
+// Look up the motor positions at a point. Return true if successful, false if the point is not in a usable cell of the table.
+bool KinematicsLookupTable::Lookup(float x, float y, float results[2]) const noexcept
+{
+	if (nodeValues == nullptr)
+	{
+		return false;
+	}
+
+	const float fx = (x - xMin) * recipSpacing;
+	const float fy = (y - yMin) * recipSpacing;
+	if (!(fx >= 0.0 && fy >= 0.0))								// this also catches NaNs
+	{
+		return false;
+	}
+
+	size_t ix = (size_t)fx;
+	if (ix + 1 >= numX)
+	{
+		if (fx > (float)(numX - 1))
+		{
+			return false;
+		}
+		ix = numX - 2;											// the point is on the high X edge of the table
+	}
+	size_t iy = (size_t)fy;
+	if (iy + 1 >= numY)
+	{
+		if (fy > (float)(numY - 1))
+		{
+			return false;
+		}
+		iy = numY - 2;											// the point is on the high Y edge of the table
+	}
+
+	if (!IsCellUsable(iy * (numX - 1) + ix))
+	{
+		return false;
+	}
+
+	Interpolate(nodeValues + 2 * (iy * numX + ix), fx - (float)ix, fy - (float)iy, results);
+	return true;
+}
+
+// Append the table details and the estimated error bound to a M669 report
+void KinematicsLookupTable::AppendDescription(const StringRef& reply) const noexcept
+{
+	if (IsBuilt())
+	{
+		reply.catf("IK table %ux%u points at %.2fmm spacing, %u of %u cells usable, max. interpolation error %.4f",
+					numX, numY, (double)spacing, numUsableCells, (numX - 1) * (numY - 1), (double)maxError);
+	}
+	else if (IsEnabled())
+	{
+		reply.cat("IK table not built");
+	}
+}
+
+#endif // SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+// End
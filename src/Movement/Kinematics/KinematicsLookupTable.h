@@ -0,0 +1,79 @@
+/*
+ * KinematicsLookupTable.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * An interpolated inverse kinematics table for machines whose X and Y motor positions depend only on the X and Y coordinates.
+ * The table holds the two motor positions at each point of a square grid. It is built when the kinematics are configured by M669,
+ * after which converting a segment end point to motor positions needs a bilinear interpolation instead of several trig functions and square roots.
+ * Cells that include an unreachable point, or that straddle a discontinuity such as an atan2 branch cut, or whose interpolation error exceeds
+ * the permitted maximum are marked unusable, so that the caller falls back to the exact calculation for points in them.
+ */
+
+#ifndef SRC_MOVEMENT_KINEMATICS_KINEMATICSLOOKUPTABLE_H_
+#define SRC_MOVEMENT_KINEMATICS_KINEMATICSLOOKUPTABLE_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+#include <General/function_ref.h>
+
+class KinematicsLookupTable
+{
+public:
+	// Function to calculate the exact motor positions at a point. It returns false if the point is not reachable.
+	typedef function_ref<bool(float x, float y, float results[2]) /*noexcept*/> CalcFunction;
+
+	KinematicsLookupTable() noexcept;
+	~KinematicsLookupTable() { Free(); }
+
+	KinematicsLookupTable(const KinematicsLookupTable&) = delete;
+	KinematicsLookupTable& operator=(const KinematicsLookupTable&) = delete;
+
+	bool TryConfigure(GCodeBuffer& gb) THROWS(GCodeException);		// process the table parameters of M669
+	bool IsEnabled() const noexcept { return requestedSpacing > 0.0; }
+	bool IsBuilt() const noexcept { return nodeValues != nullptr; }
+
+	void Build(float xMin, float xMax, float yMin, float yMax, CalcFunction calc) noexcept;
+	void Free() noexcept;
+	bool Lookup(float x, float y, float results[2]) const noexcept;
+	void AppendDescription(const StringRef& reply) const noexcept;
+
+private:
+	bool IsCellUsable(size_t cell) const noexcept { return (usableCells[cell >> 5] & (1u << (cell & 31))) != 0; }
+	void SetCellUsable(size_t cell) noexcept { usableCells[cell >> 5] |= 1u << (cell & 31); }
+	void Interpolate(const float *corner, float tx, float ty, float results[2]) const noexcept;
+	float CheckInterpolationError(float x, float y, const float interpolated[2], CalcFunction calc) const noexcept;
+
+	// Configured parameters
+	float requestedSpacing;							// the grid spacing that the user asked for, or zero if the table is disabled
+	float maxPermittedError;						// cells with a greater estimated interpolation error than this are not used
+
+	// Parameters of the current table
+	float xMin, yMin;								// the coordinates of grid point (0, 0)
+	float spacing;									// the grid spacing actually used
+	float recipSpacing;
+	float maxError;									// the largest estimated interpolation error of the usable cells
+	size_t numX, numY;								// the number of grid points in each direction
+	size_t numUsableCells;
+	float *nodeValues;								// pairs of motor positions, row by row with X varying fastest
+	uint32_t *usableCells;							// bitmap of cells that may be interpolated
+};
+
+// Bilinear interpolation within the cell whose low X, low Y grid point is 'corner'. 'tx' and 'ty' are the fractional position within the cell.
+inline void KinematicsLookupTable::Interpolate(const float *corner, float tx, float ty, float results[2]) const noexcept
+{
+	const float *const above = corner + 2 * numX;
+	for (size_t i = 0; i < 2; ++i)
+	{
+		const float low = corner[i] + (corner[i + 2] - corner[i]) * tx;
+		const float high = above[i] + (above[i + 2] - above[i]) * tx;
+		results[i] = low + (high - low) * ty;
+	}
+}
+
+#endif // SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+#endif /* SRC_MOVEMENT_KINEMATICS_KINEMATICSLOOKUPTABLE_H_ */
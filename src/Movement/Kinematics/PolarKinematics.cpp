@@ -100,17 +100,40 @@ bool PolarKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const Strin
 			seenNonGeometry = true;
 		}
 
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		const bool seenTable = ikTable.TryConfigure(gb);
+#endif
+
 		if (seen)
 		{
 			Recalc();
 		}
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		else if (seenTable)
+		{
+			BuildLookupTable();
+		}
+#endif
 		else if (!seenNonGeometry && !gb.Seen('K'))
 		{
 			Kinematics::Configure(mCode, gb, reply, error);
 			reply.catf(", radius %.1f to %.1fmm, homed radius %.1fmm, max table acc. %.1fdeg/sec^2, max table speed %.1fdeg/sec",
 							(double)minRadius, (double)maxRadius, (double)homedRadius,
 							(double)InverseConvertAcceleration(maxTurntableAcceleration), (double)InverseConvertSpeedToMmPerSec(maxTurntableSpeed));
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+			if (ikTable.IsEnabled())
+			{
+				reply.cat(", ");
+				ikTable.AppendDescription(reply);
+			}
+#endif
+		}
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		if (seenTable)
+		{
+			ikTable.AppendDescription(reply);
 		}
+#endif
 		return seen;
 	}
 	else
@@ -127,8 +150,19 @@ bool PolarKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const Strin
 // Return true if successful, false if we were unable to convert
 bool PolarKinematics::CartesianToMotorSteps(const float machinePos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) const noexcept
 {
-	motorPos[0] = lrintf(fastSqrtf(fsquare(machinePos[0]) + fsquare(machinePos[1])) * stepsPerMm[0]);
-	motorPos[1] = (motorPos[0] == 0.0) ? 0 : lrintf(atan2f(machinePos[1], machinePos[0]) * RadiansToDegrees * stepsPerMm[1]);
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	float radiusAndAngle[2];
+	if (ikTable.Lookup(machinePos[0], machinePos[1], radiusAndAngle))
+	{
+		motorPos[0] = lrintf(radiusAndAngle[0] * stepsPerMm[0]);
+		motorPos[1] = (motorPos[0] == 0) ? 0 : lrintf(radiusAndAngle[1] * stepsPerMm[1]);
+	}
+	else
+#endif
+	{
+		motorPos[0] = lrintf(fastSqrtf(fsquare(machinePos[0]) + fsquare(machinePos[1])) * stepsPerMm[0]);
+		motorPos[1] = (motorPos[0] == 0.0) ? 0 : lrintf(atan2f(machinePos[1], machinePos[0]) * RadiansToDegrees * stepsPerMm[1]);
+	}
 
 	// Transform remaining axes linearly
 	for (size_t axis = Z_AXIS; axis < numVisibleAxes; ++axis)
@@ -340,8 +374,31 @@ void PolarKinematics::Recalc()
 {
 	minRadiusSquared = (minRadius <= 0.0) ? 0.0 : fsquare(minRadius);
 	maxRadiusSquared = fsquare(maxRadius);
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	if (ikTable.IsEnabled())
+	{
+		BuildLookupTable();
+	}
+#endif
 }
 
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+// Build the inverse kinematics table. Cells close to the centre of the turntable have large angle errors, so they will not be used.
+void PolarKinematics::BuildLookupTable() noexcept
+{
+	ikTable.Build(-maxRadius, maxRadius, -maxRadius, maxRadius,
+					[](float x, float y, float results[2]) noexcept -> bool
+					{
+						results[0] = fastSqrtf(fsquare(x) + fsquare(y));
+						results[1] = atan2f(y, x) * RadiansToDegrees;
+						return true;
+					}
+				 );
+}
+
+#endif
+
 #endif // SUPPORT_POLAR
 
 // End
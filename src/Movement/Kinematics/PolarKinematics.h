@@ -9,6 +9,7 @@
 #define SRC_MOVEMENT_KINEMATICS_POLARKINEMATICS_H_
 
 #include "Kinematics.h"
+#include "KinematicsLookupTable.h"
 
 #if SUPPORT_POLAR
 
@@ -46,11 +47,18 @@ private:
 	static constexpr const char *HomeBedFileName = "homebed.g";
 
 	void Recalc();
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	void BuildLookupTable() noexcept;
+#endif
 
 	float minRadius, maxRadius, homedRadius;
 	float maxTurntableSpeed, maxTurntableAcceleration;
 
 	float minRadiusSquared, maxRadiusSquared;
+
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	KinematicsLookupTable ikTable;					// radius and turntable angle at grid points
+#endif
 };
 
 #endif // SUPPORT_POLAR
@@ -145,12 +145,24 @@ bool ScaraKinematics::CartesianToMotorSteps(const float machinePos[], const floa
 	}
 	else
 	{
-		bool armMode = currentArmMode;
-		if (!CalculateThetaAndPsi(machinePos, isCoordinated, theta, psi, armMode))
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		// The table is only valid when the arm mode can't change
+		float angles[2];
+		if (isCoordinated && currentArmMode == ikTableArmMode && ikTable.Lookup(machinePos[X_AXIS], machinePos[Y_AXIS], angles))
 		{
-			return false;
+			theta = angles[0];
+			psi = angles[1];
+		}
+		else
+#endif
+		{
+			bool armMode = currentArmMode;
+			if (!CalculateThetaAndPsi(machinePos, isCoordinated, theta, psi, armMode))
+			{
+				return false;
+			}
+			currentArmMode = armMode;
 		}
-		currentArmMode = armMode;
 	}
 
 //debugPrintf("psi = %.2f, theta = %.2f\n", psi * RadiansToDegrees, theta * RadiansToDegrees);
@@ -219,11 +231,20 @@ bool ScaraKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const Strin
 			return true;
 		}
 		gb.TryGetFValue('R', requestedMinRadius, seen);
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		const bool seenTable = ikTable.TryConfigure(gb);
+#endif
 
 		if (seen)
 		{
 			Recalc();
 		}
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		else if (seenTable)
+		{
+			BuildLookupTable();
+		}
+#endif
 		else if (!seenNonGeometry && !gb.Seen('K'))
 		{
 			Kinematics::Configure(mCode, gb, reply, error);
@@ -233,7 +254,20 @@ bool ScaraKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const Strin
 							(double)distalArmLength, (double)psiLimits[0], (double)psiLimits[1], (supportsContinuousRotation[0]) ? " (continuous)" : "",
 							(double)crosstalk[0], (double)crosstalk[1], (double)crosstalk[2],
 							(double)xOffset, (double)yOffset);
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+			if (ikTable.IsEnabled())
+			{
+				reply.cat(", ");
+				ikTable.AppendDescription(reply);
+			}
+#endif
+		}
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+		if (seenTable)
+		{
+			ikTable.AppendDescription(reply);
 		}
+#endif
 		return seen;
 	}
 	else
@@ -494,9 +528,35 @@ void ScaraKinematics::Recalc() noexcept
 	}
 	maxRadius *= 0.995;
 
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	if (ikTable.IsEnabled())
+	{
+		BuildLookupTable();
+	}
+#endif
+
 	cachedX = cachedY = std::numeric_limits<float>::quiet_NaN();		// make sure that the cached values won't match any coordinates
 }
 
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+
+// Build the inverse kinematics table for the current arm mode. The table covers the square that encloses the reachable annulus.
+void ScaraKinematics::BuildLookupTable() noexcept
+{
+	ikTableArmMode = currentArmMode;
+	ikTable.Build(-xOffset - maxRadius, -xOffset + maxRadius, -yOffset - maxRadius, -yOffset + maxRadius,
+					[this](float x, float y, float results[2]) noexcept -> bool
+					{
+						const float coords[2] = { x, y };
+						bool armMode = ikTableArmMode;
+						return CalculateThetaAndPsi(coords, true, results[0], results[1], armMode);
+					}
+				 );
+	cachedX = cachedY = std::numeric_limits<float>::quiet_NaN();		// building the table overwrote the cached values
+}
+
+#endif
+
 #endif // SUPPORT_SCARA
 
 // End
@@ -9,6 +9,7 @@
 #define SRC_MOVEMENT_KINEMATICS_SCARAKINEMATICS_H_
 
 #include "ZLeadscrewKinematics.h"
+#include "KinematicsLookupTable.h"
 
 #if SUPPORT_SCARA
 
@@ -60,6 +61,9 @@ private:
 
 	void Recalc() noexcept;
 	bool CalculateThetaAndPsi(const float machinePos[], bool isCoordinated, float& theta, float& psi, bool& armMode) const noexcept;
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	void BuildLookupTable() noexcept;
+#endif
 
 	// Primary parameters
 	float proximalArmLength;
@@ -80,6 +84,11 @@ private:
 	float distalArmLengthSquared;
 	float twoPd;
 
+#if SUPPORT_KINEMATICS_LOOKUP_TABLES
+	KinematicsLookupTable ikTable;					// theta and psi at grid points, for coordinated moves in arm mode ikTableArmMode
+	bool ikTableArmMode;
+#endif
+
 	// State variables
 	mutable float cachedX, cachedY, cachedTheta, cachedPsi;
 	mutable bool currentArmMode, cachedArmMode;
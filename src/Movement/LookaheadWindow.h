@@ -0,0 +1,152 @@
+/*
+ * LookaheadWindow.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * A compact struct-of-arrays copy of the speed data of the chain of moves that we are adjusting during lookahead.
+ * DDAs are large objects, so when a long chain of tiny segments has to be adjusted, walking the linked list and recalculating the speeds of each one in turn is slow.
+ * Instead, we walk the list once to gather the moves, their junction speed limits and how each one may be adjusted.
+ * Then the backward pass that limits the target end speeds and the forward pass that propagates the start and end speeds both run as tight loops over the arrays.
+ * Entry 0 is the most recent move, i.e. the one that lookahead was started from. Higher entries are older moves.
+ */
+
+#ifndef SRC_MOVEMENT_LOOKAHEADWINDOW_H_
+#define SRC_MOVEMENT_LOOKAHEADWINDOW_H_
+
+#include <RepRapFirmware.h>
+
+class DDA;
+
+class LookaheadWindow
+{
+public:
+	// How the end speed of a move in the window may be adjusted
+	enum class MoveKind : uint8_t
+	{
+		reachesTopSpeed,				// the move already reaches its requested speed, so only its deceleration changes
+		chainedDeceleration,			// a deceleration-only move whose start speed we may raise by raising the end speed of the previous move, which is the next entry in the window
+		deceleration,					// a deceleration-only move whose start speed is fixed
+		other							// a move that doesn't reach its requested speed and isn't deceleration-only
+	};
+
+	LookaheadWindow() noexcept : numMoves(0) { }
+
+	void Clear() noexcept { numMoves = 0; }
+	bool IsFull() const noexcept { return numMoves == LookaheadWindowSize; }
+	size_t GetNumMoves() const noexcept { return numMoves; }
+
+	void AddMove(DDA *dda, MoveKind kind, float targetNextSpeed, float requestedSpeed, float junctionSpeedLimit, float startSpeed, float endSpeed,
+					float twiceAccelTimesDistance, float twiceDecelTimesDistance) noexcept;
+	bool LimitSpeeds() noexcept;
+	void PropagateSpeeds() noexcept;
+
+	DDA *GetMove(size_t n) const noexcept pre(n < numMoves) { return moves[n]; }
+	float GetTargetNextSpeed(size_t n) const noexcept pre(n < numMoves) { return targetNextSpeeds[n]; }
+	float GetStartSpeed(size_t n) const noexcept pre(n < numMoves) { return startSpeeds[n]; }
+	float GetEndSpeed(size_t n) const noexcept pre(n < numMoves) { return endSpeeds[n]; }
+
+private:
+	DDA *moves[LookaheadWindowSize];
+	MoveKind kinds[LookaheadWindowSize];
+	float targetNextSpeeds[LookaheadWindowSize];			// the junction speeds, limited by the backward pass and then reduced by the forward pass to what is reachable
+	float requestedSpeeds[LookaheadWindowSize];
+	float junctionSpeedLimits[LookaheadWindowSize];			// the highest end speed that the jerk limits allow at the junction with the following move
+	float startSpeeds[LookaheadWindowSize];
+	float endSpeeds[LookaheadWindowSize];
+	float twiceAccelTimesDistances[LookaheadWindowSize];	// 2 * acceleration * totalDistance, so that v^2 <= u^2 + this value
+	float twiceDecelTimesDistances[LookaheadWindowSize];	// 2 * deceleration * totalDistance
+	size_t numMoves;
+};
+
+inline void LookaheadWindow::AddMove(DDA *dda, MoveKind kind, float targetNextSpeed, float requestedSpeed, float junctionSpeedLimit, float startSpeed, float endSpeed,
+										float twiceAccelTimesDistance, float twiceDecelTimesDistance) noexcept
+pre(!IsFull())
+{
+	moves[numMoves] = dda;
+	kinds[numMoves] = kind;
+	targetNextSpeeds[numMoves] = targetNextSpeed;
+	requestedSpeeds[numMoves] = requestedSpeed;
+	junctionSpeedLimits[numMoves] = junctionSpeedLimit;
+	startSpeeds[numMoves] = startSpeed;
+	endSpeeds[numMoves] = endSpeed;
+	twiceAccelTimesDistances[numMoves] = twiceAccelTimesDistance;
+	twiceDecelTimesDistances[numMoves] = twiceDecelTimesDistance;
+	++numMoves;
+}
+
+// Backward pass. Starting from the most recent move, limit the target end speed of each move to its requested speed, the jerk limits and what it can reach.
+// Where a deceleration-only move is chained to the previous one, set the target end speed of the previous move to the highest start speed that lets this one decelerate to its target.
+// Return true if we had to reduce the target speed of the oldest move to what it can reach from its fixed start speed.
+inline bool LookaheadWindow::LimitSpeeds() noexcept
+{
+	bool reducedSpeed = false;
+	for (size_t n = 0; n < numMoves; ++n)
+	{
+		float targetNextSpeed = min<float>(targetNextSpeeds[n], requestedSpeeds[n]);
+		switch (kinds[n])
+		{
+		case MoveKind::chainedDeceleration:
+			targetNextSpeed = min<float>(targetNextSpeed, junctionSpeedLimits[n]);
+			if (n + 1 < numMoves)
+			{
+				const float maxStartSpeed = fastSqrtf(fsquare(targetNextSpeed) + twiceDecelTimesDistances[n]);
+				targetNextSpeeds[n + 1] = min<float>(maxStartSpeed, requestedSpeeds[n]);
+			}
+			break;
+
+		case MoveKind::deceleration:
+			{
+				const float maxReachableSpeed = fastSqrtf(fsquare(startSpeeds[n]) + twiceDecelTimesDistances[n]);
+				if (targetNextSpeed > maxReachableSpeed)
+				{
+					targetNextSpeed = maxReachableSpeed;
+					reducedSpeed = true;
+				}
+			}
+			targetNextSpeed = min<float>(targetNextSpeed, junctionSpeedLimits[n]);
+			break;
+
+		case MoveKind::other:
+			// Set the end speed to the minimum of the requested speed and the highest we can reach. If this is an acceleration segment then this ensures smooth acceleration.
+			targetNextSpeed = min<float>(targetNextSpeed, fastSqrtf(fsquare(startSpeeds[n]) + twiceAccelTimesDistances[n]));
+			targetNextSpeed = min<float>(targetNextSpeed, junctionSpeedLimits[n]);
+			break;
+
+		case MoveKind::reachesTopSpeed:
+		default:
+			targetNextSpeed = min<float>(targetNextSpeed, junctionSpeedLimits[n]);
+			break;
+		}
+		targetNextSpeeds[n] = targetNextSpeed;
+	}
+	return reducedSpeed;
+}
+
+// Forward pass. The oldest move in the window keeps its start speed. Each following move starts at the end speed of the one before it and its end speed is limited by its acceleration.
+// We never reduce an end speed here, because that may make the move infeasible; the caller reports a lookahead error if the target speed has fallen too far below the end speed.
+inline void LookaheadWindow::PropagateSpeeds() noexcept
+{
+	size_t n = numMoves;
+	float prevEndSpeed = 0.0;
+	while (n != 0)
+	{
+		--n;
+		if (n + 1 != numMoves)
+		{
+			startSpeeds[n] = prevEndSpeed;
+			const float maxEndSpeed = fastSqrtf(fsquare(prevEndSpeed) + twiceAccelTimesDistances[n]);
+			if (maxEndSpeed < targetNextSpeeds[n])
+			{
+				targetNextSpeeds[n] = maxEndSpeed;
+			}
+		}
+		if (targetNextSpeeds[n] >= endSpeeds[n])
+		{
+			endSpeeds[n] = targetNextSpeeds[n];
+		}
+		prevEndSpeed = endSpeeds[n];
+	}
+}
+
+#endif /* SRC_MOVEMENT_LOOKAHEADWINDOW_H_ */
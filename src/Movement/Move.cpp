@@ -35,6 +35,7 @@
 
 #include "Move.h"
 #include "StepTimer.h"
+#include "MoveArena.h"
 #include <Platform/Platform.h>
 #include <GCodes/GCodeBuffer/GCodeBuffer.h>
 #include <Tools/Tool.h>
@@ -106,7 +107,7 @@ constexpr ObjectModelTableEntry Move::objectModelTable[] =
 	{ "limitAxes",				OBJECT_MODEL_FUNC_NOSELF(reprap.GetGCodes().LimitAxes()),										ObjectModelEntryFlags::none },
 	{ "noMovesBeforeHoming",	OBJECT_MODEL_FUNC_NOSELF(reprap.GetGCodes().NoMovesBeforeHoming()),								ObjectModelEntryFlags::none },
 	{ "printingAcceleration",	OBJECT_MODEL_FUNC(InverseConvertAcceleration(self->maxPrintingAcceleration), 1),				ObjectModelEntryFlags::none },
-	{ "queue",					OBJECT_MODEL_FUNC_NOSELF(&queueArrayDescriptor),												ObjectModelEntryFlags::none },
+	{ "queue",					OBJECT_MODEL_FUNC_NOSELF(&queueArrayDescriptor),												ObjectModelEntryFlags::live },
 #if SUPPORT_COORDINATE_ROTATION
 	{ "rotation",				OBJECT_MODEL_FUNC(self, 44),																	ObjectModelEntryFlags::none },
 #endif
@@ -208,11 +209,14 @@ Move::Move() noexcept
 {
 	// Kinematics must be set up here because GCodes::Init asks the kinematics for the assumed initial position
 	kinematics = Kinematics::Create(KinematicsType::cartesian);		// default to Cartesian
-	mainDDARing.Init1(InitialDdaRingLength);
+	mainDDARing.Init1(InitialDdaRingLength, DefaultMaxDdaRingLength);
 #if SUPPORT_ASYNC_MOVES
-	auxDDARing.Init1(AuxDdaRingLength);
+	auxDDARing.Init1(AuxDdaRingLength, AuxDdaRingLength);
 #endif
 	DriveMovement::InitialAllocate(InitialNumDms);
+#if SUPPORT_NATIVE_ARCS
+	DriveMovement::InitArcTable();
+#endif
 }
 
 void Move::Init() noexcept
@@ -232,6 +236,9 @@ void Move::Init() noexcept
 
 	usingMesh = useTaper = false;
 	zShift = 0.0;
+	meshChordTolerance = DefaultMeshChordTolerance;
+	maxMeshChordDeviation = 0.0;
+	meshSegmentsSaved = 0;
 
 	idleTimeout = DefaultIdleTimeout;
 	moveState = MoveState::idle;
@@ -365,6 +372,7 @@ void Move::Exit() noexcept
 			{
 				whenIdleTimerStarted = millis();				// record when we first noticed that the machine was idle
 				moveState = MoveState::timing;
+				ReleaseArenaMemory();							// give back the memory that we used to lengthen the ring
 			}
 			else if (moveState == MoveState::timing && millis() - whenIdleTimerStarted >= idleTimeout)
 			{
@@ -444,6 +452,43 @@ bool Move::IsRawMotorMove(uint8_t moveType) const noexcept
 	return moveType == 2 || ((moveType == 1 || moveType == 3) && kinematics->GetHomingMode() != HomingMode::homeCartesianAxes);
 }
 
+#if SUPPORT_NATIVE_ARCS
+
+// Return true if we can execute an arc in the specified machine axes as a true arc.
+// This requires that each motor moves just one axis and that the axis and bed transforms don't change the shape of the arc.
+bool Move::CanUseNativeArcs(size_t axis0, size_t axis1) const noexcept
+{
+	if (kinematics->GetKinematicsType() != KinematicsType::cartesian || usingMesh || tanXY != 0.0 || tanYZ != 0.0 || tanXZ != 0.0)
+	{
+		return false;
+	}
+
+	const Platform& platform = reprap.GetPlatform();
+	for (size_t axis : { axis0, axis1 })
+	{
+		if (platform.IsAxisRotational(axis))
+		{
+			return false;
+		}
+
+# if SUPPORT_CAN_EXPANSION
+		// We can only send straight line moves to expansion boards
+		const AxisDriversConfig& config = platform.GetAxisDriversConfig(axis);
+		for (size_t i = 0; i < config.numDrivers; ++i)
+		{
+			if (config.driverNumbers[i].IsRemote())
+			{
+				return false;
+			}
+		}
+# endif
+	}
+
+	return true;
+}
+
+#endif
+
 // Return true if the specified point is accessible to the Z probe
 bool Move::IsAccessibleProbePoint(float axesCoords[MaxAxes], AxesBitmap axes) const noexcept
 {
@@ -480,6 +525,21 @@ void Move::Diagnostics(MessageType mtype) noexcept
 	p.MessageF(mtype, "=== Move ===\nDMs created %u, segments created %u, maxWait %" PRIu32 "ms, bed compensation in use: %s, comp offset %.3f\n",
 						DriveMovement::NumCreated(), MoveSegment::NumCreated(), longestGcodeWaitInterval, scratchString.c_str(), (double)zShift);
 	longestGcodeWaitInterval = 0;
+	if (meshChordTolerance > 0.0)
+	{
+		// GetMeshSegments may be updating the statistics in another task, so copy and reset them together
+		float maxDeviation;
+		uint32_t segmentsSaved;
+		{
+			TaskCriticalSectionLocker lock;
+			maxDeviation = maxMeshChordDeviation;
+			segmentsSaved = meshSegmentsSaved;
+			maxMeshChordDeviation = 0.0;
+			meshSegmentsSaved = 0;
+		}
+		p.MessageF(mtype, "Mesh chord tolerance %.3fmm, max deviation %.3fmm, segments saved %" PRIu32 "\n",
+							(double)meshChordTolerance, (double)maxDeviation, segmentsSaved);
+	}
 
 #if 0	// debug only
 	scratchString.copy("Steps requested/done:");
@@ -514,6 +574,12 @@ void Move::Diagnostics(MessageType mtype) noexcept
 	maxDelay = maxDelayIncrease = 0;
 #endif
 
+	{
+		String<StringLength100> arenaString;
+		MoveArena::Diagnostics(arenaString.GetRef());
+		p.MessageF(mtype, "%s\n", arenaString.c_str());
+	}
+
 #if SUPPORT_ASYNC_MOVES
 	mainDDARing.Diagnostics(mtype, "Main");
 	auxDDARing.Diagnostics(mtype, "Aux");
@@ -522,6 +588,17 @@ void Move::Diagnostics(MessageType mtype) noexcept
 #endif
 }
 
+// Give back to the heap the memory in the move arena that we used to lengthen the ring. Only call this when the rings are idle.
+void Move::ReleaseArenaMemory() noexcept
+{
+	mainDDARing.ReleaseArenaDdas();
+#if SUPPORT_ASYNC_MOVES
+	auxDDARing.ReleaseArenaDdas();
+#endif
+	DriveMovement::ReleaseArenaDMs();
+	MoveSegment::ReleaseArenaSegments();
+}
+
 // Set the current position to be this
 void Move::SetNewPosition(const float positionNow[MaxAxesPlusExtruders], bool doBedCompensation) noexcept
 {
@@ -685,6 +762,64 @@ float Move::ComputeHeightCorrection(float xyzPoint[MaxAxes], const Tool *tool) c
 	return zCorrection + zShift;
 }
 
+// Return the largest bed compensation error if the straight move between the specified machine coordinates is divided into the specified number of equal segments
+// and bed compensation is applied only at the ends of each segment. We consider each pair of axes that the tool maps to the grid axes, as ComputeHeightCorrection does.
+float Move::GetMeshChordDeviation(const float startCoords[MaxAxes], const float endCoords[MaxAxes], const Tool *tool, unsigned int numSegments) const noexcept
+{
+	float maxDeviation = 0.0;
+	const GridDefinition& grid = GetGrid();
+	const AxesBitmap axis1Axes = Tool::GetAxisMapping(tool, grid.GetAxisNumber(1));
+	const float recipNumSegments = 1.0/(float)numSegments;
+	Tool::GetAxisMapping(tool, grid.GetAxisNumber(0))
+		.Iterate([this, startCoords, endCoords, tool, axis1Axes, numSegments, recipNumSegments, &maxDeviation](unsigned int axis0Axis, unsigned int)
+					{
+						const float axis0Start = startCoords[axis0Axis] + Tool::GetOffset(tool, axis0Axis);
+						const float axis0Change = (endCoords[axis0Axis] - startCoords[axis0Axis]) * recipNumSegments;
+						axis1Axes.Iterate([this, startCoords, endCoords, tool, numSegments, recipNumSegments, axis0Start, axis0Change, &maxDeviation](unsigned int axis1Axis, unsigned int)
+											{
+												const float axis1Start = startCoords[axis1Axis] + Tool::GetOffset(tool, axis1Axis);
+												const float axis1Change = (endCoords[axis1Axis] - startCoords[axis1Axis]) * recipNumSegments;
+												for (unsigned int seg = 0; seg < numSegments; ++seg)
+												{
+													const float deviation = heightMap.GetChordDeviation(axis0Start + seg * axis0Change, axis1Start + seg * axis1Change,
+																										axis0Start + (seg + 1) * axis0Change, axis1Start + (seg + 1) * axis1Change);
+													maxDeviation = max<float>(maxDeviation, deviation);
+												}
+											}
+										);
+					}
+				);
+	return maxDeviation;
+}
+
+// Return how many segments the straight move between the specified machine coordinates needs for bed compensation.
+// 'maxSegments' is the number we get by dividing the move at every grid cell, which is the most we ever use.
+// Applying compensation to the ends of each segment makes each one a straight line in machine coordinates, so the compensation varies linearly along it.
+// On a delta printer the segment-free tower step calculation follows that line exactly, so we only need to divide the move where the mesh is curved along its path.
+// We try 1, 2, 4... segments until the largest compensation error is within the tolerance.
+unsigned int Move::GetMeshSegments(const float startCoords[MaxAxes], const float endCoords[MaxAxes], const Tool *tool, unsigned int maxSegments) noexcept
+{
+	if (meshChordTolerance <= 0.0 || maxSegments <= 1)
+	{
+		return maxSegments;
+	}
+
+	unsigned int numSegments = 1;
+	do
+	{
+		const float deviation = GetMeshChordDeviation(startCoords, endCoords, tool, numSegments);
+		if (deviation <= meshChordTolerance)
+		{
+			TaskCriticalSectionLocker lock;				// Diagnostics may be reading and resetting the statistics in another task
+			maxMeshChordDeviation = max<float>(maxMeshChordDeviation, deviation);
+			meshSegmentsSaved += maxSegments - numSegments;
+			return numSegments;
+		}
+		numSegments *= 2;
+	} while (numSegments < maxSegments);
+	return maxSegments;
+}
+
 // Do the bed transform AFTER the axis transform
 void Move::BedTransform(float xyzPoint[MaxAxes], const Tool *tool) const noexcept
 {
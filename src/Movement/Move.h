@@ -32,18 +32,24 @@
 constexpr unsigned int InitialDdaRingLength = 60;
 constexpr unsigned int AuxDdaRingLength = 5;
 const unsigned int InitialNumDms = (InitialDdaRingLength/2 * 4) + AuxDdaRingLength;
+constexpr unsigned int DefaultMaxDdaRingLength = 2 * InitialDdaRingLength;	// how long the main ring may grow using memory from the move arena
+constexpr size_t DefaultMoveArenaLimit = 48 * 1024;
 
 #elif SAM4E || SAM4S || SAME5x
 
 constexpr unsigned int InitialDdaRingLength = 40;
 constexpr unsigned int AuxDdaRingLength = 3;
 const unsigned int InitialNumDms = (InitialDdaRingLength/2 * 4) + AuxDdaRingLength;
+constexpr unsigned int DefaultMaxDdaRingLength = InitialDdaRingLength;		// don't grow the ring unless M595 Q is used, because we are short of RAM
+constexpr size_t DefaultMoveArenaLimit = 12 * 1024;
 
 #else
 
 // We are more memory-constrained on the SAM3X and LPC
 const unsigned int DdaRingLength = 20;
 const unsigned int NumDms = 20 * 5;												// suitable for e.g. a delta + 2-input hot end
+constexpr unsigned int DefaultMaxDdaRingLength = DdaRingLength;
+constexpr size_t DefaultMoveArenaLimit = 0;
 
 #endif
 
@@ -83,6 +89,10 @@ public:
 	void SetZeroHeightError(const float coords[MaxAxes]) noexcept;			// Set zero height error at these bed coordinates
 	float GetTaperHeight() const noexcept { return (useTaper) ? taperHeight : 0.0; }
 	void SetTaperHeight(float h) noexcept;
+	float GetMeshChordTolerance() const noexcept { return meshChordTolerance; }
+	void SetMeshChordTolerance(float t) noexcept { meshChordTolerance = max<float>(t, 0.0); }
+	unsigned int GetMeshSegments(const float startCoords[MaxAxes], const float endCoords[MaxAxes], const Tool *tool, unsigned int maxSegments) noexcept;
+																			// Return how many segments a move needs for mesh compensation
 	bool UseMesh(bool b) noexcept;											// Try to enable mesh bed compensation and report the final state
 	bool IsUsingMesh() const noexcept { return usingMesh; }					// Return true if we are using mesh compensation
 	unsigned int GetNumProbedProbePoints() const noexcept;					// Return the number of actually probed probe points
@@ -127,12 +137,17 @@ public:
 	// End temporary functions
 
 	bool IsRawMotorMove(uint8_t moveType) const noexcept;									// Return true if this is a raw motor move
+#if SUPPORT_NATIVE_ARCS
+	bool CanUseNativeArcs(size_t axis0, size_t axis1) const noexcept;						// Return true if we can execute an arc in these machine axes as a true arc
+#endif
 
 	float IdleTimeout() const noexcept;														// Returns the idle timeout in seconds
 	void SetIdleTimeout(float timeout) noexcept;											// Set the idle timeout in seconds
 
 	void Simulate(SimulationMode simMode) noexcept;											// Enter or leave simulation mode
 	float GetSimulationTime() const noexcept { return mainDDARing.GetSimulationTime(); }	// Get the accumulated simulation time
+	bool HaveStepTimingStats() const noexcept { return mainDDARing.HaveStepTimingStats(); }	// Return true if we have step timings from simulating with step generation
+	void ReportStepTimingStats(const StringRef& reply) const noexcept { mainDDARing.ReportStepTimingStats(reply); }
 
 	bool PausePrint(RestorePoint& rp) noexcept;												// Pause the print as soon as we can, returning true if we were able to
 #if HAS_VOLTAGE_MONITOR || HAS_STALL_DETECT
@@ -233,11 +248,13 @@ private:
 		timing			// no moves being executed or in queue, motors are at full current
 	};
 
+	void ReleaseArenaMemory() noexcept;															// Give back the memory used to lengthen the rings
 	void BedTransform(float xyzPoint[MaxAxes], const Tool *tool) const noexcept;				// Take a position and apply the bed compensations
 	void InverseBedTransform(float xyzPoint[MaxAxes], const Tool *tool) const noexcept;			// Go from a bed-transformed point back to user coordinates
 	void AxisTransform(float xyzPoint[MaxAxes], const Tool *tool) const noexcept;				// Take a position and apply the axis-angle compensations
 	void InverseAxisTransform(float xyzPoint[MaxAxes], const Tool *tool) const noexcept;		// Go from an axis transformed point back to user coordinates
 	float ComputeHeightCorrection(float xyzPoint[MaxAxes], const Tool *tool) const noexcept;	// Compute the height correction needed at a point, ignoring taper
+	float GetMeshChordDeviation(const float startCoords[MaxAxes], const float endCoords[MaxAxes], const Tool *tool, unsigned int numSegments) const noexcept;
 
 	const char *GetCompensationTypeString() const noexcept;
 
@@ -286,6 +303,9 @@ private:
 	float taperHeight;									// Height over which we taper
 	float recipTaperHeight;								// Reciprocal of the taper height
 	float zShift;										// Height to add to the bed transform
+	float meshChordTolerance;							// If nonzero, moves are divided into fewer mesh segments than grid cells when the bed compensation error is no more than this
+	float maxMeshChordDeviation;						// The largest bed compensation error we allowed because of this since the last diagnostics report
+	uint32_t meshSegmentsSaved;							// How many fewer segments we generated because of this since the last diagnostics report
 
 	Deviation latestCalibrationDeviation;
 	Deviation initialCalibrationDeviation;
@@ -0,0 +1,127 @@
+/*
+ * MoveArena.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "MoveArena.h"
+#include "Move.h"
+
+MoveArena::Block *MoveArena::blocks = nullptr;
+size_t MoveArena::numBlocks = 0;
+size_t MoveArena::limit = DefaultMoveArenaLimit;
+unsigned int MoveArena::numFailedAllocations = 0;
+
+// Allocate an object of the specified size, returning nullptr if we have reached our memory limit or the heap is full
+/*static*/ void *MoveArena::Allocate(size_t size) noexcept
+{
+	const size_t slotSize = (size + SlotAlignment - 1) & ~(SlotAlignment - 1);
+	if (slotSize > MaxSlotSize)
+	{
+		return nullptr;
+	}
+
+	// Look for a block for objects of this size that has a free slot
+	Block *block = blocks;
+	while (block != nullptr && (block->slotSize != slotSize || block->freeSlots == nullptr))
+	{
+		block = block->next;
+	}
+
+	if (block == nullptr)
+	{
+		// Try to get a new block from the heap
+		if ((numBlocks + 1) * BlockSize > limit)
+		{
+			++numFailedAllocations;
+			return nullptr;
+		}
+
+		void * const mem = malloc(BlockSize);
+		if (mem == nullptr)
+		{
+			++numFailedAllocations;
+			return nullptr;
+		}
+
+		block = static_cast<Block*>(mem);
+		block->slotSize = slotSize;
+		block->numSlots = MaxSlotSize/slotSize;
+		block->numInUse = 0;
+		block->freeSlots = nullptr;
+		for (size_t i = block->numSlots; i != 0; )
+		{
+			--i;
+			void * const slot = block->Slots() + i * slotSize;
+			*static_cast<void**>(slot) = block->freeSlots;
+			block->freeSlots = slot;
+		}
+		block->next = blocks;
+		blocks = block;
+		++numBlocks;
+	}
+
+	void * const slot = block->freeSlots;
+	block->freeSlots = *static_cast<void**>(slot);
+	++block->numInUse;
+	return slot;
+}
+
+// Release an object that was allocated from the arena
+/*static*/ void MoveArena::Release(void *p) noexcept
+{
+	Block *prevBlock = nullptr;
+	for (Block *block = blocks; block != nullptr; block = block->next)
+	{
+		if (block->Contains(p))
+		{
+			*static_cast<void**>(p) = block->freeSlots;
+			block->freeSlots = p;
+			--block->numInUse;
+			if (block->numInUse == 0)
+			{
+				// Return the block to the heap
+				if (prevBlock == nullptr)
+				{
+					blocks = block->next;
+				}
+				else
+				{
+					prevBlock->next = block->next;
+				}
+				--numBlocks;
+				free(block);
+			}
+			return;
+		}
+		prevBlock = block;
+	}
+}
+
+// Return true if the object was allocated from the arena
+/*static*/ bool MoveArena::Owns(const void *p) noexcept
+{
+	for (const Block *block = blocks; block != nullptr; block = block->next)
+	{
+		if (block->Contains(p))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/*static*/ void MoveArena::Diagnostics(const StringRef& reply) noexcept
+{
+	unsigned int numObjects = 0;
+	for (const Block *block = blocks; block != nullptr; block = block->next)
+	{
+		numObjects += block->numInUse;
+	}
+	reply.catf("Move arena: %u blocks, %u objects, limit %u, failed allocations %u",
+				(unsigned int)numBlocks, numObjects, (unsigned int)limit, numFailedAllocations);
+	numFailedAllocations = 0;
+}
+
+// End
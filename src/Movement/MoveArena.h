@@ -0,0 +1,63 @@
+/*
+ * MoveArena.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * The DDA ring, DriveMovement pool and MoveSegment pool are allocated permanently at startup and when M595 is used.
+ * The move arena provides additional objects of these types when we want to extend the ring temporarily, for example while printing files that contain many tiny segments.
+ * Memory is taken from the heap in blocks. Each block is divided into equal-sized slots for objects of one size.
+ * When a block has no objects in use, it is returned to the heap so that other parts of the firmware can use the memory.
+ * The total memory taken by the arena is limited. If an allocation would exceed the limit, or the heap has no free memory, we return nullptr and the caller must manage without.
+ * Only the Move task may allocate and release arena objects.
+ */
+
+#ifndef SRC_MOVEMENT_MOVEARENA_H_
+#define SRC_MOVEMENT_MOVEARENA_H_
+
+#include <RepRapFirmware.h>
+
+class MoveArena
+{
+public:
+	static void *Allocate(size_t size) noexcept;					// allocate an object slot, returning nullptr if we can't
+	static void Release(void *p) noexcept pre(Owns(p));			// release an object slot, returning its block to the heap if the block is no longer in use
+	static bool Owns(const void *p) noexcept;						// return true if this object was allocated from the arena
+
+	static size_t GetLimit() noexcept { return limit; }
+	static void SetLimit(size_t newLimit) noexcept { limit = newLimit; }
+	static size_t GetBytesInUse() noexcept { return numBlocks * BlockSize; }
+
+	static void Diagnostics(const StringRef& reply) noexcept;
+
+	static constexpr size_t BlockSize = 2048;						// the amount of memory that we take from the heap at a time
+	static constexpr size_t GetMaxObjectSize() noexcept { return MaxSlotSize; }	// the size of the largest object that we can allocate
+
+private:
+	struct Block
+	{
+		Block *next;
+		void *freeSlots;											// list of free slots in this block
+		uint16_t slotSize;
+		uint16_t numSlots;
+		uint16_t numInUse;
+
+		char *Slots() noexcept { return reinterpret_cast<char*>(this) + SlotsOffset; }
+		bool Contains(const void *p) const noexcept
+		{
+			return reinterpret_cast<const char*>(p) >= reinterpret_cast<const char*>(this) + SlotsOffset
+				&& reinterpret_cast<const char*>(p) < reinterpret_cast<const char*>(this) + BlockSize;
+		}
+	};
+
+	static constexpr size_t SlotAlignment = 8;
+	static constexpr size_t SlotsOffset = (sizeof(Block) + SlotAlignment - 1) & ~(SlotAlignment - 1);
+	static constexpr size_t MaxSlotSize = BlockSize - SlotsOffset;
+
+	static Block *blocks;
+	static size_t numBlocks;
+	static size_t limit;
+	static unsigned int numFailedAllocations;
+};
+
+#endif /* SRC_MOVEMENT_MOVEARENA_H_ */
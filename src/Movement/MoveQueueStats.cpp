@@ -0,0 +1,87 @@
+/*
+ * MoveQueueStats.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "MoveQueueStats.h"
+#include "DDA.h"
+#include <Platform/Tasks.h>
+
+const uint32_t MoveQueueStats::PreparedTimeBinLimits[NumPreparedTimeBins - 1] =
+{
+	DDA::AbsoluteMinimumPreparedTime/2,
+	DDA::AbsoluteMinimumPreparedTime,
+	DDA::UsualMinimumPreparedTime,
+	2 * DDA::UsualMinimumPreparedTime
+};
+
+void MoveQueueStats::Reset() noexcept
+{
+	for (uint32_t& count : preparedTimeBins)
+	{
+		count = 0;
+	}
+	minPreparedClocks = UINT32_MAX;
+	numLookaheadSpeedReductions = numHiccups = 0;
+}
+
+// Record the prepared movement time that was queued ahead of a move when we prepared it
+void MoveQueueStats::RecordPreparedTime(int32_t preparedClocks) noexcept
+{
+	const uint32_t clocks = (uint32_t)max<int32_t>(preparedClocks, 0);
+	size_t bin = 0;
+	while (bin < NumPreparedTimeBins - 1 && clocks >= PreparedTimeBinLimits[bin])
+	{
+		++bin;
+	}
+	++preparedTimeBins[bin];
+	if (clocks < minPreparedClocks)
+	{
+		minPreparedClocks = clocks;
+	}
+}
+
+// Return the least prepared time ahead of any move in seconds, or zero if we haven't recorded any
+float MoveQueueStats::GetMinPreparedTime() const noexcept
+{
+	return (minPreparedClocks == UINT32_MAX) ? 0.0 : (float)minPreparedClocks * (1.0/StepClockRate);
+}
+
+// Append the statistics to the reply.
+// The Move task updates them while other tasks report them, so we take a copy in a critical section first to get a consistent set.
+void MoveQueueStats::Report(const StringRef& reply) const noexcept
+{
+	MoveQueueStats stats;
+	{
+		TaskCriticalSectionLocker lock;
+		stats = *this;
+	}
+	stats.ReportValues(reply);
+}
+
+void MoveQueueStats::ReportValues(const StringRef& reply) const noexcept
+{
+	reply.cat("Prepared time ahead (ms)");
+	for (size_t bin = 0; bin < NumPreparedTimeBins; ++bin)
+	{
+		if (bin == 0)
+		{
+			reply.catf(" <%u %" PRIu32, (unsigned int)lrintf(GetPreparedTimeBinLimit(bin) * SecondsToMillis), preparedTimeBins[bin]);
+		}
+		else if (bin + 1 == NumPreparedTimeBins)
+		{
+			reply.catf(", >=%u %" PRIu32, (unsigned int)lrintf(GetPreparedTimeBinLimit(bin - 1) * SecondsToMillis), preparedTimeBins[bin]);
+		}
+		else
+		{
+			reply.catf(", %u-%u %" PRIu32,
+						(unsigned int)lrintf(GetPreparedTimeBinLimit(bin - 1) * SecondsToMillis), (unsigned int)lrintf(GetPreparedTimeBinLimit(bin) * SecondsToMillis), preparedTimeBins[bin]);
+		}
+	}
+	reply.catf(", min %.1f; lookahead speed reductions %" PRIu32 ", total hiccups %" PRIu32,
+				(double)(GetMinPreparedTime() * SecondsToMillis), numLookaheadSpeedReductions, numHiccups);
+}
+
+// End
@@ -0,0 +1,52 @@
+/*
+ * MoveQueueStats.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * This class accumulates statistics about how close a DDA ring came to running out of prepared moves.
+ * Each time we prepare a move while other moves are executing, we record how much prepared movement time was already queued ahead of it in a histogram.
+ * The histogram bins are based on the usual and absolute minimum prepared times, so a print that has many moves in the lower bins is at risk of stuttering.
+ * The counts are cumulative since startup and are reported in M122 and in the object model, to help tune segmentation and the ring length.
+ */
+
+#ifndef SRC_MOVEMENT_MOVEQUEUESTATS_H_
+#define SRC_MOVEMENT_MOVEQUEUESTATS_H_
+
+#include <RepRapFirmware.h>
+
+class MoveQueueStats
+{
+public:
+	static constexpr size_t NumPreparedTimeBins = 5;
+
+	MoveQueueStats() noexcept { Reset(); }
+
+	void Reset() noexcept;
+	bool IsEmpty() const noexcept { return minPreparedClocks == UINT32_MAX && numLookaheadSpeedReductions == 0 && numHiccups == 0; }
+
+	void RecordPreparedTime(int32_t preparedClocks) noexcept;
+	void RecordLookaheadSpeedReduction() noexcept { ++numLookaheadSpeedReductions; }
+	void RecordHiccup() noexcept { ++numHiccups; }					// called from the step ISR
+
+	uint32_t GetPreparedTimeBinCount(size_t bin) const noexcept pre(bin < NumPreparedTimeBins) { return preparedTimeBins[bin]; }
+	float GetMinPreparedTime() const noexcept;						// in seconds
+	uint32_t GetNumLookaheadSpeedReductions() const noexcept { return numLookaheadSpeedReductions; }
+	uint32_t GetNumHiccups() const noexcept { return numHiccups; }
+
+	void Report(const StringRef& reply) const noexcept;
+
+	static float GetPreparedTimeBinLimit(size_t bin) noexcept pre(bin + 1 < NumPreparedTimeBins) { return (float)PreparedTimeBinLimits[bin] * (1.0/StepClockRate); }
+
+private:
+	void ReportValues(const StringRef& reply) const noexcept;
+
+	static const uint32_t PreparedTimeBinLimits[NumPreparedTimeBins - 1];	// the upper limits of all bins except the last, in step clocks
+
+	uint32_t preparedTimeBins[NumPreparedTimeBins];					// how many moves were prepared with prepared time ahead in each range
+	uint32_t minPreparedClocks;										// the least prepared time ahead of any move prepared while moving
+	uint32_t numLookaheadSpeedReductions;							// how many times lookahead had to reduce a junction speed because the earlier moves could not be adjusted
+	volatile uint32_t numHiccups;									// how many hiccups were inserted because the step ISR ran for too long
+};
+
+#endif /* SRC_MOVEMENT_MOVEQUEUESTATS_H_ */
@@ -6,6 +6,7 @@
  */
 
 #include "MoveSegment.h"
+#include "MoveArena.h"
 
 // Static members
 
@@ -32,12 +33,43 @@ MoveSegment *MoveSegment::Allocate(MoveSegment *next) noexcept
 	}
 	else
 	{
-		ms = new MoveSegment(next);
+		// Use the move arena if we can, so that we can give the memory back when we are idle
+		void * const mem = MoveArena::Allocate(sizeof(MoveSegment));
+		ms = (mem != nullptr) ? ::new(mem) MoveSegment(next) : new MoveSegment(next);
 		++numCreated;
 	}
 	return ms;
 }
 
+// Give back to the move arena all free MoveSegments that were allocated from it. Not thread-safe.
+void MoveSegment::ReleaseArenaSegments() noexcept
+{
+	MoveSegment *prev = nullptr;
+	MoveSegment *ms = freeList;
+	while (ms != nullptr)
+	{
+		MoveSegment * const next = ms->GetNext();
+		if (MoveArena::Owns(ms))
+		{
+			if (prev == nullptr)
+			{
+				freeList = next;
+			}
+			else
+			{
+				prev->nextAndFlags = reinterpret_cast<uint32_t>(next);
+			}
+			MoveArena::Release(ms);
+			--numCreated;
+		}
+		else
+		{
+			prev = ms;
+		}
+		ms = next;
+	}
+}
+
 void MoveSegment::AddToTail(MoveSegment *tail) noexcept
 {
 	MoveSegment *seg = this;
@@ -61,14 +93,14 @@ void MoveSegment::DebugPrint(char ch) const noexcept
 		debugPrintf("b=%.4e c=%.4e\n", (double)b, (double)c);
 	}
 #else
-	debugPrintf("%c d=%" PRIu32 " t=%" PRIu32 " ", ch, iSegLength, iSegTime);
+	debugPrintf("%c d=%" PRIi32 " t=%" PRIu32 " ", ch, iSegLength, iSegTime);
 	if (IsLinear())
 	{
-		debugPrintf("c=%" PRIi32 "\n", ic);
+		debugPrintf("c=%" PRIi64 "\n", ic);
 	}
 	else
 	{
-		debugPrintf("b=%" PRIi32 " c=%" PRIi32 "\n", ib, ic);
+		debugPrintf("b=%" PRIi32 " c=%" PRIi64 "\n", ib, ic);
 	}
 #endif
 }
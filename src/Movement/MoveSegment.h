@@ -120,12 +120,16 @@
  *   Compute A' B' C' for this segment and motor
  *
  * If the MCU supports hardware floating point then it is more efficient to use FP arithmetic because of the speed of FP divide and sqrt operations.
- * If it doesn't then for accel/decel segments we probably need to compute sqrt(A + C*n/(f*m)) using 64-bit maths before we take the sqrt:
- *   A is in step_clocks^2 so it can be stored directly in 64 bits
- *   B is in step_clocks so it can be stored directly in 32 bits
- *   C for accel/decel is in step clocks^2/mm so it can probably be stored directly in 64 bits (check - does this work for very low f ?)
- *   C for linear motion is in step clocks/mm so can be stored directly in 32 bits
- *   1/(f*m) is in mm/step. We will have to store it multiplied by e.g. 2^24 as 32 bits, and after multiplying it by C to get a 64-bit result, shift it right to divide by 2^24.
+ * If it doesn't then we use fixed point integer maths so that the step ISR never calls the software floating point library. The segment is still set up using floats
+ * when the move is prepared, but the values are converted to integers at that point:
+ *   Segment lengths and distances are in mm multiplied by Kdistance and stored in 32 bits
+ *   Segment times are in step clocks and stored in 32 bits
+ *   B is in step clocks so it is stored directly in 32 bits
+ *   C for accel/decel is in step clocks^2/mm (up to about 2^41 for very low accelerations) so it is stored directly in 64 bits
+ *   C for linear motion is in step clocks/mm, which may be less than 100 at high speeds, so it is stored in 64 bits multiplied by KlinearC
+ *   1/(f*m) is in mm/step and may be greater than 1 when f is very small, so it is stored in 64 bits multiplied by KmmPerStep
+ * When starting a segment we compute A' = B^2 - C*Dprev in step clocks^2 and C' = C/(f*m) in step clocks^2/step (or step clocks/step * KmmPerStep for linear segments),
+ * using MulShift to avoid overflow of the intermediate products. So in the step ISR we only need a 64-bit multiply, a 64-bit integer square root and some additions.
  */
 
 #ifndef SRC_MOVEMENT_MOVESEGMENT_H_
@@ -133,9 +137,9 @@
 
 #include <RepRapFirmware.h>
 #include <Platform/Tasks.h>
+#include <Math/Isqrt.h>
 
-//#define MS_USE_FPU		(__FPU_USED)
-#define MS_USE_FPU			(1)				// Try using floating point maths for processors without FPU too. We have implemented fastSqrtf on those processors.
+#define MS_USE_FPU		(__FPU_USED)		// use floating point maths if we have a hardware FPU, else use fixed point maths to avoid software floating point in the step ISR
 
 class MoveSegment
 {
@@ -161,18 +165,21 @@ public:
 	void SetLinear(float pSegmentLength, float p_segTime, float p_c) noexcept;
 	void SetNonLinear(float pSegmentLength, float p_segTime, float p_b, float p_c) noexcept;
 #else
-	uint32_t GetSegmentLength() const noexcept { return iSegLength; }
+	int32_t GetSegmentLength() const noexcept { return iSegLength; }
 	uint32_t GetSegmentTime() const noexcept { return iSegTime; }
-	int64_t CalcNonlinearA(uint32_t startDistance) const noexcept;
-	int64_t CalcNonlinearA(uint32_t startDistance, uint32_t pressureAdvanceK) const noexcept;
+	int64_t CalcNonlinearA(int32_t startDistance) const noexcept;
+	int64_t CalcNonlinearA(int32_t startDistance, uint32_t pressureAdvanceK) const noexcept;
 	int32_t CalcNonlinearB(uint32_t startTime) const noexcept;
 	int32_t CalcNonlinearB(uint32_t startTime, uint32_t pressureAdvanceK) const noexcept;
-	int32_t CalcLinearB(uint32_t startDistance, uint32_t startTime) const noexcept;
-	int32_t CalcC(uint32_t mmPerStepTimesK) const noexcept;
-	int32_t GetC() const noexcept { return ic; }
+	int32_t CalcLinearB(int32_t startDistance, uint32_t startTime) const noexcept;
+	int64_t CalcC(uint64_t mmPerStepTimesK) const noexcept;
+	float GetC() const noexcept;											// only for use when preparing moves, not in the step ISR
 
-	void SetLinear(uint32_t pSegmentLength, uint32_t p_segTime, int32_t p_c) noexcept;
-	void SetNonLinear(uint32_t pSegmentLength, uint32_t p_segTime, int32_t p_b, int32_t p_c) noexcept;
+	// The segments are always set up from floating point values when preparing the move, so these convert them to fixed point
+	void SetLinear(float pSegmentLength, float p_segTime, float p_c) noexcept;
+	void SetNonLinear(float pSegmentLength, float p_segTime, float p_b, float p_c) noexcept;
+
+	static int64_t MulShift(int64_t a, int64_t b, unsigned int shift) noexcept;
 #endif
 	void SetReverse() noexcept;
 
@@ -192,19 +199,26 @@ public:
 	static void Release(MoveSegment *item) noexcept;
 
 	static void InitialAllocate(unsigned int num) noexcept;
+	static void ReleaseArenaSegments() noexcept;
 	static unsigned int NumCreated() noexcept { return numCreated; }
 
-	static constexpr unsigned int SFdistance = 10;
+	static constexpr unsigned int SFdistance = 14;
 	static constexpr unsigned int SFstepsPerMm = 16;
-	static constexpr unsigned int SFmmPerStep = 31;
+	static constexpr unsigned int SFmmPerStep = 32;
+	static constexpr unsigned int SFlinearC = 16;
 	static constexpr unsigned int SFdirectionVector = 20;
 	static constexpr unsigned int SFdelta = 9;
+	static constexpr unsigned int SFdeltaDirection = 8;
 
 	static constexpr uint32_t Kdistance = 1u << SFdistance;					// a power of 2 used to multiply distances by so we can store them as integers
 	static constexpr uint32_t KstepsPerMm = 1u << SFstepsPerMm;				// a power of 2 used to multiply steps/mm by so we can store them as integers
-	static constexpr uint32_t KmmPerStep = 1u << SFmmPerStep;				// a power of 2 for scaling the Z movement fraction
+	static constexpr uint64_t KmmPerStep = (uint64_t)1u << SFmmPerStep;		// a power of 2 used to multiply mm/step by so we can store them as integers
+	static constexpr uint32_t KlinearC = 1u << SFlinearC;					// a power of 2 used to multiply the C coefficient of linear segments by so we can store it as an integer
 	static constexpr uint32_t KdirectionVector = 1u << SFdirectionVector;	// a power of 2 for scaling the direction vector
 	static constexpr uint32_t Kdelta = 1u << SFdelta;						// a power of 2 for scaling delta motion calculations to reduce rounding error (but too high makes things worse)
+	static constexpr uint32_t KdeltaDirection = 1u << SFdeltaDirection;		// a power of 2 for scaling the per-tower direction vector components to reduce rounding error
+
+	static constexpr float MaxStepsPerMm = (float)(UINT32_MAX / KstepsPerMm);	// the largest steps/mm that fits in the fixed point steps/mm fields
 
 private:
 	static constexpr uint32_t LinearFlag = 0x01;
@@ -222,9 +236,10 @@ private:
 	float segTime;											// the time in step clocks at which this move ends
 	float b, c;												// the move parameters (b is not needed for linear moves)
 #else
-	uint32_t iSegLength;									// the length of this segment before applying the movement fraction
+	int32_t iSegLength;										// the length of this segment before applying the movement fraction, multiplied by Kdistance
 	uint32_t iSegTime;										// the time in step clocks at which this move ends
-	int32_t ib, ic;											// the move parameters (b is not needed for linear moves)
+	int32_t ib;												// the b parameter in step clocks (not needed for linear moves)
+	int64_t ic;												// the c parameter, multiplied by KlinearC if this is a linear segment
 #endif
 
 };
@@ -315,14 +330,33 @@ inline bool MoveSegment::IsAccelerating() const noexcept
 
 #else
 
-inline int64_t MoveSegment::CalcNonlinearA(uint32_t startDistance) const noexcept
+// Multiply two signed 64-bit numbers and shift the 128-bit product right by 'shift' bits, where 0 < shift < 64 and the result is known to fit in 64 bits.
+// Only integer multiplications are used, so this is safe to call from the step ISR.
+inline int64_t MoveSegment::MulShift(int64_t a, int64_t b, unsigned int shift) noexcept
+{
+	const bool negative = (a < 0) != (b < 0);
+	const uint64_t ua = (a < 0) ? -(uint64_t)a : (uint64_t)a;
+	const uint64_t ub = (b < 0) ? -(uint64_t)b : (uint64_t)b;
+	const uint32_t aLo = (uint32_t)ua, aHi = (uint32_t)(ua >> 32);
+	const uint32_t bLo = (uint32_t)ub, bHi = (uint32_t)(ub >> 32);
+	const uint64_t loLo = (uint64_t)aLo * bLo;
+	const uint64_t hiLo = (uint64_t)aHi * bLo;
+	const uint64_t loHi = (uint64_t)aLo * bHi;
+	const uint64_t mid = (loLo >> 32) + (uint32_t)hiLo + (uint32_t)loHi;
+	const uint64_t productLo = (mid << 32) | (uint32_t)loLo;
+	const uint64_t productHi = (uint64_t)aHi * bHi + (hiLo >> 32) + (loHi >> 32) + (mid >> 32);
+	const uint64_t result = (productLo >> shift) | (productHi << (64 - shift));
+	return (negative) ? -(int64_t)result : (int64_t)result;
+}
+
+inline int64_t MoveSegment::CalcNonlinearA(int32_t startDistance) const noexcept
 {
-	return isquare64(ib) - (int64_t)startDistance * ic;
+	return (int64_t)isquare64(ib) - MulShift(ic, startDistance, SFdistance);
 }
 
-inline int64_t MoveSegment::CalcNonlinearA(uint32_t startDistance, uint32_t pressureAdvanceK) const noexcept
+inline int64_t MoveSegment::CalcNonlinearA(int32_t startDistance, uint32_t pressureAdvanceK) const noexcept
 {
-	return isquare64(ib - pressureAdvanceK) - (int64_t)startDistance * ic;
+	return (int64_t)isquare64(ib - (int32_t)pressureAdvanceK) - MulShift(ic, startDistance, SFdistance);
 }
 
 inline int32_t MoveSegment::CalcNonlinearB(uint32_t startTime) const noexcept
@@ -335,32 +369,39 @@ inline int32_t MoveSegment::CalcNonlinearB(uint32_t startTime, uint32_t pressure
 	return (ib - (int32_t)pressureAdvanceK) + (int32_t)startTime;
 }
 
-inline int32_t MoveSegment::CalcLinearB(uint32_t startDistance, uint32_t startTime) const noexcept
+inline int32_t MoveSegment::CalcLinearB(int32_t startDistance, uint32_t startTime) const noexcept
+{
+	return (int32_t)startTime - (int32_t)MulShift(ic, startDistance, SFlinearC + SFdistance);
+}
+
+// Calculate C' for this segment given the mm/step multiplied by KmmPerStep.
+// For a linear segment the result is in step clocks/step multiplied by KmmPerStep, else it is in step clocks^2/step.
+inline int64_t MoveSegment::CalcC(uint64_t mmPerStepTimesK) const noexcept
 {
-	return (int32_t)startTime - (((int64_t)startDistance * ic) >> SFdistance);
+	return MulShift(ic, (int64_t)mmPerStepTimesK, (IsLinear()) ? SFlinearC : SFmmPerStep);
 }
 
-inline int32_t MoveSegment::CalcC(uint32_t mmPerStepTimesK) const noexcept
+inline float MoveSegment::GetC() const noexcept
 {
-	return (int32_t)((ic * (int64_t)mmPerStepTimesK) >> SFmmPerStep);
+	return (IsLinear()) ? (float)ic * (1.0/KlinearC) : (float)ic;
 }
 
-inline void MoveSegment::SetLinear(uint32_t pSegmentLength, uint32_t p_segTime, int32_t p_c) noexcept
+inline void MoveSegment::SetLinear(float pSegmentLength, float p_segTime, float p_c) noexcept
 {
-	iSegLength = pSegmentLength;
-	iSegTime = p_segTime;
+	iSegLength = lrintf(pSegmentLength * Kdistance);
+	iSegTime = lrintf(p_segTime);
 	ib = 0;
-	ic = p_c;
+	ic = llrintf(p_c * KlinearC);
 	nextAndFlags |= LinearFlag;
 }
 
 // Set up an accelerating or decelerating move. We assume that the 'linear' flag is already clear.
-inline void MoveSegment::SetNonLinear(uint32_t pSegmentLength, uint32_t p_segTime, int32_t p_b, int32_t p_c) noexcept
+inline void MoveSegment::SetNonLinear(float pSegmentLength, float p_segTime, float p_b, float p_c) noexcept
 {
-	iSegLength = pSegmentLength;
-	iSegTime = p_segTime;
-	ib = p_b;
-	ic = p_c;
+	iSegLength = lrintf(pSegmentLength * Kdistance);
+	iSegTime = lrintf(p_segTime);
+	ib = lrintf(p_b);
+	ic = llrintf(p_c);
 }
 
 // Given that this is an accelerating or decelerating move, return true if it is accelerating
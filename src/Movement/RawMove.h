@@ -36,6 +36,21 @@ struct RawMove
 			usingStandardFeedrate : 1,								// true if this move uses the standard feed rate
 			checkEndstops : 1,										// true if any endstops or the Z probe can terminate the move
 			reduceAcceleration : 1;									// true if Z probing so we should limit the Z acceleration
+
+#if SUPPORT_NATIVE_ARCS
+	// Details of a move that is all or part of an arc and that Move should execute as a true arc. Only the final positions of the arc axes are stored in coords[].
+	struct NativeArc
+	{
+		float centre[2];											// the machine coordinates of the arc centre along the two arc axes
+		float radius;												// the arc radius in machine coordinates
+		float startAngle;											// the angle at the start of this move relative to the +axis[0] direction
+		float angle;												// the signed angle moved through, positive is anticlockwise
+		uint8_t axis[2];											// the machine axes that the arc is in
+		bool isArc;													// true if this move is an arc that Move should execute as a true arc
+		uint8_t padding;
+	} nativeArc;
+#endif
+
 	// If adding any more fields, keep the total size a multiple of 4 bytes so that we can use our optimised assignment operator
 
 	void SetDefaults(size_t firstDriveToZero) noexcept;				// set up default values
@@ -79,6 +94,11 @@ struct MovementState : public RawMove
 	float arcAngleIncrement;										// the amount by which we increment the arc angle in each segment
 	float angleIncrementSine, angleIncrementCosine;					// the sine and cosine of the increment
 	unsigned int segmentsTillNextFullCalc;							// how may more segments we can do before we need to do the full calculation instead of the quicker one
+#if SUPPORT_NATIVE_ARCS
+	float arcFinalAngle;											// the angle at the end of the arc, if we are doing native arc moves
+	float arcTotalAngle;											// the signed angle of the complete arc, if we are doing native arc moves
+	bool useNativeArcs;												// true if we are passing the arc to Move in a few true arc pieces instead of many straight segments
+#endif
 	bool doingArcMove;												// true if we are doing an arc move
 	bool xyPlane;													// true if the G17/G18/G19 selected plane of the arc move is XY in the original user coordinates
 	SegmentedMoveState segMoveState;
@@ -0,0 +1,57 @@
+/*
+ * StepTimingStats.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "StepTimingStats.h"
+
+void StepTimingStats::Reset() noexcept
+{
+	totalStepCycles = 0;
+	numStepsGenerated = numStepPasses = maxStepPassCycles = maxStepsInPass = 0;
+	totalPrepareClocks = 0;
+	numPrepares = maxPrepareClocks = 0;
+}
+
+void StepTimingStats::RecordPrepare(uint32_t stepClocks) noexcept
+{
+	totalPrepareClocks += stepClocks;
+	++numPrepares;
+	if (stepClocks > maxPrepareClocks)
+	{
+		maxPrepareClocks = stepClocks;
+	}
+}
+
+void StepTimingStats::RecordStepPass(uint32_t cycles, unsigned int stepsGenerated) noexcept
+{
+	totalStepCycles += cycles;
+	numStepsGenerated += stepsGenerated;
+	++numStepPasses;
+	if (cycles > maxStepPassCycles)
+	{
+		maxStepPassCycles = cycles;
+	}
+	if (stepsGenerated > maxStepsInPass)
+	{
+		maxStepsInPass = stepsGenerated;
+	}
+}
+
+// Append the statistics to the reply
+void StepTimingStats::Report(const StringRef& reply) const noexcept
+{
+	const float nsPerCycle = 1.0e9/(float)SystemCoreClock;
+	const float usPerStepClock = 1.0e6/(float)StepClockRate;
+	reply.catf("Step timing: %" PRIu32 " steps in %" PRIu32 " interrupts, %.1fns/step, worst interrupt %.2fus (%" PRIu32 " steps); %" PRIu32 " moves prepared, %.1fus/move, worst %.1fus",
+				numStepsGenerated, numStepPasses,
+				(double)((numStepsGenerated == 0) ? 0.0 : (float)totalStepCycles * nsPerCycle/(float)numStepsGenerated),
+				(double)((float)maxStepPassCycles * nsPerCycle * 0.001), maxStepsInPass,
+				numPrepares,
+				(double)((numPrepares == 0) ? 0.0 : (float)totalPrepareClocks * usPerStepClock/(float)numPrepares),
+				(double)((float)maxPrepareClocks * usPerStepClock));
+}
+
+// End
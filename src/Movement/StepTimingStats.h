@@ -0,0 +1,51 @@
+/*
+ * StepTimingStats.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * This class accumulates timing statistics for the step generation code when we simulate a file with step generation enabled (M37 P"file" S1).
+ * Preparing a move is timed using the step clock. Step generation is timed in CPU clock cycles using SysTick, with interrupts disabled,
+ * in the same way as the M122 P102 timing tests. This gives us a repeatable benchmark of the hot paths that we can run on any board.
+ */
+
+#ifndef SRC_MOVEMENT_STEPTIMINGSTATS_H_
+#define SRC_MOVEMENT_STEPTIMINGSTATS_H_
+
+#include <RepRapFirmware.h>
+
+class StepTimingStats
+{
+public:
+	StepTimingStats() noexcept { Reset(); }
+
+	void Reset() noexcept;
+	bool IsEmpty() const noexcept { return numPrepares == 0 && numStepPasses == 0; }
+
+	void RecordPrepare(uint32_t stepClocks) noexcept;
+	void RecordStepPass(uint32_t cycles, unsigned int stepsGenerated) noexcept;
+
+	void Report(const StringRef& reply) const noexcept;
+
+	// Read the SysTick counter. It counts down at the CPU clock rate and wraps once per millisecond.
+	static uint32_t GetCycleCount() noexcept { return SysTick->VAL & 0x00FFFFFF; }
+
+	// Return the number of CPU clock cycles between two readings of the SysTick counter, assuming that less than 1ms has elapsed
+	static uint32_t CyclesBetween(uint32_t startCount, uint32_t endCount) noexcept
+	{
+		return ((startCount >= endCount) ? startCount : startCount + (SysTick->LOAD & 0x00FFFFFF) + 1) - endCount;
+	}
+
+private:
+	uint64_t totalStepCycles;						// total CPU cycles spent calculating step times
+	uint32_t numStepsGenerated;						// total number of steps whose times we calculated
+	uint32_t numStepPasses;							// number of simulated step interrupts
+	uint32_t maxStepPassCycles;						// CPU cycles taken by the longest simulated step interrupt
+	uint32_t maxStepsInPass;						// the largest number of steps generated by a single simulated step interrupt
+
+	uint64_t totalPrepareClocks;					// total step clocks spent in DDA::Prepare
+	uint32_t numPrepares;							// number of moves prepared
+	uint32_t maxPrepareClocks;						// step clocks taken by the slowest call to DDA::Prepare
+};
+
+#endif /* SRC_MOVEMENT_STEPTIMINGSTATS_H_ */
@@ -14,6 +14,10 @@
 #include "GCodes/GCodes.h"
 #include "General/IP4String.h"
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+# include <ObjectModel/ObjectModelStreamer.h>
+#endif
+
 #define KO_START "rr_"
 const size_t KoFirst = 3;
 
@@ -122,6 +126,11 @@ bool HttpResponder::Spin() noexcept
 		SendData();
 		return true;
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	case ResponderState::streamingModel:
+		return SendModelStream();
+#endif
+
 	default:	// should not happen
 		return false;
 	}
@@ -992,6 +1001,13 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 			return;
 		}
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+		if (StringEqualsIgnoreCase(command, "model") && StartModelStream())
+		{
+			return;
+		}
+#endif
+
 #if HAS_MASS_STORAGE
 		if (StringEqualsIgnoreCase(command, "download"))
 		{
@@ -1061,8 +1077,14 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 					"Cache-Control: no-cache, no-store, must-revalidate\r\n"
 					"Pragma: no-cache\r\n"
 					"Expires: 0\r\n"
-					"Content-Type: application/json\r\n"
 				);
+#if SUPPORT_OBJECT_MODEL
+	// An object model request may ask for the response in CBOR format instead of JSON
+	const char *const flagsVal = (StringEqualsIgnoreCase(command, "model")) ? GetKeyValue("flags") : nullptr;
+	outBuf->cat((flagsVal != nullptr && ObjectExplorationContext::WantBinaryReport(flagsVal)) ? "Content-Type: application/cbor\r\n" : "Content-Type: application/json\r\n");
+#else
+	outBuf->cat("Content-Type: application/json\r\n");
+#endif
 	const unsigned int replyLength = (jsonResponse != nullptr) ? jsonResponse->Length() : 0;
 	outBuf->catf("Content-Length: %u\r\n", replyLength);
 	AddCorsHeader();
@@ -1089,6 +1111,119 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 	}
 }
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+
+// Start sending an object model report that the object model streamer generates while we send it. outBuf is non-null on entry.
+// Return false if the streamer is busy, in which case the caller must generate the whole report before sending it.
+// We don't know the length of the report in advance, so we send it using chunked transfer encoding. This also lets the client tell whether it received all of it.
+// We keep outBuf for the headers but don't send them until the streamer has generated some of the report, so that if the key is invalid we can still return an error.
+bool HttpResponder::StartModelStream() noexcept
+{
+	const char *const flagsVal = GetKeyValue("flags");
+	if (!ObjectModelStreamer::Start(this, GetKeyValue("key"), flagsVal))
+	{
+		return false;
+	}
+
+	modelStreamBinary = (flagsVal != nullptr && ObjectExplorationContext::WantBinaryReport(flagsVal));
+	modelStreamHeadersSent = false;
+	timer = millis();
+	responderState = ResponderState::streamingModel;
+	if (reprap.Debug(moduleWebserver))
+	{
+		debugPrintf("Streaming JSON reply\n");
+	}
+	return true;
+}
+
+// Send the next part of a streamed object model report if it is ready, returning true if we did anything significant
+bool HttpResponder::SendModelStream() noexcept
+{
+	bool done, succeeded;
+	OutputBuffer *const chunk = ObjectModelStreamer::GetChunk(this, done, succeeded);
+	if (chunk == nullptr && !done)
+	{
+		// The next part of the report isn't ready yet
+		if (millis() - timer < HttpSessionTimeout)
+		{
+			return false;
+		}
+		if (modelStreamHeadersSent)
+		{
+			ConnectionLost();
+		}
+		else
+		{
+			ObjectModelStreamer::Abandon(this);
+			RejectMessage("Service Unavailable", 503);
+		}
+		return true;
+	}
+
+	if (chunk == nullptr && !succeeded)
+	{
+		if (modelStreamHeadersSent)
+		{
+			ConnectionLost();								// close the connection so that the client sees that the report is incomplete
+		}
+		else
+		{
+			RejectMessage("Object model report failed");	// the report failed before we sent any of it, for example because the key was invalid
+		}
+		return true;
+	}
+
+	// We have something to send. If this is the first part of the report then outBuf is the buffer we kept for the headers, else we need a new one.
+	if (modelStreamHeadersSent)
+	{
+		if (!OutputBuffer::Allocate(outBuf))
+		{
+			OutputBuffer::ReleaseAll(chunk);
+			ReportOutputBufferExhaustion(__FILE__, __LINE__);
+			ConnectionLost();
+			return true;
+		}
+	}
+	else
+	{
+		outBuf->copy(	"HTTP/1.1 200 OK\r\n"
+						"Cache-Control: no-cache, no-store, must-revalidate\r\n"
+						"Pragma: no-cache\r\n"
+						"Expires: 0\r\n"
+						"Transfer-Encoding: chunked\r\n"
+					);
+		outBuf->cat((modelStreamBinary) ? "Content-Type: application/cbor\r\n" : "Content-Type: application/json\r\n");
+		AddCorsHeader();
+		outBuf->cat("Connection: close\r\n\r\n");
+		modelStreamHeadersSent = true;
+	}
+
+	if (chunk != nullptr)
+	{
+		outBuf->catf("%x\r\n", (unsigned int)chunk->Length());
+		outBuf->Append(chunk);
+		outBuf->cat("\r\n");
+	}
+	else
+	{
+		outBuf->cat("0\r\n\r\n");							// the zero-length chunk that ends the response
+	}
+
+	if (outBuf->HadOverflow())
+	{
+		// We can't send the rest of the report, so close the connection. The client will see that the report is incomplete.
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		ConnectionLost();
+		return true;
+	}
+
+	timer = millis();
+	Commit((chunk != nullptr) ? ResponderState::streamingModel : ResponderState::free, false);
+	return true;
+}
+
+#endif
+
 // Process the message received. We have reached the end of the headers.
 void HttpResponder::ProcessMessage() noexcept
 {
@@ -1376,6 +1511,15 @@ void HttpResponder::CancelUpload() noexcept
 	UploadingNetworkResponder::CancelUpload();
 }
 
+// This overrides the version in class UploadingNetworkResponder
+void HttpResponder::ConnectionLost() noexcept
+{
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	ObjectModelStreamer::Abandon(this);					// in case we were sending a streamed object model report
+#endif
+	UploadingNetworkResponder::ConnectionLost();
+}
+
 // This overrides the version in class NetworkResponder
 void HttpResponder::SendData() noexcept
 {
@@ -30,6 +30,7 @@ public:
 protected:
 	void CancelUpload() noexcept override;
 	void SendData() noexcept override;
+	void ConnectionLost() noexcept override;
 
 private:
 #ifdef __LPC17xx__
@@ -91,6 +92,11 @@ private:
 	bool SendFileInfo(bool quitEarly) noexcept;
 	void AddCorsHeader() noexcept;
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	bool StartModelStream() noexcept;
+	bool SendModelStream() noexcept;
+#endif
+
 #if HAS_MASS_STORAGE
 	void DoUpload() noexcept;
 #endif
@@ -123,6 +129,12 @@ private:
 	time_t fileLastModified;
 	bool postFileGotCrc;
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	// Streamed rr_model responses
+	bool modelStreamBinary;							// true if the report is in CBOR format
+	bool modelStreamHeadersSent;					// true once we have committed to a 200 response
+#endif
+
 	// Keeping track of HTTP sessions
 	static HttpSession sessions[MaxHttpSessions];
 	static unsigned int numSessions;
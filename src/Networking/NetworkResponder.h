@@ -44,6 +44,7 @@ protected:
 		// HTTP responder additional states
 		processingRequest,
 		gettingFileInfo,								// getting file info
+		streamingModel,									// waiting for the next part of an object model report
 
 		// FTP responder additional states
 		waitingForPasvPort,
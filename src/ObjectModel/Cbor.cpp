@@ -0,0 +1,118 @@
+/*
+ * Cbor.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "Cbor.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+#include <cmath>
+
+// Write the initial byte of an item and the argument that follows it, using the shortest encoding
+void Cbor::WriteHead(OutputBuffer *buf, uint8_t majorType, uint64_t val) noexcept
+{
+	char bytes[9];
+	size_t numArgBytes;
+	if (val < 24)
+	{
+		buf->cat((char)(majorType | (uint8_t)val));
+		return;
+	}
+	else if (val <= 0xFF)
+	{
+		bytes[0] = (char)(majorType | 24);
+		numArgBytes = 1;
+	}
+	else if (val <= 0xFFFF)
+	{
+		bytes[0] = (char)(majorType | 25);
+		numArgBytes = 2;
+	}
+	else if (val <= 0xFFFFFFFF)
+	{
+		bytes[0] = (char)(majorType | 26);
+		numArgBytes = 4;
+	}
+	else
+	{
+		bytes[0] = (char)(majorType | 27);
+		numArgBytes = 8;
+	}
+
+	for (size_t i = numArgBytes; i != 0; --i)
+	{
+		bytes[i] = (char)(val & 0xFF);									// CBOR is big-endian
+		val >>= 8;
+	}
+	buf->cat(bytes, numArgBytes + 1);
+}
+
+void Cbor::WriteInteger(OutputBuffer *buf, int64_t val) noexcept
+{
+	if (val >= 0)
+	{
+		WriteHead(buf, MajorUnsigned, (uint64_t)val);
+	}
+	else
+	{
+		WriteHead(buf, MajorNegative, (uint64_t)(-1 - val));
+	}
+}
+
+// Write a float. We round it to the number of decimal places that we would use in a JSON report, then use the shortest encoding that represents the rounded value exactly.
+// So most values that would be reported in JSON without a decimal point are written as integers, and many others as half-precision floats.
+void Cbor::WriteFloat(OutputBuffer *buf, float val, unsigned int numDecimalPlaces) noexcept
+{
+	if (std::isnan(val) || std::isinf(val))
+	{
+		WriteNull(buf);													// for consistency with JSON reports
+		return;
+	}
+
+	static constexpr float PowersOfTen[] = { 1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0, 10000000.0 };
+	if (numDecimalPlaces == 0)
+	{
+		numDecimalPlaces = MaxFloatDigitsDisplayedAfterPoint;			// zero means use the maximum number of decimal places, see GetFloatFormatString
+	}
+	// Only round the value if it is small enough for the float to hold fractional digits at that precision.
+	// Larger values have no such digits, and scaling them could overflow to infinity, so we leave them alone and they get one of the float encodings.
+	if (numDecimalPlaces < ARRAY_SIZE(PowersOfTen) && fabsf(val) < 16777216.0/PowersOfTen[numDecimalPlaces])
+	{
+		val = roundf(val * PowersOfTen[numDecimalPlaces])/PowersOfTen[numDecimalPlaces];
+	}
+
+	if (fabsf(val) < 2147483648.0 && val == truncf(val))
+	{
+		WriteInteger(buf, (int32_t)val);
+		return;
+	}
+
+	uint32_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	const int32_t halfExponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+	if (halfExponent > 0 && halfExponent < 31 && (bits & 0x00001FFF) == 0)
+	{
+		// The value is a normal half-precision number and we won't lose any bits of the mantissa
+		const uint16_t half = (uint16_t)(((bits >> 16) & 0x8000) | ((uint32_t)halfExponent << 10) | ((bits >> 13) & 0x03FF));
+		const char bytes[3] = { (char)HalfFloat, (char)(half >> 8), (char)(half & 0xFF) };
+		buf->cat(bytes, sizeof(bytes));
+	}
+	else
+	{
+		const char bytes[5] = { (char)SingleFloat, (char)(bits >> 24), (char)((bits >> 16) & 0xFF), (char)((bits >> 8) & 0xFF), (char)(bits & 0xFF) };
+		buf->cat(bytes, sizeof(bytes));
+	}
+}
+
+void Cbor::WriteString(OutputBuffer *buf, const char *_ecv_array str, size_t len) noexcept
+{
+	WriteHead(buf, MajorTextString, len);
+	buf->cat(str, len);
+}
+
+#endif
+
+// End
@@ -0,0 +1,50 @@
+/*
+ * Cbor.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Functions to write values in CBOR format (RFC 8949), used when a client asks for a binary object model report.
+ * Arrays and maps are written with indefinite length so that we can stream them without counting the elements first.
+ */
+
+#ifndef SRC_OBJECTMODEL_CBOR_H_
+#define SRC_OBJECTMODEL_CBOR_H_
+
+#include <RepRapFirmware.h>
+#include <Platform/OutputMemory.h>
+
+namespace Cbor
+{
+	// Major types, already shifted into the top 3 bits of the initial byte
+	constexpr uint8_t MajorUnsigned = 0u << 5;
+	constexpr uint8_t MajorNegative = 1u << 5;
+	constexpr uint8_t MajorTextString = 3u << 5;
+	constexpr uint8_t MajorArray = 4u << 5;
+	constexpr uint8_t MajorMap = 5u << 5;
+
+	// Initial bytes that have special meanings
+	constexpr uint8_t IndefiniteLength = 31;
+	constexpr uint8_t False = 0xF4;
+	constexpr uint8_t True = 0xF5;
+	constexpr uint8_t Null = 0xF6;
+	constexpr uint8_t HalfFloat = 0xF9;
+	constexpr uint8_t SingleFloat = 0xFA;
+	constexpr uint8_t Break = 0xFF;
+
+	void WriteHead(OutputBuffer *buf, uint8_t majorType, uint64_t val) noexcept;
+	void WriteInteger(OutputBuffer *buf, int64_t val) noexcept;
+	void WriteFloat(OutputBuffer *buf, float val, unsigned int numDecimalPlaces) noexcept;
+	void WriteString(OutputBuffer *buf, const char *_ecv_array str, size_t len) noexcept;
+
+	inline void WriteUnsigned(OutputBuffer *buf, uint64_t val) noexcept { WriteHead(buf, MajorUnsigned, val); }
+	inline void WriteString(OutputBuffer *buf, const char *_ecv_array str) noexcept { WriteString(buf, str, strlen(str)); }
+	inline void WriteBool(OutputBuffer *buf, bool b) noexcept { buf->cat((char)((b) ? True : False)); }
+	inline void WriteNull(OutputBuffer *buf) noexcept { buf->cat((char)Null); }
+	inline void StartArray(OutputBuffer *buf) noexcept { buf->cat((char)(MajorArray | IndefiniteLength)); }
+	inline void StartMap(OutputBuffer *buf) noexcept { buf->cat((char)(MajorMap | IndefiniteLength)); }
+	inline void EndArrayOrMap(OutputBuffer *buf) noexcept { buf->cat((char)Break); }
+	inline void WriteEmptyMap(OutputBuffer *buf) noexcept { buf->cat((char)MajorMap); }
+}
+
+#endif /* SRC_OBJECTMODEL_CBOR_H_ */
@@ -8,6 +8,9 @@
 #include "GlobalVariables.h"
 #include <Platform/OutputMemory.h>
 
+// The identifier we use for the generation number of the variable set in delta reports. The variables themselves use the hashes of their names.
+constexpr uint32_t GenerationValueId = 0xFFFFFFFFu;
+
 // This function is not used in this class
 const ObjectModelClassDescriptor *GlobalVariables::GetObjectModelClassDescriptor() const noexcept { return nullptr; }
 
@@ -17,22 +20,46 @@ const ObjectModelClassDescriptor *GlobalVariables::GetObjectModelClassDescriptor
 void GlobalVariables::ReportAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *filter) const noexcept
 		THROWS(GCodeException)
 {
-	buf->cat('{');
+	ReportStartObject(buf, context);
 	if (context.IncreaseDepth())
 	{
 		{
 			ReadLocker locker(lock);			// make sure that no other task modifies the list while we are traversing it
-			vars.IterateWhile([this, buf, &context, classDescriptor, filter](unsigned int index, const Variable& v) noexcept -> bool
+
+			// In a delta report, if any variables have been created or deleted then report all of them, because the client can't tell which ones have gone
+			// The generation number gets its own key so that it doesn't share a change table entry with the value of the global object itself
+			const uint32_t oldGenerationKey = context.EnterValue(GenerationValueId);
+			const bool reportedAllValues = context.IsDeltaReport() && context.ReportAllValues(context.RecordValue(ExpressionValue((int32_t)vars.GetGeneration())));
+			context.LeaveValue(oldGenerationKey);
+			bool first = true;
+			vars.IterateWhile([this, buf, &context, classDescriptor, filter, &first](unsigned int index, const Variable& v) noexcept -> bool
 								{
-									buf->catf((index != 0) ? ",\"%s\":" : "\"%s\":", v.GetName().Ptr());
+									// In a delta report we leave out the variables whose values haven't changed
+									const size_t startLength = (context.IsDeltaReport()) ? buf->Length() : 0;
+									const unsigned int numChangedValues = context.GetNumChangedValues();
+									ReportFieldName(buf, context, v.GetName().Ptr(), first);
+									const uint32_t oldKey = context.EnterValue(VariableSet::HashName(v.GetName().Ptr()));
 									ReportItemAsJsonFull(buf, context, classDescriptor, v.GetValue(), filter);
+									context.LeaveValue(oldKey);
+									if (context.IsDeltaReport() && context.GetNumChangedValues() == numChangedValues)
+									{
+										buf->TruncateTo(startLength);
+									}
+									else
+									{
+										first = false;
+									}
 									return true;
 								}
 							 );
+			if (context.IsDeltaReport())
+			{
+				context.ReportAllValues(reportedAllValues);
+			}
 		}
 		context.DecreaseDepth();
 	}
-	buf->cat('}');
+	ReportEndObject(buf, context);
 }
 
 ReadLockedPointer<const VariableSet> GlobalVariables::GetForReading() noexcept
@@ -17,6 +17,8 @@
 #include <General/IP4String.h>
 #include <Hardware/ExceptionHandlers.h>
 #include <Hardware/IoPorts.h>
+#include "Cbor.h"
+#include "ObjectModelStreamer.h"
 
 namespace StackUsage
 {
@@ -24,6 +26,112 @@ namespace StackUsage
 	constexpr uint32_t GetObjectValue_withTable = 48;
 }
 
+#if SUPPORT_OBJECT_MODEL_CACHE
+
+// Cache of the table entries found by FindObjectModelTableEntry, indexed by a hash of the class descriptor, the table number and the element name.
+// The tables are constant, so a cached entry never becomes stale. Several tasks may look up object model values concurrently and there is no lock,
+// so a slot may have been overwritten by the time we read it. Therefore the caller checks that the entry it finds is in the table being searched and
+// has the right name. Reading and writing a pointer are atomic operations, and a cached entry that fails the check is just a cache miss.
+static_assert((ObjectModelCacheSize & (ObjectModelCacheSize - 1)) == 0);
+static const ObjectModelTableEntry *_ecv_null objectModelCache[ObjectModelCacheSize] = { 0 };
+
+static size_t GetObjectModelCacheSlot(const ObjectModelClassDescriptor *classDescriptor, uint8_t tableNumber, const char *_ecv_array idString) noexcept
+{
+	uint32_t hash = ((uint32_t)reinterpret_cast<uintptr_t>(classDescriptor) >> 2) ^ ((uint32_t)tableNumber << 24);
+	while (*idString != 0 && *idString != '.' && *idString != '[' && *idString != '^')
+	{
+		hash = (hash ^ (uint8_t)*idString) * 16777619u;				// FNV-1a
+		++idString;
+	}
+	return (hash ^ (hash >> 16)) & (ObjectModelCacheSize - 1);
+}
+
+#endif
+
+#if SUPPORT_OBJECT_MODEL_DELTAS
+
+// Table of the fingerprints of the values reported in delta reports, used to find out which values have changed since a client's snapshot.
+// Each value is identified by a key computed from its path from the root of the object model. The table is shared by all clients. When a report
+// finds that the fingerprint of a value differs from the one in the table, it records the new fingerprint and the snapshot number of the report.
+// A client that supplies the snapshot number of an earlier report is sent just the values that were found to have changed in later reports.
+// If we don't find a value in the table then we assume that it has changed, so a full table or a key collision only costs us some unchanged values.
+struct ObjectModelChangeTableEntry
+{
+	uint32_t key;									// 0 if the slot is free
+	uint32_t fingerprint;
+	uint32_t changedAt;								// the snapshot number of the report that found the value had changed
+};
+
+static_assert((ObjectModelChangeTableSize & (ObjectModelChangeTableSize - 1)) == 0);
+static ObjectModelChangeTableEntry *_ecv_null objectModelChangeTable = nullptr;		// allocated when the first delta report is requested
+static uint32_t firstSnapshot = 0, lastSnapshot = 0;
+static ReadWriteLock objectModelChangeTableLock;	// delta reports are made one at a time so that the snapshot numbers in the table increase
+
+// Return a fingerprint of a value that changes if the JSON representation of the value changes
+static uint32_t GetFingerprint(const ExpressionValue& val) noexcept
+{
+	uint32_t hash = 2166136261u ^ ((uint32_t)val.type << 24) ^ (uint32_t)val.param;
+	auto addString = [&hash](const char *_ecv_array _ecv_null str) noexcept -> void
+						{
+							while (str != nullptr && *str != 0)
+							{
+								hash = (hash ^ (uint8_t)*str) * 16777619u;			// FNV-1a
+								++str;
+							}
+						};
+
+	switch (val.GetType())
+	{
+	case TypeCode::None:
+	case TypeCode::Array:							// the caller records the number of elements of an array and then its elements separately
+		break;
+
+	case TypeCode::Bool:
+		hash ^= (uint32_t)val.bVal;
+		break;
+
+	case TypeCode::Char:
+		hash ^= (uint8_t)val.cVal;
+		break;
+
+	case TypeCode::CString:
+#if SUPPORT_CAN_EXPANSION
+	case TypeCode::CanExpansionBoardDetails:
+#endif
+		addString(val.sVal);
+		break;
+
+	case TypeCode::HeapString:
+		addString(val.shVal.Get().Ptr());
+		break;
+
+	case TypeCode::HeapArray:
+		hash ^= val.ahVal.GetNumElements();
+		break;
+
+	case TypeCode::Port:
+		{
+			String<StringLength50> portName;
+			val.iopVal->AppendPinName(portName.GetRef());
+			addString(portName.c_str());
+		}
+		break;
+
+	case TypeCode::Special:
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+		addString(reprap.GetPlatform().GetSysDir().Ptr());
+#endif
+		break;
+
+	default:										// all other types are held in 32 bits plus the parameter
+		hash ^= val.whole;
+		break;
+	}
+	return hash;
+}
+
+#endif
+
 ExpressionValue::ExpressionValue(const MacAddress& mac) noexcept : type((uint32_t)TypeCode::MacAddress_tc), param(mac.HighWord()), uVal(mac.LowWord())
 {
 }
@@ -123,6 +231,29 @@ void ExpressionValue::AppendAsString(const StringRef& str) const noexcept
 		str.cat("[array]");
 		break;
 
+	case TypeCode::HeapArray:
+		str.cat('{');
+		for (size_t i = 0; i < ahVal.GetNumElements(); ++i)
+		{
+			if (i != 0)
+			{
+				str.cat(',');
+			}
+			const ExpressionValue element = ahVal.GetElement(i);
+			if (element.IsStringType())
+			{
+				str.cat('"');
+				element.AppendAsString(str);
+				str.cat('"');
+			}
+			else
+			{
+				element.AppendAsString(str);
+			}
+		}
+		str.cat((ahVal.GetNumElements() == 1) ? ",}" : "}");		// a single-element array literal needs a trailing comma
+		break;
+
 	case TypeCode::Bitmap16:
 	case TypeCode::Bitmap32:
 	case TypeCode::Bitmap64:
@@ -152,6 +283,10 @@ ExpressionValue::ExpressionValue(const ExpressionValue& other) noexcept
 	{
 		shVal.IncreaseRefCount();
 	}
+	else if (type == (uint32_t)TypeCode::HeapArray)
+	{
+		ahVal.IncreaseRefCount();
+	}
 }
 
 ExpressionValue::ExpressionValue(ExpressionValue&& other) noexcept
@@ -179,6 +314,10 @@ ExpressionValue& ExpressionValue::operator=(const ExpressionValue& other) noexce
 		{
 			shVal.IncreaseRefCount();
 		}
+		else if (type == (uint32_t)TypeCode::HeapArray)
+		{
+			ahVal.IncreaseRefCount();
+		}
 	}
 	return *this;
 }
@@ -191,6 +330,11 @@ void ExpressionValue::Release() noexcept
 		shVal.Delete();
 		type = (uint32_t)TypeCode::None;
 	}
+	else if (type == (uint32_t)TypeCode::HeapArray)
+	{
+		ahVal.Delete();
+		type = (uint32_t)TypeCode::None;
+	}
 }
 
 #if SUPPORT_CAN_EXPANSION
@@ -297,10 +441,22 @@ ObjectModel::ObjectModel() noexcept
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, const char *reportFlags, unsigned int initialMaxDepth, size_t initialBufferOffset) noexcept
 	: startMillis(millis()), initialBufOffset(initialBufferOffset), maxDepth(initialMaxDepth), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
 	  line(-1), column(-1), gb(gbp),
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	  numLocksHeld(0),
+#endif
 	  shortForm(false), wantArrayLength(wal), wantExists(false),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(true), excludeObsolete(true),
 	  obsoleteFieldQueried(false)
+#if SUPPORT_OBJECT_MODEL_CBOR
+	  , binaryReport(false)
+#endif
+#if SUPPORT_OBJECT_MODEL_DELTAS
+	  , deltaReport(false), reportAllValues(false)
+#endif
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	  , streaming(false), handedOverOutput(false)
+#endif
 {
 	while (true)
 	{
@@ -342,6 +498,24 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 				++reportFlags;
 			}
 			break;
+#if SUPPORT_OBJECT_MODEL_CBOR
+		case 'b':
+			binaryReport = true;
+			break;
+#endif
+#if SUPPORT_OBJECT_MODEL_DELTAS
+		case 'c':
+			deltaReport = true;
+			changesSince = 0;
+			while (isdigit(*reportFlags))
+			{
+				changesSince = (10 * changesSince) + (*reportFlags - '0');
+				++reportFlags;
+			}
+			snapshot = valueKey = 0;
+			numChangedValues = 0;
+			break;
+#endif
 		case ' ':
 		case ',':
 			break;
@@ -356,13 +530,34 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, bool wex, int p_line, int p_col) noexcept
 	: startMillis(millis()), initialBufOffset(0), maxDepth(99), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
 	  line(p_line), column(p_col), gb(gbp),
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	  numLocksHeld(0),
+#endif
 	  shortForm(false), wantArrayLength(wal), wantExists(wex),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(false), excludeObsolete(false),
 	  obsoleteFieldQueried(false)
+#if SUPPORT_OBJECT_MODEL_CBOR
+	  , binaryReport(false)
+#endif
+#if SUPPORT_OBJECT_MODEL_DELTAS
+	  , deltaReport(false), reportAllValues(false)
+#endif
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	  , streaming(false), handedOverOutput(false)
+#endif
 {
 }
 
+/*static*/ bool ObjectExplorationContext::WantBinaryReport(const char *_ecv_array reportFlags) noexcept
+{
+#if SUPPORT_OBJECT_MODEL_CBOR
+	return strchr(reportFlags, 'b') != nullptr;
+#else
+	return false;
+#endif
+}
+
 int32_t ObjectExplorationContext::GetIndex(size_t n) const THROWS(GCodeException)
 {
 	if (n < numIndicesCounted)
@@ -381,6 +576,77 @@ int32_t ObjectExplorationContext::GetLastIndex() const THROWS(GCodeException)
 	THROW_INTERNAL_ERROR;
 }
 
+#if SUPPORT_OBJECT_MODEL_DELTAS
+
+// Set the snapshot number of this delta report. If the client supplied a snapshot number that we didn't issue, for example because we have been reset since, report all values.
+void ObjectExplorationContext::StartDeltaReport(uint32_t p_snapshot, uint32_t firstValidSnapshot) noexcept
+{
+	snapshot = p_snapshot;
+	if (changesSince < firstValidSnapshot || changesSince >= p_snapshot)
+	{
+		changesSince = 0;
+		reportAllValues = true;
+	}
+}
+
+// Extend the key of the value we are reporting with the identity of a field or array element within it, returning the old key
+uint32_t ObjectExplorationContext::EnterValue(uint32_t id) noexcept
+{
+	const uint32_t oldKey = valueKey;
+	uint32_t key = (oldKey * 31u) + id;
+	key ^= key >> 16;
+	key *= 0x85EBCA6Bu;
+	key ^= key >> 13;
+	valueKey = key;
+	return oldKey;
+}
+
+// Record a value that we are about to report in a delta report. Return true if it has changed since the client's snapshot or we are reporting all values.
+// The caller must hold the lock on the change table.
+bool ObjectExplorationContext::RecordValue(const ExpressionValue& val) noexcept
+{
+	const uint32_t key = (valueKey == 0) ? 1 : valueKey;
+	const uint32_t fingerprint = GetFingerprint(val);
+	uint32_t changedAt = snapshot;
+	ObjectModelChangeTableEntry *_ecv_null slot = nullptr;
+	for (size_t i = 0; i < ObjectModelChangeTableMaxProbes; ++i)
+	{
+		ObjectModelChangeTableEntry& e = objectModelChangeTable[(key + i) & (ObjectModelChangeTableSize - 1)];
+		if (e.key == key)
+		{
+			if (e.fingerprint == fingerprint)
+			{
+				changedAt = e.changedAt;
+			}
+			slot = &e;
+			break;
+		}
+		if (e.key == 0)								// entries are never removed, so the value isn't in the table
+		{
+			slot = &e;
+			break;
+		}
+	}
+
+	if (slot == nullptr)
+	{
+		// No free slot, so replace the one at the end of the probe sequence
+		slot = &objectModelChangeTable[(key + ObjectModelChangeTableMaxProbes - 1) & (ObjectModelChangeTableSize - 1)];
+	}
+	slot->key = key;
+	slot->fingerprint = fingerprint;
+	slot->changedAt = changedAt;
+
+	if (reportAllValues || changedAt > changesSince)
+	{
+		++numChangedValues;
+		return true;
+	}
+	return false;
+}
+
+#endif
+
 bool ObjectExplorationContext::ShouldReport(const ObjectModelEntryFlags f) const noexcept
 {
 	const bool wanted = includeNonLive
@@ -421,6 +687,22 @@ void ObjectExplorationContext::CheckStack(uint32_t calledFunctionStackUsage) con
 	SoftwareReset(SoftwareResetReason::stackOverflow, (const uint32_t *)stackPtr);
 }
 
+#if SUPPORT_OBJECT_MODEL_STREAMING
+
+// The objects at the first two levels of the object model are never deleted, but deeper objects such as the kinematics may be replaced at any time
+constexpr unsigned int MaxStreamingPauseDepth = 2;
+
+// If we are streaming the report, hand over what we have generated so far provided that we hold no locks and no pointers to objects that might be deleted
+static void StreamingPausePoint(OutputBuffer *buf, ObjectExplorationContext& context) THROWS(GCodeException)
+{
+	if (context.CanPause() && context.GetCurrentDepth() <= MaxStreamingPauseDepth && ObjectModelStreamer::PausePoint(buf))
+	{
+		context.SetHandedOverOutput();
+	}
+}
+
+#endif
+
 // Report this object
 void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor,
 								uint8_t tableNumber, const char *_ecv_array filter) const THROWS(GCodeException)
@@ -436,7 +718,19 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 		while (classDescriptor != nullptr)
 		{
 			const uint8_t * const descriptor = classDescriptor->omd;
-			if (tableNumber < descriptor[0])
+			if (*filter != 0 && *filter != '*')
+			{
+				// The filter names a single element and the names in a table are unique, so look it up instead of comparing the filter with every entry
+				const ObjectModelTableEntry * const e = FindObjectModelTableEntry(classDescriptor, tableNumber, filter);
+				if (e != nullptr && context.ShouldReport(e->flags) && e->ReportAsJson(buf, context, classDescriptor, this, filter, !added))
+				{
+					added = true;
+				}
+#if SUPPORT_OBJECT_MODEL_STREAMING
+				StreamingPausePoint(buf, context);
+#endif
+			}
+			else if (tableNumber < descriptor[0])
 			{
 				const ObjectModelTableEntry *tbl = classDescriptor->omt;
 				for (size_t i = 0; i < tableNumber; ++i)
@@ -453,6 +747,9 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 						{
 							added = true;
 						}
+#if SUPPORT_OBJECT_MODEL_STREAMING
+						StreamingPausePoint(buf, context);
+#endif
 					}
 					--numEntries;
 					++tbl;
@@ -469,30 +766,169 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 		{
 			if (*filter == 0)
 			{
-				buf->cat('}');
+				ReportEndObject(buf, context);
 			}
 		}
+		else if (*filter == 0)
+		{
+			ReportEmptyObject(buf, context);
+		}
 		else
 		{
-			buf->cat((*filter == 0) ? "{}" : "null");
+			ReportNull(buf, context);
 		}
 		context.DecreaseDepth();
 	}
 	else
 	{
-		buf->cat("{}");
+		ReportEmptyObject(buf, context);
 	}
 }
 
 // Construct a JSON representation of those parts of the object model requested by the user. This version is called on the root of the tree.
-void ObjectModel::ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException)
+// If 'streaming' is true then we are running in the object model streamer task, which takes the report from the buffer in chunks as we generate it.
+void ObjectModel::ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength, bool streaming) const THROWS(GCodeException)
 {
 	const unsigned int defaultMaxDepth = (wantArrayLength) ? 99 : (filter[0] == 0) ? 1 : 99;
 	ObjectExplorationContext context(gb, wantArrayLength, reportFlags, defaultMaxDepth, buf->Length());
-	ReportAsJson(buf, context, nullptr, 0, filter);
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	if (streaming && !context.IsDeltaReport())			// a delta report may need to remove data that we have already written, so we can't stream it
+	{
+		context.StartStreaming();
+	}
+#endif
+#if SUPPORT_OBJECT_MODEL_DELTAS
+	if (context.IsDeltaReport())
+	{
+		WriteLocker lock(objectModelChangeTableLock);
+		if (objectModelChangeTable == nullptr)
+		{
+			objectModelChangeTable = new ObjectModelChangeTableEntry[ObjectModelChangeTableSize];
+			memset(objectModelChangeTable, 0, ObjectModelChangeTableSize * sizeof(ObjectModelChangeTableEntry));
+			firstSnapshot = lastSnapshot = (uint32_t)random(0x40000000);	// start at a random number so that a client is unlikely to quote a valid snapshot number after we are reset
+		}
+		context.StartDeltaReport(++lastSnapshot, firstSnapshot + 1);
+		ReportAsJson(buf, context, nullptr, 0, filter);
+		ReportFieldName(buf, context, "snapshot", false);
+		ReportInteger(buf, context, context.GetSnapshot());
+	}
+	else
+#endif
+	{
+		ReportAsJson(buf, context, nullptr, 0, filter);
+	}
 	if (context.GetNextElement() >= 0)
 	{
-		buf->catf(",\"next\":%d", context.GetNextElement());
+		ReportFieldName(buf, context, "next", false);
+		ReportInteger(buf, context, context.GetNextElement());
+	}
+}
+
+// Functions to write the parts of a report that differ between JSON and CBOR
+/*static*/ void ObjectModel::ReportStartObject(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::StartMap(buf);
+	}
+	else
+	{
+		buf->cat('{');
+	}
+}
+
+/*static*/ void ObjectModel::ReportFieldName(OutputBuffer *buf, const ObjectExplorationContext& context, const char *_ecv_array name, bool first) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::WriteString(buf, name);
+	}
+	else
+	{
+		buf->cat((first) ? "\"" : ",\"");
+		buf->cat(name);
+		buf->cat("\":");
+	}
+}
+
+/*static*/ void ObjectModel::ReportEndObject(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::EndArrayOrMap(buf);
+	}
+	else
+	{
+		buf->cat('}');
+	}
+}
+
+/*static*/ void ObjectModel::ReportEmptyObject(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::WriteEmptyMap(buf);
+	}
+	else
+	{
+		buf->cat("{}");
+	}
+}
+
+/*static*/ void ObjectModel::ReportStartArray(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::StartArray(buf);
+	}
+	else
+	{
+		buf->cat('[');
+	}
+}
+
+// Write the separator that goes before every array element except the first. CBOR doesn't need one.
+/*static*/ void ObjectModel::ReportArraySeparator(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (!context.IsBinaryReport())
+	{
+		buf->cat(',');
+	}
+}
+
+/*static*/ void ObjectModel::ReportEndArray(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::EndArrayOrMap(buf);
+	}
+	else
+	{
+		buf->cat(']');
+	}
+}
+
+/*static*/ void ObjectModel::ReportNull(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::WriteNull(buf);
+	}
+	else
+	{
+		buf->cat("null");
+	}
+}
+
+/*static*/ void ObjectModel::ReportInteger(OutputBuffer *buf, const ObjectExplorationContext& context, int64_t val) noexcept
+{
+	if (context.IsBinaryReport())
+	{
+		Cbor::WriteInteger(buf, val);
+	}
+	else
+	{
+		buf->catf("%" PRIi64, val);
 	}
 }
 
@@ -513,7 +949,11 @@ inline void ObjectModel::ReportItemAsJson(OutputBuffer *buf, ObjectExplorationCo
 			|| val.omVal == nullptr					// OM arrays may contain null entries, so we need to handle them here
 		   )
 		{
-			buf->cat("null");
+			if (context.IsDeltaReport())
+			{
+				(void)context.RecordValue(val);
+			}
+			ReportNull(buf, context);
 		}
 		else
 		{
@@ -521,7 +961,13 @@ inline void ObjectModel::ReportItemAsJson(OutputBuffer *buf, ObjectExplorationCo
 			{
 				++filter;
 			}
+			// In a delta report, if the object has only just appeared then report all of it, not just the values that have changed
+			const bool reportedAllValues = context.IsDeltaReport() && context.ReportAllValues(context.RecordValue(val));
 			val.omVal->ReportAsJson(buf, context, (val.omVal == this) ? classDescriptor : nullptr, val.param, filter);
+			if (context.IsDeltaReport())
+			{
+				context.ReportAllValues(reportedAllValues);
+			}
 		}
 	}
 	else
@@ -535,28 +981,32 @@ void ObjectModel::ReportArrayLengthAsJson(OutputBuffer *buf, ObjectExplorationCo
 	switch (val.GetType())
 	{
 	case TypeCode::Array:
-		buf->catf("%u", val.omadVal->GetNumElements(this, context));
+		ReportInteger(buf, context, val.omadVal->GetNumElements(this, context));
 		break;
 
 	case TypeCode::Bitmap16:
 	case TypeCode::Bitmap32:
-		buf->catf("%u", Bitmap<uint32_t>::MakeFromRaw(val.uVal).CountSetBits());
+		ReportInteger(buf, context, Bitmap<uint32_t>::MakeFromRaw(val.uVal).CountSetBits());
 		break;
 
 	case TypeCode::Bitmap64:
-		buf->catf("%u", Bitmap<uint64_t>::MakeFromRaw(val.Get56BitValue()).CountSetBits());
+		ReportInteger(buf, context, Bitmap<uint64_t>::MakeFromRaw(val.Get56BitValue()).CountSetBits());
 		break;
 
 	case TypeCode::CString:
-		buf->catf("%u", strlen(val.sVal));
+		ReportInteger(buf, context, strlen(val.sVal));
 		break;
 
 	case TypeCode::HeapString:
-		buf->catf("%u", val.shVal.GetLength());
+		ReportInteger(buf, context, val.shVal.GetLength());
+		break;
+
+	case TypeCode::HeapArray:
+		ReportInteger(buf, context, val.ahVal.GetNumElements());
 		break;
 
 	default:
-		buf->cat("null");
+		ReportNull(buf, context);
 		break;
 	}
 }
@@ -566,6 +1016,17 @@ void ObjectModel::ReportArrayLengthAsJson(OutputBuffer *buf, ObjectExplorationCo
 void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 										const ExpressionValue& val, const char *filter) const THROWS(GCodeException)
 {
+	if (context.IsDeltaReport() && val.GetType() != TypeCode::Array)
+	{
+		(void)context.RecordValue(val);				// we report the value even if it hasn't changed, because it may be an element of an array that has changed
+	}
+
+	if (context.IsBinaryReport() && val.GetType() != TypeCode::Array && val.GetType() != TypeCode::HeapArray)
+	{
+		ReportValueAsCbor(buf, context, val, filter);
+		return;
+	}
+
 	switch (val.GetType())
 	{
 	case TypeCode::Array:
@@ -582,24 +1043,28 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 				const int32_t index = StrToI32(filter, &endptr);
 				if (endptr == filter || *endptr != ']' || index < 0 || (size_t)index >= val.omadVal->GetNumElements(this, context))
 				{
-					buf->cat("null");					// avoid returning badly-formed JSON
+					ReportNull(buf, context);			// avoid returning badly-formed JSON
 					break;								// invalid syntax, or index out of range
 				}
 				if (*filter == 0)
 				{
-					buf->cat('[');
+					ReportStartArray(buf, context);
 				}
 				context.AddIndex(index);
 				{
 					// As at release 3.1.1 this next block uses the most stack of this entire function
 					ReadLocker lock(val.omadVal->lockPointer);
+					context.LockTaken(val.omadVal->lockPointer);
 					const ExpressionValue element = val.omadVal->GetElement(this, context);
+					const uint32_t oldKey = context.EnterValue(index);
 					ReportItemAsJson(buf, context, classDescriptor, element, endptr + 1);
+					context.LeaveValue(oldKey);
+					context.LockReleased(val.omadVal->lockPointer);
 				}
 				context.RemoveIndex();
 				if (*filter == 0)
 				{
-					buf->cat(']');
+					ReportEndArray(buf, context);
 				}
 			}
 		}
@@ -609,10 +1074,46 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 		}
 		else
 		{
-			buf->cat("null");
+			ReportNull(buf, context);
 		}
 		break;
 
+	case TypeCode::HeapArray:
+		if (*filter == '[')
+		{
+			++filter;
+			if (*filter != ']')						// if reporting on [parts of] a single element
+			{
+				const char *endptr;
+				const int32_t index = StrToI32(filter, &endptr);
+				if (endptr == filter || *endptr != ']' || index < 0 || (size_t)index >= val.ahVal.GetNumElements())
+				{
+					ReportNull(buf, context);		// avoid returning badly-formed JSON
+					break;							// invalid syntax, or index out of range
+				}
+				const ExpressionValue element = val.ahVal.GetElement(index);
+				const uint32_t oldKey = context.EnterValue(index);
+				ReportItemAsJson(buf, context, classDescriptor, element, endptr + 1);
+				context.LeaveValue(oldKey);
+				break;
+			}
+			++filter;
+		}
+		ReportStartArray(buf, context);
+		for (size_t i = 0; i < val.ahVal.GetNumElements(); ++i)
+		{
+			if (i != 0)
+			{
+				ReportArraySeparator(buf, context);
+			}
+			const ExpressionValue element = val.ahVal.GetElement(i);
+			const uint32_t oldKey = context.EnterValue(i);
+			ReportItemAsJson(buf, context, classDescriptor, element, filter);
+			context.LeaveValue(oldKey);
+		}
+		ReportEndArray(buf, context);
+		break;
+
 	case TypeCode::Float:
 		ReportFloat(buf, val);
 		break;
@@ -793,6 +1294,106 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 	}
 }
 
+// Report a value that is not an array or object in CBOR format
+// This is a separate function to avoid having a string buffer on the stack of a recursive function
+/*static*/ void ObjectModel::ReportValueAsCbor(OutputBuffer *buf, const ObjectExplorationContext& context, const ExpressionValue& val, const char *_ecv_array filter) noexcept
+{
+	switch (val.GetType())
+	{
+	case TypeCode::Float:
+		Cbor::WriteFloat(buf, val.fVal, val.param);
+		break;
+
+	case TypeCode::Uint32:
+		Cbor::WriteUnsigned(buf, val.uVal);
+		break;
+
+	case TypeCode::Uint64:
+		Cbor::WriteUnsigned(buf, ((uint64_t)val.param << 32) | val.uVal);
+		break;
+
+	case TypeCode::Int32:
+		Cbor::WriteInteger(buf, val.iVal);
+		break;
+
+	case TypeCode::CString:
+		Cbor::WriteString(buf, val.sVal);
+		break;
+
+	case TypeCode::HeapString:
+		Cbor::WriteString(buf, val.shVal.Get().Ptr());
+		break;
+
+	case TypeCode::Bitmap16:
+	case TypeCode::Bitmap32:
+	case TypeCode::Bitmap64:
+		{
+			const uint64_t bits = (val.GetType() == TypeCode::Bitmap64) ? val.Get56BitValue() : val.uVal;
+			const auto bm = Bitmap<uint64_t>::MakeFromRaw(bits);
+			if (*filter == '[')
+			{
+				++filter;
+				if (*filter != ']')					// if reporting on a single element of the array
+				{
+					const char *endptr;
+					const int32_t index = StrToI32(filter, &endptr);
+					int bitNumber;
+					if (endptr == filter || *endptr != ']' || index < 0 || (bitNumber = bm.GetSetBitNumber(index)) < 0)
+					{
+						Cbor::WriteNull(buf);
+					}
+					else
+					{
+						Cbor::WriteUnsigned(buf, (unsigned int)bitNumber);
+					}
+					break;
+				}
+			}
+			else if (context.ShortFormReport())
+			{
+				Cbor::WriteUnsigned(buf, bits);
+				break;
+			}
+
+			// If we get here then we want a long form report
+			Cbor::StartArray(buf);
+			bm.Iterate([buf](unsigned int bn, unsigned int count) noexcept { Cbor::WriteUnsigned(buf, bn); });
+			Cbor::EndArrayOrMap(buf);
+		}
+		break;
+
+	case TypeCode::Enum32:
+		if (context.ShortFormReport())
+		{
+			Cbor::WriteUnsigned(buf, val.uVal);
+		}
+		else
+		{
+			Cbor::WriteString(buf, "unimplemented");
+		}
+		break;
+
+	case TypeCode::Bool:
+		Cbor::WriteBool(buf, val.bVal);
+		break;
+
+	case TypeCode::None:
+	case TypeCode::ObjectModel_tc:					// ReportItemAsJson handles objects, so we should not get here
+	case TypeCode::Array:
+	case TypeCode::HeapArray:
+		Cbor::WriteNull(buf);
+		break;
+
+	default:										// all the remaining types are reported as strings
+		{
+			String<StringLength100> str;
+			val.AppendAsString(str.GetRef());
+			Cbor::WriteString(buf, str.c_str(), str.strlen());
+		}
+		break;
+	}
+}
+
 // This is a separate function to avoid having a string buffer on the stack of a recursive function
 void ObjectModel::ReportPinNameAsJson(OutputBuffer *buf, const ExpressionValue& val) noexcept
 {
@@ -807,12 +1408,17 @@ void ObjectModel::ReportPinNameAsJson(OutputBuffer *buf, const ExpressionValue&
 void ObjectModel::ReportArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 										const ObjectModelArrayDescriptor *omad, const char *_ecv_array filter) const THROWS(GCodeException)
 {
-	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset());		// it's a root array if we haven't started writing to the buffer yet
+	// It's a root array if we haven't started writing to the buffer yet. If we are streaming and have handed over part of the report then the buffer length no longer tells us that.
+	const bool isRootArray = !context.HaveHandedOverOutput() && buf->Length() == context.GetInitialBufferOffset();
 	ReadLocker lock(omad->lockPointer);
+	context.LockTaken(omad->lockPointer);
 
-	buf->cat('[');
+	ReportStartArray(buf, context);
 	const size_t count = omad->GetNumElements(this, context);
 	const size_t startElement = (isRootArray) ? context.GetStartElement() : 0;
+
+	// In a delta report, if the number of elements has changed then report all of each element, because the client can't tell which elements were added or removed
+	const bool reportedAllValues = context.IsDeltaReport() && context.ReportAllValues(context.RecordValue(ExpressionValue((int32_t)count)));
 	for (size_t i = startElement; i < count; ++i)
 	{
 		// Support retrieving just part of the array in case it is too large to write all of it to the buffer
@@ -824,18 +1430,28 @@ void ObjectModel::ReportArrayAsJson(OutputBuffer *buf, ObjectExplorationContext&
 				context.SetNextElement(i);
 				break;
 			}
-			buf->cat(',');
+			ReportArraySeparator(buf, context);
 		}
 		context.AddIndex(i);
 		const ExpressionValue element = omad->GetElement(this, context);
+		const uint32_t oldKey = context.EnterValue(i);
 		ReportItemAsJson(buf, context, classDescriptor, element, filter);
+		context.LeaveValue(oldKey);
 		context.RemoveIndex();
+#if SUPPORT_OBJECT_MODEL_STREAMING
+		StreamingPausePoint(buf, context);
+#endif
 	}
 	if (isRootArray && context.GetNextElement() < 0)
 	{
 		context.SetNextElement(0);
 	}
-	buf->cat(']');
+	ReportEndArray(buf, context);
+	if (context.IsDeltaReport())
+	{
+		context.ReportAllValues(reportedAllValues);
+	}
+	context.LockReleased(omad->lockPointer);
 }
 
 // Find the requested entry
@@ -854,6 +1470,21 @@ const ObjectModelTableEntry* ObjectModel::FindObjectModelTableEntry(const Object
 	}
 
 	const size_t numEntries = descriptor[tableNumber + 1];
+
+#if SUPPORT_OBJECT_MODEL_CACHE
+	// Wildcards match whatever entry the search looks at first, so don't use the cache for them
+	const bool useCache = (idString[0] != 0 && idString[0] != '*');
+	const size_t cacheSlot = (useCache) ? GetObjectModelCacheSlot(classDescriptor, tableNumber, idString) : 0;
+	if (useCache)
+	{
+		const ObjectModelTableEntry *_ecv_null const cached = objectModelCache[cacheSlot];
+		if (cached >= tbl && cached < tbl + numEntries && cached->IdCompare(idString) == 0)
+		{
+			return cached;
+		}
+	}
+#endif
+
 	size_t low = 0, high = numEntries;
 	while (high > low)
 	{
@@ -861,6 +1492,12 @@ const ObjectModelTableEntry* ObjectModel::FindObjectModelTableEntry(const Object
 		const int t = tbl[mid].IdCompare(idString);
 		if (t == 0)
 		{
+#if SUPPORT_OBJECT_MODEL_CACHE
+			if (useCache)
+			{
+				objectModelCache[cacheSlot] = &tbl[mid];
+			}
+#endif
 			return &tbl[mid];
 		}
 		if (t > 0)
@@ -874,6 +1511,12 @@ const ObjectModelTableEntry* ObjectModel::FindObjectModelTableEntry(const Object
 	}
 	if (low < numEntries && tbl[low].IdCompare(idString) == 0)
 	{
+#if SUPPORT_OBJECT_MODEL_CACHE
+		if (useCache)
+		{
+			objectModelCache[cacheSlot] = &tbl[low];
+		}
+#endif
 		return &tbl[low];
 	}
 	return nullptr;
@@ -900,15 +1543,30 @@ bool ObjectModelTableEntry::ReportAsJson(OutputBuffer* buf, ObjectExplorationCon
 	const ExpressionValue val = func(self, context);
 	// We include nulls if either the "include nulls" flag is set or the "include important" flag is set and the field is flagged important.
 	// The latter is so that field state.messageBox gets reported to PanelDue even if null when the "important" flag is set, so that PanelDue knows when a message has been cleared.
-	if (val.GetType() != TypeCode::None || context.ShouldIncludeNulls() || (context.ShouldIncludeImportant() && ((uint8_t)flags & (uint8_t)ObjectModelEntryFlags::important)))
+	// In a delta report we include nulls because the value may have changed to null.
+	if (   val.GetType() != TypeCode::None || context.ShouldIncludeNulls() || context.IsDeltaReport()
+		|| (context.ShouldIncludeImportant() && ((uint8_t)flags & (uint8_t)ObjectModelEntryFlags::important))
+	   )
 	{
+		// In a delta report we leave out fields that contain no changed values, so remember where this one starts
+		const size_t startLength = (context.IsDeltaReport()) ? buf->Length() : 0;
+		const unsigned int numChangedValues = context.GetNumChangedValues();
 		if (*filter == 0)
 		{
-			buf->cat((first) ? "{\"" : ",\"");
-			buf->cat(name);
-			buf->cat("\":");
+			if (first)
+			{
+				ObjectModel::ReportStartObject(buf, context);
+			}
+			ObjectModel::ReportFieldName(buf, context, name, first);
 		}
+		const uint32_t oldKey = context.EnterValue((uint32_t)reinterpret_cast<uintptr_t>(this));
 		self->ReportItemAsJson(buf, context, classDescriptor, val, nextElement);
+		context.LeaveValue(oldKey);
+		if (context.IsDeltaReport() && *filter == 0 && context.GetNumChangedValues() == numChangedValues)
+		{
+			buf->TruncateTo(startLength);
+			return false;
+		}
 		return true;
 	}
 	return false;
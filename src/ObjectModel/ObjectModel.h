@@ -11,6 +11,7 @@
 #include <RepRapFirmware.h>
 #include <GCodes/GCodeException.h>
 #include <Platform/Heap.h>
+#include <Platform/ArrayHandle.h>
 
 #if SUPPORT_OBJECT_MODEL
 
@@ -45,6 +46,7 @@ enum class TypeCode : uint8_t
 	Special,
 	Port,
 	UniqueId_tc,
+	HeapArray,			// array held in a variable
 #if SUPPORT_CAN_EXPANSION
 	CanExpansionBoardDetails
 #endif
@@ -93,12 +95,14 @@ struct ExpressionValue
 		const ObjectModel *omVal;					// object of some class derived from ObjectModel
 		const ObjectModelArrayDescriptor *omadVal;
 		StringHandle shVal;
+		ArrayHandle ahVal;
 		const IoPort *iopVal;
 		const UniqueId *uniqueIdVal;
 		uint32_t whole;								// a member we can use to copy the whole thing safely, at least as big as all the others. Assumes all other members are trivially copyable.
 	};
 
 	static_assert(sizeof(whole) >= sizeof(shVal));
+	static_assert(sizeof(whole) >= sizeof(ahVal));
 	static_assert(sizeof(whole) >= sizeof(omVal));
 	static_assert(sizeof(whole) >= sizeof(fVal));
 
@@ -140,6 +144,7 @@ struct ExpressionValue
 	explicit ExpressionValue(const MacAddress& mac) noexcept;
 	ExpressionValue(SpecialType s, uint32_t u) noexcept : type((uint32_t)TypeCode::Special), param((uint32_t)s), uVal(u) { }
 	explicit ExpressionValue(StringHandle h) noexcept : type((uint32_t)TypeCode::HeapString), param(0), shVal(h) { }
+	explicit ExpressionValue(ArrayHandle ah) noexcept : type((uint32_t)TypeCode::HeapArray), param(0), ahVal(ah) { }
 	explicit ExpressionValue(const IoPort& p) noexcept : type((uint32_t)TypeCode::Port), param(0), iopVal(&p) { }
 	explicit ExpressionValue(const UniqueId& id) noexcept : type((uint32_t)TypeCode::UniqueId_tc), param(0), uniqueIdVal(&id) { }
 #if SUPPORT_CAN_EXPANSION
@@ -175,6 +180,7 @@ struct ExpressionValue
 	}
 
 	void Set(StringHandle sh) noexcept { Release(); type = (uint32_t)TypeCode::HeapString; shVal = sh; }
+	void Set(ArrayHandle ah) noexcept { Release(); type = (uint32_t)TypeCode::HeapArray; ahVal = ah; }
 	void Set(std::nullptr_t dummy) noexcept { Release();  type = (uint32_t)TypeCode::None; }
 
 	// Store a 56-bit value
@@ -228,6 +234,7 @@ public:
 	void SetMaxDepth(unsigned int d) noexcept { maxDepth = d; }
 	bool IncreaseDepth() noexcept { if (currentDepth < maxDepth) { ++currentDepth; return true; } return false; }
 	void DecreaseDepth() noexcept { --currentDepth; }
+	unsigned int GetCurrentDepth() const noexcept { return currentDepth; }
 	void AddIndex(int32_t index) THROWS(GCodeException);
 	void AddIndex() THROWS(GCodeException);
 	void RemoveIndex() THROWS(GCodeException);
@@ -250,6 +257,51 @@ public:
 	bool ObsoleteFieldQueried() const noexcept { return obsoleteFieldQueried; }
 	void SetObsoleteFieldQueried() noexcept { obsoleteFieldQueried = true; }
 
+#if SUPPORT_OBJECT_MODEL_CBOR
+	bool IsBinaryReport() const noexcept { return binaryReport; }
+#else
+	constexpr bool IsBinaryReport() const noexcept { return false; }
+#endif
+
+	// Return true if the report flags ask for a report in CBOR format instead of JSON
+	static bool WantBinaryReport(const char *_ecv_array reportFlags) noexcept;
+
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	// Functions used when the report is handed to the network in chunks while we generate it
+	bool IsStreaming() const noexcept { return streaming; }
+	void StartStreaming() noexcept { streaming = true; }
+	bool HaveHandedOverOutput() const noexcept { return handedOverOutput; }
+	void SetHandedOverOutput() noexcept { handedOverOutput = true; }
+	void LockTaken(const ReadWriteLock *null lock) noexcept { if (lock != nullptr) { ++numLocksHeld; } }
+	void LockReleased(const ReadWriteLock *null lock) noexcept { if (lock != nullptr) { --numLocksHeld; } }
+	bool CanPause() const noexcept { return streaming && numLocksHeld == 0; }
+#else
+	constexpr bool IsStreaming() const noexcept { return false; }
+	constexpr bool HaveHandedOverOutput() const noexcept { return false; }
+	void LockTaken(const ReadWriteLock *null lock) noexcept { }
+	void LockReleased(const ReadWriteLock *null lock) noexcept { }
+	constexpr bool CanPause() const noexcept { return false; }
+#endif
+
+#if SUPPORT_OBJECT_MODEL_DELTAS
+	// Functions used when reporting only the values that have changed since the client's snapshot
+	bool IsDeltaReport() const noexcept { return deltaReport; }
+	uint32_t GetSnapshot() const noexcept { return snapshot; }
+	void StartDeltaReport(uint32_t p_snapshot, uint32_t firstValidSnapshot) noexcept;
+	uint32_t EnterValue(uint32_t id) noexcept;
+	void LeaveValue(uint32_t oldKey) noexcept { valueKey = oldKey; }
+	bool RecordValue(const ExpressionValue& val) noexcept;
+	unsigned int GetNumChangedValues() const noexcept { return numChangedValues; }
+	bool ReportAllValues(bool b) noexcept { const bool ret = reportAllValues; reportAllValues = b; return ret; }
+#else
+	constexpr bool IsDeltaReport() const noexcept { return false; }
+	uint32_t EnterValue(uint32_t id) noexcept { return 0; }
+	void LeaveValue(uint32_t oldKey) noexcept { }
+	bool RecordValue(const ExpressionValue& val) noexcept { return true; }
+	unsigned int GetNumChangedValues() const noexcept { return 0; }
+	bool ReportAllValues(bool b) noexcept { return false; }
+#endif
+
 	GCodeException ConstructParseException(const char *msg) const noexcept;
 	GCodeException ConstructParseException(const char *msg, const char *sparam) const noexcept;
 	void CheckStack(uint32_t calledFunctionStackUsage) const THROWS(GCodeException);
@@ -269,6 +321,15 @@ private:
 	int line;
 	int column;
 	const GCodeBuffer *_ecv_null gb;
+#if SUPPORT_OBJECT_MODEL_DELTAS
+	uint32_t changesSince;							// the snapshot number that the client supplied
+	uint32_t snapshot;								// the snapshot number of this report
+	uint32_t valueKey;								// identifies the value we are reporting by its path from the root
+	unsigned int numChangedValues;					// how many changed values we have reported
+#endif
+#if SUPPORT_OBJECT_MODEL_STREAMING
+	unsigned int numLocksHeld;						// how many object model read locks we hold, because we mustn't hand over the report while holding one
+#endif
 	unsigned int shortForm : 1,
 				wantArrayLength : 1,
 				wantExists : 1,
@@ -277,7 +338,19 @@ private:
 				includeNulls : 1,
 				excludeVerbose : 1,
 				excludeObsolete : 1,
-				obsoleteFieldQueried : 1;
+				obsoleteFieldQueried : 1
+#if SUPPORT_OBJECT_MODEL_CBOR
+				, binaryReport : 1
+#endif
+#if SUPPORT_OBJECT_MODEL_DELTAS
+				, deltaReport : 1,
+				reportAllValues : 1
+#endif
+#if SUPPORT_OBJECT_MODEL_STREAMING
+				, streaming : 1,
+				handedOverOutput : 1						// true if the streamer has taken some of the report from the buffer, so its length no longer tells us where we are
+#endif
+				;
 };
 
 // Entry to describe an array of objects or values. These must be brace-initializable into flash memory.
@@ -299,7 +372,7 @@ public:
 	virtual ~ObjectModel() { }
 
 	// Construct a JSON representation of those parts of the object model requested by the user. This version is called only on the root of the tree.
-	void ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException);
+	void ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength, bool streaming = false) const THROWS(GCodeException);
 
 	// Get the value of an object via the table
 	ExpressionValue GetObjectValueUsingTableNumber(ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, const char *_ecv_array idString, uint8_t tableNumber) const THROWS(GCodeException);
@@ -311,6 +384,17 @@ public:
 	// Skip the current element in the ID or filter string
 	static const char* GetNextElement(const char *id) noexcept;
 
+	// Functions to write the parts of a report that differ between JSON and CBOR
+	static void ReportStartObject(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportFieldName(OutputBuffer *buf, const ObjectExplorationContext& context, const char *_ecv_array name, bool first) noexcept;
+	static void ReportEndObject(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportEmptyObject(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportStartArray(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportArraySeparator(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportEndArray(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportNull(OutputBuffer *buf, const ObjectExplorationContext& context) noexcept;
+	static void ReportInteger(OutputBuffer *buf, const ObjectExplorationContext& context, int64_t val) noexcept;
+
 protected:
 	// Construct a JSON representation of those parts of the object model requested by the user
 	// Overridden in class GlobalVariables
@@ -337,6 +421,7 @@ private:
 	__attribute__ ((noinline)) static void ReportBitmap1632Long(OutputBuffer *buf, const ExpressionValue& val) noexcept;
 	__attribute__ ((noinline)) static void ReportBitmap64Long(OutputBuffer *buf, const ExpressionValue& val) noexcept;
 	__attribute__ ((noinline)) static void ReportPinNameAsJson(OutputBuffer *buf, const ExpressionValue& val) noexcept;
+	__attribute__ ((noinline)) static void ReportValueAsCbor(OutputBuffer *buf, const ObjectExplorationContext& context, const ExpressionValue& val, const char *_ecv_array filter) noexcept;
 
 #if SUPPORT_CAN_EXPANSION
 	__attribute__ ((noinline)) static void ReportExpansionBoardDetail(OutputBuffer *buf, const ExpressionValue& val) noexcept;
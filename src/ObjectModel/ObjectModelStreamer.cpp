@@ -0,0 +1,188 @@
+/*
+ * ObjectModelStreamer.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "ObjectModelStreamer.h"
+
+#if SUPPORT_OBJECT_MODEL_STREAMING
+
+#include <Platform/RepRap.h>
+#include <Platform/OutputMemory.h>
+#include <Platform/TaskPriorities.h>
+#include <GCodes/GCodeException.h>
+#include <RTOSIface/RTOSIface.h>
+
+constexpr size_t ObjectModelStreamerTaskStackWords = 1000;		// the same as the Network task, which generates the reports when we don't
+static Task<ObjectModelStreamerTaskStackWords> *streamerTask = nullptr;
+
+// The state of the report. 'owner' is set by the network task when it starts a report and cleared when the report has been collected or abandoned.
+static const void *volatile owner = nullptr;
+static volatile OutputStack chunks;							// the parts of the report that are waiting to be collected
+static volatile bool requested = false;						// true when a report has been requested but the streamer task hasn't started it yet
+static volatile bool finished = false;						// true when the streamer task has finished generating the report
+static volatile bool failed = false;						// true if the report is incomplete
+static volatile bool abandoned = false;						// true if the owner doesn't want the rest of the report
+static String<StringLength100> reportKey;
+static String<StringLength50> reportFlags;
+
+extern "C" [[noreturn]] void ObjectModelStreamerTask(void *pvParameters) noexcept
+{
+	for (;;)
+	{
+		while (!requested)
+		{
+			TaskBase::Take(TaskBase::TimeoutUnlimited);
+		}
+		requested = false;
+
+		OutputBuffer *buf = nullptr;
+		try
+		{
+			buf = reprap.GetModelResponse(nullptr, reportKey.c_str(), reportFlags.c_str(), true);
+		}
+		catch (const GCodeException&)
+		{
+			// We couldn't hand over part of the report, or the owner abandoned it. GetModelResponse has already released the buffer.
+		}
+
+		TaskCriticalSectionLocker lock;
+		if (abandoned)
+		{
+			OutputBuffer::ReleaseAll(buf);
+			chunks.ReleaseAll();
+			owner = nullptr;
+		}
+		else
+		{
+			if (buf == nullptr)
+			{
+				failed = true;
+			}
+			else
+			{
+				(void)chunks.Push(buf);
+			}
+			finished = true;
+		}
+	}
+}
+
+// Start generating a report for a network responder. Return true if successful, false if the streamer is busy or the key or flags are too long.
+/*static*/ bool ObjectModelStreamer::Start(const void *requester, const char *_ecv_array _ecv_null key, const char *_ecv_array _ecv_null flags) noexcept
+{
+	if (owner != nullptr)
+	{
+		return false;
+	}
+
+	if (key == nullptr) { key = ""; }
+	if (flags == nullptr) { flags = ""; }
+	if (strlen(key) >= StringLength100 || strlen(flags) >= StringLength50)
+	{
+		return false;												// the key or flags are too long to copy
+	}
+	reportKey.copy(key);
+	reportFlags.copy(flags);
+
+	if (streamerTask == nullptr)
+	{
+		streamerTask = new Task<ObjectModelStreamerTaskStackWords>;
+		streamerTask->Create(ObjectModelStreamerTask, "OMSTREAM", nullptr, TaskPriority::SpinPriority);
+	}
+
+	finished = failed = abandoned = false;
+	owner = requester;
+	requested = true;
+	streamerTask->Give();
+	return true;
+}
+
+// Get the next chunk of the report. If none is available yet, return nullptr and set 'done' false.
+// If the report is complete and all of it has been collected, return nullptr, set 'done' true and set 'succeeded' true unless the report was incomplete.
+/*static*/ OutputBuffer *_ecv_null ObjectModelStreamer::GetChunk(const void *requester, bool& done, bool& succeeded) noexcept
+{
+	if (owner != requester)
+	{
+		done = true;
+		succeeded = false;
+		return nullptr;
+	}
+
+	const bool wasFinished = finished;								// read this before we look for a chunk, in case the last chunk is added in between
+	OutputBuffer * const chunk = chunks.Pop();
+	if (chunk != nullptr)
+	{
+		streamerTask->Give();										// the streamer task may be waiting for us to collect data
+		done = false;
+		return chunk;
+	}
+
+	done = wasFinished;
+	if (wasFinished)
+	{
+		succeeded = !failed;
+		owner = nullptr;
+	}
+	return nullptr;
+}
+
+// Tell the streamer that we don't want the rest of the report, for example because the client has closed the connection
+/*static*/ void ObjectModelStreamer::Abandon(const void *requester) noexcept
+{
+	if (owner == requester)
+	{
+		{
+			TaskCriticalSectionLocker lock;
+			abandoned = true;
+			if (finished)
+			{
+				chunks.ReleaseAll();
+				owner = nullptr;
+			}
+		}
+		streamerTask->Give();
+	}
+}
+
+// This is called by the report generator in the streamer task at points where it may safely wait.
+// If we have generated enough of the report, hand it over, first waiting for the network to collect the earlier chunks if too much is queued already.
+// Return true if we handed over the contents of the buffer. Throw an exception to stop generating the report if we can't hand it over.
+/*static*/ bool ObjectModelStreamer::PausePoint(OutputBuffer *buf) THROWS(GCodeException)
+{
+	if (buf->Length() < ObjectModelStreamChunkSize)
+	{
+		return false;
+	}
+
+	if (buf->HadOverflow())
+	{
+		throw GCodeException("out of output buffers");
+	}
+
+	while (chunks.DataLength() >= ObjectModelStreamMaxQueuedData && !abandoned)
+	{
+		if (!TaskBase::Take(ObjectModelStreamTimeout))
+		{
+			throw GCodeException("report not collected");
+		}
+	}
+
+	if (abandoned)
+	{
+		throw GCodeException("report abandoned");
+	}
+
+	OutputBuffer * const chunk = buf->Detach();
+	if (chunk == nullptr || !chunks.Push(chunk))
+	{
+		throw GCodeException("out of output buffers");
+	}
+	return true;
+}
+
+#endif
+
+// End
@@ -0,0 +1,34 @@
+/*
+ * ObjectModelStreamer.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Generates object model reports in a task of their own so that a network responder can send the start of a report while the rest is generated.
+ * The report is handed over in chunks at points where the generator holds no locks. When the network falls behind, the generator waits for it,
+ * so the buffer space used is bounded however large the report is. Only one report is generated at a time; a responder that finds the streamer
+ * busy generates the whole report itself as before.
+ */
+
+#ifndef SRC_OBJECTMODEL_OBJECTMODELSTREAMER_H_
+#define SRC_OBJECTMODEL_OBJECTMODELSTREAMER_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_OBJECT_MODEL_STREAMING
+
+class ObjectModelStreamer
+{
+public:
+	// Functions called by the network responder that wants the report, which is identified by 'requester'
+	static bool Start(const void *requester, const char *_ecv_array _ecv_null key, const char *_ecv_array _ecv_null flags) noexcept;
+	static OutputBuffer *_ecv_null GetChunk(const void *requester, bool& done, bool& succeeded) noexcept;
+	static void Abandon(const void *requester) noexcept;
+
+	// Function called by the report generator where it may hand over what it has generated so far. Returns true if it did.
+	static bool PausePoint(OutputBuffer *buf) THROWS(GCodeException);
+};
+
+#endif
+
+#endif /* SRC_OBJECTMODEL_OBJECTMODELSTREAMER_H_ */
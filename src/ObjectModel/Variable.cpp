@@ -18,38 +18,155 @@ Variable::~Variable()
 	val.Release();
 }
 
-Variable* VariableSet::Lookup(const char *str) noexcept
+std::atomic<uint32_t> VariableSet::lastGeneration = 0;
+
+/*static*/ uint32_t VariableSet::HashName(const char *str) noexcept
+{
+	uint32_t hash = 2166136261u;						// FNV-1a
+	while (*str != 0)
+	{
+		hash = (hash ^ (uint8_t)*str) * 16777619u;
+		++str;
+	}
+	return hash;
+}
+
+// Return a new generation number. Zero is reserved to mean that a handle is not valid.
+/*static*/ uint32_t VariableSet::NewGeneration() noexcept
+{
+	uint32_t g;
+	do
+	{
+		g = ++lastGeneration;
+	} while (g == 0);
+	return g;
+}
+
+// Find the most recently created variable with the specified name
+VariableSet::LinkedVariable *VariableSet::Find(const char *str) const noexcept
 {
-	LinkedVariable *lv;
-	for (lv = root; lv != nullptr; lv = lv->next)
+	const uint32_t hash = HashName(str);
+	if (buckets != nullptr)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0)
+		for (LinkedVariable *lv = buckets[hash & (numBuckets - 1)]; lv != nullptr; lv = lv->nextInBucket)
 		{
-			return &(lv->v);
+			if (lv->hash == hash && strcmp(lv->v.GetName().Ptr(), str) == 0)
+			{
+				return lv;
+			}
+		}
+	}
+	else
+	{
+		for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
+		{
+			if (lv->hash == hash && strcmp(lv->v.GetName().Ptr(), str) == 0)
+			{
+				return lv;
+			}
 		}
 	}
 	return nullptr;
 }
 
+Variable* VariableSet::Lookup(const char *str) noexcept
+{
+	LinkedVariable * const lv = Find(str);
+	return (lv == nullptr) ? nullptr : &(lv->v);
+}
+
 const Variable* VariableSet::Lookup(const char *str) const noexcept
 {
-	const LinkedVariable *lv;
-	for (lv = root; lv != nullptr; lv = lv->next)
+	const LinkedVariable * const lv = Find(str);
+	return (lv == nullptr) ? nullptr : &(lv->v);
+}
+
+// Look up a variable using a handle from a previous lookup of the same name if it is still valid, else by name and update the handle
+const Variable* VariableSet::Lookup(const char *str, VariableHandle& handle) const noexcept
+{
+	if (handle.generation != generation)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0)
-		{
-			return &(lv->v);
-		}
+		LinkedVariable * const lv = Find(str);
+		handle.var = (lv == nullptr) ? nullptr : &(lv->v);
+		handle.generation = generation;
 	}
-	return nullptr;
+	return handle.var;
 }
 
 void VariableSet::InsertNew(const char *str, ExpressionValue pVal, int8_t pScope) noexcept
 {
-	LinkedVariable * const toInsert = new LinkedVariable(str, pVal, pScope, root);
+	LinkedVariable * const toInsert = new LinkedVariable(str, HashName(str), pVal, pScope, root);
 	root = toInsert;
+	++numVariables;
+	generation = NewGeneration();
+	if (buckets == nullptr)
+	{
+		if (numVariables > MaxUnhashedVariables)
+		{
+			Rehash(InitialVariableHashBuckets);
+		}
+	}
+	else if (numVariables > 2 * numBuckets && numBuckets < MaxVariableHashBuckets)
+	{
+		Rehash(2 * numBuckets);
+	}
+	else
+	{
+		LinkedVariable *& bucket = buckets[toInsert->hash & (numBuckets - 1)];
+		toInsert->nextInBucket = bucket;
+		bucket = toInsert;
+	}
+}
+
+// Rebuild the hash table with the specified number of buckets, which must be a power of 2
+void VariableSet::Rehash(size_t newNumBuckets) noexcept
+{
+	delete[] buckets;
+	buckets = new LinkedVariable*[newNumBuckets];
+	numBuckets = newNumBuckets;
+	for (size_t i = 0; i < newNumBuckets; ++i)
+	{
+		buckets[i] = nullptr;
+	}
+
+	// Append each variable to the end of its bucket so that the variables in each bucket are in the same order as in the main list
+	for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
+	{
+		lv->nextInBucket = nullptr;
+		LinkedVariable **pp = &buckets[lv->hash & (numBuckets - 1)];
+		while (*pp != nullptr)
+		{
+			pp = &((*pp)->nextInBucket);
+		}
+		*pp = lv;
+	}
+}
+
+// Unlink a variable from the list and the hash table and delete it. 'prev' is the preceding variable in the list.
+void VariableSet::Remove(LinkedVariable *lv, LinkedVariable *prev) noexcept
+{
+	if (prev == nullptr)
+	{
+		root = lv->next;
+	}
+	else
+	{
+		prev->next = lv->next;
+	}
+
+	if (buckets != nullptr)
+	{
+		LinkedVariable **pp = &buckets[lv->hash & (numBuckets - 1)];
+		while (*pp != lv)
+		{
+			pp = &((*pp)->nextInBucket);
+		}
+		*pp = lv->nextInBucket;
+	}
+
+	delete lv;
+	--numVariables;
+	generation = NewGeneration();
 }
 
 // Remove all variables with a scope greater than the parameter
@@ -58,45 +175,28 @@ void VariableSet::EndScope(uint8_t blockNesting) noexcept
 	LinkedVariable *prev = nullptr;
 	for (LinkedVariable *lv = root; lv != nullptr; )
 	{
+		LinkedVariable * const next = lv->next;
 		if (lv->v.GetScope() > blockNesting)
 		{
-			LinkedVariable *temp = lv;
-			lv = lv->next;
-			if (prev == nullptr)
-			{
-				root = lv;
-			}
-			else
-			{
-				prev->next = lv;
-			}
-			delete temp;
+			Remove(lv, prev);
 		}
 		else
 		{
 			prev = lv;
-			lv = lv->next;
 		}
+		lv = next;
 	}
 }
 
 void VariableSet::Delete(const char *str) noexcept
 {
+	const uint32_t hash = HashName(str);
 	LinkedVariable *prev = nullptr;
 	for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0)
+		if (lv->hash == hash && strcmp(lv->v.GetName().Ptr(), str) == 0)
 		{
-			if (prev == nullptr)
-			{
-				root = lv->next;
-			}
-			else
-			{
-				prev->next = lv->next;
-			}
-			delete lv;
+			Remove(lv, prev);
 			break;
 		}
 		prev = lv;
@@ -111,6 +211,10 @@ void VariableSet::Clear() noexcept
 		root = lv->next;
 		delete lv;
 	}
+	delete[] buckets;
+	buckets = nullptr;
+	numVariables = numBuckets = 0;
+	generation = NewGeneration();
 }
 
 VariableSet::~VariableSet()
@@ -123,7 +227,13 @@ void VariableSet::AssignFrom(VariableSet& other) noexcept
 {
 	Clear();
 	root = other.root;
+	buckets = other.buckets;
+	numVariables = other.numVariables;
+	numBuckets = other.numBuckets;
 	other.root = nullptr;
+	other.buckets = nullptr;
+	other.numVariables = other.numBuckets = 0;
+	other.generation = NewGeneration();
 }
 
 void VariableSet::IterateWhile(function_ref<bool(unsigned int, const Variable&) /*noexcept*/ > func) const noexcept
@@ -13,6 +13,7 @@
 #include <Platform/Heap.h>
 #include <ObjectModel/ObjectModel.h>
 #include <General/function_ref.h>
+#include <atomic>
 
 // Class to represent a variable having a name and a value
 class Variable
@@ -25,6 +26,8 @@ public:
 	ExpressionValue GetValue() const noexcept { return val; }
 	int8_t GetScope() const noexcept { return scope; }
 	void Assign(ExpressionValue ev) noexcept { val = ev; }
+	const char *_ecv_null AssignElement(const int32_t *_ecv_array indices, size_t numIndices, const ExpressionValue& ev) noexcept
+		{ return ArrayHandle::AssignElement(val, indices, numIndices, ev); }
 
 private:
 	StringHandle name;
@@ -32,12 +35,27 @@ private:
 	int8_t scope;								// -1 for a parameter, else the block nesting level when it was created
 };
 
+// Class to remember where a variable was found, so that it need not be looked up by name again.
+// The handle is valid only while no variables are added to or removed from the set that the variable was found in.
+class VariableHandle
+{
+public:
+	VariableHandle() noexcept : generation(0), var(nullptr) { }
+
+private:
+	friend class VariableSet;
+
+	uint32_t generation;						// the generation of the set when we looked up the variable, or zero if not valid
+	Variable *null var;							// the variable that we found, or nullptr if it didn't exist
+};
+
 // Class to represent a collection of variables.
-// For now this is just a linked list, but it could be changed to a hash table for faster lookup and insertion.
+// The variables are kept in a linked list with the most recently created first, which is the order in which they are reported and searched.
+// When there are more than a few of them we also index them by a hash of the name, so that a lookup need only compare the names of the variables in one bucket.
 class VariableSet
 {
 public:
-	VariableSet() noexcept : root(nullptr) { }
+	VariableSet() noexcept : root(nullptr), buckets(nullptr), numVariables(0), numBuckets(0), generation(NewGeneration()) { }
 	~VariableSet();
 	VariableSet(const VariableSet&) = delete;
 	VariableSet& operator=(const VariableSet& other) = delete;
@@ -46,6 +64,7 @@ public:
 
 	Variable *Lookup(const char *_ecv_array str) noexcept;
 	const Variable *Lookup(const char *_ecv_array str) const noexcept;
+	const Variable *Lookup(const char *_ecv_array str, VariableHandle& handle) const noexcept;
 	void InsertNew(const char *str, ExpressionValue pVal, int8_t pScope) noexcept;
 	void InsertNewParameter(const char *str, ExpressionValue pVal) noexcept { InsertNew(str, pVal, -1); }
 	void EndScope(uint8_t blockNesting) noexcept;
@@ -53,19 +72,37 @@ public:
 	void Clear() noexcept;
 
 	void IterateWhile(function_ref<bool(unsigned int index, const Variable& v) /*noexcept*/ > func) const noexcept;
+	uint32_t GetGeneration() const noexcept { return generation; }
+
+	static uint32_t HashName(const char *_ecv_array str) noexcept;
 
 private:
 	struct LinkedVariable
 	{
 		DECLARE_FREELIST_NEW_DELETE(LinkedVariable)
 
-		LinkedVariable(const char *_ecv_array str, ExpressionValue pVal, int8_t pScope, LinkedVariable *p_next) : next(p_next), v(str, pVal, pScope) {}
+		LinkedVariable(const char *_ecv_array str, uint32_t p_hash, ExpressionValue pVal, int8_t pScope, LinkedVariable *p_next)
+			: next(p_next), nextInBucket(nullptr), hash(p_hash), v(str, pVal, pScope) {}
 
 		LinkedVariable * null next;
+		LinkedVariable * null nextInBucket;
+		uint32_t hash;
 		Variable v;
 	};
 
+	static uint32_t NewGeneration() noexcept;
+
+	LinkedVariable *null Find(const char *_ecv_array str) const noexcept;
+	void Remove(LinkedVariable *lv, LinkedVariable *null prev) noexcept;
+	void Rehash(size_t newNumBuckets) noexcept;
+
 	LinkedVariable * null root;
+	LinkedVariable * null * null buckets;		// hash table, allocated when there are more than a few variables
+	uint16_t numVariables;
+	uint16_t numBuckets;
+	uint32_t generation;						// changed whenever a variable is added or removed, so that handles to the old variables are no longer used
+
+	static std::atomic<uint32_t> lastGeneration;	// generation numbers are unique across all sets so that a handle can't be used with the wrong set
 };
 
 #endif /* SRC_GCODES_VARIABLE_H_ */
@@ -0,0 +1,132 @@
+/*
+ * ArrayHandle.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ */
+
+#include "ArrayHandle.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+#include <ObjectModel/ObjectModel.h>
+
+struct ArrayStorage
+{
+	explicit ArrayStorage(size_t p_capacity) noexcept : refCount(1), numElements(0), capacity(p_capacity), elements(new ExpressionValue[p_capacity]) { }
+	~ArrayStorage() { delete[] elements; }
+
+	std::atomic<unsigned int> refCount;
+	size_t numElements;
+	size_t capacity;
+	ExpressionValue *elements;
+};
+
+// Allocate an array with all elements set to the same value
+void ArrayHandle::Allocate(size_t numElements, const ExpressionValue& initialValue) noexcept
+{
+	Delete();
+	if (numElements != 0)
+	{
+		storage = new ArrayStorage(numElements);
+		for (size_t i = 0; i < numElements; ++i)
+		{
+			storage->elements[i] = initialValue;
+		}
+		storage->numElements = numElements;
+	}
+}
+
+size_t ArrayHandle::GetNumElements() const noexcept
+{
+	return (storage == nullptr) ? 0 : storage->numElements;
+}
+
+ExpressionValue ArrayHandle::GetElement(size_t index) const noexcept
+{
+	return storage->elements[index];
+}
+
+// Append a value to the array
+void ArrayHandle::Append(const ExpressionValue& val) noexcept
+{
+	MakeUnique();
+	const size_t numElements = GetNumElements();
+	if (storage == nullptr || numElements == storage->capacity)
+	{
+		Reserve(max<size_t>(2 * numElements, 4));
+	}
+	storage->elements[numElements] = val;
+	++storage->numElements;
+}
+
+void ArrayHandle::Delete() noexcept
+{
+	if (storage != nullptr)
+	{
+		if (--storage->refCount == 0)
+		{
+			delete storage;								// this releases the elements
+		}
+		storage = nullptr;
+	}
+}
+
+const ArrayHandle& ArrayHandle::IncreaseRefCount() const noexcept
+{
+	if (storage != nullptr)
+	{
+		++storage->refCount;
+	}
+	return *this;
+}
+
+// If the storage is shared with any other array value then make a copy of it, so that we can modify it
+void ArrayHandle::MakeUnique() noexcept
+{
+	if (storage != nullptr && storage->refCount > 1)
+	{
+		Reserve(storage->capacity);
+	}
+}
+
+// Replace the storage by a copy with the specified capacity, which must be at least the number of elements
+void ArrayHandle::Reserve(size_t newCapacity) noexcept
+{
+	ArrayStorage * const newStorage = new ArrayStorage(newCapacity);
+	if (storage != nullptr)
+	{
+		for (size_t i = 0; i < storage->numElements; ++i)
+		{
+			newStorage->elements[i] = storage->elements[i];
+		}
+		newStorage->numElements = storage->numElements;
+		Delete();
+	}
+	storage = newStorage;
+}
+
+/*static*/ const char *ArrayHandle::AssignElement(ExpressionValue& arrayVal, const int32_t *indices, size_t numIndices, const ExpressionValue& newVal) noexcept
+{
+	ExpressionValue *element = &arrayVal;
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		if (element->GetType() != TypeCode::HeapArray)
+		{
+			return "variable is not an array";
+		}
+		ArrayHandle& ah = element->ahVal;
+		if (indices[i] < 0 || (size_t)indices[i] >= ah.GetNumElements())
+		{
+			return "array index out of bounds";
+		}
+		ah.MakeUnique();
+		element = &ah.storage->elements[indices[i]];
+	}
+	*element = newVal;
+	return nullptr;
+}
+
+#endif
+
+// End
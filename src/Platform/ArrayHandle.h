@@ -0,0 +1,47 @@
+/*
+ * ArrayHandle.h
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: agent
+ *
+ * Arrays of values held in global and local variables. The storage is reference counted so that copying an array value is cheap.
+ * An array is copied before it is modified if there is more than one reference to it, so array values behave as if they were copied on assignment.
+ */
+
+#ifndef SRC_PLATFORM_ARRAYHANDLE_H_
+#define SRC_PLATFORM_ARRAYHANDLE_H_
+
+#include <RepRapFirmware.h>
+
+#include <atomic>
+
+struct ExpressionValue;
+struct ArrayStorage;
+
+// Note: ArrayHandle is a union member in ExpressionValue, therefore it cannot have a non-trivial destructor, copy constructor etc.
+// This means that when an object containing an ArrayHandle is copied or destroyed, that object must handle the reference count.
+class ArrayHandle
+{
+public:
+	ArrayHandle() noexcept { storage = nullptr; }
+
+	void Allocate(size_t numElements, const ExpressionValue& initialValue) noexcept;
+	size_t GetNumElements() const noexcept;
+	ExpressionValue GetElement(size_t index) const noexcept pre(index < GetNumElements());
+	void Append(const ExpressionValue& val) noexcept;
+	void Delete() noexcept;
+	const ArrayHandle& IncreaseRefCount() const noexcept;
+	bool IsNull() const noexcept { return storage == nullptr; }
+
+	// Assign a value to an element of the array in 'arrayVal', or of an array nested within it, copying any of the arrays that are shared.
+	// Return nullptr if successful, else an error message.
+	static const char *_ecv_null AssignElement(ExpressionValue& arrayVal, const int32_t *_ecv_array indices, size_t numIndices, const ExpressionValue& newVal) noexcept;
+
+private:
+	void MakeUnique() noexcept;
+	void Reserve(size_t numElements) noexcept;
+
+	ArrayStorage *_ecv_null storage;
+};
+
+#endif /* SRC_PLATFORM_ARRAYHANDLE_H_ */
@@ -105,6 +105,53 @@ void OutputBuffer::Clear() noexcept
 	dataLength = 0;
 }
 
+// Discard the data after the specified length of the whole chain, releasing any buffers that are no longer needed
+void OutputBuffer::TruncateTo(size_t length) noexcept
+{
+	OutputBuffer *item = this;
+	while (length > item->dataLength && item->next != nullptr)
+	{
+		length -= item->dataLength;
+		item = item->next;
+	}
+
+	if (length < item->dataLength)
+	{
+		item->dataLength = length;
+	}
+	if (item->next != nullptr)
+	{
+		ReleaseAll(item->next);
+		for (OutputBuffer *p = this; p != nullptr; p = p->next)
+		{
+			p->last = item;
+		}
+	}
+}
+
+// Move all the data in this chain to a new chain and return that chain, leaving this buffer empty and ready to have more data written to it.
+// Only the data in this buffer is copied; the rest of the chain is handed over as it is. Return nullptr if we can't allocate a buffer.
+OutputBuffer *OutputBuffer::Detach() noexcept
+{
+	OutputBuffer *newBuffer;
+	if (!Allocate(newBuffer))
+	{
+		return nullptr;
+	}
+
+	memcpy(newBuffer->data, data + bytesRead, dataLength - bytesRead);
+	newBuffer->dataLength = dataLength - bytesRead;
+	if (next != nullptr)
+	{
+		newBuffer->next = next;
+		newBuffer->last = last;									// the other buffers in the chain already point to the last one
+	}
+	next = nullptr;
+	last = this;
+	dataLength = bytesRead = 0;
+	return newBuffer;
+}
+
 void OutputBuffer::UpdateWhenQueued() noexcept
 {
 	whenQueued = millis();
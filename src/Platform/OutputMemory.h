@@ -61,6 +61,9 @@ public:
 	size_t lcat(const char *_ecv_array src, size_t len) noexcept;
 	size_t cat(StringRef &str) noexcept;
 
+	void TruncateTo(size_t length) noexcept;						// Discard the data after the specified length of the whole chain
+	OutputBuffer *null Detach() noexcept;							// Move the data in the whole chain to a new chain, leaving this buffer empty
+
 	size_t EncodeChar(char c) noexcept;
 	size_t EncodeReply(OutputBuffer *src) noexcept;
 
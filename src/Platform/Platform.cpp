@@ -333,6 +333,9 @@ constexpr ObjectModelTableEntry Platform::objectModelTable[] =
 
 #if SUPPORT_ACCELEROMETERS
 	// 9. boards[0].accelerometer members
+# if SUPPORT_RESONANCE_ANALYSIS
+	{ "analysis",			OBJECT_MODEL_FUNC_NOSELF(Accelerometers::GetLocalAnalysis()),												ObjectModelEntryFlags::none },
+# endif
 	{ "points",				OBJECT_MODEL_FUNC_NOSELF((int32_t)Accelerometers::GetLocalAccelerometerDataPoints()),						ObjectModelEntryFlags::none },
 	{ "runs",				OBJECT_MODEL_FUNC_NOSELF((int32_t)Accelerometers::GetLocalAccelerometerRuns()),								ObjectModelEntryFlags::none },
 #endif
@@ -368,7 +371,7 @@ constexpr uint8_t Platform::objectModelTableDescriptor[] =
 	2,																		// section 7: move.axes[].microstepping
 	2,																		// section 8: move.extruders[].microstepping
 #if SUPPORT_ACCELEROMETERS
-	2,																		// section 9: boards[0].accelerometer
+	2 + SUPPORT_RESONANCE_ANALYSIS,											// section 9: boards[0].accelerometer
 #else
 	0,
 #endif
@@ -2944,6 +2947,9 @@ void Platform::SetDriveStepsPerUnit(size_t axisOrExtruder, float value, uint32_t
 		}
 	}
 	driveStepsPerUnit[axisOrExtruder] = max<float>(value, 1.0);	// don't allow zero or negative
+#if !MS_USE_FPU
+	driveStepsPerUnit[axisOrExtruder] = min<float>(driveStepsPerUnit[axisOrExtruder], MoveSegment::MaxStepsPerMm);	// don't overflow the fixed point step calculations
+#endif
 	reprap.MoveUpdated();
 }
 
@@ -22,6 +22,7 @@
 #include <Hardware/SoftwareReset.h>
 #include <Hardware/ExceptionHandlers.h>
 #include <Accelerometers/Accelerometers.h>
+#include <ObjectModel/Cbor.h>
 #include "Version.h"
 
 #ifdef DUET_NG
@@ -2532,7 +2533,9 @@ void RepRap::AppendStringArray(OutputBuffer *buf, const char *name, size_t numVa
 
 // Return a query into the object model, or return nullptr if no buffer available
 // We append a newline to help PanelDue resync after receiving corrupt or incomplete data. DWC ignores it.
-OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException)
+// If the flags ask for a binary report then the response is a CBOR map with the same fields as the JSON object, and there is no newline.
+// If 'streaming' is true then the object model streamer may take the start of the report from the buffer before we return the rest of it
+OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags, bool streaming) const THROWS(GCodeException)
 {
 	OutputBuffer *outBuf;
 	if (OutputBuffer::Allocate(outBuf))
@@ -2540,7 +2543,20 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 		if (key == nullptr) { key = ""; }
 		if (flags == nullptr) { flags = ""; }
 
-		outBuf->printf("{\"key\":\"%.s\",\"flags\":\"%.s\",\"result\":", key, flags);
+		const bool binary = ObjectExplorationContext::WantBinaryReport(flags);
+		if (binary)
+		{
+			Cbor::StartMap(outBuf);
+			Cbor::WriteString(outBuf, "key");
+			Cbor::WriteString(outBuf, key);
+			Cbor::WriteString(outBuf, "flags");
+			Cbor::WriteString(outBuf, flags);
+			Cbor::WriteString(outBuf, "result");
+		}
+		else
+		{
+			outBuf->printf("{\"key\":\"%.s\",\"flags\":\"%.s\",\"result\":", key, flags);
+		}
 
 		const bool wantArrayLength = (*key == '#');
 		if (wantArrayLength)
@@ -2550,8 +2566,15 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 
 		try
 		{
-			reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength);
-			outBuf->cat("}\n");
+			reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength, streaming);
+			if (binary)
+			{
+				Cbor::EndArrayOrMap(outBuf);
+			}
+			else
+			{
+				outBuf->cat("}\n");
+			}
 			if (outBuf->HadOverflow())
 			{
 				OutputBuffer::ReleaseAll(outBuf);
@@ -1191,16 +1191,73 @@ bool DataTransfer::WriteFileChunkRequest(const char *filename, uint32_t offset,
 	return true;
 }
 
+// Return the data type that we use to send a heap array to the SBC.
+// An array whose elements all have the same numeric or boolean type is sent in binary. Any other array is sent as a string in array literal form.
+static DataType GetHeapArrayDataType(const ExpressionValue& value) noexcept
+{
+	const size_t numElements = value.ahVal.GetNumElements();
+	if (numElements == 0)
+	{
+		return DataType::String;
+	}
+
+	const TypeCode elementType = value.ahVal.GetElement(0).GetType();
+	for (size_t i = 1; i < numElements; ++i)
+	{
+		if (value.ahVal.GetElement(i).GetType() != elementType)
+		{
+			return DataType::String;
+		}
+	}
+
+	switch (elementType)
+	{
+	case TypeCode::Int32:		return DataType::IntArray;
+	case TypeCode::Uint32:		return DataType::UIntArray;
+	case TypeCode::Float:		return DataType::FloatArray;
+	case TypeCode::Bool:		return DataType::BoolArray;
+	case TypeCode::DriverId_tc:	return DataType::DriverIdArray;
+	default:					return DataType::String;
+	}
+}
+
+// Return the number of bytes needed to send the elements of an array of the specified type in binary
+static size_t GetArrayDataLength(DataType dataType, size_t numElements) noexcept
+{
+	return (dataType == DataType::BoolArray) ? numElements * sizeof(uint8_t) : numElements * sizeof(uint32_t);
+}
+
+// Write the elements of a heap array that has a binary data type, starting on a 4-byte boundary
+void DataTransfer::WriteArrayData(DataType dataType, const ExpressionValue& value) noexcept
+{
+	txPointer = AddPadding(txPointer);
+	const size_t numElements = value.ahVal.GetNumElements();
+	for (size_t i = 0; i < numElements; ++i)
+	{
+		const ExpressionValue element = value.ahVal.GetElement(i);
+		if (dataType == DataType::BoolArray)
+		{
+			const uint8_t b = (element.bVal) ? 1 : 0;
+			WriteData(reinterpret_cast<const char *>(&b), sizeof(b));
+		}
+		else
+		{
+			const uint32_t u = element.uVal;				// this also gets the bits of an int32_t or float
+			WriteData(reinterpret_cast<const char *>(&u), sizeof(u));
+		}
+	}
+}
+
 bool DataTransfer::WriteEvaluationResult(const char *expression, const ExpressionValue& value) noexcept
 {
 	// Calculate payload length
 	const size_t expressionLength = strlen(expression);
 	size_t payloadLength;
 	String<StringLength50> rslt;
+	DataType arrayDataType = DataType::String;
 	switch (value.GetType())
 	{
 	case TypeCode::None:
-	// FIXME Add support for arrays
 	case TypeCode::Bool:
 	case TypeCode::DriverId_tc:
 	case TypeCode::Uint32:
@@ -1226,6 +1283,18 @@ bool DataTransfer::WriteEvaluationResult(const char *expression, const Expressio
 	case TypeCode::HeapString:
 		payloadLength = expressionLength + value.shVal.GetLength();
 		break;
+	case TypeCode::HeapArray:
+		arrayDataType = GetHeapArrayDataType(value);
+		if (arrayDataType == DataType::String)
+		{
+			value.AppendAsString(rslt.GetRef());
+			payloadLength = expressionLength + rslt.strlen();
+		}
+		else
+		{
+			payloadLength = AddPadding(expressionLength) + GetArrayDataLength(arrayDataType, value.ahVal.GetNumElements());
+		}
+		break;
 
 	default:
 		rslt.printf("unsupported type code %d", (int)value.type);
@@ -1295,6 +1364,21 @@ bool DataTransfer::WriteEvaluationResult(const char *expression, const Expressio
 		header->intValue = value.shVal.GetLength();
 		WriteData(value.shVal.Get().Ptr(), header->intValue);
 		break;
+	case TypeCode::HeapArray:
+		if (arrayDataType == DataType::String)
+		{
+			// We have already converted the value to a string in 'rslt'
+			header->dataType = DataType::String;
+			header->intValue = rslt.strlen();
+			WriteData(rslt.c_str(), rslt.strlen());
+		}
+		else
+		{
+			header->dataType = arrayDataType;
+			header->intValue = value.ahVal.GetNumElements();
+			WriteArrayData(arrayDataType, value);
+		}
+		break;
 	case TypeCode::DateTime_tc:
 	case TypeCode::MacAddress_tc:
 	case TypeCode::IPAddress_tc:
@@ -1396,9 +1480,9 @@ bool DataTransfer::WriteSetVariableResult(const char *varName, const ExpressionV
 	const size_t varNameLength = strlen(varName);
 	size_t payloadLength;
 	String<StringLength50> rslt;
+	DataType arrayDataType = DataType::String;
 	switch (value.GetType())
 	{
-	// FIXME Add support for arrays
 	case TypeCode::Bool:
 	case TypeCode::DriverId_tc:
 	case TypeCode::Uint32:
@@ -1419,6 +1503,18 @@ bool DataTransfer::WriteSetVariableResult(const char *varName, const ExpressionV
 	case TypeCode::HeapString:
 		payloadLength = varNameLength + value.shVal.GetLength();
 		break;
+	case TypeCode::HeapArray:
+		arrayDataType = GetHeapArrayDataType(value);
+		if (arrayDataType == DataType::String)
+		{
+			value.AppendAsString(rslt.GetRef());
+			payloadLength = varNameLength + rslt.strlen();
+		}
+		else
+		{
+			payloadLength = AddPadding(varNameLength) + GetArrayDataLength(arrayDataType, value.ahVal.GetNumElements());
+		}
+		break;
 
 	default:
 		rslt.printf("unsupported type code %d", (int)value.type);
@@ -1475,6 +1571,21 @@ bool DataTransfer::WriteSetVariableResult(const char *varName, const ExpressionV
 		header->intValue = value.shVal.GetLength();
 		WriteData(value.shVal.Get().Ptr(), header->intValue);
 		break;
+	case TypeCode::HeapArray:
+		if (arrayDataType == DataType::String)
+		{
+			// We have already converted the value to a string in 'rslt'
+			header->dataType = DataType::String;
+			header->intValue = rslt.strlen();
+			WriteData(rslt.c_str(), rslt.strlen());
+		}
+		else
+		{
+			header->dataType = arrayDataType;
+			header->intValue = value.ahVal.GetNumElements();
+			WriteArrayData(arrayDataType, value);
+		}
+		break;
 	case TypeCode::DateTime_tc:
 	case TypeCode::MacAddress_tc:
 	case TypeCode::IPAddress_tc:
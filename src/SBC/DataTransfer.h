@@ -149,6 +149,7 @@ private:
 	PacketHeader *WritePacketHeader(FirmwareRequest request, size_t dataLength = 0, uint16_t resendPacktId = 0) noexcept;
 	void WriteData(const char *data, size_t length) noexcept;
 	template<typename T> T *WriteDataHeader() noexcept;
+	void WriteArrayData(DataType dataType, const ExpressionValue& value) noexcept;
 
 	size_t AddPadding(size_t length) const noexcept;
 };
@@ -290,7 +290,7 @@ void SbcInterface::ExchangeData() noexcept
 			break;
 		}
 
-		// Get the object model
+		// Get the object model. If the flags include 'b' then the response is in CBOR format instead of JSON.
 		case SbcRequest::GetObjectModel:
 		{
 			String<StringLength100> key;
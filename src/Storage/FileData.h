@@ -138,6 +138,20 @@ public:
 		return not_null(f)->Length();
 	}
 
+#if SUPPORT_BINARY_GCODE
+	GCodeFileFormat GetGCodeFormat() const noexcept
+	pre(IsLive())
+	{
+		return not_null(f)->GetGCodeFormat();
+	}
+
+	void SetGCodeFormat(GCodeFileFormat format) noexcept
+	pre(IsLive())
+	{
+		not_null(f)->SetGCodeFormat(format);
+	}
+#endif
+
 	// Move operator
 	void MoveFrom(FileData& other) noexcept
 	{
@@ -12,6 +12,10 @@
 #include <PrintMonitor/PrintMonitor.h>
 #include <GCodes/GCodes.h>
 
+#if SUPPORT_BINARY_GCODE
+# include <GCodes/BinaryGCodeDecoder.h>
+#endif
+
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 
 FileInfoParser::FileInfoParser() noexcept
@@ -81,7 +85,11 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 		}
 
 		// If the file is empty or not a G-Code file, we don't need to parse anything
-		constexpr const char *GcodeFileExtensions[] = { ".gcode", ".g", ".gco", ".gc", ".nc" };
+		constexpr const char *GcodeFileExtensions[] = { ".gcode", ".g", ".gco", ".gc", ".nc"
+#if SUPPORT_BINARY_GCODE
+															, ".bgcode"
+#endif
+														};
 		bool isGcodeFile = false;
 		for (const char *ext : GcodeFileExtensions)
 		{
@@ -143,6 +151,25 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 				accumulatedReadTime += now - startTime;
 				startTime = now;
 
+#if SUPPORT_BINARY_GCODE
+				// A binary G-code file has all the information in the metadata that follows the file header, which fits in the first chunk
+				size_t metadataLength;
+				if (bufferStartFileOffset == 0 && BinaryGCodeDecoder::IsFileHeader(buf, sizeToScan, metadataLength))
+				{
+					buf[min<size_t>(BinaryGCodeFileHeaderSize + metadataLength, sizeToScan)] = 0;
+					ParseBinaryMetadata(buf + BinaryGCodeFileHeaderSize);
+					parseState = notParsing;
+					fileBeingParsed->Close();
+					if (parsedFileInfo.numLayers == 0 && parsedFileInfo.layerHeight > 0.0 && parsedFileInfo.objectHeight > 0.0)
+					{
+						parsedFileInfo.numLayers = lrintf(parsedFileInfo.objectHeight / parsedFileInfo.layerHeight);
+					}
+					parsedFileInfo.incomplete = false;
+					info = parsedFileInfo;
+					return GCodeResult::ok;
+				}
+#endif
+
 				// Search for filament usage (Cura puts it at the beginning of a G-code file)
 				if (parsedFileInfo.numFilaments == 0)
 				{
@@ -642,6 +669,86 @@ bool FileInfoParser::FindSlicerInfo(const char* bufp) noexcept
 	return false;
 }
 
+#if SUPPORT_BINARY_GCODE
+
+// Return true if the key at the start of a line of metadata is the one we want
+static bool MetadataKeyMatches(const char *_ecv_array bufp, size_t keyLength, const char *_ecv_array key) noexcept
+{
+	return strlen(key) == keyLength && memcmp(bufp, key, keyLength) == 0;
+}
+
+// Parse the metadata of a binary G-code file. The buffer is null-terminated and holds lines of the form key=value.
+void FileInfoParser::ParseBinaryMetadata(const char *_ecv_array bufp) noexcept
+{
+	while (*bufp != 0)
+	{
+		const char *_ecv_array lineEnd = strchr(bufp, '\n');
+		if (lineEnd == nullptr)
+		{
+			lineEnd = bufp + strlen(bufp);
+		}
+
+		const char *_ecv_array const equals = (const char *_ecv_array)memchr(bufp, '=', lineEnd - bufp);
+		if (equals != nullptr)
+		{
+			const size_t keyLength = equals - bufp;
+			const char *_ecv_array value = equals + 1;
+			if (MetadataKeyMatches(bufp, keyLength, "generatedBy"))
+			{
+				parsedFileInfo.generatedBy.Clear();
+				while (value < lineEnd && *value >= ' ')
+				{
+					parsedFileInfo.generatedBy.cat(*value++);
+				}
+			}
+			else if (MetadataKeyMatches(bufp, keyLength, "layerHeight"))
+			{
+				parsedFileInfo.layerHeight = SafeStrtof(value, nullptr);
+			}
+			else if (MetadataKeyMatches(bufp, keyLength, "objectHeight"))
+			{
+				parsedFileInfo.objectHeight = SafeStrtof(value, nullptr);
+			}
+			else if (MetadataKeyMatches(bufp, keyLength, "numLayers"))
+			{
+				parsedFileInfo.numLayers = StrToU32(value, nullptr);
+			}
+			else if (MetadataKeyMatches(bufp, keyLength, "printTime"))
+			{
+				parsedFileInfo.printTime = StrToU32(value, nullptr);
+			}
+			else if (MetadataKeyMatches(bufp, keyLength, "simulatedTime"))
+			{
+				parsedFileInfo.simulatedTime = StrToU32(value, nullptr);
+			}
+			else if (MetadataKeyMatches(bufp, keyLength, "filament"))
+			{
+				const size_t maxFilaments = reprap.GetGCodes().GetNumExtruders();
+				parsedFileInfo.numFilaments = 0;
+				while (parsedFileInfo.numFilaments < maxFilaments)
+				{
+					const char *_ecv_array endptr;
+					const float filamentLength = SafeStrtof(value, &endptr);
+					if (endptr == value)
+					{
+						break;
+					}
+					parsedFileInfo.filamentNeeded[parsedFileInfo.numFilaments++] = filamentLength;
+					if (*endptr != ',')
+					{
+						break;
+					}
+					value = endptr + 1;
+				}
+			}
+		}
+
+		bufp = (*lineEnd == 0) ? lineEnd : lineEnd + 1;
+	}
+}
+
+#endif
+
 // Scan the buffer for a 2-part filament used string. Return the number of filament found.
 void FileInfoParser::FindFilamentUsedEmbedded(const char* p, const char *s1, const char *s2, unsigned int &filamentsFound) noexcept
 {
@@ -61,6 +61,9 @@ private:
 	unsigned int FindFilamentUsed(const char *_ecv_array bufp) noexcept;
 	void FindFilamentUsedEmbedded(const char *_ecv_array p, const char *_ecv_array s1, const char *_ecv_array s2, unsigned int &filamentsFound) noexcept;
 	bool FindThumbnails(const char *_ecv_array bufp, FilePosition bufferStartFilePosition) noexcept;
+#if SUPPORT_BINARY_GCODE
+	void ParseBinaryMetadata(const char *_ecv_array bufp) noexcept;
+#endif
 
 	// We parse G-Code files in multiple stages. These variables hold the required information
 	Mutex parserMutex;
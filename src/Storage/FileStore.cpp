@@ -33,6 +33,9 @@ FileStore::FileStore() noexcept
 void FileStore::Init() noexcept
 {
 	usageMode = FileUseMode::free;
+#if SUPPORT_BINARY_GCODE
+	gcodeFormat = GCodeFileFormat::unknown;
+#endif
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 	openCount = 0;
 	closeRequested = false;
@@ -54,6 +57,9 @@ void FileStore::Init() noexcept
 bool FileStore::Open(const char *_ecv_array filePath, OpenMode mode, uint32_t preAllocSize) noexcept
 {
 	const bool writing = (mode == OpenMode::write || mode == OpenMode::writeWithCrc || mode == OpenMode::append);
+#if SUPPORT_BINARY_GCODE
+	gcodeFormat = GCodeFileFormat::unknown;
+#endif
 #if HAS_EMBEDDED_FILES
 # if HAS_SBC_INTERFACE
 	if (!reprap.UsingSbcInterface())
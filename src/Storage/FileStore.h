@@ -36,6 +36,16 @@ enum class FileUseMode : uint8_t
 	invalidated		// file object is in use but file system has been invalidated
 };
 
+#if SUPPORT_BINARY_GCODE
+// The format of a G-code file. We record it in the FileStore so that we only need to check it once each time the file is opened.
+enum class GCodeFileFormat : uint8_t
+{
+	unknown,
+	text,
+	binary
+};
+#endif
+
 class FileStore
 {
 public:
@@ -58,6 +68,10 @@ public:
 	bool IsFree() const noexcept { return usageMode == FileUseMode::free; }
 	FilePosition Position() const noexcept;						// Return the current position in the file, assuming we are reading the file
 	void Duplicate() noexcept;									// Create a second reference to this file
+#if SUPPORT_BINARY_GCODE
+	GCodeFileFormat GetGCodeFormat() const noexcept { return gcodeFormat; }
+	void SetGCodeFormat(GCodeFileFormat format) noexcept { gcodeFormat = format; }
+#endif
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	FileWriteBuffer *GetWriteBuffer() const noexcept;			// Return a pointer to the remaining space for writing
@@ -119,6 +133,9 @@ private:
 
 	volatile bool closeRequested;
 	FileUseMode usageMode;
+#if SUPPORT_BINARY_GCODE
+	GCodeFileFormat gcodeFormat;
+#endif
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	bool calcCrc;